@@ -0,0 +1,126 @@
+/**
+  @file callback.cc
+
+  @brief Implements sorting and sampling utitlities. Employs pre-allocated copy-out parameters to avoid dependence on front end's memory allocation. The core does not implement the callback.h and callback.cc so I have to implement them here...
+
+  @author GitHub user @fyears
+ */
+#include <algorithm> // sort
+#include <random> // default_random_engine
+#include <utility> // make_pair
+//#include <iostream>
+#include <vector> // vector
+
+
+#include "callback.h"
+#include "rowsampler.h"
+
+/**
+  @brief Call-back to row sampling.
+
+  @param rowSampler is the training's sampler, mapping variates to rows.
+
+  @param nSamp is the number of samples to draw.
+
+  @param out[] outputs the sampled row indices.
+
+  @return count of rows sampled, with copy-out parameter vector.
+*/
+unsigned int CallBack::SampleRows(const RowSampler *rowSampler, unsigned int nSamp, int out[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  std::vector<double> ru(rowSampler->VarCount(nSamp));
+  for (unsigned int i = 0; i < ru.size(); i++) {
+    ru[i] = distribution(gen);
+  }
+  // Without replacement, rows of zero weight are never drawn.
+  return rowSampler->Sample(nSamp, &ru[0], out);
+}
+
+
+/**
+  @brief Call-back to integer quicksort with indices.
+
+  @param ySorted[] is a copy-out vector containing the sorted integers.
+
+  @param rank2Row[] is the vector of permuted indices.
+
+  @param one is a hard-coded integer indicating unit stride.
+
+  @param nRow is the number of rows to sort.
+
+  @return Formally void, with copy-out parameter vectors.
+*/
+void CallBack::QSortI(int ySorted[], int rank2Row[], int one, int nRow) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = one; i <= nRow; ++i)
+  {
+    pairs.push_back(std::make_pair(ySorted[i-1], rank2Row[i-1]));
+  }
+
+  std::sort(pairs.begin(), pairs.end(),
+    [](const std::pair<int, int> &a, const std::pair<int, int> &b){
+      return a.first < b.first;
+    }
+  );
+
+  for (int i = one; i <= nRow; ++i) {
+    ySorted[i-1] = pairs[i-1].first;
+    rank2Row[i-1] = pairs[i-1].second;
+  }
+}
+
+
+/**
+  @brief Call-back to double quicksort with indices.
+
+  @param ySorted[] is the copy-out vector of sorted values.
+
+  @param rank2Row[] is the copy-out vector of permuted indices.
+
+  @param one is a hard-coded integer indicating unit stride.
+
+  @param nRow is the number of rows to sort.
+
+  @return Formally void, with copy-out parameter vectors.
+*/
+void CallBack::QSortD(double ySorted[], int rank2Row[], int one, int nRow) {
+  std::vector<std::pair<double, int>> pairs;
+  for (int i = one; i <= nRow; ++i)
+  {
+    pairs.push_back(std::make_pair(ySorted[i-1], rank2Row[i-1]));
+  }
+
+  std::sort(pairs.begin(), pairs.end(),
+    [](const std::pair<double, int> &a, const std::pair<double, int> &b){
+      // avoid Inf
+      return a.first < b.first || (b.first != b.first && a.first == a.first);
+    }
+  );
+
+  for (int i = one; i <= nRow; ++i) {
+    ySorted[i-1] = pairs[i-1].first;
+    rank2Row[i-1] = pairs[i-1].second;
+  }
+}
+
+
+/**
+  @brief Call-back to uniform random-variate generator.
+
+  @param len is number of variates to generate.
+
+  @param out[] is the copy-out vector of generated variates.
+
+  @return Formally void, with copy-out parameter vector.
+    
+ */
+void CallBack::RUnif(int len, double out[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  for (int i = 0; i < len; i++){
+    out[i] = distribution(gen);
+  }
+}
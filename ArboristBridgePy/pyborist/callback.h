@@ -12,16 +12,9 @@
 #include <vector>
 
 class CallBack {
-  static unsigned int nRow;
-  static bool withRepl;
-  static std::vector<double> weight;
-
   public:
-    static void SampleInit(unsigned int _nRow,
-      double _sampleWeight[],
-      bool _withRepl);
-
-    static void SampleRows(unsigned int nSamp,
+    static unsigned int SampleRows(const class RowSampler *rowSampler,
+      unsigned int nSamp,
       int out[]);
 
     static void QSortI(int ySorted[],
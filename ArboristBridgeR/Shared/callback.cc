@@ -27,33 +27,19 @@
 #include "rcppSample.h"
 #include "callback.h"
 
-/**
-   @brief Initializes static state parameters for row sampling.
-
-   @param _nRow is the (fixed) number of response rows.
-
-   @param _weight is the user-specified weighting of row samples.
-
-   @param _repl is true iff sampling with replacement.
-
-   @return void.
- */
-void CallBack::SampleInit(unsigned int _nRow, const double _weight[], bool _repl) {
-  RcppSample::Init(_nRow, _weight, _repl);
-}
-
-
 /**
    @brief Call-back to Rcpp implementation of row sampling.
 
+   @param rowSampler is the training's sampler, mapping variates to rows.
+
    @param nSamp is the number of samples to draw.
 
    @param out[] outputs the sampled row indices.
 
-   @return Formally void, with copy-out parameter vector.
+   @return count of rows sampled, with copy-out parameter vector.
 */
-void CallBack::SampleRows(unsigned int nSamp, int out[]) {
-  RcppSample::SampleRows(nSamp, out);
+unsigned int CallBack::SampleRows(const RowSampler *rowSampler, unsigned int nSamp, int out[]) {
+  return RcppSample::SampleRows(rowSampler, nSamp, out);
 }
 
 
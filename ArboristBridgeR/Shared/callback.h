@@ -28,8 +28,7 @@
 
 class CallBack {
  public:
-  static void SampleInit(unsigned int _nRow, const double _sampleWeight[], bool _withRepl);
-  static void SampleRows(unsigned int nSamp, int out[]);
+  static unsigned int SampleRows(const class RowSampler *rowSampler, unsigned int nSamp, int out[]);
   static void RUnif(int len, double out[]);
 };
 
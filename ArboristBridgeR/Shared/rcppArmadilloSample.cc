@@ -23,53 +23,26 @@
    @author Mark Seligman
  */
 
-#include <RcppArmadilloExtensions/sample.h>
 #include "rcppSample.h"
+#include "rowsampler.h"
 
 //#include <iostream>
 //using namespace std;
 
-unsigned int RcppSample::nRow = 0;
-bool RcppSample::withRepl = false;
-
-NumericVector weightNull(0);
-NumericVector &RcppSample::weight = weightNull;
-
 /**
-   @brief Caches row sampling parameters as static values.
-
-   @param _nRow is length of the response vector.
+   @brief Samples row indices either with or without replacement, mapping R's uniform variates through the training's sampler.
 
-   @param _weight is user-specified weighting of row samples.
-
-   @param _withRepl is true iff sampling with replacement.
-
-   @return void.
- */
-void RcppSample::Init(unsigned int _nRow, const double feWeight[], bool _withRepl) {
-  nRow = _nRow;
-  NumericVector _weight(nRow);
-  weight = _weight;
-  for (unsigned int i = 0; i < nRow; i++)
-    weight[i] = feWeight[i];
-  withRepl = _withRepl;
-}
-
-
-/**
-   @brief Samples row indices either with or without replacement using methods from RccpArmadillo.
+   @param rowSampler maps variates to rows.
 
    @param nSamp is the number of samples to draw.
 
    @param out[] is an output vector of sampled row indices.
 
-   @return void, with output vector.
+   @return count of rows sampled:  may fall short of 'nSamp' when
+   sampling without replacement, with output vector.
  */
-void RcppSample::SampleRows(unsigned int nSamp, int out[]) {
+unsigned int RcppSample::SampleRows(const RowSampler *rowSampler, unsigned int nSamp, int out[]) {
   RNGScope scope;
-  IntegerVector rowVec(seq_len(nRow)-1);
-  IntegerVector samp = RcppArmadillo::sample(rowVec, nSamp, withRepl, weight);
-
-  for (unsigned int i = 0; i < nSamp; i++)
-    out[i] = samp[i];
+  NumericVector ru(runif(rowSampler->VarCount(nSamp)));
+  return rowSampler->Sample(nSamp, ru.begin(), out);
 }
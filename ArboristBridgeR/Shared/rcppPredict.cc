@@ -31,6 +31,7 @@ using namespace Rcpp;
 #include "rcppForest.h"
 #include "rcppLeaf.h"
 #include "predict.h"
+#include "taskpool.h"
 
 #include "forest.h"
 #include "leaf.h"
@@ -40,6 +41,20 @@ using namespace Rcpp;
 //#include <iostream>
 //using namespace std;
 
+/**
+   @brief Pool of prediction workers, built on first use and retained
+   for the session, so that each call wakes workers rather than starting
+   them.  The pool holds no prediction state, and runs any loop issued
+   while another is in progress serially in the caller.
+
+   @return pool shared by the prediction entries.
+ */
+static TaskPool *PredictPool() {
+  static TaskPool taskPool;
+  return &taskPool;
+}
+
+
 /**
    @brief Utility for computing mean-square error of prediction.
    
@@ -97,7 +112,7 @@ RcppExport SEXP RcppPredictReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
   RcppLeaf::UnwrapReg(sLeaf, yTrain, leafOrigin, leafNode, leafCount, bagLeaf, bagLeafTot, bagBits, validate);
 
   std::vector<double> yPred(nRow);
-  Predict::Regression(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int *) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagBits, yTrain, yPred);
+  Predict::Regression(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int *) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagBits, yTrain, yPred, Predict::rowTileDefault, 0, 0, PredictPool());
 
   List prediction;
   if (Rf_isNull(sYTest)) { // Prediction
@@ -214,7 +229,7 @@ RcppExport SEXP RcppPredictCtg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
   std::vector<unsigned int> censusCore(nRow * ctgWidth);
   std::vector<unsigned int> yPred(nRow);
   NumericVector probCore = doProb ? NumericVector(nRow * ctgWidth) : NumericVector(0);
-  Predict::Classification(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int*) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagBits, rowTrain, weight, ctgWidth, yPred, &censusCore[0], testCore, test ? &confCore[0] : 0, misPredCore, doProb ? probCore.begin() : 0);
+  Predict::Classification(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int*) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagBits, rowTrain, weight, ctgWidth, yPred, &censusCore[0], testCore, test ? &confCore[0] : 0, misPredCore, doProb ? probCore.begin() : 0, Predict::rowTileDefault, 0, 0, PredictPool());
 
   List predBlock(sPredBlock);
   IntegerMatrix census = transpose(IntegerMatrix(ctgWidth, nRow, &censusCore[0]));
@@ -378,7 +393,7 @@ RcppExport SEXP RcppPredictQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP
   std::vector<double> yPred(nRow);
   std::vector<double> quantVecCore(as<std::vector<double> >(sQuantVec));
   std::vector<double> qPredCore(nRow * quantVecCore.size());
-  Predict::Quantiles(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int*) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagLeaf, bagLeafTot, bagBits, yTrain, yPred, quantVecCore, as<unsigned int>(sQBin), qPredCore, validate);
+  Predict::Quantiles(valNum, rowStart, runLength, predStart, (valNum.size() == 0 && nPredNum > 0) ? transpose(blockNum).begin() : 0, nPredFac > 0 ? (unsigned int*) transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, nTree, facSplit, facLen, facOrig, nFac, leafOrigin, leafNode, leafCount, bagLeaf, bagLeafTot, bagBits, yTrain, yPred, quantVecCore, as<unsigned int>(sQBin), qPredCore, validate, Predict::rowTileDefault, 0, 0, PredictPool());
   
   NumericMatrix qPred(transpose(NumericMatrix(quantVecCore.size(), nRow, qPredCore.begin())));
   List prediction;
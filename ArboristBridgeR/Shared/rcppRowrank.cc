@@ -26,6 +26,7 @@
 
 #include "rcppRowrank.h"
 #include "rowrank.h"
+#include "rowrankfile.h"
 
 // Testing only:
 //#include <iostream>
@@ -84,14 +85,162 @@ RcppExport SEXP RcppRowRank(SEXP sPredBlock) {
 }
 
 
+/**
+   @brief Writes a presorted RowRank to file, for mapping by later
+   sessions.
+
+   @param sPredBlock is the PredBlock from which the RowRank was built.
+
+   @param sRowRank is the RowRank to write.
+
+   @param sPath is the file name.
+
+   @return RowRankFile object describing the file written.
+ */
+RcppExport SEXP RcppRowRankWrite(SEXP sPredBlock, SEXP sRowRank, SEXP sPath) {
+  List predBlock(sPredBlock);
+  if (!predBlock.inherits("PredBlock"))
+    stop("Expecting PredBlock");
+  List rowRank(sRowRank);
+  if (!rowRank.inherits("RowRank"))
+    stop("Expecting RowRank");
+
+  std::string path = as<std::string>(sPath);
+  IntegerVector row((SEXP) rowRank["row"]);
+  IntegerVector rank((SEXP) rowRank["rank"]);
+  IntegerVector runLength((SEXP) rowRank["runLength"]);
+  IntegerVector numOff((SEXP) rowRank["numOff"]);
+  NumericVector numVal((SEXP) rowRank["numVal"]);
+  IntegerVector facCard((SEXP) predBlock["facCard"]);
+  if (!RowRankFile::Write(path.c_str(), as<unsigned int>(predBlock["nRow"]), as<unsigned int>(predBlock["nPredNum"]), as<unsigned int>(predBlock["nPredFac"]), (unsigned int *) row.begin(), (unsigned int *) rank.begin(), (unsigned int *) runLength.begin(), runLength.length(), (unsigned int *) numOff.begin(), numVal.begin(), numVal.length(), (unsigned int *) facCard.begin(), RcppRowrank::Fingerprint(predBlock)))
+    stop("Unable to write RowRank file");
+
+  RowRankFile rowRankFile(path.c_str());
+  if (!rowRankFile.Valid())
+    stop("Unable to map RowRank file");
+
+  return RcppRowrank::FileInfo(&rowRankFile, path);
+}
+
+
+/**
+   @brief Checks the header of a RowRank file, without retaining the
+   mapping.  Contents are read only if verification is requested.
+
+   @param sPath is the file name.
+
+   @param sPredBlock is the PredBlock to be trained, from whose values
+   the file must have been built.
+
+   @param sVerify is true iff the file's runs and fingerprint are also to
+   be checked against the design.
+
+   @return RowRankFile object describing the file.
+ */
+RcppExport SEXP RcppRowRankFile(SEXP sPath, SEXP sPredBlock, SEXP sVerify) {
+  List predBlock(sPredBlock);
+  if (!predBlock.inherits("PredBlock"))
+    stop("Expecting PredBlock");
+
+  std::string path = as<std::string>(sPath);
+  RowRankFile rowRankFile(path.c_str());
+  if (!rowRankFile.Valid())
+    stop("Invalid or unreadable RowRank file");
+  if (as<bool>(sVerify) && (!rowRankFile.Validate() || rowRankFile.Fingerprint() != RcppRowrank::Fingerprint(predBlock)))
+    stop("RowRank file does not conform to design");
+
+  return RcppRowrank::FileInfo(&rowRankFile, path);
+}
+
+
+/**
+   @brief Summarizes a mapped file as an R object standing in for the
+   RowRank.
+
+   @return RowRankFile list.
+ */
+List RcppRowrank::FileInfo(const RowRankFile *rowRankFile, const std::string &path) {
+  const unsigned int *facCard = rowRankFile->FacCard();
+  List fileInfo = List::create(
+      _["file"] = path,
+      _["nRow"] = rowRankFile->NRow(),
+      _["nPredNum"] = rowRankFile->NPredNum(),
+      _["nPredFac"] = rowRankFile->NPredFac(),
+      _["facCard"] = IntegerVector(facCard, facCard + rowRankFile->NPredFac())
+  );
+  fileInfo.attr("class") = "RowRankFile";
+
+  return fileInfo;
+}
+
+
+/**
+   @brief Hashes the dimensions of a PredBlock and a sample of its
+   predictor values, so that a RowRank file built from one design is not
+   mistaken for that of another having the same shape.  The sample is
+   bounded, so large designs are neither read in full nor paged in.
+
+   @return sampled hash of the numerical and factor blocks.
+ */
+uint64_t RcppRowrank::Fingerprint(const List &predBlock) {
+  uint32_t dim[3] = {as<uint32_t>(predBlock["nRow"]), as<uint32_t>(predBlock["nPredNum"]), as<uint32_t>(predBlock["nPredFac"])};
+  uint64_t hash = RowRankFile::Hash(dim, sizeof(dim));
+  if (as<unsigned int>(predBlock["nPredNum"]) > 0) {
+    if (!Rf_isNull(predBlock["blockNumRLE"])) {
+      List blockNumRLE((SEXP) predBlock["blockNumRLE"]);
+      NumericVector valNum((SEXP) blockNumRLE["valNum"]);
+      IntegerVector rowStart((SEXP) blockNumRLE["rowStart"]);
+      IntegerVector runLength((SEXP) blockNumRLE["runLength"]);
+      IntegerVector predStart((SEXP) blockNumRLE["predStart"]);
+      hash = RowRankFile::Sample(valNum.begin(), valNum.length() * sizeof(double), hash);
+      hash = RowRankFile::Sample(rowStart.begin(), rowStart.length() * sizeof(int), hash);
+      hash = RowRankFile::Sample(runLength.begin(), runLength.length() * sizeof(int), hash);
+      hash = RowRankFile::Sample(predStart.begin(), predStart.length() * sizeof(int), hash);
+    }
+    else {
+      NumericMatrix blockNum((SEXP) predBlock["blockNum"]);
+      hash = RowRankFile::Sample(blockNum.begin(), blockNum.length() * sizeof(double), hash);
+    }
+  }
+  if (as<unsigned int>(predBlock["nPredFac"]) > 0) {
+    IntegerMatrix blockFac((SEXP) predBlock["blockFac"]);
+    hash = RowRankFile::Sample(blockFac.begin(), blockFac.length() * sizeof(int), hash);
+  }
+
+  return hash;
+}
+
+
 IntegerVector RcppRowrank::iv1 = IntegerVector(0);
 IntegerVector RcppRowrank::iv2 = IntegerVector(0);
 IntegerVector RcppRowrank::iv3 = IntegerVector(0);
 IntegerVector RcppRowrank::iv4 = IntegerVector(0);
 NumericVector RcppRowrank::nv1 = NumericVector(0);
 
-void RcppRowrank::Unwrap(SEXP sRowRank, unsigned int *&feNumOff, double *&feNumVal, unsigned int *&feRow, unsigned int *&feRank, unsigned int *&feRLE, unsigned int &rleLength) {
+/**
+   @brief Exposes the RowRank vectors as core arrays.  A RowRankFile is
+   mapped and its sections passed through without copying.
+
+   @param rrFile outputs the mapping of a RowRankFile, if any, which
+   the caller holds for the duration of its training.
+
+   @return void, with output pointer parameters.
+ */
+void RcppRowrank::Unwrap(SEXP sRowRank, std::unique_ptr<RowRankFile> &rrFile, const unsigned int *&feNumOff, const double *&feNumVal, const unsigned int *&feRow, const unsigned int *&feRank, const unsigned int *&feRLE, unsigned int &rleLength) {
   List rowRank(sRowRank);
+  if (rowRank.inherits("RowRankFile")) {
+    rrFile.reset(new RowRankFile(as<std::string>(rowRank["file"]).c_str()));
+    if (!rrFile->Valid() || !rrFile->Validate())
+      stop("Invalid or unreadable RowRank file");
+
+    feNumOff = rrFile->NumOff();
+    feNumVal = rrFile->NumVal();
+    feRow = rrFile->Row();
+    feRank = rrFile->Rank();
+    feRLE = rrFile->RLE();
+    rleLength = rrFile->RLELength();
+    return;
+  }
   if (!rowRank.inherits("RowRank"))
     stop("Expecting RowRank");
 
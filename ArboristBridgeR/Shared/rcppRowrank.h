@@ -31,13 +31,17 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 
+#include <cstdint>
+#include <memory>
+
 class RcppRowrank {
   static IntegerVector iv1, iv2, iv3, iv4;
   static NumericVector nv1;
 
-
  public:
-  static void Unwrap(SEXP sRowRank, unsigned int *&feNumOff, double *&feNumVal, unsigned int *&feRow, unsigned int *&feRank, unsigned int *&feRLE, unsigned int &feRLELength);
+  static void Unwrap(SEXP sRowRank, std::unique_ptr<class RowRankFile> &rrFile, const unsigned int *&feNumOff, const double *&feNumVal, const unsigned int *&feRow, const unsigned int *&feRank, const unsigned int *&feRLE, unsigned int &feRLELength);
+  static List FileInfo(const class RowRankFile *rowRankFile, const std::string &path);
+  static uint64_t Fingerprint(const List &predBlock);
   static void Clear();
 };
 
@@ -32,15 +32,11 @@
 using namespace Rcpp;
 
 /**
-   @brief Row-sampling parameters supplied by the front end are invariant, so can be cached as static.
+   @brief Variates are drawn from R's generator, but mapped to rows by the sampler of the requesting training.  No sampling state is cached, so trainings do not interfere.
  */
 class RcppSample {
-  static unsigned int nRow;
-  static bool withRepl;
-  static NumericVector &weight;
 public:
-  static void Init(unsigned int _nRow, const double feWeight[], bool _withRepl);
-  static void SampleRows(unsigned int nSamp, int out[]);
+  static unsigned int SampleRows(const class RowSampler *rowSampler, unsigned int nSamp, int out[]);
 };
 
 #endif
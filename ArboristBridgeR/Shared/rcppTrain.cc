@@ -27,16 +27,33 @@
 using namespace Rcpp;
 
 #include "rcppRowrank.h"
+#include "rowrankfile.h"
 #include "rcppForest.h"
 #include "rcppLeaf.h"
 #include "train.h"
+#include "trainctx.h"
 #include "forest.h"
 #include "leaf.h"
 
+#include <memory>
+
 ////#include <iostream>
 //using namespace std;
 
 
+/**
+   @brief Draws a seed for the core generator from R's stream, so that
+   'set.seed()' continues to determine the trained forest.
+
+   @return 64-bit seed.
+ */
+uint64_t RcppSeed() {
+  RNGScope scope;
+  NumericVector rn(runif(2));
+  return (static_cast<uint64_t>(rn[0] * 4294967296.0) << 32) | static_cast<uint64_t>(rn[1] * 4294967296.0);
+}
+
+
 /**
    @brief R-language interface to response caching.
 
@@ -82,9 +99,13 @@ void RcppProxyCtg(IntegerVector y, NumericVector classWeight, std::vector<double
 
    @param sTotLevels is an upper bound on the number of levels to construct for each tree.
 
+   The training context is held by a guard, as stop() may unwind from
+   any point of the call.
+
    @return Wrapped length of forest vector, with output parameters.
  */
 RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sSplitQuant, SEXP sProbVec, SEXP sThinLeaves, SEXP sClassWeight) {
+  BEGIN_RCPP
   List predBlock(sPredBlock);
   if (!predBlock.inherits("PredBlock"))
     stop("Expecting PredBlock");
@@ -111,7 +132,20 @@ RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SE
   NumericVector predProb = NumericVector(sProbVec)[predMap];
   NumericVector splitQuant = NumericVector(sSplitQuant)[predMap];
 
-  Train::Init(nPred, nTree, as<unsigned int>(sNSamp), sampleWeight, as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), ctgWidth, as<unsigned int>(sPredFixed), splitQuant.begin(), predProb.begin(), as<bool>(sThinLeaves));
+  TrainOpt opt(nTree, as<unsigned int>(sNSamp), RcppSeed());
+  opt.withRepl = as<bool>(sWithRepl);
+  opt.trainBlock = as<unsigned int>(sTrainBlock);
+  opt.minNode = as<unsigned int>(sMinNode);
+  opt.minRatio = as<double>(sMinRatio);
+  opt.totLevels = as<unsigned int>(sTotLevels);
+  opt.predFixed = as<unsigned int>(sPredFixed);
+  opt.splitQuant = splitQuant.begin();
+  opt.predProb = predProb.begin();
+  opt.thinLeaves = as<bool>(sThinLeaves);
+  opt.ctgWidth = ctgWidth;
+  std::unique_ptr<TrainCtx> ctx(Train::Init(nPred, sampleWeight, opt));
+  if (!ctx)
+    stop("Inconsistent training parameters");
 
   std::vector<unsigned int> facCard(as<std::vector<unsigned int> >(predBlock["facCard"]));
   std::vector<unsigned int> origin(nTree);
@@ -126,11 +160,14 @@ RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SE
   std::vector<unsigned int> bagBits;
   std::vector<double> weight;
 
-  double *feNumVal;
-  unsigned int *feNumOff, *feRow, *feRank, *feRLE, rleLength;
-  RcppRowrank::Unwrap(sRowRank, feNumOff, feNumVal, feRow, feRank, feRLE, rleLength);
+  const double *feNumVal;
+  const unsigned int *feNumOff, *feRow, *feRank, *feRLE;
+  unsigned int rleLength;
+  std::unique_ptr<RowRankFile> rrFile;
+  RcppRowrank::Unwrap(sRowRank, rrFile, feNumOff, feNumVal, feRow, feRank, feRLE, rleLength);
 
-  Train::Classification(feRow, feRank, feNumOff, feNumVal, feRLE, rleLength, as<std::vector<unsigned int> >(y), ctgWidth, proxy, origin, facOrig, predInfo, facCard, forestNode, facSplit, leafOrigin, leafNode, bagLeaf, bagBits, weight);
+  Train::Classification(ctx.get(), feRow, feRank, feNumOff, feNumVal, feRLE, rleLength, as<std::vector<unsigned int> >(y), ctgWidth, proxy, origin, facOrig, predInfo, facCard, forestNode, facSplit, leafOrigin, leafNode, bagLeaf, bagBits, weight);
+  ctx.reset();
 
   RcppRowrank::Clear();
   
@@ -140,10 +177,18 @@ RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SE
       _["leaf"] = RcppLeaf::WrapCtg(leafOrigin, leafNode, bagLeaf, bagBits, weight, yOneBased.length(), CharacterVector(yOneBased.attr("levels"))),
       _["predInfo"] = infoOut[predMap] // Maps back from core order.
   );
+  END_RCPP
 }
 
 
+/**
+   @brief Constructs regression forest, guarding the training context as
+   above.
+
+   @return Wrapped forest, leaf and information vectors.
+ */
 RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sSplitQuant, SEXP sProbVec, SEXP sThinLeaves, SEXP sRegMono) {
+  BEGIN_RCPP
   List predBlock(sPredBlock);
   if (!predBlock.inherits("PredBlock"))
     stop("Expecting PredBlock");
@@ -162,11 +207,26 @@ RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTre
   NumericVector regMono = NumericVector(sRegMono)[predMap];
   NumericVector splitQuant = NumericVector(sSplitQuant)[predMap];
   
-  Train::Init(nPred, nTree, as<unsigned int>(sNSamp), sampleWeight, as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), 0, as<unsigned int>(sPredFixed), splitQuant.begin(), predProb.begin(), as<bool>(sThinLeaves), regMono.begin());
-
-  double *feNumVal;
-  unsigned int *feRow, *feNumOff, *feRank, *feRLE, rleLength;
-  RcppRowrank::Unwrap(sRowRank, feNumOff, feNumVal, feRow, feRank, feRLE, rleLength);
+  TrainOpt opt(nTree, as<unsigned int>(sNSamp), RcppSeed());
+  opt.withRepl = as<bool>(sWithRepl);
+  opt.trainBlock = as<unsigned int>(sTrainBlock);
+  opt.minNode = as<unsigned int>(sMinNode);
+  opt.minRatio = as<double>(sMinRatio);
+  opt.totLevels = as<unsigned int>(sTotLevels);
+  opt.predFixed = as<unsigned int>(sPredFixed);
+  opt.splitQuant = splitQuant.begin();
+  opt.predProb = predProb.begin();
+  opt.thinLeaves = as<bool>(sThinLeaves);
+  opt.regMono = regMono.begin();
+  std::unique_ptr<TrainCtx> ctx(Train::Init(nPred, sampleWeight, opt));
+  if (!ctx)
+    stop("Inconsistent training parameters");
+
+  const double *feNumVal;
+  const unsigned int *feRow, *feNumOff, *feRank, *feRLE;
+  unsigned int rleLength;
+  std::unique_ptr<RowRankFile> rrFile;
+  RcppRowrank::Unwrap(sRowRank, rrFile, feNumOff, feNumVal, feRow, feRank, feRLE, rleLength);
 
   NumericVector y(sY);
   NumericVector yOrdered = clone(y).sort();
@@ -184,7 +244,8 @@ RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTre
   std::vector<unsigned int> facSplit;
 
   const std::vector<unsigned int> facCard(as<std::vector<unsigned int> >(predBlock["facCard"]));
-  Train::Regression(feRow, feRank, feNumOff, feNumVal, feRLE, rleLength, as<std::vector<double> >(y), as<std::vector<unsigned int> >(row2Rank), origin, facOrig, predInfo, facCard, forestNode, facSplit, leafOrigin, leafNode, bagLeaf, bagBits);
+  Train::Regression(ctx.get(), feRow, feRank, feNumOff, feNumVal, feRLE, rleLength, as<std::vector<double> >(y), as<std::vector<unsigned int> >(row2Rank), origin, facOrig, predInfo, facCard, forestNode, facSplit, leafOrigin, leafNode, bagLeaf, bagBits);
+  ctx.reset();
 
   RcppRowrank::Clear();
 
@@ -195,4 +256,5 @@ RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTre
       _["leaf"] = RcppLeaf::WrapReg(leafOrigin, leafNode, bagLeaf, bagBits, as<std::vector<double> >(y)),
       _["predInfo"] = infoOut[predMap] // Maps back from core order.
     );
+  END_RCPP
 }
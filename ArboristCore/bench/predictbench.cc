@@ -0,0 +1,135 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictbench.cc
+
+   @brief Compares row-major forest traversal against tiled traversal,
+   over a range of tile sizes and both node formats, verifying identical
+   predictions and reporting rows per second.
+
+   Not part of any package build.  From this directory:
+
+     g++ -O2 -std=c++11 -fopenmp -ffunction-sections -Wl,--gc-sections -I.. predictbench.cc ../predict.cc ../forest.cc ../leaf.cc ../predblock.cc ../quant.cc ../bv.cc ../taskpool.cc -o predictbench
+     ./predictbench [nTree nLeaf nRow]
+
+   @author Mark Seligman
+ */
+
+#include "forest.h"
+#include "leaf.h"
+#include "predict.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+/**
+   @brief Grows a random tree by repeatedly splitting a random leaf, then
+   lays it out breadth-first, as trained trees are, with each node's
+   successors adjacent.
+
+   @return void, with nodes and leaves appended.
+ */
+static void RandomTree(std::mt19937 &gen, unsigned int nLeaf, unsigned int nPred, std::vector<ForestNode> &forestNode, std::vector<LeafNode> &leafNode) {
+  std::vector<unsigned int> left(1, 0); // Zero iff terminal.
+  std::vector<unsigned int> leaves(1, 0);
+  while (leaves.size() < nLeaf) {
+    unsigned int pick = gen() % leaves.size();
+    unsigned int parent = leaves[pick];
+    left[parent] = left.size();
+    leaves[pick] = left.size();
+    leaves.push_back(left.size() + 1);
+    left.insert(left.end(), 2, 0);
+  }
+
+  std::normal_distribution<double> norm;
+  std::vector<unsigned int> order(1, 0); // Breadth-first position -> node.
+  std::vector<unsigned int> position(left.size());
+  for (unsigned int i = 0; i < order.size(); i++) {
+    position[order[i]] = i;
+    if (left[order[i]] != 0) {
+      order.push_back(left[order[i]]);
+      order.push_back(left[order[i]] + 1);
+    }
+  }
+  unsigned int base = forestNode.size();
+  forestNode.resize(base + order.size());
+  unsigned int leafIdx = 0;
+  for (unsigned int i = 0; i < order.size(); i++) {
+    unsigned int node = order[i];
+    if (left[node] != 0) {
+      forestNode[base + i].SetNum(gen() % nPred, position[left[node]] - i, norm(gen));
+    }
+    else {
+      forestNode[base + i].SetNum(leafIdx++, 0, 0.0);
+      LeafNode leaf;
+      leaf.Init();
+      leaf.Score() = norm(gen);
+      leafNode.push_back(leaf);
+    }
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  unsigned int nTree = argc > 1 ? std::atoi(argv[1]) : 2000;
+  unsigned int nLeaf = argc > 2 ? std::atoi(argv[2]) : 2000;
+  unsigned int nRow = argc > 3 ? std::atoi(argv[3]) : 20000;
+  const unsigned int nPred = 20;
+
+  std::mt19937 gen(17);
+  std::vector<ForestNode> forestNode;
+  std::vector<LeafNode> leafNode;
+  std::vector<unsigned int> origin(nTree), leafOrigin(nTree), facOrigin(nTree, 0);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    origin[tIdx] = forestNode.size();
+    leafOrigin[tIdx] = leafNode.size();
+    RandomTree(gen, nLeaf, nPred, forestNode, leafNode);
+  }
+
+  std::normal_distribution<double> norm;
+  std::vector<double> numT(nRow * nPred);
+  for (auto &val : numT)
+    val = norm(gen);
+  std::vector<double> yTrain(nRow, 0.0);
+  std::vector<double> valNum;
+  std::vector<unsigned int> rowStart, runLength, predStart;
+
+  std::cout << "nTree " << nTree << ", nLeaf " << nLeaf << ", forest " << forestNode.size() * sizeof(ForestNode) / (1 << 20) << " MB, nRow " << nRow << std::endl;
+  const unsigned int tiles[][3] = { {0, 0, 0}, {32, 0, 0}, {64, 0, 0}, {128, 0, 0}, {256, 0, 0}, {128, 8, 0}, {128, 32, 0}, {128, 128, 0}, {0, 0, 1}, {128, 0, 1}, {256, 0, 1} };
+  // Built once, as on loading a forest, so not timed.
+  ForestCompact forestCompact(&forestNode[0], &origin[0], nTree, nPred);
+  std::vector<double> yRef;
+  bool same = true;
+  for (auto &tile : tiles) {
+    std::vector<double> yPred(nRow);
+    auto start = std::chrono::steady_clock::now();
+    Predict::Regression(valNum, rowStart, runLength, predStart, &numT[0], 0, nPred, 0, &forestNode[0], &origin[0], nTree, 0, 0, &facOrigin[0], nTree, leafOrigin, &leafNode[0], leafNode.size(), 0, yTrain, yPred, tile[0], tile[1], tile[2] != 0 ? &forestCompact : 0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const char *format = tile[2] != 0 ? "compact " : "";
+    if (yRef.empty()) {
+      yRef = yPred;
+    }
+    else {
+      same = same && yPred == yRef;
+    }
+    if (tile[0] == 0) {
+      std::cout << format << "row-major:  ";
+    }
+    else {
+      std::cout << format << "rowTile " << tile[0] << ", treeTile " << tile[1] << (tile[1] == 0 ? " (cache):  " : ":  ");
+    }
+    std::cout << nRow / seconds << " rows/s" << std::endl;
+  }
+  std::cout << (same ? "outputs identical" : "OUTPUTS DIFFER") << std::endl;
+
+  return same ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file presortbench.cc
+
+   @brief Compares the radix presort against the comparison presort,
+   verifying identical output and reporting timings.
+
+   Not part of any package build.  From this directory:
+
+     g++ -O2 -std=c++11 -fopenmp -I.. presortbench.cc ../rowrank.cc -o presortbench
+     ./presortbench [nRow nPred]
+
+   @author Mark Seligman
+ */
+
+#include "rowrank.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+/**
+   @brief Times a single presort invocation.
+
+   @return wall-clock seconds.
+ */
+template<typename Sorter>
+static double Time(Sorter sorter) {
+  auto start = std::chrono::steady_clock::now();
+  sorter();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char *argv[]) {
+  unsigned int nRow = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  unsigned int nPred = argc > 2 ? std::atoi(argv[2]) : 16;
+  const unsigned int cardMax = 40;
+
+  // Mixes continuous columns with coarsely-rounded ones, so that ties,
+  // runs and signed zeroes are exercised.
+  std::mt19937 gen(17);
+  std::normal_distribution<double> norm;
+  std::vector<double> feNum(size_t(nRow) * nPred);
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    for (unsigned int row = 0; row < nRow; row++) {
+      double val = norm(gen);
+      feNum[size_t(predIdx) * nRow + row] = predIdx % 2 == 0 ? val : std::round(4.0 * val) * 0.25;
+    }
+  }
+  std::vector<unsigned int> feFac(size_t(nRow) * nPred);
+  for (auto & code : feFac) {
+    code = gen() % cardMax;
+  }
+
+  bool same = true;
+  std::vector<unsigned int> row[2], rank[2], rle[2], numOff[2];
+  std::vector<double> num[2];
+  double numTime[2], facTime[2];
+  for (int radix = 0; radix < 2; radix++) {
+    numOff[radix] = std::vector<unsigned int>(nPred);
+    numTime[radix] = Time([&] { RowRank::PreSortNum(&feNum[0], nPred, nRow, row[radix], rank[radix], rle[radix], numOff[radix], num[radix], radix == 1); });
+  }
+  same = same && row[0] == row[1] && rank[0] == rank[1] && rle[0] == rle[1] && numOff[0] == numOff[1] && num[0] == num[1];
+
+  for (int radix = 0; radix < 2; radix++) {
+    row[radix].clear();
+    rank[radix].clear();
+    rle[radix].clear();
+    facTime[radix] = Time([&] { RowRank::PreSortFac(&feFac[0], nPred, nRow, row[radix], rank[radix], rle[radix], radix == 1); });
+  }
+  same = same && row[0] == row[1] && rank[0] == rank[1] && rle[0] == rle[1];
+
+  std::cout << "nRow " << nRow << ", nPred " << nPred << std::endl;
+  std::cout << "numeric:  comparison " << numTime[0] << "s, radix " << numTime[1] << "s" << std::endl;
+  std::cout << "factor:  comparison " << facTime[0] << "s, counting " << facTime[1] << "s" << std::endl;
+  std::cout << (same ? "outputs identical" : "OUTPUTS DIFFER") << std::endl;
+
+  return same ? 0 : 1;
+}
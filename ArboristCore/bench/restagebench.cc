@@ -0,0 +1,153 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file restagebench.cc
+
+   @brief Compares per-sample restaging against block-wise stream
+   compaction, in both buffer layouts, verifying identical output and
+   reporting throughput.
+
+   Not part of any package build.  From this directory:
+
+     g++ -O2 -std=c++11 -fopenmp -I.. restagebench.cc ../samplepred.cc ../path.cc ../pathcompact.cc ../bv.cc -o restagebench
+     ./restagebench [nSamp nRep]
+
+   @author Mark Seligman
+ */
+
+#include "samplepred.h"
+#include "path.h"
+#include "pathcompact.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+/**
+   @brief Restages the root column repeatedly from buffer zero into
+   buffer one, then checks the latter against the expected partition.
+
+   @param block is true iff the block-wise kernels are to be timed.
+
+   @param ndx is true iff node-relative indices are restaged.
+
+   @return true iff output matches expectation.
+ */
+template<typename Layout>
+static bool Restage(SamplePred *samplePred, IdxPath *stPath, unsigned int nSamp, unsigned int nRep, unsigned int leftCount, bool block, bool ndx, const std::vector<unsigned int> &refIdx, const std::vector<unsigned int> &refRank, double &seconds) {
+  const unsigned int reachBase[2] = { 0, leftCount };
+  unsigned int reachOffset[2];
+  Layout targ;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int rep = 0; rep < nRep; rep++) {
+    reachOffset[0] = reachBase[0];
+    reachOffset[1] = reachBase[1];
+    if (ndx) {
+      targ = block ? samplePred->RestageNdxOne<Layout>(reachOffset, reachBase, 0, 0, stPath, 1, 0, nSamp) : samplePred->RestageNdxGen<Layout>(reachOffset, reachBase, 0, 0, stPath, 1, 0, nSamp);
+    }
+    else {
+      targ = block ? samplePred->RestageStxOne<Layout>(reachOffset, 0, 0, stPath, 1, 0, nSamp, false) : samplePred->RestageStxGen<Layout>(reachOffset, 0, 0, stPath, 1, 0, nSamp, false);
+    }
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / nRep;
+
+  unsigned int *idxTarg;
+  samplePred->Buffers(0, 1, targ, idxTarg);
+  bool same = reachOffset[1] == refIdx.size();
+  for (unsigned int idx = 0; same && idx < refIdx.size(); idx++) {
+    same = idxTarg[idx] == refIdx[idx] && targ[idx].Rank() == refRank[idx];
+  }
+
+  return same;
+}
+
+
+int main(int argc, char *argv[]) {
+  unsigned int nSamp = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  unsigned int nRep = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  // Roughly one sample in twenty goes extinct, as when a sibling has
+  // become terminal.
+  std::mt19937 gen(17);
+  std::vector<StagePack> stagePack(nSamp);
+  for (unsigned int idx = 0; idx < nSamp; idx++) {
+    stagePack[idx].Init(idx, gen() % nSamp, 1 + gen() % 3, 0, FltVal(gen() % 1000) * 0.01);
+  }
+  IdxPath *stPath = new IdxPath(nSamp);
+  std::vector<unsigned int> path(nSamp);
+  unsigned int leftCount = 0;
+  unsigned int ndOff[2] = { 0, 0 };
+  for (unsigned int idx = 0; idx < nSamp; idx++) {
+    path[idx] = gen() % 20 == 0 ? NodePath::noPath : gen() & 1;
+    unsigned int off = path[idx] == NodePath::noPath ? 0 : ndOff[path[idx]]++;
+    stPath->Set(idx, path[idx], idx, off & 0xffff);
+    leftCount += path[idx] == 0 ? 1 : 0;
+  }
+
+  // Expected partition, with left successor preceding right.
+  std::vector<unsigned int> stxIdx, ndxIdx;
+  for (unsigned int side = 0; side < 2; side++) {
+    unsigned int sideOff = 0;
+    for (unsigned int idx = 0; idx < nSamp; idx++) {
+      if (path[idx] == side) {
+        stxIdx.push_back(idx);
+        ndxIdx.push_back((side == 0 ? 0 : leftCount) + (sideOff++ & 0xffff));
+      }
+    }
+  }
+  std::vector<unsigned int> refRank(stxIdx.size());
+
+  bool same = true;
+  std::cout << "nSamp " << nSamp << ", kernel " << PathCompact::Kernel() << std::endl;
+  for (int columnar = 0; columnar < 2; columnar++) {
+    SamplePred *samplePred = SamplePred::Factory(1, nSamp, nSamp, 0, columnar == 1);
+    samplePred->Stage(stagePack, 0, 0, nSamp);
+
+    // Ranks are read back from the staged buffer, in expected order.
+    unsigned int *idxSource;
+    std::vector<unsigned int> rankStaged(nSamp);
+    if (columnar == 1) {
+      SPCol source;
+      samplePred->Buffers(0, 0, source, idxSource);
+      for (unsigned int idx = 0; idx < nSamp; idx++)
+        rankStaged[idxSource[idx]] = source[idx].Rank();
+    }
+    else {
+      SPRow source;
+      samplePred->Buffers(0, 0, source, idxSource);
+      for (unsigned int idx = 0; idx < nSamp; idx++)
+        rankStaged[idxSource[idx]] = source[idx].Rank();
+    }
+    for (unsigned int idx = 0; idx < stxIdx.size(); idx++) {
+      refRank[idx] = rankStaged[stxIdx[idx]];
+    }
+
+    for (int ndx = 0; ndx < 2; ndx++) {
+      double seconds[2];
+      for (int block = 0; block < 2; block++) {
+        if (columnar == 1) {
+          same = Restage<SPCol>(samplePred, stPath, nSamp, nRep, leftCount, block == 1, ndx == 1, ndx == 1 ? ndxIdx : stxIdx, refRank, seconds[block]) && same;
+        }
+        else {
+          same = Restage<SPRow>(samplePred, stPath, nSamp, nRep, leftCount, block == 1, ndx == 1, ndx == 1 ? ndxIdx : stxIdx, refRank, seconds[block]) && same;
+        }
+      }
+      // Each sample moves a twelve-byte node and a four-byte index.
+      double bytes = 16.0 * nSamp;
+      std::cout << (columnar == 1 ? "column" : "row") << (ndx == 1 ? " ndx" : " stx") << ":  per-sample " << bytes / seconds[0] * 1.0e-9 << " GB/s, block " << bytes / seconds[1] * 1.0e-9 << " GB/s" << std::endl;
+    }
+    delete samplePred;
+  }
+  std::cout << (same ? "outputs identical" : "OUTPUTS DIFFER") << std::endl;
+  delete stPath;
+
+  return same ? 0 : 1;
+}
@@ -25,6 +25,8 @@
 #include "runset.h"
 #include "rowrank.h"
 #include "path.h"
+#include "trainctx.h"
+#include "taskpool.h"
 
 #include <numeric>
 #include <algorithm>
@@ -38,17 +40,21 @@
 
 /**
    @brief Static entry for regression.
+
+   @param _nOut is the number of response outputs.
+
+   @param _sumOut holds the per-sample output sums:  null iff single output.
  */
-Bottom *Bottom::FactoryReg(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, unsigned int _bagCount) {
-  return new Bottom(_pmTrain, _samplePred, new SPReg(_pmTrain, _rowRank, _samplePred, _bagCount), _bagCount, _rowRank->SafeSize(_bagCount));
+Bottom *Bottom::FactoryReg(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, const Sample *_sample, SamplePred *_samplePred, unsigned int _bagCount, unsigned int _tIdx, unsigned int _nOut, const double _sumOut[]) {
+  return new Bottom(_ctx, _pmTrain, _rowRank, _sample, _samplePred, new SPReg(_ctx, _pmTrain, _rowRank, _samplePred, _bagCount, _tIdx, 0, _nOut, _sumOut), _bagCount);
 }
 
 
 /**
    @brief Static entry for classification.
  */
-Bottom *Bottom::FactoryCtg(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, const std::vector<SampleNode> &_sampleCtg, unsigned int _bagCount) {
-  return new Bottom(_pmTrain, _samplePred, new SPCtg(_pmTrain, _rowRank, _samplePred, _sampleCtg, _bagCount), _bagCount, _rowRank->SafeSize(_bagCount));
+Bottom *Bottom::FactoryCtg(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, const Sample *_sample, SamplePred *_samplePred, const std::vector<SampleNode> &_sampleCtg, unsigned int _bagCount, unsigned int _tIdx) {
+  return new Bottom(_ctx, _pmTrain, _rowRank, _sample, _samplePred, new SPCtg(_ctx, _pmTrain, _rowRank, _samplePred, _sampleCtg, _bagCount, _tIdx), _bagCount);
 }
 
 
@@ -57,10 +63,13 @@ Bottom *Bottom::FactoryCtg(const PMTrain *_pmTrain, const RowRank *_rowRank, Sam
 
    @param bagCount enables sizing of predicate bit vectors.
 
+   @param _sample stages predictors not staged at the root.
+
    @param splitCount specifies the number of splits to map.
  */
-Bottom::Bottom(const PMTrain *_pmTrain, SamplePred *_samplePred, SplitPred *_splitPred, unsigned int _bagCount, unsigned int _stageSize) : nPred(_pmTrain->NPred()), nPredFac(_pmTrain->NPredFac()), bagCount(_bagCount), termST(std::vector<unsigned int>(bagCount)), nodeRel(false), prePath(std::vector<unsigned int>(_stageSize)), stPath(new IdxPath(bagCount)), splitPrev(0), splitCount(1), pmTrain(_pmTrain), samplePred(_samplePred), splitPred(_splitPred), splitSig(new SplitSig(nPred)), run(splitPred->Runs()), replayExpl(new BV(bagCount)), history(std::vector<unsigned int>(0)), levelDelta(std::vector<unsigned char>(nPred)), levelFront(new Level(1, nPred, bagCount, bagCount, nodeRel)) {
+Bottom::Bottom(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, const Sample *_sample, SamplePred *_samplePred, SplitPred *_splitPred, unsigned int _bagCount) : ctx(_ctx), nPred(_pmTrain->NPred()), nPredFac(_pmTrain->NPredFac()), bagCount(_bagCount), termST(std::vector<unsigned int>(bagCount)), nodeRel(false), stPath(new IdxPath(bagCount)), splitPrev(0), splitCount(1), pmTrain(_pmTrain), rowRank(_rowRank), sample(_sample), samplePred(_samplePred), splitPred(_splitPred), splitSig(new SplitSig(nPred)), run(splitPred->Runs()), replayExpl(new BV(bagCount)), history(std::vector<unsigned int>(0)), levelDelta(std::vector<unsigned char>(nPred)), levelFront(new Level(1, nPred, bagCount, bagCount, nodeRel)), staged(std::vector<unsigned char>(nPred)) {
   level.push_front(levelFront);
+  std::fill(staged.begin(), staged.end(), 0);
   levelFront->Ancestor(0, 0, bagCount);
   std::fill(levelDelta.begin(), levelDelta.end(), 0);
 
@@ -78,7 +87,39 @@ Bottom::Bottom(const PMTrain *_pmTrain, SamplePred *_samplePred, SplitPred *_spl
   // This is the only time that the denseCount is assigned outside of
   // restaging:
 void Bottom::RootDef(unsigned int predIdx, unsigned int denseCount) {
-  levelFront->Define(0, predIdx, IsFactor(predIdx) ? (pmTrain->FacCard(predIdx) + (denseCount > 0 ? 1 : 0)) : 0, 0, denseCount);
+  RootDef(predIdx, denseCount, IsFactor(predIdx) ? (pmTrain->FacCard(predIdx) + (denseCount > 0 ? 1 : 0)) : 0);
+}
+
+
+/**
+   @brief As above, but with run count specified by the caller.  Local
+   subtrees inherit the count reaching their root in the tree proper.
+
+   @return void.
+ */
+void Bottom::RootDef(unsigned int predIdx, unsigned int denseCount, unsigned int runCount) {
+  staged[predIdx] = 1;
+  levelFront->Define(0, predIdx, runCount, 0, denseCount);
+}
+
+
+/**
+   @brief Builds the bottom of a subtree to be completed locally,
+   splitting as the tree proper does.
+
+   @param _samplePred holds the subtree's staged contents.
+
+   @param stageSample holds the subtree's samples, in local order.
+
+   @param local2ST maps each local sample to its subtree index in the
+   tree proper.
+
+   @param subKey is the pretree index of the subtree root.
+
+   @return new bottom, owned by the subtree.
+ */
+Bottom *Bottom::Spawn(SamplePred *_samplePred, const std::vector<SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int subKey) const {
+  return new Bottom(ctx, pmTrain, rowRank, 0, _samplePred, splitPred->Spawn(_samplePred, stageSample, local2ST, subKey), stageSample.size());
 }
 
   
@@ -164,12 +205,40 @@ void Bottom::Reindex(IndexLevel *indexLevel) {
    @return vector of splitting signatures, possibly empty, for each node passed.
  */
 void Bottom::Split(IndexLevel &index, std::vector<SSNode*> &argMax) {
+  Schedule(index);
+  Restage();
+  Stage(index);
+  splitPred->Split(index);
+
+  return ArgMax(index, argMax);
+}
+
+
+/**
+   @brief Schedules the current level's restaging and splitting.
+
+   @return void, with populated restaging and splitting schedules.
+ */
+void Bottom::Schedule(IndexLevel &index) {
   LevelInit();
-  unsigned int supUnFlush = FlushRear();
+  supUnFlush = FlushRear();
   splitPred->LevelInit(index);
+  for (auto levelIdx : index.HandoffNodes()) {
+    ScheduleHandoff(levelIdx);
+  }
 
   Backdate();
-  Restage();
+}
+
+
+/**
+   @brief Stages lazily-scheduled predictors, then retires the levels
+   flushed by the current schedule.
+
+   @return void.
+ */
+void Bottom::Stage(const IndexLevel &index) {
+  StageFront(index);
 
   // Source levels must persist through restaging ut allow path lookup.
   //
@@ -177,24 +246,66 @@ void Bottom::Split(IndexLevel &index, std::vector<SSNode*> &argMax) {
     delete level[off];
     level.pop_back();
   }
+}
 
-  splitPred->Split(index);
 
-  return ArgMax(index, argMax);
+/**
+   @brief Builds the level's split tasks, once restaging has completed.
+
+   @return void.
+ */
+void Bottom::SplitPrepare(const IndexLevel &index) {
+  splitPred->SplitPrepare(index);
 }
 
 
-void Bottom::ArgMax(const IndexLevel &index, std::vector<SSNode*> &argMax) {
-  unsigned int levelCount = argMax.size();
+/**
+   @brief Accessor for the size of the level's split task list.
+
+   @return count of split tasks.
+ */
+unsigned int Bottom::TaskCount() const {
+  return splitPred->TaskCount();
+}
+
+
+/**
+   @brief Accessor for the estimated cost of a split task.
+
+   @return cost estimate.
+ */
+unsigned int Bottom::TaskCost(unsigned int taskIdx) const {
+  return splitPred->TaskCost(taskIdx);
+}
+
+
+/**
+   @brief Executes a single split task.
+
+   @param taskIdx is the task's position within the list.
+
+   @return void.
+ */
+void Bottom::SplitTask(unsigned int taskIdx) {
+  splitPred->SplitTask(taskIdx);
+}
 
-  unsigned int levelIdx;
-#pragma omp parallel default(shared) private(levelIdx)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+
+/**
+   @brief Reduces the level's segmented scans, once all tasks have
+   completed.
+
+   @return void.
+ */
+void Bottom::SplitReduce() {
+  splitPred->SplitReduce();
+}
+
+
+void Bottom::ArgMax(const IndexLevel &index, std::vector<SSNode*> &argMax) {
+  ctx->taskPool->Run(argMax.size(), [&](unsigned int levelIdx) {
       argMax[levelIdx] = splitSig->ArgMax(levelIdx, index.MinInfo(levelIdx));
-    }
-  }
+    }, nPred);
 }
 
 
@@ -373,12 +484,194 @@ Level::~Level() {
    @return true iff the front-level definition is a singleton.
  */
 bool Bottom::ScheduleSplit(unsigned int levelIdx, unsigned int predIdx, unsigned int &runCount, unsigned int &bufIdx) {
+  if (!staged[predIdx]) {
+    StageDef(predIdx);
+  }
   DefForward(levelIdx, predIdx);
 
   return !levelFront->Singleton(levelIdx, predIdx, runCount, bufIdx);
 }
 
 
+/**
+   @brief Brings every predictor forward to a node about to be completed
+   as a local subtree, so that the node's cells are current once
+   restaging completes.
+
+   @param levelIdx is the node's index within the front level.
+
+   @return void.
+ */
+void Bottom::ScheduleHandoff(unsigned int levelIdx) {
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    if (!staged[predIdx]) {
+      StageDef(predIdx);
+    }
+    DefForward(levelIdx, predIdx);
+  }
+}
+
+
+/**
+   @brief Packs the explicit contents of a front-level cell for staging
+   within a local subtree.  Singletons are left unpacked, as their
+   buffers are not restaged.
+
+   @param idxStart is the node's starting buffer index.
+
+   @param extent is the node's index count.
+
+   @param buf2Local maps buffered indices to subtree-local indices.
+
+   @param stagePack outputs the packed cell, in rank order.
+
+   @param denseCount outputs the number of implicit indices in the cell.
+
+   @return run count of the front-level definition.
+ */
+unsigned int Bottom::Pack(unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &buf2Local, std::vector<StagePack> &stagePack, unsigned int &denseCount) const {
+  unsigned int runCount, bufIdx;
+  bool singleton = levelFront->Singleton(levelIdx, predIdx, runCount, bufIdx);
+  denseCount = AdjustDense(levelIdx, predIdx, idxStart, extent);
+  if (!singleton) {
+    samplePred->Pack(predIdx, bufIdx, idxStart, extent, buf2Local, stagePack);
+  }
+
+  return runCount;
+}
+
+
+/**
+   @brief Defines a lazily-staged predictor at every node of the front
+   level, reserving its buffers.  Staging itself is deferred until
+   scheduling completes.
+
+   Run counts are those conveyed by a root definition, so that splitting
+   proceeds just as if the predictor had been staged at the root and
+   left unrestaged until now.
+
+   @param predIdx is the predictor index.
+
+   @return void.
+ */
+void Bottom::StageDef(unsigned int predIdx) {
+  staged[predIdx] = 1;
+  stageFront.push_back(predIdx);
+
+  unsigned int extent;
+  (void) rowRank->SafeOffset(predIdx, bagCount, extent);
+  samplePred->Allocate(predIdx, extent);
+
+  unsigned int runCount = 0;
+  if (IsFactor(predIdx)) {
+    runCount = pmTrain->FacCard(predIdx) + (sample->ImplicitCount(rowRank, predIdx) > 0 ? 1 : 0);
+  }
+  for (unsigned int levelIdx = 0; levelIdx < splitCount; levelIdx++) {
+    AddDef(levelIdx, predIdx, runCount, 0);
+  }
+}
+
+
+/**
+   @brief Stages those predictors first scheduled at the current level.
+
+   @param index holds the front-level index sets.
+
+   @return void.
+ */
+void Bottom::StageFront(const IndexLevel &index) {
+  if (stageFront.empty())
+    return;
+
+  std::vector<unsigned int> stNode(bagCount);
+  std::vector<unsigned int> stIdx(bagCount);
+  std::fill(stNode.begin(), stNode.end(), splitCount); // Extinct.
+  index.FrontMap(stNode, stIdx);
+  if (!nodeRel) { // Buffers record subtree indices.
+    std::iota(stIdx.begin(), stIdx.end(), 0);
+  }
+
+  ctx->taskPool->Run(stageFront.size(), [&](unsigned int stageIdx) {
+      StageFront(index, stageFront[stageIdx], stNode, stIdx);
+    }, bagCount);
+
+  stageFront.clear();
+}
+
+
+/**
+   @brief Stages a predictor directly into the front level's node
+   layout, as though restaged from the root.
+
+   @param stNode maps each subtree index to its front-level node, if live.
+
+   @param stIdx maps each live subtree index to its buffered index.
+
+   @return void.
+ */
+void Bottom::StageFront(const IndexLevel &index, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx) {
+  std::vector<StagePack> stagePack;
+  sample->Pack(rowRank, predIdx, stagePack);
+
+  std::vector<unsigned int> explCount(splitCount);
+  std::fill(explCount.begin(), explCount.end(), 0);
+  for (auto & pack : stagePack) {
+    unsigned int levelIdx = stNode[pack.SIdx()];
+    if (levelIdx < splitCount) {
+      explCount[levelIdx]++;
+    }
+  }
+
+  // Implicit indices, if any, are packed away from each node as dense
+  // restaging would have done.  Nodes are visited in buffer order so
+  // that no node's explicit indices overrun its successor.
+  //
+  std::vector<unsigned int> idxOff(splitCount);
+  if (stagePack.size() < bagCount) {
+    std::vector<unsigned int> byStart(splitCount);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::sort(byStart.begin(), byStart.end(), [&index](unsigned int a, unsigned int b) { return index.StartIdx(a) < index.StartIdx(b); });
+    unsigned int idxLeft = 0;
+    for (auto levelIdx : byStart) {
+      levelFront->SetDense(levelIdx, predIdx, index.StartIdx(levelIdx) - idxLeft, index.Extent(levelIdx) - explCount[levelIdx]);
+      idxOff[levelIdx] = idxLeft;
+      idxLeft += explCount[levelIdx];
+    }
+  }
+  else {
+    for (unsigned int levelIdx = 0; levelIdx < splitCount; levelIdx++) {
+      idxOff[levelIdx] = index.StartIdx(levelIdx);
+    }
+  }
+  if (samplePred->Columnar()) {
+    StageColumn<SPCol>(index, predIdx, stagePack, stNode, stIdx, idxOff);
+  }
+  else {
+    StageColumn<SPRow>(index, predIdx, stagePack, stNode, stIdx, idxOff);
+  }
+}
+
+
+/**
+   @brief Scatters a predictor's explicit indices in the layout specified
+   and sets run counts of the nodes staged.
+
+   @param idxOff holds the starting buffer offset of each node.
+
+   @return void.
+ */
+template<typename Layout> void Bottom::StageColumn(const IndexLevel &index, unsigned int predIdx, const std::vector<StagePack> &stagePack, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff) {
+  Layout targ = samplePred->Stage<Layout>(stagePack, predIdx, stNode, stIdx, idxOff);
+
+  // Root definitions are not examined for runs until restaged.
+  if (index.Level() > 0) {
+    for (unsigned int levelIdx = 0; levelIdx < splitCount; levelIdx++) {
+      SetRuns(levelIdx, predIdx, index.StartIdx(levelIdx), index.Extent(levelIdx), targ);
+    }
+  }
+}
+
+
 /**
    @brief Finds definition reaching coordinate pair at current level,
    flushing ancestor if necessary.
@@ -401,20 +694,47 @@ void Bottom::DefForward(unsigned int levelIdx, unsigned int predIdx) {
    @return void, with side-effected restaging buffers.
  */
 void Bottom::Restage() {
-  int nodeIdx;
-
-#pragma omp parallel default(shared) private(nodeIdx)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (nodeIdx = 0; nodeIdx < int(restageCoord.size()); nodeIdx++) {
-      Restage(restageCoord[nodeIdx]);
-    }
+  std::vector<unsigned int> cost(restageCoord.size());
+  for (unsigned int rsIdx = 0; rsIdx < cost.size(); rsIdx++) {
+    cost[rsIdx] = RestageCost(rsIdx);
   }
+  ctx->taskPool->Run(cost, [this](unsigned int rsIdx) {
+      Restage(restageCoord[rsIdx]);
+    });
 
   restageCoord.clear();
 }
 
 
+/**
+   @brief Estimates the cost of restaging a scheduled pair.
+
+   @return extent of the pair's reaching definition.
+ */
+unsigned int Bottom::RestageCost(unsigned int rsIdx) const {
+  unsigned int del, runCount, bufIdx;
+  SPPair mrra;
+  restageCoord[rsIdx].Ref(mrra, del, runCount, bufIdx);
+
+  unsigned int startIdx, extent;
+  Bounds(mrra, del, startIdx, extent);
+  return extent;
+}
+
+
+/**
+   @brief Restages a single scheduled pair.  Pairs are independent,
+   so may be interleaved with those of other trees.
+
+   @param rsIdx is the pair's position within the restaging schedule.
+
+   @return void.
+ */
+void Bottom::Restage(unsigned int rsIdx) {
+  Restage(restageCoord[rsIdx]);
+}
+
+
 /**
    @brief General, multi-level restaging.
  */
@@ -423,16 +743,20 @@ void Bottom::Restage(RestageCoord &rsCoord) {
   SPPair mrra;
   rsCoord.Ref(mrra, del, runCount, bufIdx);
 
-  SPNode *targ = Restage(mrra, bufIdx, del);
-  RunCounts(targ, mrra, del);
+  if (samplePred->Columnar()) {
+    Restage<SPCol>(mrra, bufIdx, del);
+  }
+  else {
+    Restage<SPRow>(mrra, bufIdx, del);
+  }
 }
 
 
 /**
-   @brief Restaging dispatch mechanism.
+   @brief Restaging dispatch mechanism, specialized by buffer layout.
  */
-SPNode *Bottom::Restage(SPPair mrra, unsigned int bufIdx, unsigned int del) {
-  SPNode *targ;
+template<typename Layout> void Bottom::Restage(const SPPair &mrra, unsigned int bufIdx, unsigned int del) {
+  Layout targ;
   unsigned int startIdx, extent;
   Bounds(mrra, del, startIdx, extent);
   
@@ -441,30 +765,30 @@ SPNode *Bottom::Restage(SPPair mrra, unsigned int bufIdx, unsigned int del) {
     unsigned int reachBase[1 << NodePath::pathMax];
     OffsetClone(mrra, del, reachOffset, reachBase);
     if (IsDense(mrra, del)) {
-      targ = RestageNdxDense(reachOffset, reachBase, mrra, bufIdx, del);
+      targ = RestageNdxDense<Layout>(reachOffset, reachBase, mrra, bufIdx, del);
     }
     else if (del == 1) {
-      targ = samplePred->RestageNdxOne(reachOffset, reachBase, mrra.second, bufIdx, FrontPath(1), PathMask(1), startIdx, extent);
+      targ = samplePred->RestageNdxOne<Layout>(reachOffset, reachBase, mrra.second, bufIdx, FrontPath(1), PathMask(1), startIdx, extent);
     }
     else {
-      targ = samplePred->RestageNdxGen(reachOffset, reachBase, mrra.second, bufIdx, FrontPath(del), PathMask(del), startIdx, extent);
+      targ = samplePred->RestageNdxGen<Layout>(reachOffset, reachBase, mrra.second, bufIdx, FrontPath(del), PathMask(del), startIdx, extent);
     }
   }
   else { // Source level employs subtree indexing.  Target may or may not.
     OffsetClone(mrra, del, reachOffset);
     if (IsDense(mrra, del)) {
-      targ = RestageStxDense(reachOffset, mrra, bufIdx, del);
+      targ = RestageStxDense<Layout>(reachOffset, mrra, bufIdx, del);
     }
     else if (del == 1) {
-      targ = samplePred->RestageStxOne(reachOffset, mrra.second, bufIdx, stPath, PathMask(1), startIdx, extent, nodeRel);
+      targ = samplePred->RestageStxOne<Layout>(reachOffset, mrra.second, bufIdx, stPath, PathMask(1), startIdx, extent, nodeRel);
 
     }
     else {
-      targ = samplePred->RestageStxGen(reachOffset, mrra.second, bufIdx, stPath, PathMask(del), startIdx, extent, nodeRel);
+      targ = samplePred->RestageStxGen<Layout>(reachOffset, mrra.second, bufIdx, stPath, PathMask(del), startIdx, extent, nodeRel);
     }
   }
 
-  return targ;
+  RunCounts(targ, mrra, del);
 }
 
 
@@ -497,19 +821,19 @@ unsigned int Level::DiagRestage(const SPPair &mrra, unsigned int reachOffset[])
    in the case of dense ranks, as cell sizes are not derivable directly
    from index nodes.
  */
-SPNode *Bottom::RestageNdxDense(unsigned int reachOffset[], const unsigned int reachBase[], const SPPair &mrra, unsigned int bufIdx, unsigned int del) {
+template<typename Layout> Layout Bottom::RestageNdxDense(unsigned int reachOffset[], const unsigned int reachBase[], const SPPair &mrra, unsigned int bufIdx, unsigned int del) {
   IdxPath *frontPath = FrontPath(del);
   unsigned int pathMask = PathMask(del);
   unsigned int startIdx, extent;
   Bounds(mrra, del, startIdx, extent);
   
-  unsigned int *ppBlock = &prePath[samplePred->StageOffset(mrra.second)];
+  unsigned int *ppBlock = samplePred->PathBlock(mrra.second);
   unsigned int pathCount[1 << NodePath::pathMax];
   for (unsigned int path = 0; path < level[del]->BackScale(1); path++) {
     pathCount[path] = 0;
   }
 
-  SPNode *source, *targ;
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(mrra, bufIdx, source, idxSource, targ, idxTarg);
   for (unsigned int idx = startIdx; idx < startIdx + extent; idx++) {
@@ -534,7 +858,7 @@ SPNode *Bottom::RestageNdxDense(unsigned int reachOffset[], const unsigned int r
     unsigned int path = ppBlock[idx];
     if (path != NodePath::noPath) {
       unsigned int destIdx = reachOffset[path]++;
-      targ[destIdx] = source[idx];
+      targ.Move(destIdx, source, idx);
       idxTarg[destIdx] = idxSource[idx];
     }
   }
@@ -548,7 +872,7 @@ SPNode *Bottom::RestageNdxDense(unsigned int reachOffset[], const unsigned int r
    in the case of dense ranks, as cell sizes are not derivable directly
    from index nodes.
  */
-SPNode *Bottom::RestageStxDense(unsigned int reachOffset[], const SPPair &mrra, unsigned int bufIdx, unsigned int del) {
+template<typename Layout> Layout Bottom::RestageStxDense(unsigned int reachOffset[], const SPPair &mrra, unsigned int bufIdx, unsigned int del) {
 
   // Decomposition into two paths adds ~5% performance penalty, but
   // is necessary for dense packing or for coprocessor loading.
@@ -557,13 +881,13 @@ SPNode *Bottom::RestageStxDense(unsigned int reachOffset[], const SPPair &mrra,
   unsigned int startIdx, extent;
   Bounds(mrra, del, startIdx, extent);
 
-  unsigned int *ppBlock = &prePath[samplePred->StageOffset(mrra.second)];
+  unsigned int *ppBlock = samplePred->PathBlock(mrra.second);
   unsigned int pathCount[1 << NodePath::pathMax];
   for (unsigned int path = 0; path < level[del]->BackScale(1); path++) {
     pathCount[path] = 0;
   }
 
-  SPNode *source, *targ;
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(mrra, bufIdx, source, idxSource, targ, idxTarg);
   for (unsigned int idx = startIdx; idx < startIdx + extent; idx++) {
@@ -586,7 +910,7 @@ SPNode *Bottom::RestageStxDense(unsigned int reachOffset[], const SPPair &mrra,
     unsigned int path = ppBlock[idx];
     if (path != NodePath::noPath) {
       unsigned int destIdx = reachOffset[path]++;
-      targ[destIdx] = source[idx];
+      targ.Move(destIdx, source, idx);
       idxTarg[destIdx] = idxSource[idx];
     }
   }
@@ -654,7 +978,7 @@ void Level::OffsetClone(const SPPair &mrra, unsigned int reachOffset[], unsigned
 
    @return void.
  */
-void Bottom::Buffers(const SPPair &mrra, unsigned int bufIdx, SPNode *&source, unsigned int *&idxSource, SPNode *&targ, unsigned int *&idxTarg) const {
+template<typename Layout> void Bottom::Buffers(const SPPair &mrra, unsigned int bufIdx, Layout &source, unsigned int *&idxSource, Layout &targ, unsigned int *&idxTarg) const {
   samplePred->Buffers(mrra.second, bufIdx, source, idxSource, targ, idxTarg);
 }
 
@@ -665,7 +989,7 @@ void Bottom::Buffers(const SPPair &mrra, unsigned int bufIdx, SPNode *&source, u
 
    @return void.
  */
-void Level::RunCounts(const SPNode targ[], const SPPair &mrra, const Bottom *bottom) const {
+template<typename Layout> void Level::RunCounts(const Layout &targ, const SPPair &mrra, const Bottom *bottom) const {
   unsigned int predIdx = mrra.second;
   const NodePath *pathPos = &nodePath[BackScale(mrra.first)];
   for (unsigned int path = 0; path < BackScale(1); path++) {
@@ -683,7 +1007,7 @@ void Level::RunCounts(const SPNode targ[], const SPPair &mrra, const Bottom *bot
 
    @return void.
  */
-void Level::SetRuns(const Bottom *bottom, unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int extent, const SPNode *targ) {
+template<typename Layout> void Level::SetRuns(const Bottom *bottom, unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int extent, const Layout &targ) {
   MRRA &reach = def[PairOffset(levelIdx, predIdx)];
   unsigned int denseCount = reach.AdjustDense(idxStart, extent);
   if (extent == 0) { // all indices implicit.
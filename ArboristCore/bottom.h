@@ -193,8 +193,8 @@ class Level {
   void FrontDef(class Bottom *bottom, unsigned int mrraIdx, unsigned int predIdx, unsigned int runCount, unsigned int sourceBit);
   void OffsetClone(const SPPair &mrra, unsigned int reachOffset[], unsigned int reachBase[]);
   unsigned int DiagRestage(const SPPair &mrra, unsigned int reachOffset[]);
-  void RunCounts(const class SPNode targ[], const SPPair &mrra, const class Bottom *bottom) const ;
-  void SetRuns(const class Bottom *bottom, unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int idxCount, const class SPNode *targ);
+  template<typename Layout> void RunCounts(const Layout &targ, const SPPair &mrra, const class Bottom *bottom) const ;
+  template<typename Layout> void SetRuns(const class Bottom *bottom, unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int idxCount, const Layout &targ);
   void PackDense(unsigned int idxLeft, const unsigned int pathCount[], Level *levelFront, const SPPair &mrra, unsigned int reachOffset[]) const;
   void SetExtinct(unsigned int idx);
   bool Backdate(const class IdxPath *one2Front);
@@ -387,7 +387,7 @@ class RestageCoord {
     bufIdx = _bufIdx;
   }
 
-  void inline Ref(SPPair &_mrra, unsigned int &_del, unsigned int &_runCount, unsigned int &_bufIdx) {
+  void inline Ref(SPPair &_mrra, unsigned int &_del, unsigned int &_runCount, unsigned int &_bufIdx) const {
     _mrra = mrra;
     _del = del;
     _runCount = runCount;
@@ -399,6 +399,7 @@ class RestageCoord {
 /**
  */
 class Bottom {
+  const class TrainCtx *ctx;
   const unsigned int nPred;
   const unsigned int nPredFac;
   const unsigned int bagCount;
@@ -406,8 +407,7 @@ class Bottom {
   std::vector<class TermKey> termKey; // Frontier map keys:  uninitialized.
   //unsigned int termTop; // Next unused terminal index.
   bool nodeRel; // Subtree- or node-relative indexing.  Sticky, once node-.
-  
-  std::vector<unsigned int> prePath;
+  unsigned int supUnFlush; // Highest level not flushed by current schedule.
 
   static constexpr double efficiency = 0.15; // Work efficiency threshold.
 
@@ -415,6 +415,8 @@ class Bottom {
   unsigned int splitPrev;
   unsigned int splitCount; // # nodes in the level about to split.
   const class PMTrain *pmTrain;
+  const class RowRank *rowRank;
+  const class Sample *sample;
   class SamplePred *samplePred;
   class SplitPred *splitPred;  // constant?
   class SplitSig *splitSig;
@@ -429,14 +431,19 @@ class Bottom {
   std::deque<Level *> level;
   
   std::vector<RestageCoord> restageCoord;
+  std::vector<unsigned char> staged; // Whether predictor has been staged.
+  std::vector<unsigned int> stageFront; // Predictors to stage at front level.
 
   // Restaging methods.
   void Restage(RestageCoord &rsCoord);
-  SPNode *Restage(SPPair mrra, unsigned int bufIdx, unsigned int del);
-  SPNode *RestageNdxDense(unsigned int reachOffset[], const unsigned int reachBase[], const SPPair &mrra, unsigned int bufIdx, unsigned int del);
-  SPNode *RestageStxDense(unsigned int reachOffset[], const SPPair &mrra, unsigned int bufIdx, unsigned int del);
+  template<typename Layout> void Restage(const SPPair &mrra, unsigned int bufIdx, unsigned int del);
+  template<typename Layout> Layout RestageNdxDense(unsigned int reachOffset[], const unsigned int reachBase[], const SPPair &mrra, unsigned int bufIdx, unsigned int del);
+  template<typename Layout> Layout RestageStxDense(unsigned int reachOffset[], const SPPair &mrra, unsigned int bufIdx, unsigned int del);
+  void StageDef(unsigned int predIdx);
+  void StageFront(const class IndexLevel &index);
+  void StageFront(const class IndexLevel &index, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx);
+  template<typename Layout> void StageColumn(const class IndexLevel &index, unsigned int predIdx, const std::vector<class StagePack> &stagePack, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff);
   void Backdate() const;
-  void ArgMax(const class IndexLevel &index, std::vector<class SSNode*> &argMax);
 
   /**
      @brief Increments reaching levels for all pairs involving node.
@@ -461,19 +468,31 @@ class Bottom {
   bool NonTerminal(class PreTree *preTree, class SSNode *ssNode, unsigned int extent, unsigned int ptId, double &sumExpl);
   void FrontUpdate(unsigned int sIdx, bool isLeft, unsigned int relBase, unsigned int &relIdx);
   void RootDef(unsigned int predIdx, unsigned int denseCount);
+  void RootDef(unsigned int predIdx, unsigned int denseCount, unsigned int runCount);
   void ScheduleRestage(unsigned int del, unsigned int mrraIdx, unsigned int predIdx, unsigned int runCount, unsigned int bufIdx);
   int RestageIdx(unsigned int bottomIdx);
   void RestagePath(unsigned int startIdx, unsigned int extent, unsigned int lhOff, unsigned int rhOff, unsigned int level, unsigned int predIdx);
   bool ScheduleSplit(unsigned int levelIdx, unsigned int predIdx, unsigned int &runCount, unsigned int &bufIdx);
+  void ScheduleHandoff(unsigned int levelIdx);
+  unsigned int Pack(unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &buf2Local, std::vector<class StagePack> &stagePack, unsigned int &denseCount) const;
+  Bottom *Spawn(class SamplePred *_samplePred, const std::vector<class SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int subKey) const;
 
-  static Bottom *FactoryReg(const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, unsigned int _bagCount);
-  static Bottom *FactoryCtg(const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, const std::vector<class SampleNode> &_sampleCtg, unsigned int _bagCount);
+  static Bottom *FactoryReg(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, const class Sample *_sample, class SamplePred *_samplePred, unsigned int _bagCount, unsigned int _tIdx, unsigned int _nOut = 1, const double _sumOut[] = 0);
+  static Bottom *FactoryCtg(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, const class Sample *_sample, class SamplePred *_samplePred, const std::vector<class SampleNode> &_sampleCtg, unsigned int _bagCount, unsigned int _tIdx);
   
-  Bottom(const class PMTrain *_pmTrain, class SamplePred *_samplePred, class SplitPred *_splitPred, unsigned int _bagCount, unsigned int _stageSize);
+  Bottom(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, const class Sample *_sample, class SamplePred *_samplePred, class SplitPred *_splitPred, unsigned int _bagCount);
   ~Bottom();
   void LevelInit();
   void LevelClear();
   void Split(class IndexLevel &index, std::vector<class SSNode*> &argMax);
+  void Schedule(class IndexLevel &index);
+  void Stage(const class IndexLevel &index);
+  void SplitPrepare(const class IndexLevel &index);
+  unsigned int TaskCount() const;
+  unsigned int TaskCost(unsigned int taskIdx) const;
+  void SplitTask(unsigned int taskIdx);
+  void SplitReduce();
+  void ArgMax(const class IndexLevel &index, std::vector<class SSNode*> &argMax);
   void Terminal(unsigned int extent, unsigned int ptId);
   void Overlap(class PreTree *preTree, unsigned int splitNext, unsigned int leafNext);
   void LevelPrepare(unsigned int splitNext, unsigned int idxLive, unsigned int idxMax);
@@ -484,8 +503,29 @@ class Bottom {
   void SSWrite(unsigned int levelIdx, unsigned int predIdx, unsigned int setPos, unsigned int bufIdx, const class NuxLH &nux) const;
   unsigned int FlushRear();
   void DefForward(unsigned int levelIdx, unsigned int predIdx);
-  void Buffers(const SPPair &mrra, unsigned int bufIdx, SPNode *&source, unsigned int *&relIdxSource, SPNode *&targ, unsigned int *&relIdxTarg) const;
+  template<typename Layout> void Buffers(const SPPair &mrra, unsigned int bufIdx, Layout &source, unsigned int *&relIdxSource, Layout &targ, unsigned int *&relIdxTarg) const;
   void Restage();
+  void Restage(unsigned int rsIdx);
+  unsigned int RestageCost(unsigned int rsIdx) const;
+
+  /**
+     @brief Accessor for the size of the level's restaging schedule.
+
+     @return count of scheduled restaging pairs.
+   */
+  inline unsigned int RestageCount() const {
+    return restageCoord.size();
+  }
+
+
+  /**
+     @brief Empties the restaging schedule, once all pairs are restaged.
+
+     @return void.
+   */
+  inline void RestageClear() {
+    restageCoord.clear();
+  }
   bool IsFactor(unsigned int predIdx) const;
   void SetLive(unsigned int ndx, unsigned int targIdx, unsigned int stx, unsigned int path, unsigned int ndBase);
   void SetExtinct(unsigned int termIdx, unsigned int stIdx);
@@ -506,12 +546,12 @@ class Bottom {
   }
 
 
-  inline void RunCounts(const class SPNode targ[], const SPPair &mrra, unsigned int del) {
+  template<typename Layout> inline void RunCounts(const Layout &targ, const SPPair &mrra, unsigned int del) {
     level[del]->RunCounts(targ, mrra, this);
   }
   
 
-  inline void SetRuns(unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int idxCount, const class SPNode *targ) const {
+  template<typename Layout> inline void SetRuns(unsigned int levelIdx, unsigned int predIdx, unsigned int idxStart, unsigned int idxCount, const Layout &targ) const {
     levelFront->SetRuns(this, levelIdx, predIdx, idxStart, idxCount, targ);
   }
 
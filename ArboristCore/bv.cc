@@ -118,6 +118,17 @@ void BV::Consume(std::vector<unsigned int> &out, unsigned int bitEnd) const {
 }
 
 
+/**
+   @brief Appends contents to a segmented vector, as a contiguous run.
+
+   @return void, with output segmented vector.
+ */
+void BV::Consume(SegVec<unsigned int> &out, unsigned int bitEnd) const {
+  unsigned int slots = bitEnd == 0 ? nSlot : SlotAlign(bitEnd);
+  out.Append(raw, slots);
+}
+
+
 unsigned int BV::PopCount() const {
   unsigned int pop = 0;
   for (unsigned int i = 0; i < nSlot; i++) {
@@ -215,6 +226,35 @@ void BVJagged::RowExport(std::vector<unsigned int> &outRow, unsigned int rowHeig
 }
 
 
+/**
+   @brief Static entry.  Restrides an exported matrix in place to admit
+   additional columns.  Rows are moved back to front, as no row's new
+   position precedes its old one.
+
+   @param _raw is the exported matrix, of conforming dimensions.
+
+   @param nColPrev is the current column count.
+
+   @param _nCol is the widened column count.
+
+   @return void, with resized output reference parameter.
+ */
+void BitMatrix::Widen(std::vector<unsigned int> &_raw, unsigned int _nRow, unsigned int nColPrev, unsigned int _nCol) {
+  unsigned int slotPrev = SlotAlign(nColPrev);
+  unsigned int slotNext = SlotAlign(_nCol);
+  _raw.resize(std::max(size_t(_nRow * Stride(_nCol)), _raw.size()), 0); // Conforms to wrapper.
+  if (slotNext == slotPrev)
+    return;
+
+  for (unsigned int row = _nRow; row-- > 0; ) {
+    auto rowPrev = _raw.begin() + row * slotPrev;
+    auto rowNext = _raw.begin() + row * slotNext;
+    std::copy_backward(rowPrev, rowPrev + slotPrev, rowNext + slotPrev);
+    std::fill(rowNext + slotPrev, rowNext + slotNext, 0);
+  }
+}
+
+
 /**
    @brief Static entry.  Exports matrix as vector of vectors.
 
@@ -20,6 +20,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "segvec.h"
+
 // TODO: Recast using templates.
 
 class BV {
@@ -47,6 +49,7 @@ class BV {
   }
 
   void Consume(std::vector<unsigned int> &out, unsigned int bitEnd = 0) const;
+  void Consume(SegVec<unsigned int> &out, unsigned int bitEnd = 0) const;
   unsigned int PopCount() const;
 
   BV *Resize(unsigned int bitMin);
@@ -185,6 +188,7 @@ class BitMatrix : public BV {
   }
   
   static void Export(const std::vector<unsigned int> &_raw, unsigned int _nRow, std::vector<std::vector<unsigned int> > &vecOut);
+  static void Widen(std::vector<unsigned int> &_raw, unsigned int _nRow, unsigned int nColPrev, unsigned int _nCol);
 
 
   inline BitRow *Row(unsigned int row) {
@@ -0,0 +1,423 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file checkpoint.cc
+
+   @brief Methods for writing and recovering block-wise training
+   checkpoints.
+
+   @author Mark Seligman
+ */
+
+#include "checkpoint.h"
+#include "trainctx.h"
+#include "forest.h"
+#include "leaf.h"
+#include "bv.h"
+#include "predblock.h"
+#include "rowrankfile.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+//#include <iostream>
+//using namespace std;
+
+const char Checkpoint::magic[8] = {'A', 'R', 'B', 'C', 'K', 'P', 'T', '\0'};
+
+
+/**
+   @brief Opens the checkpoint file.  If the file already records
+   exactly the trees present, as following recovery, records are
+   appended to it.  Otherwise the file is begun anew, and any trees
+   present are recorded with the first block.
+
+   @param _dataHash is the fingerprint of the data trained.
+
+   @param _nRow is the number of training rows.
+
+   @param _aux holds any per-leaf values beyond the leaf node, such as
+   category weights, null iff none.
+
+   @param _auxWidth is the number of auxiliary values per leaf.
+
+   @param tBase is the number of trees already present.
+ */
+Checkpoint::Checkpoint(const TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, const SegVec<ForestNode> &_forestNode, const SegVec<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, const SegVec<LeafNode> &_leafNode, const SegVec<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth, unsigned int tBase) : path(ctx->checkpointPath), dataHash(_dataHash), nRow(_nRow), auxWidth(_auxWidth), origin(_origin), facOrigin(_facOrigin), forestNode(_forestNode), facSplit(_facSplit), leafOrigin(_leafOrigin), leafNode(_leafNode), bagLeaf(_bagLeaf), bagBits(_bagBits), aux(_aux), tDone(0), bagBase(0), failed(false) {
+  CkptHeader hdr = Header(ctx, dataHash, nRow, auxWidth);
+  unsigned int tFile = 0;
+  uint64_t fileEnd = tBase > 0 ? Walk(path, hdr, tBase, tFile, nullptr) : 0;
+  if (fileEnd > 0 && tFile == tBase) {
+    // Discards any partial record trailing the last complete one.
+#ifndef _WIN32
+    failed = truncate(path.c_str(), fileEnd) != 0;
+#endif
+    out.open(path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(fileEnd);
+    tDone = tBase;
+    bagBase = bagLeaf.size();
+  }
+  else {
+    out.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.flush();
+  }
+  failed = failed || !out;
+}
+
+
+/**
+   @brief Waits for any record in flight.
+ */
+Checkpoint::~Checkpoint() {
+  Join();
+}
+
+
+/**
+   @brief Builds a checkpoint if one is requested.  Train::Init has
+   already declined requests under the front-end generator.
+
+   @return new checkpoint, null iff none.
+ */
+Checkpoint *Checkpoint::Factory(const TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, const SegVec<ForestNode> &_forestNode, const SegVec<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, const SegVec<LeafNode> &_leafNode, const SegVec<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth, unsigned int tBase) {
+  if (ctx->checkpointPath.empty())
+    return 0;
+
+  return new Checkpoint(ctx, _dataHash, _nRow, _origin, _facOrigin, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagLeaf, _bagBits, _aux, _auxWidth, tBase);
+}
+
+
+/**
+   @brief Fingerprints the data trained, so that trees recovered from a
+   file are known to have been grown from the same design and response.
+   The presorted design is sampled, as for RowRank files, so that the
+   cost does not grow with the design.  The response is hashed in full.
+
+   @param feRow, feRank and feRLE are the presorted runs.
+
+   @param numOff and numVal are the numerical predictor values.
+
+   @param y is the numerical response or, for classification, the proxy.
+
+   @param yCount is the number of response values.
+
+   @param yCtg is the categorical response, null iff regression.
+
+   @return fingerprint, zero if no checkpoint is kept.
+ */
+uint64_t Checkpoint::Fingerprint(const TrainCtx *ctx, const PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int feRLE[], unsigned int rleLength, const unsigned int numOff[], const double numVal[], const double y[], size_t yCount, const unsigned int yCtg[]) {
+  if (ctx->checkpointPath.empty())
+    return 0;
+
+  // Numerical values are rank-indexed, so the values of the last
+  // numerical predictor extend to its highest rank.
+  unsigned int nPredNum = pmTrain->NPredNum();
+  unsigned int nRow = pmTrain->NRow();
+  size_t numLength = 0;
+  unsigned int rleIdx = 0;
+  for (unsigned int numIdx = 0; numIdx < nPredNum; numIdx++) {
+    for (unsigned int rowTot = 0; rowTot < nRow && rleIdx < rleLength; rowTot += feRLE[rleIdx++]);
+    if (numIdx + 1 == nPredNum && rleIdx > 0)
+      numLength = numOff[numIdx] + feRank[rleIdx - 1] + 1;
+  }
+
+  uint64_t hash = RowRankFile::Sample(feRow, size_t(rleLength) * sizeof(unsigned int));
+  hash = RowRankFile::Sample(feRank, size_t(rleLength) * sizeof(unsigned int), hash);
+  hash = RowRankFile::Sample(feRLE, size_t(rleLength) * sizeof(unsigned int), hash);
+  hash = RowRankFile::Sample(numOff, nPredNum * sizeof(unsigned int), hash);
+  hash = RowRankFile::Sample(numVal, numLength * sizeof(double), hash);
+  hash = RowRankFile::Hash(y, yCount * sizeof(double), hash);
+  if (yCtg != 0)
+    hash = RowRankFile::Hash(yCtg, nRow * sizeof(unsigned int), hash);
+
+  return hash;
+}
+
+
+/**
+   @brief Describes the training under way.  Trees recovered from a
+   file must have been grown under an identical header:  the same data,
+   seed and options.  Options governing only the schedule or layout of
+   training leave the trees unaltered, so are not recorded.
+
+   @param _dataHash is the fingerprint of the data trained.
+
+   @return header value.
+ */
+CkptHeader Checkpoint::Header(const TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, unsigned int _auxWidth) {
+  CkptHeader hdr;
+  std::memset(&hdr, 0, sizeof(hdr));
+  std::memcpy(hdr.magic, magic, sizeof(magic));
+  hdr.version = version;
+  hdr.byteOrder = byteOrder;
+  hdr.seed = ctx->seed;
+  hdr.dataHash = _dataHash;
+  uint64_t vecHash = RowRankFile::Hash(ctx->sampleWeight.data(), ctx->sampleWeight.size() * sizeof(double));
+  vecHash = RowRankFile::Hash(ctx->predProb.data(), ctx->predProb.size() * sizeof(double), vecHash);
+  vecHash = RowRankFile::Hash(ctx->splitQuant.data(), ctx->splitQuant.size() * sizeof(double), vecHash);
+  vecHash = RowRankFile::Hash(ctx->regMono.data(), ctx->regMono.size() * sizeof(double), vecHash);
+  hdr.vecHash = vecHash;
+  hdr.minRatio = ctx->minRatio;
+  hdr.nRow = _nRow;
+  hdr.nPred = ctx->nPred;
+  hdr.ctgWidth = ctx->ctgWidth;
+  hdr.auxWidth = _auxWidth;
+  hdr.nodeSize = sizeof(ForestNode);
+  hdr.leafSize = sizeof(LeafNode);
+  hdr.bagSize = sizeof(BagLeaf);
+  hdr.nSamp = ctx->nSamp;
+  hdr.withRepl = ctx->withRepl;
+  hdr.minNode = ctx->minNode;
+  hdr.totLevels = ctx->totLevels;
+  hdr.predFixed = ctx->predFixed;
+  hdr.rankBins = ctx->rankBins;
+  hdr.approxMin = ctx->approxMin;
+  hdr.extraTrees = ctx->extraTrees;
+  hdr.thinLeaves = ctx->thinLeaves;
+
+  return hdr;
+}
+
+
+/**
+   @brief Computes the payload length implied by a record's counts.
+
+   @return byte count following the record header.
+ */
+uint64_t Checkpoint::PayloadSize(const CkptBlock &blk, const CkptHeader &hdr) {
+  return 3 * Pad(blk.tCount * sizeof(unsigned int))
+    + Pad(blk.nNode * sizeof(ForestNode))
+    + Pad(blk.nFac * sizeof(unsigned int))
+    + Pad(blk.nLeaf * sizeof(LeafNode))
+    + Pad(blk.nBag * sizeof(BagLeaf))
+    + Pad(blk.nLeaf * hdr.auxWidth * sizeof(double))
+    + Pad(uint64_t(blk.tCount) * BV::SlotAlign(hdr.nRow) * sizeof(unsigned int))
+    + Pad(hdr.nPred * sizeof(double))
+    + sizeof(marker);
+}
+
+
+/**
+   @brief Visits the complete, consecutive records of a conforming file.
+
+   @param expect is the header the file must bear.
+
+   @param tMax bounds the number of trees visited.
+
+   @param tCount outputs the number of trees visited.
+
+   @param visit is invoked with each record header and its payload, if
+   callable.
+
+   @return byte offset following the last record visited, zero iff the
+   file is absent or does not conform.
+ */
+uint64_t Checkpoint::Walk(const std::string &_path, const CkptHeader &expect, unsigned int tMax, unsigned int &tCount, const std::function<void(const CkptBlock &, const char *)> &visit) {
+  tCount = 0;
+  std::ifstream in(_path.c_str(), std::ios::binary | std::ios::ate);
+  if (!in)
+    return 0;
+  uint64_t length = in.tellg();
+  in.seekg(0);
+
+  CkptHeader hdr;
+  if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) || std::memcmp(&hdr, &expect, sizeof(hdr)) != 0)
+    return 0;
+
+  uint64_t end = sizeof(hdr);
+  CkptBlock blk;
+  std::vector<char> payload;
+  while (in.read(reinterpret_cast<char*>(&blk), sizeof(blk))) {
+    if (blk.marker != marker || blk.tStart != tCount || blk.tCount == 0 || blk.tCount > tMax - tCount || blk.payload > length - end - sizeof(blk) || blk.payload != PayloadSize(blk, hdr))
+      break;
+    payload.resize(blk.payload);
+    if (!in.read(&payload[0], blk.payload))
+      break;
+    uint32_t close;
+    std::memcpy(&close, &payload[blk.payload - sizeof(close)], sizeof(close));
+    if (close != marker)
+      break;
+
+    if (visit)
+      visit(blk, &payload[0]);
+    tCount += blk.tCount;
+    end += sizeof(blk) + blk.payload;
+  }
+
+  return end;
+}
+
+
+/**
+   @brief Recovers the trees recorded by a checkpoint file, in place of
+   the contents of the forest and leaf vectors.  Origin vectors and bag
+   matrix are sized for the context's full tree count.
+
+   @param _dataHash is the fingerprint of the data to be trained.
+
+   @param _predInfo outputs the running information sum recorded with the
+   trees recovered, unnormalized so that resumption sums bit-identically.
+
+   @return number of trees recovered, zero if checkpointing is not in
+   effect or the file is absent or does not conform.
+ */
+unsigned int Checkpoint::Load(const TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth) {
+  if (ctx->checkpointPath.empty())
+    return 0;
+
+  _origin.clear();
+  _facOrigin.clear();
+  _leafOrigin.clear();
+  _forestNode.clear();
+  _facSplit.clear();
+  _leafNode.clear();
+  _bagLeaf.clear();
+  if (_aux != 0)
+    _aux->clear();
+  _bagBits.assign(_nRow * BV::Stride(ctx->nTree), 0);
+  BitMatrix bag(_bagBits, _nRow, ctx->nTree);
+  _predInfo.assign(_predInfo.size(), 0.0);
+
+  unsigned int bagSlots = BV::SlotAlign(_nRow);
+  unsigned int tCount;
+  CkptHeader hdr = Header(ctx, _dataHash, _nRow, _auxWidth);
+  Walk(ctx->checkpointPath, hdr, ctx->nTree, tCount, [&](const CkptBlock &blk, const char *pos) {
+      pos = Take(pos, blk.tCount, _origin);
+      pos = Take(pos, blk.tCount, _facOrigin);
+      pos = Take(pos, blk.tCount, _leafOrigin);
+      pos = Take(pos, blk.nNode, _forestNode);
+      pos = Take(pos, blk.nFac, _facSplit);
+      pos = Take(pos, blk.nLeaf, _leafNode);
+      pos = Take(pos, blk.nBag, _bagLeaf);
+      if (_aux != 0) {
+        pos = Take(pos, blk.nLeaf * _auxWidth, *_aux);
+      }
+      else {
+        pos += Pad(blk.nLeaf * _auxWidth * sizeof(double));
+      }
+
+      const unsigned int *bits = reinterpret_cast<const unsigned int*>(pos);
+      for (unsigned int blockIdx = 0; blockIdx < blk.tCount; blockIdx++) {
+        BitRow treeBag(const_cast<unsigned int*>(bits) + blockIdx * bagSlots, bagSlots);
+        for (unsigned int row = 0; row < _nRow; row++) {
+          if (treeBag.TestBit(row))
+            bag.SetBit(row, blk.tStart + blockIdx);
+        }
+      }
+      pos += Pad(uint64_t(blk.tCount) * bagSlots * sizeof(unsigned int));
+
+      std::memcpy(&_predInfo[0], pos, _predInfo.size() * sizeof(double));
+    });
+
+  _origin.resize(ctx->nTree);
+  _facOrigin.resize(ctx->nTree);
+  _leafOrigin.resize(ctx->nTree);
+
+  return tCount;
+}
+
+
+/**
+   @brief Records trees trained since the previous record, then hands
+   the record to a background writer.  Waits only for the preceding
+   record, if still in flight.
+
+   @param tEnd is one beyond the last tree trained.
+
+   @param predInfo is the running sum of information, by predictor.
+
+   @return void.
+ */
+void Checkpoint::Record(unsigned int tEnd, const std::vector<double> &predInfo) {
+  Join();
+  if (failed || tEnd <= tDone)
+    return;
+
+  CkptBlock blk;
+  std::memset(&blk, 0, sizeof(blk));
+  blk.marker = marker;
+  blk.tStart = tDone;
+  blk.tCount = tEnd - tDone;
+  size_t nodeStart = origin[tDone];
+  size_t facStart = facOrigin[tDone];
+  size_t leafStart = leafOrigin[tDone];
+  blk.nNode = forestNode.size() - nodeStart;
+  blk.nFac = facSplit.size() - facStart;
+  blk.nLeaf = leafNode.size() - leafStart;
+  blk.nBag = bagLeaf.size() - bagBase;
+
+  CkptHeader hdr;
+  hdr.nRow = nRow;
+  hdr.nPred = predInfo.size();
+  hdr.auxWidth = auxWidth;
+  blk.payload = PayloadSize(blk, hdr);
+
+  record.assign(sizeof(blk) + blk.payload, 0);
+  char *pos = &record[0];
+  auto put = [&pos](const void *src, size_t bytes) {
+    if (bytes > 0)
+      std::memcpy(pos, src, bytes);
+    pos += Pad(bytes);
+  };
+  put(&blk, sizeof(blk));
+  put(&origin[tDone], blk.tCount * sizeof(unsigned int));
+  put(&facOrigin[tDone], blk.tCount * sizeof(unsigned int));
+  put(&leafOrigin[tDone], blk.tCount * sizeof(unsigned int));
+  pos = Put(pos, forestNode, nodeStart, blk.nNode);
+  pos = Put(pos, facSplit, facStart, blk.nFac);
+  pos = Put(pos, leafNode, leafStart, blk.nLeaf);
+  pos = Put(pos, bagLeaf, bagBase, blk.nBag);
+  put(aux == 0 ? 0 : aux->data() + leafStart * auxWidth, blk.nLeaf * auxWidth * sizeof(double));
+
+  // Bag bits are recorded by tree, rather than by row, so that each
+  // record is self-contained.
+  unsigned int bagSlots = BV::SlotAlign(nRow);
+  BitMatrix bag(bagBits, nRow, origin.size());
+  for (unsigned int blockIdx = 0; blockIdx < blk.tCount; blockIdx++) {
+    BitRow treeBag(reinterpret_cast<unsigned int*>(pos) + blockIdx * bagSlots, bagSlots);
+    for (unsigned int row = 0; row < nRow; row++) {
+      if (bag.TestBit(row, tDone + blockIdx))
+        treeBag.SetBit(row);
+    }
+  }
+  pos += Pad(uint64_t(blk.tCount) * bagSlots * sizeof(unsigned int));
+  put(&predInfo[0], predInfo.size() * sizeof(double));
+  uint32_t close = marker;
+  put(&close, sizeof(close));
+
+  tDone = tEnd;
+  bagBase = bagLeaf.size();
+  writer = std::thread(&Checkpoint::Write, this);
+}
+
+
+/**
+   @brief Writer body:  appends the record in flight and flushes.
+
+   @return void.
+ */
+void Checkpoint::Write() {
+  out.write(&record[0], record.size());
+  out.flush();
+  failed = !out;
+}
+
+
+/**
+   @brief Waits for the writer, if any, to complete.
+
+   @return void.
+ */
+void Checkpoint::Join() {
+  if (writer.joinable())
+    writer.join();
+}
@@ -0,0 +1,172 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file checkpoint.h
+
+   @brief Class definitions for block-wise training checkpoints.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_CHECKPOINT_H
+#define ARBORIST_CHECKPOINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <functional>
+
+#include "segvec.h"
+
+/**
+   @brief Fixed-size file header.  Identifies the training to which the
+   records belong:  its data, and every option altering the trees grown.
+ */
+struct CkptHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder; // Written natively:  detects foreign endianness.
+  uint64_t seed; // Keys the core generator.
+  uint64_t dataHash; // Fingerprint of the design and response.
+  uint64_t vecHash; // Hash of the per-predictor and per-row options.
+  double minRatio;
+  uint32_t nRow;
+  uint32_t nPred;
+  uint32_t ctgWidth;
+  uint32_t auxWidth; // Per-leaf auxiliary values:  zero iff none.
+  uint32_t nodeSize; // Record sizes, as compiled.
+  uint32_t leafSize;
+  uint32_t bagSize;
+  uint32_t nSamp;
+  uint32_t withRepl;
+  uint32_t minNode;
+  uint32_t totLevels;
+  uint32_t predFixed;
+  uint32_t rankBins;
+  uint32_t approxMin;
+  uint32_t extraTrees;
+  uint32_t thinLeaves;
+};
+
+
+/**
+   @brief Per-block record header.  The payload follows, with sections
+   in the order declared and each padded to 'Checkpoint::align' bytes,
+   and is closed by a copy of the marker.
+ */
+struct CkptBlock {
+  uint32_t marker;
+  uint32_t tStart; // First tree recorded.
+  uint32_t tCount; // # trees recorded.
+  uint32_t unused;
+  uint64_t nNode; // # ForestNode.
+  uint64_t nFac; // # factor-split slots.
+  uint64_t nLeaf; // # LeafNode.
+  uint64_t nBag; // # BagLeaf.
+  uint64_t payload; // Bytes following header, including closing marker.
+};
+
+
+/**
+   @brief Appends each newly-trained block of trees to a file, together
+   with the running predictor information, and recovers a forest from
+   such a file.
+
+   As the core generator is keyed by seed and tree index alone, the
+   generator state following a block is fully determined by the seed and
+   by the number of trees recorded.  Records are written by a background
+   thread, overlapping the training of the following block, and are
+   self-delimiting:  an interrupted write leaves a partial record, which
+   recovery ignores.
+ */
+class Checkpoint {
+  static const char magic[8];
+  static const uint32_t version = 2;
+  static const uint32_t byteOrder = 0x01020304;
+  static const uint32_t marker = 0x4b4c4231; // Opens and closes a record.
+  static const size_t align = 8;
+
+  const std::string path;
+  const uint64_t dataHash;
+  const unsigned int nRow;
+  const unsigned int auxWidth;
+  std::vector<unsigned int> &origin;
+  std::vector<unsigned int> &facOrigin;
+  const SegVec<class ForestNode> &forestNode;
+  const SegVec<unsigned int> &facSplit;
+  std::vector<unsigned int> &leafOrigin;
+  const SegVec<class LeafNode> &leafNode;
+  const SegVec<class BagLeaf> &bagLeaf;
+  std::vector<unsigned int> &bagBits;
+  std::vector<double> *aux; // Null iff no per-leaf auxiliary values.
+  unsigned int tDone; // # trees recorded.
+  size_t bagBase; // # BagLeaf recorded.
+  std::ofstream out; // Accessed only by the writer, once launched.
+  std::vector<char> record; // Record in flight.
+  std::thread writer;
+  bool failed; // Whether a write has failed:  no further records.
+
+  static size_t Pad(size_t bytes) {
+    return (bytes + align - 1) & ~(align - 1);
+  }
+
+  static CkptHeader Header(const class TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, unsigned int _auxWidth);
+  static uint64_t PayloadSize(const CkptBlock &blk, const CkptHeader &hdr);
+  static uint64_t Walk(const std::string &_path, const CkptHeader &expect, unsigned int tMax, unsigned int &tCount, const std::function<void(const CkptBlock &, const char *)> &visit);
+
+
+  /**
+     @brief Appends a section of a record to a vector.
+
+     @return position of the following section.
+   */
+  template<typename T> static const char *Take(const char *pos, size_t count, std::vector<T> &out) {
+    const T *src = reinterpret_cast<const T*>(pos);
+    out.insert(out.end(), src, src + count);
+    return pos + Pad(count * sizeof(T));
+  }
+
+
+  /**
+     @brief Copies a section of a record from a segmented store.
+
+     @return position of the following section.
+   */
+  template<typename T> static char *Put(char *pos, const SegVec<T> &src, size_t start, size_t count) {
+    src.CopyOut(start, count, reinterpret_cast<T*>(pos));
+    return pos + Pad(count * sizeof(T));
+  }
+
+  void Write();
+  void Join();
+
+ public:
+  Checkpoint(const class TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, const SegVec<class ForestNode> &_forestNode, const SegVec<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, const SegVec<class LeafNode> &_leafNode, const SegVec<class BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth, unsigned int tBase);
+  ~Checkpoint();
+
+  static Checkpoint *Factory(const class TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, const SegVec<class ForestNode> &_forestNode, const SegVec<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, const SegVec<class LeafNode> &_leafNode, const SegVec<class BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth, unsigned int tBase);
+
+  static uint64_t Fingerprint(const class TrainCtx *ctx, const class PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int feRLE[], unsigned int rleLength, const unsigned int numOff[], const double numVal[], const double y[], size_t yCount, const unsigned int yCtg[] = 0);
+
+  static unsigned int Load(const class TrainCtx *ctx, uint64_t _dataHash, unsigned int _nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, std::vector<double> *_aux, unsigned int _auxWidth);
+
+  void Record(unsigned int tEnd, const std::vector<double> &predInfo);
+
+
+  /**
+     @return count of trees recorded, including any recovered.
+   */
+  inline unsigned int TreeCount() const {
+    return tDone;
+  }
+};
+
+#endif
@@ -19,18 +19,22 @@
 #include "predblock.h"
 #include "rowrank.h"
 #include "predict.h"
+#include "taskpool.h"
+
+#include <cmath>
+#include <cfloat>
 
 //#include <iostream>
 //using namespace std;
 
 
-const double *ForestNode::splitQuant = 0;
-
-
 /**
-   @brief Crescent constructor for training.
+   @brief Crescent constructor for training.  Trees already present, if
+   warm starting, are adopted by the segmented stores without copying.
 */
-ForestTrain::ForestTrain(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec) : forestNode(_forestNode), treeOrigin(_origin), facOrigin(_facOrigin), facVec(_facVec) {
+ForestTrain::ForestTrain(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec) : nodeOut(_forestNode), treeOrigin(_origin), facOrigin(_facOrigin), facOut(_facVec) {
+  forestNode.Adopt(nodeOut);
+  facVec.Adopt(facOut);
 }
 
 ForestTrain::~ForestTrain() {
@@ -38,16 +42,149 @@ ForestTrain::~ForestTrain() {
 
 
 /**
-   @brief Constructor for prediction.
+   @brief Constructor for prediction from contiguous arrays.
+
+   @param _rowTile is the number of rows walked through a group of trees
+   before the next group is visited, zero iff each row walks the entire
+   forest in turn.
+
+   @param _treeTile is the number of trees per group, zero iff groups
+   are sized to a cache budget.
+
+   @param _forestCompact is a compact copy of the forest to be walked
+   in place of the full nodes, null iff the full nodes are walked.
+
+   Factor splits are addressed by per-tree offset, so the factor count
+   passed by the front end is not consulted.
 */
-Forest::Forest(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facVec[], size_t _facLen, const unsigned int _facOrigin[], unsigned int _nFac, Predict *_predict) : forestNode(_forestNode), treeOrigin(_origin), nTree(_nTree), facSplit(new BVJagged(_facVec, _facLen, _facOrigin, _nFac)), predict(_predict), predMap(predict->PredMap())  {
+Forest::Forest(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facVec[], size_t _facLen, const unsigned int _facOrigin[], unsigned int, Predict *_predict, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact) : nTree(_nTree), treeNode(std::vector<const ForestNode*>(_nTree)), treeFac(std::vector<const unsigned int*>(_nTree)), rowTile(_rowTile), forestCompact(_forestCompact), predict(_predict), predMap(predict->PredMap())  {
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    treeNode[tIdx] = _forestNode + _origin[tIdx];
+    treeFac[tIdx] = _facOrigin[tIdx] < _facLen ? _facVec + _facOrigin[tIdx] : 0;
+  }
+  TreeGroups(_origin, _treeTile);
+}
+
+
+/**
+   @brief Constructor for prediction directly from the segmented stores
+   of an in-process training, without exporting a contiguous copy.  Each
+   tree is contiguous within its segment, so only per-tree bases are
+   looked up.
+*/
+Forest::Forest(const SegVec<ForestNode> &_forestNode, const unsigned int _origin[], unsigned int _nTree, const SegVec<unsigned int> &_facVec, const unsigned int _facOrigin[], Predict *_predict, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact) : nTree(_nTree), treeNode(std::vector<const ForestNode*>(_nTree)), treeFac(std::vector<const unsigned int*>(_nTree)), rowTile(_rowTile), forestCompact(_forestCompact), predict(_predict), predMap(predict->PredMap())  {
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    treeNode[tIdx] = _forestNode.Base(_origin[tIdx]);
+    treeFac[tIdx] = _facVec.Base(_facOrigin[tIdx]);
+  }
+  TreeGroups(_origin, _treeTile);
+}
+
+
+/**
+   @brief Derives the compact nodes from the full nodes, tree by tree,
+   preserving tree-relative indices.  A tree's extent is recovered from
+   its own successor offsets, as trees are laid out breadth-first with
+   successors following their parents.
+
+   @param _nPredNum is the number of numerical predictors, which precede
+   the factors in predictor numbering.
+ */
+ForestCompact::ForestCompact(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _nPredNum) : compactOrigin(std::vector<size_t>(_nTree)) {
+  size_t height = 0;
+  for (unsigned int tIdx = 0; tIdx < _nTree; tIdx++) {
+    compactOrigin[tIdx] = height;
+    const ForestNode *treeNode = _forestNode + _origin[tIdx];
+    unsigned int treeHeight = 1;
+    for (unsigned int idx = 0; idx < treeHeight; idx++) {
+      unsigned int pred, bump;
+      double num;
+      treeNode[idx].Ref(pred, bump, num);
+      if (bump != 0)
+        treeHeight = std::max(treeHeight, idx + bump + 2);
+    }
+    height += treeHeight;
+  }
+
+  compactNode.resize(height);
+  for (unsigned int tIdx = 0; tIdx < _nTree; tIdx++) {
+    const ForestNode *treeNode = _forestNode + _origin[tIdx];
+    size_t treeHeight = (tIdx + 1 < _nTree ? compactOrigin[tIdx + 1] : height) - compactOrigin[tIdx];
+    NodeCompact *node = &compactNode[compactOrigin[tIdx]];
+    for (unsigned int idx = 0; idx < treeHeight; idx++) {
+      const ForestNode &full = treeNode[idx];
+      unsigned int pred, bump;
+      double num;
+      full.Ref(pred, bump, num);
+      if (node[idx].Init(full, bump != 0 && pred >= _nPredNum, escape.size()))
+        escape.push_back(full);
+    }
+  }
+}
+
+
+/**
+   @brief Packs a full node, escaping it if any field does not fit.
+
+   @param isFactor is true iff the node splits a factor.
+
+   @param escIdx is the escape-table position, should the node be escaped.
+
+   @return true iff the node has been escaped.
+ */
+bool NodeCompact::Init(const ForestNode &node, bool isFactor, unsigned int escIdx) {
+  unsigned int _pred, _bump;
+  double _num;
+  node.Ref(_pred, _bump, _num);
+  if (_bump == 0) {
+    val.idx = _pred;
+    pred = bump = 0;
+    return false;
+  }
+
+  if (_pred >= escape || _bump >= 0x10000 || (isFactor ? _num >= facLimit : std::fabs(_num) > FLT_MAX)) {
+    val.idx = escIdx;
+    pred = escape;
+    bump = 0;
+    return true;
+  }
+
+  // Rounds downward, so that observations not exceeding the rounded
+  // value also do not exceed the full one.
+  float numFloat = _num;
+  if (numFloat > _num)
+    numFloat = std::nextafter(numFloat, -HUGE_VALF);
+  val.num = numFloat;
+  pred = _pred;
+  bump = _bump;
+  return false;
+}
+
+
+/**
+   @brief Partitions the trees into consecutive groups, each walked by a
+   tile of rows before the next is visited.
+
+   @param treeTile is the number of trees per group, zero iff groups are
+   filled until their nodes, in the format walked, reach 'groupBytes'.
+
+   @return void, with group boundaries set.
+ */
+void Forest::TreeGroups(const unsigned int _origin[], unsigned int treeTile) {
+  size_t nodeBytes = forestCompact != 0 ? sizeof(NodeCompact) : sizeof(ForestNode);
+  groupStart.push_back(0);
+  for (unsigned int tIdx = 1; tIdx < nTree; tIdx++) {
+    unsigned int groupFirst = groupStart.back();
+    if (treeTile > 0 ? tIdx - groupFirst == treeTile : (_origin[tIdx] - _origin[groupFirst]) * nodeBytes >= groupBytes)
+      groupStart.push_back(tIdx);
+  }
+  groupStart.push_back(nTree);
 }
 
 
 /**
  */ 
 Forest::~Forest() {
-  delete facSplit;
 }
 
 
@@ -59,12 +196,23 @@ Forest::~Forest() {
    @return void.
  */
 void Forest::PredictAcross(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
+  if (forestCompact != 0)
+    PredictAcrossFormat<NodeCompact>(rowStart, rowEnd, bag);
+  else
+    PredictAcrossFormat<ForestNode>(rowStart, rowEnd, bag);
+}
+
+
+/**
+   @brief As above, but specialized to the node format walked.
+ */
+template<class NodeT> void Forest::PredictAcrossFormat(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
   if (predMap->NPredFac() == 0)
-    PredictAcrossNum(rowStart, rowEnd, bag);
+    PredictAcrossNum<NodeT>(rowStart, rowEnd, bag);
   else if (predMap->NPredNum() == 0)
-    PredictAcrossFac(rowStart, rowEnd, bag);
+    PredictAcrossFac<NodeT>(rowStart, rowEnd, bag);
   else
-    PredictAcrossMixed(rowStart, rowEnd, bag);
+    PredictAcrossMixed<NodeT>(rowStart, rowEnd, bag);
 }
 
 
@@ -75,16 +223,10 @@ void Forest::PredictAcross(unsigned int rowStart, unsigned int rowEnd, const cla
 
    @return Void with output vector parameter.
  */
-void Forest::PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-      PredictRowNum(row, predict->RowNum(row - rowStart), row - rowStart, bag);
-    }
-  }
+template<class NodeT> void Forest::PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
+  RowTiles(rowStart, rowEnd, [&](unsigned int blockRow, unsigned int tStart, unsigned int tEnd) {
+      PredictRowNum<NodeT>(rowStart + blockRow, predict->RowNum(blockRow), blockRow, bag, tStart, tEnd);
+    });
 }
 
 
@@ -95,17 +237,10 @@ void Forest::PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const
 
    @return Void with output vector parameter.
  */
-void Forest::PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-      PredictRowFac(row, predict->RowFac(row - rowStart), row - rowStart, bag);
-  }
-  }
-
+template<class NodeT> void Forest::PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
+  RowTiles(rowStart, rowEnd, [&](unsigned int blockRow, unsigned int tStart, unsigned int tEnd) {
+      PredictRowFac<NodeT>(rowStart + blockRow, predict->RowFac(blockRow), blockRow, bag, tStart, tEnd);
+    });
 }
 
 
@@ -120,17 +255,43 @@ void Forest::PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const
 
    @return Void with output vector parameter.
  */
-void Forest::PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-      PredictRowMixed(row, predict->RowNum(row - rowStart), predict->RowFac(row - rowStart), row - rowStart, bag);
-    }
+template<class NodeT> void Forest::PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
+  RowTiles(rowStart, rowEnd, [&](unsigned int blockRow, unsigned int tStart, unsigned int tEnd) {
+      PredictRowMixed<NodeT>(rowStart + blockRow, predict->RowNum(blockRow), predict->RowFac(blockRow), blockRow, bag, tStart, tEnd);
+    });
+}
+
+
+/**
+   @brief Drives the traversal of a block of rows.  Row-major traversal
+   walks each row through the entire forest in turn, streaming the whole
+   forest once per row.  Tiled traversal instead walks a tile of rows
+   through one group of trees before moving to the next group, so that
+   the group remains cached across the tile.  Tiles are the unit of
+   parallelism.
+
+   @param visit walks a block-relative row through a range of trees.
+
+   @return void.
+ */
+void Forest::RowTiles(unsigned int rowStart, unsigned int rowEnd, const std::function<void(unsigned int, unsigned int, unsigned int)> &visit) const {
+  unsigned int blockRows = rowEnd - rowStart;
+  if (rowTile == 0) {
+    predict->Pool()->Run(blockRows, [&](unsigned int blockRow) {
+        visit(blockRow, 0, nTree);
+      }, nTree);
+    return;
   }
 
+  predict->Pool()->Run((blockRows + rowTile - 1) / rowTile, [&](unsigned int tileIdx) {
+      unsigned int tileStart = tileIdx * rowTile;
+      unsigned int tileEnd = std::min(tileStart + rowTile, blockRows);
+      for (unsigned int groupIdx = 0; groupIdx + 1 < groupStart.size(); groupIdx++) {
+        for (unsigned int blockRow = tileStart; blockRow < tileEnd; blockRow++) {
+          visit(blockRow, groupStart[groupIdx], groupStart[groupIdx + 1]);
+        }
+      }
+    }, rowTile * nTree);
 }
 
 
@@ -143,24 +304,30 @@ void Forest::PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, cons
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tStart is the first tree walked.
+
+   @param tEnd is one beyond the last tree walked.
+
    @return Void with output vector parameter.
  */
 
-void Forest::PredictRowNum(unsigned int row, const double rowT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  for (unsigned int tIdx = 0; tIdx < NTree(); tIdx++) {
+template<class NodeT> void Forest::PredictRowNum(unsigned int row, const double rowT[], unsigned int blockRow, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const {
+  for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
     if (bag->TestBit(row, tIdx)) {
       predict->BagIdx(blockRow, tIdx);
       continue;
     }
 
-    unsigned int idx = treeOrigin[tIdx];
+    const NodeT *node;
+    Base(tIdx, node);
+    unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred; // N.B.:  Use BlockIdx() if numericals not numbered from 0.
     double num;
-    Ref(idx, pred, bump, num);
+    Ref(node, idx, pred, bump, num);
     while (bump != 0) {
-      idx += (rowT[pred] <= num ? bump : bump + 1);
-      Ref(idx, pred, bump, num);
+      idx += (NumLeft(node, tIdx, idx, rowT[pred], num) ? bump : bump + 1);
+      Ref(node, idx, pred, bump, num);
     }
     predict->LeafIdx(blockRow, tIdx, pred);
   }
@@ -176,24 +343,30 @@ void Forest::PredictRowNum(unsigned int row, const double rowT[], unsigned int b
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tStart is the first tree walked.
+
+   @param tEnd is one beyond the last tree walked.
+
    @return Void with output vector parameter.
  */
-void Forest::PredictRowFac(unsigned int row, const unsigned int rowT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  for (unsigned int tIdx = 0; tIdx < NTree(); tIdx++) {
+template<class NodeT> void Forest::PredictRowFac(unsigned int row, const unsigned int rowT[], unsigned int blockRow, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const {
+  for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
     if (bag->TestBit(row, tIdx)) {
       predict->BagIdx(blockRow, tIdx);
       continue;
     }
 
-    unsigned int idx = treeOrigin[tIdx];
+    const NodeT *node;
+    Base(tIdx, node);
+    unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred; // N.B.: Use BlockIdx() if not factor-only (zero based).
     double num;
-    Ref(idx, pred, bump, num);
+    Ref(node, idx, pred, bump, num);
     while (bump != 0) {
       unsigned int bitOff = (unsigned int) num + rowT[pred];
-      idx += facSplit->TestBit(tIdx, bitOff) ? bump : bump + 1;
-      Ref(idx, pred, bump, num);
+      idx += FacBit(tIdx, bitOff) ? bump : bump + 1;
+      Ref(node, idx, pred, bump, num);
     }
     predict->LeafIdx(blockRow, tIdx, pred);
   }
@@ -211,25 +384,31 @@ void Forest::PredictRowFac(unsigned int row, const unsigned int rowT[], unsigned
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tStart is the first tree walked.
+
+   @param tEnd is one beyond the last tree walked.
+
    @return Void with output vector parameter.
  */
-void Forest::PredictRowMixed(unsigned int row, const double rowNT[], const unsigned int rowFT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  for (unsigned int tIdx = 0; tIdx < NTree(); tIdx++) {
+template<class NodeT> void Forest::PredictRowMixed(unsigned int row, const double rowNT[], const unsigned int rowFT[], unsigned int blockRow, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const {
+  for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
     if (bag->TestBit(row, tIdx)) {
       predict->BagIdx(blockRow, tIdx);
       continue;
     }
 
-    unsigned int idx = treeOrigin[tIdx];
+    const NodeT *node;
+    Base(tIdx, node);
+    unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred;
     double num;
-    Ref(idx, pred, bump, num);
+    Ref(node, idx, pred, bump, num);
     while (bump != 0) {
       bool isFactor;
       unsigned int blockIdx = predMap->BlockIdx(pred, isFactor);
-      idx += isFactor ? (facSplit->TestBit(tIdx, (unsigned int) num + rowFT[blockIdx]) ? bump : bump + 1) : (rowNT[blockIdx] <= num ? bump : bump + 1);
-      Ref(idx, pred, bump, num);
+      idx += isFactor ? (FacBit(tIdx, (unsigned int) num + rowFT[blockIdx]) ? bump : bump + 1) : (NumLeft(node, tIdx, idx, rowNT[blockIdx], num) ? bump : bump + 1);
+      Ref(node, idx, pred, bump, num);
     }
     predict->LeafIdx(blockRow, tIdx, pred);
   }
@@ -241,7 +420,7 @@ void Forest::PredictRowMixed(unsigned int row, const double rowNT[], const unsig
 void ForestTrain::NodeInit(unsigned int treeHeight) {
   ForestNode fn;
   fn.Init();
-  forestNode.insert(forestNode.end(), treeHeight, fn);
+  forestNode.Extend(treeHeight, fn);
 }
 
 
@@ -254,16 +433,29 @@ void ForestTrain::BitProduce(const BV *splitBits, unsigned int bitEnd) {
 
 
 /**
-  @brief Reserves space in the relevant vectors for new trees.
+  @brief Sizes the next segments of the relevant stores for new trees.
+  An underestimate opens further segments, rather than relocating.
  */
 void ForestTrain::Reserve(unsigned int blockHeight, unsigned int blockFac, double slop) {
-  forestNode.reserve(slop * blockHeight);
+  forestNode.Reserve(slop * blockHeight);
   if (blockFac > 0) {
-    facVec.reserve(slop * blockFac);
+    facVec.Reserve(slop * blockFac);
   }
 }
 
 
+/**
+   @brief Copies the completed forest into the front end's vectors, each
+   contiguous and sized exactly.
+
+   @return void, with front-end vectors filled.
+ */
+void ForestTrain::Export() {
+  forestNode.Export(nodeOut);
+  facVec.Export(facOut);
+}
+
+
 /**
    @brief Registers current vector sizes of crescent forest as origin values.
 
@@ -282,11 +474,17 @@ void ForestTrain::Origins(unsigned int tIdx) {
 
    @param rowRank holds the presorted predictor values.
 
+   @param splitQuant gives the per-predictor splitting quantile.
+
+   @param tStart is the first tree whose splits remain in rank form.
+   Earlier trees, if any, have already been updated.
+
    @return void
  */
-void ForestTrain::SplitUpdate(const PMTrain *pmTrain, const RowRank *rowRank) const {
-  for (unsigned int i = 0; i < forestNode.size(); i++) {
-    forestNode[i].SplitUpdate(pmTrain, rowRank);
+void ForestTrain::SplitUpdate(const PMTrain *pmTrain, const RowRank *rowRank, const double splitQuant[], unsigned int tStart) {
+  unsigned int nodeStart = tStart < treeOrigin.size() ? treeOrigin[tStart] : forestNode.size();
+  for (unsigned int i = nodeStart; i < forestNode.size(); i++) {
+    forestNode[i].SplitUpdate(pmTrain, rowRank, splitQuant);
   }
 }
 
@@ -296,9 +494,11 @@ void ForestTrain::SplitUpdate(const PMTrain *pmTrain, const RowRank *rowRank) co
 
    @param rowRank holds the presorted predictor values.
 
+   @param splitQuant gives the per-predictor splitting quantile.
+
    @return void.
  */
-void ForestNode::SplitUpdate(const PMTrain *pmTrain, const RowRank *rowRank) {
+void ForestNode::SplitUpdate(const PMTrain *pmTrain, const RowRank *rowRank, const double splitQuant[]) {
   if (Nonterminal() && !pmTrain->IsFactor(pred)) {
     splitVal.num = rowRank->QuantRank(pred, splitVal.rankRange, splitQuant);
   }
@@ -19,15 +19,18 @@
 
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cmath>
 
 #include "param.h"
+#include "bv.h"
 
 
 /**
    @brief To replace parallel array access.
  */
 class ForestNode {
-  static const double *splitQuant;
   unsigned int pred;
   unsigned int bump;
   union {
@@ -49,17 +52,7 @@ class ForestNode {
 
   
  public:
-  static void Immutables(const double _splitQuant[]) {
-    splitQuant = _splitQuant;
-  }
-
-  
-  static void DeImmutables() {
-    splitQuant = 0;
-  }
-  
-  
-  void SplitUpdate(const class PMTrain *pmTrain, const class RowRank *rowRank);
+  void SplitUpdate(const class PMTrain *pmTrain, const class RowRank *rowRank, const double splitQuant[]);
   static void Export(const unsigned int _nodeOrigin[], unsigned int _nTree, const ForestNode *_forestNode, unsigned int nodeEnd, std::vector<std::vector<unsigned int> > &_pred, std::vector<std::vector<unsigned int> > &_bump, std::vector<std::vector<double> > &_split);
 
   inline void Init() {
@@ -109,21 +102,122 @@ class ForestNode {
 };
 
 
+/**
+   @brief Inference-only node, half the width of ForestNode, derived from
+   a trained forest when it is loaded.
+
+   Numeric split values are held in single precision, rounded downward.
+   Observations at or below the rounded value branch left outright, and
+   those clearly above it branch right.  Only the rare observation lying
+   within rounding distance consults the full node for its exact value,
+   so that branching is identical to that through the full nodes.  Nodes
+   whose predictor, successor offset, split magnitude or factor bit
+   offset does not fit are escaped to a side table of full nodes.
+ */
+class NodeCompact {
+  union {
+    float num; // Split value or factor bit offset, if nonterminal.
+    unsigned int idx; // Leaf index, if terminal;  else escape index, if escaped.
+  } val;
+  uint16_t pred; // Predictor index, or 'escape'.
+  uint16_t bump; // Offset to left successor:  zero iff terminal.
+
+ public:
+  static const unsigned int escape = 0xffff; // Reserved predictor index.
+  static const unsigned int facLimit = 1 << 24; // Bit offsets exact in float.
+  static constexpr double roundSlop = 1.0 / (1 << 22); // Exceeds relative rounding.
+  static constexpr double roundMin = 1.0e-44; // Exceeds subnormal rounding.
+
+  bool Init(const ForestNode &node, bool isFactor, unsigned int escIdx);
+
+
+  /**
+     @brief Unpacks the node as would ForestNode::Ref(), consulting the
+     escape table if the node has been escaped.
+
+     @param escTable holds the full versions of escaped nodes.
+
+     @return void, with output reference parameters.
+   */
+  inline void Ref(unsigned int &_pred, unsigned int &_bump, double &_num, const ForestNode escTable[]) const {
+    if (pred == escape) {
+      escTable[val.idx].Ref(_pred, _bump, _num);
+    }
+    else if (bump == 0) {
+      _pred = val.idx;
+      _bump = 0;
+    }
+    else {
+      _pred = pred;
+      _bump = bump;
+      _num = val.num;
+    }
+  }
+};
+
+
+/**
+   @brief Compact copy of a trained forest, built once when the forest is
+   loaded and then walked by any number of predictions.  Tree-relative
+   node indices are those of the full forest, with which the copy is
+   walked, as observations near a rounded split value consult it.
+ */
+class ForestCompact {
+  std::vector<NodeCompact> compactNode; // Compact nodes, contiguous by tree.
+  std::vector<size_t> compactOrigin; // Offset of each tree's nodes.
+  std::vector<ForestNode> escape; // Nodes not representable compactly.
+
+ public:
+  ForestCompact(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _nPredNum);
+
+
+  inline unsigned int NTree() const {
+    return compactOrigin.size();
+  }
+
+
+  /**
+     @brief Base of a tree's compact nodes.
+   */
+  inline const NodeCompact *Base(unsigned int tIdx) const {
+    return &compactNode[compactOrigin[tIdx]];
+  }
+
+
+  /**
+     @brief Full versions of the escaped nodes, by escape index.
+   */
+  inline const ForestNode *Escape() const {
+    return escape.data();
+  }
+};
+
+
 /**
    @brief The decision forest as a read-only collection.
 */
 class Forest {
-  const ForestNode *forestNode;
-  const unsigned int *treeOrigin;
+  static constexpr size_t groupBytes = 1 << 18; // Node budget of a tree group.
+
   const unsigned int nTree;
-  class BVJagged *facSplit; // Consolidation of per-tree values.
+  std::vector<const ForestNode*> treeNode; // Base of nodes, per tree.
+  std::vector<const unsigned int*> treeFac; // Base of factor bits, per tree.
+  const unsigned int rowTile; // Rows walked per tile:  zero iff row-major.
+  std::vector<unsigned int> groupStart; // First tree of each group, plus end.
+  const ForestCompact *forestCompact; // Compact copy walked:  null iff full.
 
   class Predict *predict;
   const class PMPredict *predMap;
 
-  void PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
-  void PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
-  void PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
+  template<class NodeT> void PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
+  template<class NodeT> void PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
+  template<class NodeT> void PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
+  template<class NodeT> void PredictRowNum(unsigned int row, const double rowT[], unsigned int rowBlock, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const;
+  template<class NodeT> void PredictRowFac(unsigned int row, const unsigned int rowT[], unsigned int rowBlock, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const;
+  template<class NodeT> void PredictRowMixed(unsigned int row, const double rowNT[], const unsigned int rowIT[], unsigned int rowBlock, const class BitMatrix *bag, unsigned int tStart, unsigned int tEnd) const;
+  template<class NodeT> void PredictAcrossFormat(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
+  void TreeGroups(const unsigned int _origin[], unsigned int treeTile);
+  void RowTiles(unsigned int rowStart, unsigned int rowEnd, const std::function<void(unsigned int, unsigned int, unsigned int)> &visit) const;
 
 
   inline unsigned int NTree() const {
@@ -131,27 +225,92 @@ class Forest {
   }
 
 
-  inline void Ref(unsigned int idx, unsigned int &pred, unsigned int &bump, double &num) const {
-    forestNode[idx].Ref(pred, bump, num);
+  /**
+     @brief Tests a tree's factor-split bit.
+
+     @param bitOff is the tree-relative bit offset.
+
+     @return true iff bit set.
+   */
+  inline bool FacBit(unsigned int tIdx, unsigned int bitOff) const {
+    unsigned int mask;
+    unsigned int slot = BV::SlotMask(bitOff, mask);
+    return (treeFac[tIdx][slot] & mask) != 0;
+  }
+
+
+  /**
+     @brief Base of a tree's nodes, in the format walked.
+   */
+  inline void Base(unsigned int tIdx, const ForestNode *&node) const {
+    node = treeNode[tIdx];
+  }
+
+
+  inline void Base(unsigned int tIdx, const NodeCompact *&node) const {
+    node = forestCompact->Base(tIdx);
+  }
+
+
+  /**
+     @brief Unpacks a tree-relative node, in the format walked.
+   */
+  inline void Ref(const ForestNode *node, unsigned int idx, unsigned int &pred, unsigned int &bump, double &num) const {
+    node[idx].Ref(pred, bump, num);
+  }
+
+
+  inline void Ref(const NodeCompact *node, unsigned int idx, unsigned int &pred, unsigned int &bump, double &num) const {
+    node[idx].Ref(pred, bump, num, forestCompact->Escape());
+  }
+
+
+  /**
+     @brief Tests whether a numeric observation branches left, given the
+     split value unpacked in the format walked.  The node pointer only
+     selects the format:  tree and node indices are consulted solely by
+     the compact format.
+
+     @return true iff observation does not exceed the split value.
+   */
+  inline bool NumLeft(const ForestNode *, unsigned int, unsigned int, double x, double num) const {
+    return x <= num;
+  }
+
+
+  /**
+     @brief As above, but resolving observations within rounding distance
+     of the compact split value against the full node.
+   */
+  inline bool NumLeft(const NodeCompact *, unsigned int tIdx, unsigned int idx, double x, double num) const {
+    if (x <= num)
+      return true;
+    else if (x > num + std::fabs(num) * NodeCompact::roundSlop + NodeCompact::roundMin)
+      return false;
+
+    unsigned int pred, bump;
+    double numFull;
+    treeNode[tIdx][idx].Ref(pred, bump, numFull);
+    return x <= numFull;
   }
   
 
  public:
   void PredictAcross(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const ;
-   void PredictRowNum(unsigned int row, const double rowT[], unsigned int rowBlock, const class BitMatrix *bag) const;
-  void PredictRowFac(unsigned int row, const unsigned int rowT[], unsigned int rowBlock, const class BitMatrix *bag) const;
-  void PredictRowMixed(unsigned int row, const double rowNT[], const unsigned int rowIT[], unsigned int rowBlock, const class BitMatrix *bag) const;
 
-  Forest(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facVec[], size_t _facLen, const unsigned int _facOrigin[], unsigned int _nFac, class Predict *_predict);
+  Forest(const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facVec[], size_t _facLen, const unsigned int _facOrigin[], unsigned int _nFac, class Predict *_predict, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact);
+  Forest(const SegVec<ForestNode> &_forestNode, const unsigned int _origin[], unsigned int _nTree, const SegVec<unsigned int> &_facVec, const unsigned int _facOrigin[], class Predict *_predict, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact);
   ~Forest();
 };
 
 
 class ForestTrain {
-  std::vector<ForestNode> &forestNode;
+  std::vector<ForestNode> &nodeOut; // Front end's copy:  filled on export.
   std::vector<unsigned int> &treeOrigin;
   std::vector<unsigned int> &facOrigin;
-  std::vector<unsigned int> &facVec;
+  std::vector<unsigned int> &facOut; // Front end's copy:  filled on export.
+  SegVec<ForestNode> forestNode; // Crescent nodes, contiguous by tree.
+  SegVec<unsigned int> facVec; // Crescent factor bits, contiguous by tree.
 
 
   inline unsigned int NodeIdx(unsigned int tIdx, unsigned int nodeOffset) {
@@ -182,7 +341,21 @@ class ForestTrain {
   void Origins(unsigned int tIdx);
   void Reserve(unsigned int nodeEst, unsigned int facEst, double slop);
   void NodeInit(unsigned int treeHeight);
-  void SplitUpdate(const class PMTrain *pmTrain, const class RowRank *rowRank) const;
+  void SplitUpdate(const class PMTrain *pmTrain, const class RowRank *rowRank, const double splitQuant[], unsigned int tStart = 0);
+  void Export();
+
+
+  /**
+     @brief Accessors for the segmented node and factor-bit stores.
+   */
+  inline const SegVec<ForestNode> &Nodes() const {
+    return forestNode;
+  }
+
+
+  inline const SegVec<unsigned int> &FacVec() const {
+    return facVec;
+  }
 
 
   /**
@@ -21,8 +21,14 @@
 #include "splitsig.h"
 #include "bottom.h"
 #include "path.h"
+#include "trainctx.h"
+#include "subtree.h"
+#include "taskpool.h"
 
 #include <numeric>
+#include <algorithm>
+#include <chrono>
+
 
 // Testing only:
 //#include <iostream>
@@ -31,41 +37,18 @@
 //clock_t clock(void);
 
 
-unsigned int IndexLevel::totLevels = 0;
-unsigned int IndexLevel::minNode = 0;
-
-/**
-   @brief Initialization of static invariants.
-
-   @param _minNode is the minimum node size for splitting.
-
-   @param _totLevels is the maximum number of levels to evaluate.
-
-   @return void.
- */
-void IndexLevel::Immutables(unsigned int _minNode, unsigned int _totLevels) {
-  minNode = _minNode;
-  totLevels = _totLevels;
-}
-
-
 /**
-   @brief Reset of statics.
-
-   @return void.
- */
-void IndexLevel::DeImmutables() {
-  totLevels = 0;
-  minNode = 0;
-}
+   @brief Per-tree constructor.  Sets up root node for level zero.
 
+   @param _ctx is the training context.
 
+   @param _level is the depth of the root:  nonzero iff a local subtree.
+   Subtrees complete without further handoff.
 
-/**
-   @brief Per-tree constructor.  Sets up root node for level zero.
+   @param _minInfo is the information threshold inherited by the root.
  */
-IndexLevel::IndexLevel(const std::vector<SampleNode> &_stageSample, unsigned int nSamp, double bagSum) : stageSample(_stageSample), indexSet(std::vector<IndexSet>(1)), bagCount(stageSample.size()), idxLive(bagCount), relBase(std::vector<unsigned int>(1)), rel2ST(std::vector<unsigned int>(bagCount)), rel2Sample(stageSample), st2Split(std::vector<unsigned int>(bagCount)) {
-  indexSet[0].Init(0, nSamp, 0, bagCount, 0.0, 0, bagSum, 0, 0, bagCount);
+IndexLevel::IndexLevel(const TrainCtx *_ctx, const PMTrain *_pmTrain, const std::vector<SampleNode> &_stageSample, unsigned int nSamp, double bagSum, unsigned int _level, double _minInfo) : ctx(_ctx), pmTrain(_pmTrain), minNode(ctx->minNode), totLevels(ctx->totLevels), minRatio(ctx->minRatio), subtreeMax(_level == 0 ? ctx->subtreeMax : 0), stageSample(_stageSample), indexSet(std::vector<IndexSet>(1)), bagCount(stageSample.size()), level(_level), idxLive(bagCount), relBase(std::vector<unsigned int>(1)), rel2ST(std::vector<unsigned int>(bagCount)), rel2Sample(stageSample), st2Split(std::vector<unsigned int>(bagCount)) {
+  indexSet[0].Init(0, nSamp, 0, bagCount, _minInfo, 0, bagSum, 0, 0, bagCount);
   relBase[0] = 0;
   std::iota(rel2ST.begin(), rel2ST.end(), 0);
   std::fill(st2Split.begin(), st2Split.end(), 0);
@@ -87,7 +70,10 @@ IndexSet::IndexSet() : preBias(0.0), splitIdx(0), ptId(0), lhStart(0), extent(0)
 
 /**
    @brief Instantiates a block of PreTees for bulk return, but may or may
-   not build them concurrently.
+   not build them concurrently.  Trees drawing from the front-end
+   generator are grown one at a time, so that draws are ordered.
+
+   @param ctx is the training context, accumulating growing time.
 
    @param sampleBlock contains the sample objects characterizing the roots.
 
@@ -95,26 +81,61 @@ IndexSet::IndexSet() : preBias(0.0), splitIdx(0), ptId(0), lhStart(0), extent(0)
 
    @return brace of 'treeBlock'-many PreTree objects.
 */
-PreTree **IndexLevel::BlockTrees(const PMTrain *pmTrain, Sample **sampleBlock, int treeBlock) {
+PreTree **IndexLevel::BlockTrees(TrainCtx *ctx, const PMTrain *pmTrain, Sample **sampleBlock, int treeBlock) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
   PreTree **ptBlock = new PreTree*[treeBlock];
 
-  for (int blockIdx = 0; blockIdx < treeBlock; blockIdx++) {
-    Sample *sample = sampleBlock[blockIdx];
-    ptBlock[blockIdx] = OneTree(pmTrain, sample);
+  if (ctx->treeParallel && !ctx->feRNG) {
+    TreeParallel(ctx, pmTrain, sampleBlock, treeBlock, ptBlock);
+  }
+  else if (ctx->levelSync && treeBlock > 1) {
+    BlockLevels(ctx, pmTrain, sampleBlock, treeBlock, ptBlock);
+  }
+  else {
+    for (int blockIdx = 0; blockIdx < treeBlock; blockIdx++) {
+      Sample *sample = sampleBlock[blockIdx];
+      ptBlock[blockIdx] = OneTree(ctx, pmTrain, sample);
+    }
   }
+  ctx->growTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
   
   return ptBlock;
 }
 
 
+/**
+   @brief Grows the trees of a block concurrently, one tree per worker.
+
+   Trees share no mutable state, so the block is simply scheduled over
+   the task pool, largest bag first.  Not employed when variates are
+   drawn from the front end, whose callbacks are neither reentrant nor
+   ordered across workers.
+   Level-wise loops issued from within a tree then execute serially in
+   the worker growing it.
+
+   @param ptBlock outputs the block of trained PreTrees.
+
+   @return void, with output parameter vector.
+ */
+void IndexLevel::TreeParallel(const TrainCtx *ctx, const PMTrain *pmTrain, Sample **sampleBlock, int treeBlock, PreTree **ptBlock) {
+  std::vector<unsigned int> cost(treeBlock);
+  for (int blockIdx = 0; blockIdx < treeBlock; blockIdx++) {
+    cost[blockIdx] = sampleBlock[blockIdx]->BagCount();
+  }
+  ctx->taskPool->Run(cost, [&](unsigned int blockIdx) {
+      ptBlock[blockIdx] = OneTree(ctx, pmTrain, sampleBlock[blockIdx]);
+    });
+}
+
+
 /**
    @brief Performs sampling and level processing for a single tree.
 
    @return void.
  */
-PreTree *IndexLevel::OneTree(const PMTrain *pmTrain, Sample *sample) {
-  PreTree *preTree = new PreTree(pmTrain, sample->BagCount());
-  IndexLevel *index = new IndexLevel(sample->StageSample(), Sample::NSamp(), sample->BagSum());
+PreTree *IndexLevel::OneTree(const TrainCtx *ctx, const PMTrain *pmTrain, Sample *sample) {
+  PreTree *preTree = new PreTree(pmTrain, sample->BagCount(), ctx->heightEst);
+  IndexLevel *index = new IndexLevel(ctx, pmTrain, sample->StageSample(), sample->NSamp(), sample->BagSum());
   Bottom *bottom = sample->Bot();
   index->Levels(bottom, preTree);
   delete index;
@@ -132,15 +153,203 @@ PreTree *IndexLevel::OneTree(const PMTrain *pmTrain, Sample *sample) {
    @return void.
 */
 void  IndexLevel::Levels(Bottom *bottom, PreTree *preTree) {
-  for (unsigned int level = 0; !indexSet.empty(); level++) {
+  while (!indexSet.empty()) {
     //    cout << "\nLevel " << level << "\n" << endl;
     std::vector<SSNode*> argMax(indexSet.size());
     bottom->Split(*this, argMax);
+    Advance(bottom, preTree, argMax);
+  }
+}
+
+
+/**
+   @brief Consumes the splits found at the current level and produces
+   the index sets of the next.
+
+   @param argMax holds the splitting signatures of the current level.
+
+   @return void.
+ */
+void IndexLevel::Advance(Bottom *bottom, PreTree *preTree, std::vector<SSNode*> &argMax) {
+  Subtrees(bottom, preTree);
+
+  unsigned int leafNext;
+  unsigned int splitNext = SplitCensus(argMax, leafNext, level + 1 == totLevels);
+  Consume(bottom, preTree, splitNext, leafNext);
+  Produce(bottom, preTree, splitNext);
+  level++;
+}
+
+
+/**
+   @brief Grows the trees of a block level by level, in lockstep.
+
+   The restaging and splitting schedules of every live tree are pooled
+   at each level, so that shallow levels expose work proportional to
+   the block size, rather than to the predictor count alone.  Trees
+   retire from the block as their frontiers empty.  Per-tree state is
+   unshared, so results coincide with those of serial training.
+
+   @param ptBlock outputs the block of trained PreTrees.
+
+   @return void, with output parameter vector.
+ */
+void IndexLevel::BlockLevels(const TrainCtx *ctx, const PMTrain *pmTrain, Sample **sampleBlock, int treeBlock, PreTree **ptBlock) {
+  std::vector<IndexLevel *> index(treeBlock);
+  std::vector<Bottom *> bottom(treeBlock);
+  std::vector<unsigned int> live(treeBlock);
+  for (int blockIdx = 0; blockIdx < treeBlock; blockIdx++) {
+    Sample *sample = sampleBlock[blockIdx];
+    ptBlock[blockIdx] = new PreTree(pmTrain, sample->BagCount(), ctx->heightEst);
+    index[blockIdx] = new IndexLevel(ctx, pmTrain, sample->StageSample(), sample->NSamp(), sample->BagSum());
+    bottom[blockIdx] = sample->Bot();
+    live[blockIdx] = blockIdx;
+  }
+
+  std::vector<std::pair<unsigned int, unsigned int> > coord; // Tree, position.
+  std::vector<unsigned int> cost;
+  while (!live.empty()) {
+    for (auto blockIdx : live) {
+      bottom[blockIdx]->Schedule(*index[blockIdx]);
+      for (unsigned int rsIdx = 0; rsIdx < bottom[blockIdx]->RestageCount(); rsIdx++) {
+        coord.push_back(std::make_pair(blockIdx, rsIdx));
+        cost.push_back(bottom[blockIdx]->RestageCost(rsIdx));
+      }
+    }
+
+    ctx->taskPool->Run(cost, [&](unsigned int coordIdx) {
+        bottom[coord[coordIdx].first]->Restage(coord[coordIdx].second);
+      });
+    coord.clear();
+    cost.clear();
+
+    for (auto blockIdx : live) {
+      bottom[blockIdx]->RestageClear();
+      bottom[blockIdx]->Stage(*index[blockIdx]);
+      bottom[blockIdx]->SplitPrepare(*index[blockIdx]);
+      for (unsigned int taskIdx = 0; taskIdx < bottom[blockIdx]->TaskCount(); taskIdx++) {
+        coord.push_back(std::make_pair(blockIdx, taskIdx));
+        cost.push_back(bottom[blockIdx]->TaskCost(taskIdx));
+      }
+    }
+
+    ctx->taskPool->Run(cost, [&](unsigned int coordIdx) {
+        bottom[coord[coordIdx].first]->SplitTask(coord[coordIdx].second);
+      });
+    coord.clear();
+    cost.clear();
+    for (auto blockIdx : live) {
+      bottom[blockIdx]->SplitReduce();
+    }
+
+    std::vector<unsigned int> liveNext;
+    for (auto blockIdx : live) {
+      IndexLevel *indexLevel = index[blockIdx];
+      std::vector<SSNode*> argMax(indexLevel->indexSet.size());
+      bottom[blockIdx]->ArgMax(*indexLevel, argMax);
+      indexLevel->Advance(bottom[blockIdx], ptBlock[blockIdx], argMax);
+      if (!indexLevel->indexSet.empty()) {
+        liveNext.push_back(blockIdx);
+      }
+      else {
+        delete indexLevel;
+        bottom[blockIdx]->SubtreeFrontier(ptBlock[blockIdx]);
+      }
+    }
+    live = std::move(liveNext);
+  }
+}
+
+
+/**
+   @brief Marks sufficiently small nodes of the current level for local
+   completion.  The root is never handed off, nor are nodes already
+   found unsplitable.
+
+   @param unsplitable is set for each node handed off.
+
+   @return void.
+ */
+void IndexLevel::Handoff(std::vector<bool> &unsplitable) {
+  if (subtreeMax == 0 || level == 0)
+    return;
 
-    unsigned int leafNext;
-    unsigned int splitNext = SplitCensus(argMax, leafNext, level + 1 == totLevels);
-    Consume(bottom, preTree, splitNext, leafNext);
-    Produce(bottom, preTree, splitNext);
+  for (auto & iSet : indexSet) {
+    unsigned int splitIdx = iSet.SplitIdx();
+    if (!unsplitable[splitIdx] && iSet.Extent() <= subtreeMax) {
+      unsplitable[splitIdx] = true;
+      handoff.push_back(splitIdx);
+    }
+  }
+}
+
+
+/**
+   @brief Completes the nodes handed off at this level, each as a
+   subtree in its own buffers, and grafts them onto the pretree.
+
+   The handed-off nodes are otherwise treated as terminal, so their
+   cells remain intact until the next level restages.  Subtrees are
+   grown concurrently, but grafted in level order, so that pretree
+   numbering does not depend on the thread schedule.  Subtrees drawing
+   from the front-end generator are grown serially, in level order, as
+   the order of their draws would otherwise vary with the schedule.
+
+   @return void.
+ */
+void IndexLevel::Subtrees(const Bottom *bottom, PreTree *preTree) {
+  if (handoff.empty())
+    return;
+
+  std::vector<unsigned int> buf2Local(bagCount); // Nodes do not overlap.
+  std::vector<Subtree *> subtree(handoff.size());
+  std::vector<unsigned int> cost(handoff.size());
+  for (unsigned int subIdx = 0; subIdx < handoff.size(); subIdx++) {
+    cost[subIdx] = Extent(handoff[subIdx]);
+  }
+  auto grow = [&](unsigned int subIdx) {
+    subtree[subIdx] = new Subtree(ctx, bottom, *this, handoff[subIdx], buf2Local);
+    subtree[subIdx]->Grow(ctx, pmTrain, *this, handoff[subIdx]);
+  };
+  if (ctx->feRNG) {
+    for (unsigned int subIdx = 0; subIdx < handoff.size(); subIdx++) {
+      grow(subIdx);
+    }
+  }
+  else {
+    ctx->taskPool->Run(cost, grow);
+  }
+
+  for (auto st : subtree) {
+    st->Graft(preTree);
+    delete st;
+  }
+  handoff.clear();
+}
+
+
+/**
+   @brief Localizes the samples of a node about to be handed off.
+
+   @param nodeRel is true iff buffers currently record node-relative
+   indices, else subtree-relative.
+
+   @param sampleLocal outputs the node's samples, in local order.
+
+   @param local2ST outputs the subtree index of each local sample.
+
+   @param buf2Local maps each buffered index of the node to its local
+   index.  Entries of other nodes are unchanged.
+
+   @return void, with output vectors.
+ */
+void IndexLevel::Localize(unsigned int splitIdx, bool nodeRel, std::vector<SampleNode> &sampleLocal, std::vector<unsigned int> &local2ST, std::vector<unsigned int> &buf2Local) const {
+  unsigned int base = relBase[splitIdx];
+  unsigned int extent = Extent(splitIdx);
+  sampleLocal = std::vector<SampleNode>(rel2Sample.begin() + base, rel2Sample.begin() + base + extent);
+  local2ST = std::vector<unsigned int>(rel2ST.begin() + base, rel2ST.begin() + base + extent);
+  for (unsigned int idx = 0; idx < extent; idx++) {
+    buf2Local[nodeRel ? base + idx : local2ST[idx]] = idx;
   }
 }
 
@@ -317,14 +526,9 @@ void IndexLevel::Reindex(Bottom *bottom, BV *replayExpl) {
   std::vector<unsigned int> succST(idxLive);
   std::vector<SampleNode> succSample(idxLive);
 
-  unsigned int i;
-#pragma omp parallel default(shared) private(i)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (i = 0; i < indexSet.size(); i++) {
+  ctx->taskPool->Run(ExtentCost(), [&](unsigned int i) {
       indexSet[i].Reindex(bottom, replayExpl, idxLive, rel2ST, succST, rel2Sample, succSample);
-    }
-  }
+    });
   rel2ST = std::move(succST);
   rel2Sample = std::move(succSample);
 }
@@ -453,8 +657,8 @@ void IndexLevel::Produce(Bottom *bottom, PreTree *preTree, unsigned int splitNex
 */
 void IndexSet::Produce(IndexLevel *indexLevel, Bottom *bottom, const PreTree *preTree, std::vector<IndexSet> &indexNext) const {
   if (ssNode != 0) {
-    Successor(indexLevel, indexNext, leftExpl ? succExpl : succImpl, bottom, lhSCount, lhStart, lhExtent, ssNode->MinInfo(), preTree->LHId(ptId), leftExpl ? sumExpl : sum - sumExpl, leftExpl ? pathExpl : pathImpl);
-    Successor(indexLevel, indexNext, leftExpl ? succImpl : succExpl, bottom, sCount - lhSCount, lhStart + lhExtent, extent - lhExtent, ssNode->MinInfo(), preTree->RHId(ptId), leftExpl ? sum - sumExpl : sumExpl, leftExpl ? pathImpl : pathExpl);
+    Successor(indexLevel, indexNext, leftExpl ? succExpl : succImpl, bottom, lhSCount, lhStart, lhExtent, ssNode->MinInfo(indexLevel->MinRatio()), preTree->LHId(ptId), leftExpl ? sumExpl : sum - sumExpl, leftExpl ? pathExpl : pathImpl);
+    Successor(indexLevel, indexNext, leftExpl ? succImpl : succExpl, bottom, sCount - lhSCount, lhStart + lhExtent, extent - lhExtent, ssNode->MinInfo(indexLevel->MinRatio()), preTree->RHId(ptId), leftExpl ? sum - sumExpl : sumExpl, leftExpl ? pathImpl : pathExpl);
   }
 }
 
@@ -488,18 +692,51 @@ void IndexSet::SuccInit(IndexLevel *indexLevel, Bottom *bottom, unsigned int _sp
    @brief Visits all live indices, so likely worth parallelizing.
  */
 void IndexLevel::SumsAndSquares(unsigned int ctgWidth, std::vector<double> &sumSquares, std::vector<double> &ctgSum, std::vector<bool> &unsplitable) const {
-  unsigned int splitIdx;
-  
-#pragma omp parallel default(shared) private(splitIdx)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (splitIdx = 0; splitIdx < indexSet.size(); splitIdx++) {
-    unsplitable[splitIdx] = indexSet[splitIdx].SumsAndSquares(rel2Sample, ctgWidth, sumSquares[splitIdx], &ctgSum[splitIdx * ctgWidth]);
-    }
+  std::vector<unsigned char> unsplitNode(indexSet.size()); // Bit vectors share words.
+  ctx->taskPool->Run(ExtentCost(), [&](unsigned int splitIdx) {
+      unsplitNode[splitIdx] = indexSet[splitIdx].SumsAndSquares(rel2Sample, ctgWidth, sumSquares[splitIdx], &ctgSum[splitIdx * ctgWidth]);
+    });
+  for (unsigned int splitIdx = 0; splitIdx < indexSet.size(); splitIdx++) {
+    unsplitable[splitIdx] = unsplitNode[splitIdx];
   }
 }
 
 
+/**
+   @brief Multi-output regression:  gathers the output sums of all live
+   indices.
+
+   @param nodeRel is true iff buffers record node-relative indices.
+
+   @param sumOut holds the output sums, by subtree index.
+
+   @param idxOut outputs the sums, by buffered index.
+
+   @param nodeOut outputs the sums, by node.  Assumed initialized to zero.
+
+   @return void, with output vectors.
+ */
+void IndexLevel::SumsOut(bool nodeRel, unsigned int nOut, const double sumOut[], std::vector<double> &idxOut, std::vector<double> &nodeOut) const {
+  ctx->taskPool->Run(ExtentCost(), [&](unsigned int splitIdx) {
+      indexSet[splitIdx].SumsOut(rel2ST, nodeRel, nOut, sumOut, &idxOut[0], &nodeOut[splitIdx * nOut]);
+    });
+}
+
+
+/**
+   @brief Estimates per-node costs for level-wide loops.
+
+   @return vector of node extents.
+ */
+std::vector<unsigned int> IndexLevel::ExtentCost() const {
+  std::vector<unsigned int> cost(indexSet.size());
+  for (unsigned int splitIdx = 0; splitIdx < cost.size(); splitIdx++) {
+    cost[splitIdx] = indexSet[splitIdx].Extent();
+  }
+  return cost;
+}
+
+
 /**
    @brief Sums each category for a node splitable in the upcoming level.
 
@@ -535,3 +772,51 @@ bool IndexSet::SumsAndSquares(const std::vector<SampleNode> &rel2Sample, unsigne
   return unsplitable;
 }
 
+
+
+/**
+   @brief Copies the output sums of the node's indices to their buffered
+   positions, accumulating node totals.
+
+   @param nodeOut accumulates the node's sums, by output.
+
+   @return void.
+ */
+void IndexSet::SumsOut(const std::vector<unsigned int> &rel2ST, bool nodeRel, unsigned int nOut, const double sumOut[], double idxOut[], double nodeOut[]) const {
+  for (unsigned int relIdx = relBase; relIdx < relBase + extent; relIdx++) {
+    unsigned int stIdx = rel2ST[relIdx];
+    const double *out = &sumOut[stIdx * nOut];
+    double *bufOut = &idxOut[(nodeRel ? relIdx : stIdx) * nOut];
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      bufOut[outIdx] = out[outIdx];
+      nodeOut[outIdx] += out[outIdx];
+    }
+  }
+}
+
+
+/**
+   @brief Maps the subtree indices live in the current level to their
+   nodes and node-relative indices.
+
+   @param stNode outputs the containing node of each live index.  Entries
+   for extinct indices are left unchanged.
+
+   @param stRel outputs the node-relative index of each live index.
+
+   @return void, with output vectors.
+ */
+void IndexLevel::FrontMap(std::vector<unsigned int> &stNode, std::vector<unsigned int> &stRel) const {
+  for (auto & iSet : indexSet) {
+    iSet.FrontMap(rel2ST, stNode, stRel);
+  }
+}
+
+
+void IndexSet::FrontMap(const std::vector<unsigned int> &rel2ST, std::vector<unsigned int> &stNode, std::vector<unsigned int> &stRel) const {
+  for (unsigned int relIdx = relBase; relIdx < relBase + extent; relIdx++) {
+    unsigned int stIdx = rel2ST[relIdx];
+    stNode[stIdx] = splitIdx;
+    stRel[stIdx] = relIdx;
+  }
+}
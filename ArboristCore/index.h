@@ -80,6 +80,8 @@ class IndexSet {
   void Produce(class IndexLevel *indexLevel, class Bottom *bottom, const class PreTree *preTree, std::vector<IndexSet> &indexNext) const;
   static unsigned SplitAccum(class IndexLevel *indexLevel, unsigned int _extent, unsigned int &_idxLive, unsigned int &_idxMax);
   bool SumsAndSquares(const std::vector<class SampleNode> &rel2Sample, unsigned int ctgWidth, double &sumSquares, double *ctgSumCol) const;
+  void SumsOut(const std::vector<unsigned int> &rel2ST, bool nodeRel, unsigned int nOut, const double sumOut[], double idxOut[], double nodeOut[]) const;
+  void FrontMap(const std::vector<unsigned int> &rel2ST, std::vector<unsigned int> &stNode, std::vector<unsigned int> &stRel) const;
 
 
   /**
@@ -236,11 +238,16 @@ class IndexSet {
    @brief The index sets associated with nodes at a single subtree level.
  */
 class IndexLevel {
-  static unsigned int minNode;
-  static unsigned int totLevels;
+  const class TrainCtx *ctx;
+  const class PMTrain *pmTrain;
+  const unsigned int minNode; // Minimal splitable extent.
+  const unsigned int totLevels; // Level limit, if positive.
+  const double minRatio; // Information threshold ratio for splitting.
+  const unsigned int subtreeMax; // Extent completed locally:  zero iff none.
   const std::vector<class SampleNode> &stageSample;
   std::vector<IndexSet> indexSet;
   const unsigned int bagCount;
+  unsigned int level; // Zero-based depth of the current level.
   bool levelTerminal; // Whether this level must exit.
   unsigned int idxLive; // Total live indices.
   unsigned int idxMax; // Widest live node.
@@ -253,26 +260,43 @@ class IndexLevel {
   std::vector<unsigned int> rel2ST; // Maps to subtree index.
   std::vector<class SampleNode> rel2Sample;
   std::vector<unsigned int> st2Split; // Useful for subtree-relative indexing.
+  std::vector<unsigned int> handoff; // Nodes completed as local subtrees.
 
-  static class PreTree *OneTree(const class PMTrain *pmTrain, class Sample *sample);
+  static class PreTree *OneTree(const class TrainCtx *ctx, const class PMTrain *pmTrain, class Sample *sample);
+  static void TreeParallel(const class TrainCtx *ctx, const class PMTrain *pmTrain, class Sample **sampleBlock, int treeBlock, class PreTree **ptBlock);
+  static void BlockLevels(const class TrainCtx *ctx, const class PMTrain *pmTrain, class Sample **sampleBlock, int treeBlock, class PreTree **ptBlock);
+  void Advance(class Bottom *bottom, class PreTree *preTree, std::vector<class SSNode*> &argMax);
   unsigned int SplitCensus(std::vector<class SSNode *> &argMax, unsigned int &leafNext, bool _levelTerminal);
   void Consume(class Bottom *bottom, class PreTree *preTree, unsigned int splitNext, unsigned int leafNext);
   void Produce(class Bottom *bottom, class PreTree *preTree, unsigned int splitNext);
+  void Subtrees(const class Bottom *bottom, class PreTree *preTree);
+  std::vector<unsigned int> ExtentCost() const;
 
 
  public:
-  static void Immutables(unsigned int _minNode, unsigned int _totLevels);
-  static void DeImmutables();
-
-  IndexLevel(const std::vector<class SampleNode> &_stageSample, unsigned int _nSamp, double _bagSum);
+  IndexLevel(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const std::vector<class SampleNode> &_stageSample, unsigned int _nSamp, double _bagSum, unsigned int _level = 0, double _minInfo = 0.0);
   ~IndexLevel();
 
-  static class PreTree **BlockTrees(const class PMTrain *pmTrain, class Sample **sampleBlock, int _treeBlock);
+  static class PreTree **BlockTrees(class TrainCtx *ctx, const class PMTrain *pmTrain, class Sample **sampleBlock, int _treeBlock);
   void Levels(class Bottom *bottom, class PreTree *preTree);
   unsigned int IdxSucc(class Bottom *bottom, unsigned int extent, unsigned int ptId, unsigned int &outOff, bool terminal = false);
   void Reindex(class Bottom *bottom, class BV *replayExpl);
   void Reindex(class Bottom *bottom, class BV *replayExpl, class IdxPath *stPath);
   void SumsAndSquares(unsigned int ctgWidth, std::vector<double> &sumSquares, std::vector<double> &ctgSum, std::vector<bool> &unsplitable) const;
+  void SumsOut(bool nodeRel, unsigned int nOut, const double sumOut[], std::vector<double> &idxOut, std::vector<double> &nodeOut) const;
+  void FrontMap(std::vector<unsigned int> &stNode, std::vector<unsigned int> &stRel) const;
+  void Handoff(std::vector<bool> &unsplitable);
+  void Localize(unsigned int splitIdx, bool nodeRel, std::vector<class SampleNode> &sampleLocal, std::vector<unsigned int> &local2ST, std::vector<unsigned int> &buf2Local) const;
+
+
+  /**
+     @brief Accessor for nodes handed off at the current level.
+
+     @return level indices of nodes to be completed as local subtrees.
+   */
+  inline const std::vector<unsigned int> &HandoffNodes() const {
+    return handoff;
+  }
 
 
   /**
@@ -298,6 +322,26 @@ class IndexLevel {
   }
 
 
+  /**
+     @brief Accessor for current level.
+
+     @return zero-based depth of level under construction.
+   */
+  inline unsigned int Level() const {
+    return level;
+  }
+
+
+  /**
+     @brief Accessor for information threshold ratio.
+
+     @return minimum ratio of successor to parent information.
+   */
+  inline double MinRatio() const {
+    return minRatio;
+  }
+
+
   /**
      @brief 'bagCount' accessor.
 
@@ -323,6 +367,11 @@ class IndexLevel {
   }
   
 
+  inline unsigned int PTId(unsigned int splitIdx) const {
+    return indexSet[splitIdx].PTId();
+  }
+
+
   inline unsigned int StartIdx(unsigned int splitIdx) const {
     return indexSet[splitIdx].Start();
   }
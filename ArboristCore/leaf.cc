@@ -23,22 +23,15 @@
 //#include <iostream>
 //using namespace std;
 
-bool Leaf::thinLeaves = false;
-
-void Leaf::Immutables(bool _thinLeaves) {
-  thinLeaves = _thinLeaves;
-}
-
-
-void Leaf::DeImmutables() {
-  thinLeaves = false;
-}
-
-
 /**
-   @breif Training constructor.
+   @breif Training constructor.  Leaves already present, if warm
+   starting, are adopted by the segmented stores without copying.
+
+   @param _thinLeaves is true iff bag/leaf records are to be omitted.
  */
-Leaf::Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain) : origin(_origin), nTree(origin.size()), leafNode(_leafNode), bagLeaf(_bagLeaf), bagRow(new BitMatrix(_bagBits, rowTrain, nTree)) {
+Leaf::Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves) : thinLeaves(_thinLeaves), origin(_origin), nTree(origin.size()), leafOut(_leafNode), bagOut(_bagLeaf), bagRow(new BitMatrix(_bagBits, rowTrain, nTree)) {
+  leafNode.Adopt(leafOut);
+  bagLeaf.Adopt(bagOut);
 }
 
 
@@ -49,7 +42,7 @@ Leaf::~Leaf() {
 
 /**
  */
-LeafReg::LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain) : Leaf(_origin, _leafNode, _bagLeaf, _bagBits, rowTrain) {
+LeafReg::LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves) : Leaf(_origin, _leafNode, _bagLeaf, _bagBits, rowTrain, _thinLeaves) {
 }
 
 
@@ -58,13 +51,26 @@ LeafReg::~LeafReg() {
 
 
 /**
-   @brief Reserves leafNode space based on estimate.
+   @brief Sizes the next leaf and bag segments based on estimate.  An
+   underestimate opens further segments, rather than relocating.
 
    @return void.
  */
 void Leaf::Reserve(unsigned int leafEst, unsigned int bagEst) {
-  leafNode.reserve(leafEst);
-  bagLeaf.reserve(bagEst);
+  leafNode.Reserve(leafEst);
+  bagLeaf.Reserve(bagEst);
+}
+
+
+/**
+   @brief Copies the completed leaf and bag records into the front end's
+   vectors, each contiguous and sized exactly.
+
+   @return void, with front-end vectors filled.
+ */
+void Leaf::Export() {
+  leafNode.Export(leafOut);
+  bagLeaf.Export(bagOut);
 }
 
 
@@ -82,14 +88,37 @@ void LeafReg::Reserve(unsigned int leafEst, unsigned int bagEst) {
  */
 void LeafCtg::Reserve(unsigned int leafEst, unsigned int bagEst) {
   Leaf::Reserve(leafEst, bagEst);
-  weight.reserve(leafEst * ctgWidth);
+  weight.reserve(weight.size() + leafEst * ctgWidth);
+}
+
+
+/**
+   @brief Constructor for crescent multi-output forest.
+
+   @param _scoreOut accumulates per-output leaf scores.
+
+   @param _nOut is the number of response outputs.
+ */
+LeafMulti::LeafMulti(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves, std::vector<double> &_scoreOut, unsigned int _nOut) : LeafReg(_origin, _leafNode, _bagLeaf, _bagBits, rowTrain, _thinLeaves), scoreOut(_scoreOut), nOut(_nOut) {
+}
+
+
+LeafMulti::~LeafMulti() {
+}
+
+
+/**
+ */
+void LeafMulti::Reserve(unsigned int leafEst, unsigned int bagEst) {
+  LeafReg::Reserve(leafEst, bagEst);
+  scoreOut.reserve(scoreOut.size() + leafEst * nOut);
 }
 
 
 /**
    @brief Constructor for crescent forest.
  */
-LeafCtg::LeafCtg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int>  &_bagBits, unsigned int rowTrain, std::vector<double> &_weight, unsigned int _ctgWidth) : Leaf(_origin, _leafNode, _bagLeaf, _bagBits, rowTrain), weight(_weight), ctgWidth(_ctgWidth) {
+LeafCtg::LeafCtg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int>  &_bagBits, unsigned int rowTrain, bool _thinLeaves, std::vector<double> &_weight, unsigned int _ctgWidth) : Leaf(_origin, _leafNode, _bagLeaf, _bagBits, rowTrain, _thinLeaves), weight(_weight), ctgWidth(_ctgWidth) {
 }
 
 
@@ -112,6 +141,18 @@ void LeafReg::Leaves(const PMTrain *pmTrain, const Sample *sample, const std::ve
 }
 
 
+/**
+   @brief As above, but also scores each output.
+
+   @return void.
+ */
+void LeafMulti::Leaves(const PMTrain *pmTrain, const Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx) {
+  LeafReg::Leaves(pmTrain, sample, leafMap, tIdx);
+  unsigned int leafCount = 1 + *std::max_element(leafMap.begin(), leafMap.end());
+  ScoresOut((const SampleReg*) sample, leafMap, leafCount, tIdx);
+}
+
+
 /**
    @brief Records row, multiplicity and leaf index for bagged samples
    within a tree.
@@ -162,6 +203,36 @@ void LeafReg::Scores(const Sample *sample, const std::vector<unsigned int> &leaf
 }
 
 
+/**
+   @brief Derives per-output scores as means, as with the primary score.
+
+   @param leafMap maps sample id to leaf index.
+
+   @param leafCount is the number of leaves in the tree.
+
+   @return void, with side-effected score vector.
+*/
+void LeafMulti::ScoresOut(const SampleReg *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx) {
+  scoreOut.insert(scoreOut.end(), nOut * leafCount, 0.0);
+  std::vector<unsigned int> sCount(leafCount); // Per-leaf sample counts.
+  std::fill(sCount.begin(), sCount.end(), 0);
+  for (unsigned int sIdx = 0; sIdx < sample->BagCount(); sIdx++) {
+    unsigned int leafIdx = leafMap[sIdx];
+    const double *out = sample->SumOut(sIdx);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      ScoreOut(tIdx, leafIdx, outIdx) += out[outIdx];
+    }
+    sCount[leafIdx] += sample->SCount(sIdx);
+  }
+
+  for (unsigned int leafIdx = 0; leafIdx < leafCount; leafIdx++) {
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      ScoreOut(tIdx, leafIdx, outIdx) /= sCount[leafIdx];
+    }
+  }
+}
+
+
 /**
    @brief Writes the current tree origin and computes the extent of each leaf node.
 
@@ -170,15 +241,14 @@ void LeafReg::Scores(const Sample *sample, const std::vector<unsigned int> &leaf
    @void, with count-adjusted leaf nodes.
  */
 void Leaf::NodeExtent(const Sample *sample, std::vector<unsigned int> leafMap, unsigned int leafCount, unsigned int tIdx) {
-  unsigned int leafBase = leafNode.size();
-  origin[tIdx] = leafBase;
+  origin[tIdx] = leafNode.size();
 
   LeafNode init;
   init.Init();
-  leafNode.insert(leafNode.end(), leafCount, init);
+  LeafNode *treeLeaf = leafNode.Extend(leafCount, init);
   for (unsigned int sIdx = 0; sIdx < sample->BagCount(); sIdx++) {
     unsigned int leafIdx = leafMap[sIdx];
-    leafNode[leafBase + leafIdx].Count()++;
+    treeLeaf[leafIdx].Count()++;
   }
 }
 
@@ -17,6 +17,7 @@
 #define ARBORIST_LEAF_H
 
 #include "sample.h"
+#include "segvec.h"
 #include <vector>
 
 
@@ -61,6 +62,7 @@ class RankCount {
 class LeafNode {
   double score;
   unsigned int extent; // count of sample-index slots.
+  unsigned int unused; // Explicit padding, zeroed:  records byte-reproducible.
 
   static void TreeExport(const LeafNode _leafNode[], unsigned int _leafCount, unsigned int treeOff, std::vector<double> &_score, std::vector<unsigned int> &_extent);
 
@@ -93,6 +95,7 @@ class LeafNode {
   inline void Init() {
     score = 0.0;
     extent = 0;
+    unused = 0;
   }
 
   
@@ -124,11 +127,13 @@ class LeafNode {
 
 
 class Leaf {
-  static bool thinLeaves;
+  const bool thinLeaves; // Whether to omit bag/leaf records.
   std::vector<unsigned int> &origin; // Starting position, per tree.
   const unsigned int nTree;
-  std::vector<LeafNode> &leafNode;
-  std::vector<BagLeaf> &bagLeaf; // bagged row/count:  per sample.
+  std::vector<LeafNode> &leafOut; // Front end's copy:  filled on export.
+  std::vector<BagLeaf> &bagOut; // Front end's copy:  filled on export.
+  SegVec<LeafNode> leafNode; // Crescent leaves, contiguous by tree.
+  SegVec<BagLeaf> bagLeaf; // bagged row/count:  per sample.
   class BitMatrix *bagRow;
 
   static void TreeExport(const class BitMatrix *bag, const BagLeaf _bagLeaf[], unsigned int bagOrig, unsigned int bagCount, std::vector<unsigned int> &rowTree, std::vector<unsigned int> &sCountTree);
@@ -139,15 +144,26 @@ class Leaf {
   void NodeExtent(const class Sample *sample, std::vector<unsigned int> leafMap, unsigned int leafCount, unsigned int tIdx);
 
  public:
-  static void Immutables(bool _thinLeaves);
-  static void DeImmutables();
-
-  Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain);
+  Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves);
   virtual ~Leaf();
   virtual void Reserve(unsigned int leafEst, unsigned int bagEst);
   virtual void Leaves(const class PMTrain *pmTrain, const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx) = 0;
 
   void BagTree(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx);
+  void Export();
+
+
+  /**
+     @brief Accessors for the segmented leaf and bag stores.
+   */
+  inline const SegVec<LeafNode> &LeafNodes() const {
+    return leafNode;
+  }
+
+
+  inline const SegVec<BagLeaf> &BagLeaves() const {
+    return bagLeaf;
+  }
 
   
   inline unsigned Origin(unsigned int tIdx) {
@@ -221,7 +237,7 @@ class LeafReg : public Leaf {
 
 
  public:
-  LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain);
+  LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves);
   ~LeafReg();
   static void Export(const std::vector<unsigned int> &_origin, const LeafNode _leafNode[], unsigned int _leafCount, const BagLeaf _bagLeaf[], unsigned int _bagBits[], unsigned int _trainRow, std::vector<std::vector<unsigned int> >&rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> >&extentTree);
   
@@ -231,6 +247,34 @@ class LeafReg : public Leaf {
 };
 
 
+/**
+   @brief Multi-output regression:  scores each output, in addition to
+   the primary score held by the leaf node.
+ */
+class LeafMulti : public LeafReg {
+  std::vector<double> &scoreOut; // # leaves x # outputs
+  const unsigned int nOut;
+
+  void ScoresOut(const class SampleReg *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx);
+ public:
+  LeafMulti(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves, std::vector<double> &_scoreOut, unsigned int _nOut);
+  ~LeafMulti();
+
+  void Reserve(unsigned int leafEst, unsigned int bagEst);
+  void Leaves(const class PMTrain *pmTrain, const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx);
+
+
+  /**
+     @brief Looks up score by leaf index and output.
+
+     @return reference to score slot.
+   */
+  inline double &ScoreOut(unsigned int tIdx, unsigned int leafIdx, unsigned int outIdx) {
+    return scoreOut[nOut * NodeIdx(tIdx, leafIdx) + outIdx];
+  }
+};
+
+
 class LeafCtg : public Leaf {
   std::vector<double> &weight; // # leaves x # categories
   const unsigned int ctgWidth;
@@ -239,7 +283,7 @@ class LeafCtg : public Leaf {
 
   void Scores(const class PMTrain *pmTrain, const class SampleCtg *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx);
  public:
-  LeafCtg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, std::vector<double> &_weight, unsigned int _ctgWdith);
+  LeafCtg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagLeaf, std::vector<unsigned int> &_bagBits, unsigned int rowTrain, bool _thinLeaves, std::vector<double> &_weight, unsigned int _ctgWdith);
   ~LeafCtg();
 
   static void Export(const std::vector<unsigned int> &_origin, const LeafNode _leafNode[], unsigned int _leafCount, const BagLeaf _bagLeaf[], unsigned int _bagBits[], unsigned int _trainRow, const double _weight[], unsigned int _ctgWidth, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<double> > &_weightTree);
@@ -79,8 +79,9 @@ class IdxPath {
   static constexpr unsigned int maskExtinct = NodePath::noPath;
   static constexpr unsigned int maskLive = maskExtinct - 1;
   static constexpr unsigned int relMax = 1 << 15;
+  static constexpr unsigned int pathPad = 3; // Word-wide reads of final path.
   std::vector<unsigned int> relFront;
-  std::vector<unsigned char> pathFront;
+  std::vector<unsigned char> pathFront; // Padded for vector gathers.
 
   // Only defined for enclosing Levels employing node-relative indexing.
   //
@@ -125,6 +126,24 @@ class IdxPath {
     return relFront[idx];
   }
 
+
+  /**
+     @brief Exposes the path vector to block-wise restaging.
+
+     @return base of path vector, padded for word-wide reads.
+   */
+  inline const unsigned char *PathBase() const {
+    return &pathFront[0];
+  }
+
+
+  /**
+     @return node-relative offset of a live index.
+   */
+  inline unsigned int OffFront(unsigned int idx) const {
+    return offFront[idx];
+  }
+
   
   /**
      @brief Accumulates a path bit vector for a live reference.
@@ -0,0 +1,216 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file pathcompact.cc
+
+   @brief Serial and vector kernels partitioning restaged samples.
+
+   @author Mark Seligman
+ */
+
+#include "pathcompact.h"
+#include "path.h"
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ARBORIST_PATHCOMPACT_X86
+#include <immintrin.h>
+#endif
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Classifies samples from 'start' through 'count', serially.
+
+   @return void, with path bits accumulated into output parameters.
+ */
+static inline void ClassifyTail(const unsigned int idxSource[], unsigned int start, unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits) {
+  for (unsigned int k = start; k < count; k++) {
+    unsigned int path = pathFront[idxSource[k]];
+    uint64_t live = (path & NodePath::noPath) == 0 ? 1 : 0;
+    uint64_t right = (path & pathMask) != 0 ? 1 : 0;
+    leftBits |= (live & (right ^ 1)) << k;
+    rightBits |= (live & right) << k;
+  }
+}
+
+
+void PathCompact::ClassifySerial(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits) {
+  leftBits = rightBits = 0;
+  ClassifyTail(idxSource, 0, count, pathFront, pathMask, leftBits, rightBits);
+}
+
+
+unsigned int PathCompact::CompressSerial(const void *source, unsigned int count, uint64_t bits, void *dest) {
+  const unsigned char *src = static_cast<const unsigned char *>(source);
+  unsigned char *dst = static_cast<unsigned char *>(dest);
+  unsigned int outCount = 0;
+  for (unsigned int k = 0; k < count; k++) {
+    if ((bits & (uint64_t(1) << k)) != 0) {
+      memcpy(dst + 4 * outCount++, src + 4 * k, 4);
+    }
+  }
+
+  return outCount;
+}
+
+
+#ifdef ARBORIST_PATHCOMPACT_X86
+// Lane permutations packing each eight-bit selection to the low lanes,
+// as nibbles.
+static unsigned int permLUT[256];
+
+
+/**
+   @brief Gathers eight path bytes per iteration.  Gathers read whole
+   words, hence the padding required of 'pathFront'.
+ */
+__attribute__((target("avx2"))) static void ClassifyAVX2(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits) {
+  const __m256i vExtinct = _mm256_set1_epi32(NodePath::noPath);
+  const __m256i vMask = _mm256_set1_epi32(pathMask);
+  const __m256i vZero = _mm256_setzero_si256();
+  leftBits = rightBits = 0;
+  unsigned int k = 0;
+  for (; k + 8 <= count; k += 8) {
+    __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idxSource + k));
+    __m256i path = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pathFront), idx, 1);
+    uint64_t live = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(path, vExtinct), vZero)));
+    uint64_t left = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(path, vMask), vZero)));
+    leftBits |= (live & left) << k;
+    rightBits |= (live & ~left & 0xff) << k;
+  }
+  _mm256_zeroupper();
+  ClassifyTail(idxSource, k, count, pathFront, pathMask, leftBits, rightBits);
+}
+
+
+/**
+   @brief Packs eight lanes per iteration by table-driven permutation.
+   Masked loads and stores touch only the lanes selected.
+ */
+__attribute__((target("avx2,popcnt"))) static unsigned int CompressAVX2(const void *source, unsigned int count, uint64_t bits, void *dest) {
+  const int *src = static_cast<const int *>(source);
+  int *dst = static_cast<int *>(dest);
+  const __m256i vLane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i vShift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+  const __m256i vNibble = _mm256_set1_epi32(0xf);
+  unsigned int outCount = 0;
+  for (unsigned int k = 0; k < count; k += 8) {
+    unsigned int sel = (bits >> k) & 0xff;
+    if (sel == 0)
+      continue;
+
+    __m256i selMask = _mm256_cmpgt_epi32(_mm256_setzero_si256(), _mm256_sllv_epi32(_mm256_set1_epi32(sel), _mm256_sub_epi32(_mm256_set1_epi32(31), vLane)));
+    __m256i val = _mm256_maskload_epi32(src + k, selMask);
+    __m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(permLUT[sel]), vShift), vNibble);
+    unsigned int selCount = _mm_popcnt_u32(sel);
+    __m256i outMask = _mm256_cmpgt_epi32(_mm256_set1_epi32(selCount), vLane);
+    _mm256_maskstore_epi32(dst + outCount, outMask, _mm256_permutevar8x32_epi32(val, perm));
+    outCount += selCount;
+  }
+  _mm256_zeroupper();
+
+  return outCount;
+}
+
+
+/**
+   @brief Gathers sixteen path bytes per iteration.
+ */
+__attribute__((target("avx512f"))) static void ClassifyAVX512(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits) {
+  const __m512i vExtinct = _mm512_set1_epi32(NodePath::noPath);
+  const __m512i vMask = _mm512_set1_epi32(pathMask);
+  leftBits = rightBits = 0;
+  unsigned int k = 0;
+  for (; k + 16 <= count; k += 16) {
+    __m512i idx = _mm512_loadu_si512(idxSource + k);
+    __m512i path = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, idx, pathFront, 1);
+    uint64_t live = ~_mm512_test_epi32_mask(path, vExtinct) & 0xffff;
+    uint64_t right = _mm512_test_epi32_mask(path, vMask);
+    leftBits |= (live & ~right) << k;
+    rightBits |= (live & right) << k;
+  }
+  _mm256_zeroupper();
+  ClassifyTail(idxSource, k, count, pathFront, pathMask, leftBits, rightBits);
+}
+
+
+/**
+   @brief Packs sixteen lanes per iteration by compressing store.
+ */
+__attribute__((target("avx512f,popcnt"))) static unsigned int CompressAVX512(const void *source, unsigned int count, uint64_t bits, void *dest) {
+  const int *src = static_cast<const int *>(source);
+  int *dst = static_cast<int *>(dest);
+  unsigned int outCount = 0;
+  for (unsigned int k = 0; k < count; k += 16) {
+    __mmask16 sel = (bits >> k) & 0xffff;
+    if (sel == 0)
+      continue;
+
+    _mm512_mask_compressstoreu_epi32(dst + outCount, sel, _mm512_maskz_loadu_epi32(sel, src + k));
+    outCount += _mm_popcnt_u32(sel);
+  }
+  _mm256_zeroupper();
+
+  return outCount;
+}
+#endif
+
+
+const unsigned int PathCompact::blockSize;
+PathCompact::ClassifyKernel PathCompact::classifyKernel = PathCompact::ClassifySerial;
+PathCompact::CompressKernel PathCompact::compressKernel = PathCompact::CompressSerial;
+const char *PathCompact::kernelName = "serial";
+const bool PathCompact::selected = PathCompact::Select();
+
+
+/**
+   @brief Selects the widest kernels supported by the host.  Invoked
+   once, during static initialization.
+
+   @return true.
+ */
+bool PathCompact::Select() {
+#ifdef ARBORIST_PATHCOMPACT_X86
+  for (unsigned int sel = 0; sel < 256; sel++) {
+    unsigned int packed = 0;
+    unsigned int outLane = 0;
+    for (unsigned int lane = 0; lane < 8; lane++) {
+      if ((sel & (1 << lane)) != 0) {
+        packed |= lane << (4 * outLane++);
+      }
+    }
+    permLUT[sel] = packed;
+  }
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    classifyKernel = ClassifyAVX512;
+    compressKernel = CompressAVX512;
+    kernelName = "avx512";
+  }
+  else if (__builtin_cpu_supports("avx2")) {
+    classifyKernel = ClassifyAVX2;
+    compressKernel = CompressAVX2;
+    kernelName = "avx2";
+  }
+#endif
+
+  return true;
+}
+
+
+/**
+   @return name of the kernels in use.
+ */
+const char *PathCompact::Kernel() {
+  return kernelName;
+}
@@ -0,0 +1,123 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file pathcompact.h
+
+   @brief Class definitions for vectorized stream compaction of
+   restaged samples.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_PATHCOMPACT_H
+#define ARBORIST_PATHCOMPACT_H
+
+#include <cstdint>
+
+/**
+   @brief Partitions blocks of samples along a one-bit path, as when
+   restaging a node's samples into its two successors.
+
+   Restaging a block proceeds in two passes.  Classify() gathers the
+   front-level path of each sample, yielding bit masks of the samples
+   headed left and right.  Compress() then packs the selected elements
+   of any four-byte column contiguously into its target.  Neither pass
+   branches on individual samples.
+
+   The kernels are chosen once, at load time, from the instruction sets
+   supported by the host.
+ */
+class PathCompact {
+  typedef void (*ClassifyKernel)(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits);
+  typedef unsigned int (*CompressKernel)(const void *source, unsigned int count, uint64_t bits, void *dest);
+
+  static ClassifyKernel classifyKernel;
+  static CompressKernel compressKernel;
+  static const char *kernelName;
+
+  static bool Select();
+  static const bool selected;
+
+ public:
+  static const unsigned int blockSize = 64; // Samples per mask.
+
+  static void ClassifySerial(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits);
+  static unsigned int CompressSerial(const void *source, unsigned int count, uint64_t bits, void *dest);
+  static const char *Kernel();
+
+
+  /**
+     @brief Determines the successor of each sample in a block.
+
+     @param idxSource holds the path indices of the block's samples.
+
+     @param count is the number of samples in the block:  <= blockSize.
+
+     @param pathFront holds the front-level path of each index, readable
+     at least three bytes beyond the greatest index.
+
+     @param pathMask selects the path bit.
+
+     @param leftBits outputs a mask of the live samples taking path zero.
+
+     @param rightBits outputs a mask of the live samples taking path one.
+
+     @return void, with output reference parameters.
+   */
+  static inline void Classify(const unsigned int idxSource[], unsigned int count, const unsigned char pathFront[], unsigned int pathMask, uint64_t &leftBits, uint64_t &rightBits) {
+    classifyKernel(idxSource, count, pathFront, pathMask, leftBits, rightBits);
+  }
+
+
+  /**
+     @brief Packs the elements of a block selected by a mask.
+
+     @param source is the block of four-byte elements.
+
+     @param count is the number of elements in the block.
+
+     @param bits selects the elements to retain.
+
+     @param dest outputs the selected elements, in order.  Nothing is
+     written beyond the last of these.
+
+     @return number of elements written.
+   */
+  static inline unsigned int Compress(const unsigned int source[], unsigned int count, uint64_t bits, unsigned int dest[]) {
+    return compressKernel(source, count, bits, dest);
+  }
+
+
+  /**
+     @brief As above, for single-precision response values.
+   */
+  static inline unsigned int Compress(const float source[], unsigned int count, uint64_t bits, float dest[]) {
+    return compressKernel(source, count, bits, dest);
+  }
+
+
+  /**
+     @brief Locates the lowest set bit of a nonzero mask.
+
+     @return position of the bit.
+   */
+  static inline unsigned int LowBit(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    unsigned int pos = 0;
+    while ((bits & 1) == 0) {
+      bits >>= 1;
+      pos++;
+    }
+    return pos;
+#endif
+  }
+};
+
+#endif
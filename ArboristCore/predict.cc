@@ -19,6 +19,7 @@
 #include "predict.h"
 #include "quant.h"
 #include "bv.h"
+#include "taskpool.h"
 
 #include <cfloat>
 #include <algorithm>
@@ -29,12 +30,26 @@
 
 /**
    @brief Static entry for regression case.
+
+   @param _rowTile is the number of rows walked through each group of
+   trees in turn, zero iff rows walk the forest one at a time.
+
+   @param _treeTile is the number of trees per group, zero iff groups are
+   sized to fit cache.
+
+   @param _forestCompact, if non-null, is a compact copy of the forest,
+   built once by the caller, to be walked in place of the full nodes.
+   Predictions are identical in either format.
+
+   @param _taskPool, if non-null, is a pool of workers held by the caller
+   across predictions, so that a call costs wakeups rather than thread
+   creation.  Null iff prediction is to run in the calling thread.
  */
-void Predict::Regression(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred) {
+void Predict::Regression(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact, TaskPool *_taskPool) {
   // Non-quantile regression does not employ BagLeaf information.
   LeafPerfReg *_leafReg = new LeafPerfReg(&_leafOrigin[0], _nTree, _leafNode, _leafCount, 0, 0, _bagBits, yTrain.size());
-  PredictReg *predictReg = new PredictReg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafReg, yTrain, _nTree, _yPred);
-  Forest *forest =  new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictReg);
+  PredictReg *predictReg = new PredictReg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafReg, yTrain, _nTree, _yPred, _taskPool);
+  Forest *forest =  new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictReg, _rowTile, _treeTile, _forestCompact);
   predictReg->PredictAcross(forest);
 
   delete predictReg;
@@ -43,15 +58,40 @@ void Predict::Regression(const std::vector<double> &_valNum, const std::vector<u
 }
 
 
+/**
+   @brief Static entry for multi-output regression.
+
+   @param _scoreOut holds the per-output leaf scores.
+
+   @param _nOut is the number of outputs.
+
+   @param yTrain is the training response, by output.
+
+   @param _yPred outputs the predicted response, by output.
+
+   @return void, with output reference vector.
+ */
+void Predict::RegressionMulti(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const double _scoreOut[], unsigned int _nOut, const std::vector<double> &yTrain, std::vector<double> &_yPred, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact, TaskPool *_taskPool) {
+  LeafPerfReg *_leafReg = new LeafPerfReg(&_leafOrigin[0], _nTree, _leafNode, _leafCount, 0, 0, _bagBits, yTrain.size() / _nOut);
+  PredictMulti *predictMulti = new PredictMulti(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size() / _nOut), _leafReg, _scoreOut, _nOut, yTrain, _nTree, _yPred, _taskPool);
+  Forest *forest =  new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictMulti, _rowTile, _treeTile, _forestCompact);
+  predictMulti->PredictAcross(forest);
+
+  delete predictMulti;
+  delete forest;
+  delete _leafReg;
+}
+
+
 /**
    @brief Static entry for regression case.
 
    // Only prediction method requiring BagLeaf.
  */
-void Predict::Quantiles(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, const BagLeaf _bagLeaf[], unsigned int _bagLeafTot, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, bool validate) {
+void Predict::Quantiles(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, const BagLeaf _bagLeaf[], unsigned int _bagLeafTot, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, bool validate, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact, TaskPool *_taskPool) {
   LeafPerfReg *_leafReg = new LeafPerfReg(&_leafOrigin[0], _nTree, _leafNode, _leafCount, _bagLeaf, _bagLeafTot, _bagBits, yTrain.size());
-  PredictReg *predictReg = new PredictReg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafReg, yTrain, _nTree, _yPred);
-  Forest *forest =  new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictReg);
+  PredictReg *predictReg = new PredictReg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafReg, yTrain, _nTree, _yPred, _taskPool);
+  Forest *forest =  new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictReg, _rowTile, _treeTile, _forestCompact);
   Quant *quant = new Quant(predictReg, _leafReg, quantVec, qBin);
   predictReg->PredictAcross(forest, quant, &qPred[0], validate);
 
@@ -65,11 +105,11 @@ void Predict::Quantiles(const std::vector<double> &_valNum, const std::vector<un
 /**
    @brief Entry for separate classification prediction.
  */
-void Predict::Classification(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], unsigned int _rowTrain, const double _weight[], unsigned int _ctgWidth, std::vector<unsigned int> &_yPred, unsigned int *_census, const std::vector<unsigned int> &_yTest, unsigned int *_conf, std::vector<double> &_error, double *_prob) {
+void Predict::Classification(const std::vector<double> &_valNum, const std::vector<unsigned int> &_rowStart, const std::vector<unsigned int> &_runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], unsigned int _rowTrain, const double _weight[], unsigned int _ctgWidth, std::vector<unsigned int> &_yPred, unsigned int *_census, const std::vector<unsigned int> &_yTest, unsigned int *_conf, std::vector<double> &_error, double *_prob, unsigned int _rowTile, unsigned int _treeTile, const ForestCompact *_forestCompact, TaskPool *_taskPool) {
   // Ctg prediction does not employ BagLeaf information.
   LeafPerfCtg *_leafCtg = new LeafPerfCtg(&_leafOrigin[0], _nTree, _leafNode, _leafCount, 0, 0, _bagBits, _rowTrain, _weight, _ctgWidth);
-  PredictCtg *predictCtg = new PredictCtg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafCtg, _nTree, _yPred);
-  Forest *forest = new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictCtg);
+  PredictCtg *predictCtg = new PredictCtg(new PMPredict(_valNum, _rowStart, _runLength, _predStart, _blockNumT, _blockFacT, _nPredNum, _nPredFac, _yPred.size()), _leafCtg, _nTree, _yPred, _taskPool);
+  Forest *forest = new Forest(_forestNode, _origin, _nTree, _facSplit, _facLen, _facOff, _nFac, predictCtg, _rowTile, _treeTile, _forestCompact);
   predictCtg->PredictAcross(forest, _census, _yTest, _conf, _error, _prob);
 
   delete predictCtg;
@@ -78,12 +118,28 @@ void Predict::Classification(const std::vector<double> &_valNum, const std::vect
 }
 
 
-PredictCtg::PredictCtg(PMPredict *_pmPredict, const LeafPerfCtg *_leafCtg, unsigned int _nTree, std::vector<unsigned int> &_yPred) : Predict(_pmPredict, _nTree, _yPred.size(), _leafCtg->NoLeaf()), leafCtg(_leafCtg), ctgWidth(leafCtg->CtgWidth()), yPred(_yPred), defaultScore(ctgWidth), defaultWeight(std::vector<double>(ctgWidth)) {
+PredictCtg::PredictCtg(PMPredict *_pmPredict, const LeafPerfCtg *_leafCtg, unsigned int _nTree, std::vector<unsigned int> &_yPred, TaskPool *_taskPool) : Predict(_pmPredict, _nTree, _yPred.size(), _leafCtg->NoLeaf(), _taskPool), leafCtg(_leafCtg), ctgWidth(leafCtg->CtgWidth()), yPred(_yPred), defaultScore(ctgWidth), defaultWeight(std::vector<double>(ctgWidth)) {
   std::fill(defaultWeight.begin(), defaultWeight.end(), -1.0);
 }
 
 
-PredictReg::PredictReg(PMPredict *_pmPredict, const LeafPerfReg *_leafReg, const std::vector<double> &_yTrain, unsigned int _nTree, std::vector<double> &_yPred) : Predict(_pmPredict, _nTree, _yPred.size(), _leafReg->NoLeaf()), leafReg(_leafReg), yTrain(_yTrain), yPred(_yPred), defaultScore(-DBL_MAX) {
+PredictReg::PredictReg(PMPredict *_pmPredict, const LeafPerfReg *_leafReg, const std::vector<double> &_yTrain, unsigned int _nTree, std::vector<double> &_yPred, TaskPool *_taskPool) : Predict(_pmPredict, _nTree, _yPred.size(), _leafReg->NoLeaf(), _taskPool), leafReg(_leafReg), yTrain(_yTrain), yPred(_yPred), defaultScore(-DBL_MAX) {
+}
+
+
+/**
+   @brief Constructor.  Default scores are computed eagerly, as rows are
+   scored concurrently.
+ */
+PredictMulti::PredictMulti(PMPredict *_pmPredict, const LeafPerfReg *_leafReg, const double _scoreOut[], unsigned int _nOut, const std::vector<double> &yTrain, unsigned int _nTree, std::vector<double> &_yPred, TaskPool *_taskPool) : Predict(_pmPredict, _nTree, _yPred.size() / _nOut, _leafReg->NoLeaf(), _taskPool), leafReg(_leafReg), scoreOut(_scoreOut), nOut(_nOut), yPred(_yPred), defaultOut(std::vector<double>(_nOut)) {
+  unsigned int rowTrain = yTrain.size() / nOut;
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+    double sum = 0.0;
+    for (unsigned int row = 0; row < rowTrain; row++) {
+      sum += yTrain[outIdx * rowTrain + row];
+    }
+    defaultOut[outIdx] = sum / rowTrain;
+  }
 }
 
 
@@ -154,7 +210,13 @@ double PredictCtg::DefaultWeight(double *weightPredict) {
 }
 
 
-Predict::Predict(class PMPredict *_pmPredict, unsigned int _nTree, unsigned int _nRow, unsigned int _noLeaf) : noLeaf(_noLeaf), pmPredict(_pmPredict), nTree(_nTree), nRow(_nRow) {
+/**
+   @brief Base constructor.
+
+   @param _taskPool is the caller's pool, if any.  Otherwise a pool of
+   one worker is built, which starts no threads.
+ */
+Predict::Predict(class PMPredict *_pmPredict, unsigned int _nTree, unsigned int _nRow, unsigned int _noLeaf, TaskPool *_taskPool) : noLeaf(_noLeaf), pmPredict(_pmPredict), nTree(_nTree), nRow(_nRow), poolSerial(_taskPool == 0 ? new TaskPool(1) : 0), taskPool(_taskPool == 0 ? poolSerial : _taskPool) {
   predictLeaves = new unsigned int[PMPredict::rowBlock * nTree];
 }
 
@@ -162,6 +224,7 @@ Predict::Predict(class PMPredict *_pmPredict, unsigned int _nTree, unsigned int
 Predict::~Predict() {
   delete [] predictLeaves;
   delete pmPredict;
+  delete poolSerial;
 }
 
 
@@ -237,26 +300,20 @@ void PredictCtg::Validate(const std::vector<unsigned int> &yTest, unsigned int c
    @return void, with output reference vector.
 */
 void PredictCtg::Vote(double *votes, unsigned int census[]) {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (row = 0; row < int(nRow); row++) {
-    int argMax = -1;
-    double scoreMax = 0.0;
-    double *score = votes + row * ctgWidth;
-    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-      double ctgScore = score[ctg]; // Jittered vote count.
-      if (ctgScore > scoreMax) {
-	scoreMax = ctgScore;
-	argMax = ctg;
+  taskPool->Run(nRow, [&](unsigned int row) {
+      int argMax = -1;
+      double scoreMax = 0.0;
+      double *score = votes + row * ctgWidth;
+      for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+        double ctgScore = score[ctg]; // Jittered vote count.
+        if (ctgScore > scoreMax) {
+          scoreMax = ctgScore;
+          argMax = ctg;
+        }
+        census[row * ctgWidth + ctg] = ctgScore; // De-jittered.
       }
-      census[row * ctgWidth + ctg] = ctgScore; // De-jittered.
-    }
-    yPred[row] = argMax;
-  }
-  }
+      yPred[row] = argMax;
+    }, ctgWidth);
 }
 
 
@@ -266,32 +323,24 @@ void PredictCtg::Vote(double *votes, unsigned int census[]) {
    @return internal vote table, with output reference vector.
  */
 void PredictCtg::Score(double *votes, unsigned int rowStart, unsigned int rowEnd) {
-  int blockRow;
-
-// TODO:  Recast loop by blocks, to avoid
-// false sharing.
-#pragma omp parallel default(shared) private(blockRow)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (blockRow = 0; blockRow < int(rowEnd - rowStart); blockRow++) {
-    double *prediction = votes + (rowStart + blockRow) * ctgWidth;
-    unsigned int treesSeen = 0;
-    for (unsigned int tc = 0; tc < nTree; tc++) {
-      if (!IsBagged(blockRow, tc)) {
-	treesSeen++;
-	double val = leafCtg->GetScore(tc, LeafIdx(blockRow, tc));
-	unsigned int ctg = val; // Truncates jittered score for indexing.
-	prediction[ctg] += 1 + val - ctg;
+  taskPool->Run(rowEnd - rowStart, [&](unsigned int blockRow) {
+      double *prediction = votes + (rowStart + blockRow) * ctgWidth;
+      unsigned int treesSeen = 0;
+      for (unsigned int tc = 0; tc < nTree; tc++) {
+        if (!IsBagged(blockRow, tc)) {
+          treesSeen++;
+          double val = leafCtg->GetScore(tc, LeafIdx(blockRow, tc));
+          unsigned int ctg = val; // Truncates jittered score for indexing.
+          prediction[ctg] += 1 + val - ctg;
+        }
       }
-    }
-    if (treesSeen == 0) {
-      for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-	prediction[ctg] = 0.0;
+      if (treesSeen == 0) {
+        for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+          prediction[ctg] = 0.0;
+        }
+        prediction[DefaultScore()] = 1;
       }
-      prediction[DefaultScore()] = 1;
-    }
-  }
-  }
+    }, nTree);
 }
 
 
@@ -361,12 +410,7 @@ void PredictReg::PredictAcross(const Forest *forest, Quant *quant, double qPred[
   @return void, with output refererence vector.
  */
 void PredictReg::Score(unsigned int rowStart, unsigned int rowEnd) {
-  int blockRow;
-
-#pragma omp parallel default(shared) private(blockRow)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (blockRow = 0; blockRow < int(rowEnd - rowStart); blockRow++) {
+  taskPool->Run(rowEnd - rowStart, [&](unsigned int blockRow) {
       double score = 0.0;
       int treesSeen = 0;
       for (unsigned int tc = 0; tc < nTree; tc++) {
@@ -376,11 +420,54 @@ void PredictReg::Score(unsigned int rowStart, unsigned int rowEnd) {
         }
       }
       yPred[rowStart + blockRow] = treesSeen > 0 ? score / treesSeen : DefaultScore();
-    }
+    }, nTree);
+}
+
+
+/**
+   @brief Predictions for a block of rows, by output.
+
+   @return void, with side-effected prediction vector.
+ */
+void PredictMulti::PredictAcross(const Forest *forest) {
+  const BitMatrix *bag = leafReg->Bag();
+  for (unsigned int rowStart = 0; rowStart < nRow; rowStart += PMPredict::rowBlock) {
+    unsigned int rowEnd = std::min(rowStart + PMPredict::rowBlock, nRow);
+    pmPredict->BlockTranspose(rowStart, rowEnd);
+    forest->PredictAcross(rowStart, rowEnd, bag);
+    Score(rowStart, rowEnd);
   }
 }
 
 
+/**
+  @brief Sets per-output scores from leaf predictions.
+
+  @return void, with output refererence vector.
+ */
+void PredictMulti::Score(unsigned int rowStart, unsigned int rowEnd) {
+  taskPool->Run(rowEnd - rowStart, [&](unsigned int blockRow) {
+      unsigned int row = rowStart + blockRow;
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        yPred[outIdx * nRow + row] = 0.0;
+      }
+      int treesSeen = 0;
+      for (unsigned int tc = 0; tc < nTree; tc++) {
+        if (!IsBagged(blockRow, tc)) {
+          treesSeen++;
+          const double *leafOut = &scoreOut[nOut * leafReg->NodeIdx(tc, LeafIdx(blockRow, tc))];
+          for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+            yPred[outIdx * nRow + row] += leafOut[outIdx];
+          }
+        }
+      }
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        yPred[outIdx * nRow + row] = treesSeen > 0 ? yPred[outIdx * nRow + row] / treesSeen : defaultOut[outIdx];
+      }
+    }, nTree * nOut);
+}
+
+
 const double *Predict::RowNum(unsigned rowOff) const {
   return pmPredict->RowNum(rowOff);
 }
@@ -21,25 +21,42 @@
 
 class Predict {
   const unsigned int noLeaf; // Inattainable leaf index value.
+ public:
+  static const unsigned int rowTileDefault = 128; // Rows per traversal tile.
  protected:
   class PMPredict *pmPredict;
   const unsigned int nTree;
   const unsigned int nRow;
   unsigned int *predictLeaves;
+  class TaskPool *poolSerial; // Single-worker pool, iff none supplied.
+  class TaskPool *taskPool; // Workers for row blocks, owned by caller.
 
  public:  
   
-  Predict(class PMPredict *_pmPredict, unsigned int _nTree, unsigned int _nRow, unsigned int _noLeaf);
+  Predict(class PMPredict *_pmPredict, unsigned int _nTree, unsigned int _nRow, unsigned int _noLeaf, class TaskPool *_taskPool);
   virtual ~Predict();
 
-  static void Regression(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred);
+  static void Regression(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, unsigned int _rowTile = rowTileDefault, unsigned int _treeTile = 0, const class ForestCompact *_forestCompact = 0, class TaskPool *_taskPool = 0);
+
 
+  static void RegressionMulti(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], const double _scoreOut[], unsigned int _nOut, const std::vector<double> &yTrain, std::vector<double> &_yPred, unsigned int _rowTile = rowTileDefault, unsigned int _treeTile = 0, const class ForestCompact *_forestCompact = 0, class TaskPool *_taskPool = 0);
 
-  static void Quantiles(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, const class BagLeaf _bagLeaf[], unsigned int _bagLeafTot, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, bool validate);
+  static void Quantiles(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, const class BagLeaf _bagLeaf[], unsigned int _bagLeafTot, unsigned int _bagBits[], const std::vector<double> &yTrain, std::vector<double> &_yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, bool validate, unsigned int _rowTile = rowTileDefault, unsigned int _treeTile = 0, const class ForestCompact *_forestCompact = 0, class TaskPool *_taskPool = 0);
 
-  static void Classification(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], unsigned int _rowTrain, const double _weight[], unsigned int _ctgWidth, std::vector<unsigned int> &_yPred, unsigned int *_census, const std::vector<unsigned int> &_yTest, unsigned int *_conf, std::vector<double> &_error, double *_prob);
+  static void Classification(const std::vector<double> &valNum, const std::vector<unsigned int> &rowStart, const std::vector<unsigned int> &runLength, const std::vector<unsigned int> &_predStart, double *_blockNumT, unsigned int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestNode _forestNode[], const unsigned int _origin[], unsigned int _nTree, unsigned int _facSplit[], size_t _facLen, const unsigned int _facOff[], unsigned int _nFac, std::vector<unsigned int> &_leafOrigin, const class LeafNode _leafNode[], unsigned int _leafCount, unsigned int _bagBits[], unsigned int _rowTrain, const double _weight[], unsigned int _ctgWidth, std::vector<unsigned int> &_yPred, unsigned int *_census, const std::vector<unsigned int> &_yTest, unsigned int *_conf, std::vector<double> &_error, double *_prob, unsigned int _rowTile = rowTileDefault, unsigned int _treeTile = 0, const class ForestCompact *_forestCompact = 0, class TaskPool *_taskPool = 0);
 
   const double *RowNum(unsigned int row) const;
+
+
+  /**
+     @brief Accessor for the task pool.
+
+     @return pool running this predictor's loops.
+   */
+  inline class TaskPool *Pool() const {
+    return taskPool;
+  }
+
   const unsigned int *RowFac(unsigned int row) const;
   
 
@@ -91,7 +108,7 @@ class PredictReg : public Predict {
   void Score(unsigned int rowStart, unsigned int rowEnd);
   double DefaultScore();
  public:
-  PredictReg(PMPredict *_pmPredict, const class LeafPerfReg *_leafReg, const std::vector<double> &_yTrain, unsigned int _nTree, std::vector<double> &_yPred);
+  PredictReg(PMPredict *_pmPredict, const class LeafPerfReg *_leafReg, const std::vector<double> &_yTrain, unsigned int _nTree, std::vector<double> &_yPred, class TaskPool *_taskPool);
   ~PredictReg() {}
 
   void PredictAcross(const class Forest *forest);
@@ -109,6 +126,24 @@ class PredictReg : public Predict {
 };
 
 
+/**
+   @brief Multi-output regression:  averages each output's leaf scores.
+ */
+class PredictMulti : public Predict {
+  const class LeafPerfReg *leafReg;
+  const double *scoreOut; // # leaves x # outputs.
+  const unsigned int nOut;
+  std::vector<double> &yPred; // # rows x # outputs, by output.
+  std::vector<double> defaultOut; // Per-output mean training response.
+  void Score(unsigned int rowStart, unsigned int rowEnd);
+ public:
+  PredictMulti(class PMPredict *_pmPredict, const class LeafPerfReg *_leafReg, const double _scoreOut[], unsigned int _nOut, const std::vector<double> &yTrain, unsigned int _nTree, std::vector<double> &_yPred, class TaskPool *_taskPool);
+  ~PredictMulti() {}
+
+  void PredictAcross(const class Forest *forest);
+};
+
+
 class PredictCtg : public Predict {
   const class LeafPerfCtg *leafCtg;
   const unsigned int ctgWidth;
@@ -123,7 +158,7 @@ class PredictCtg : public Predict {
   void DefaultInit();
   double DefaultWeight(double *weightPredict);
  public:
-  PredictCtg(class PMPredict *_pmPredict, const class LeafPerfCtg *_leafCtg, unsigned int _nTree, std::vector<unsigned int> &_yPred);
+  PredictCtg(class PMPredict *_pmPredict, const class LeafPerfCtg *_leafCtg, unsigned int _nTree, std::vector<unsigned int> &_yPred, class TaskPool *_taskPool);
   ~PredictCtg();
 
   void PredictAcross(const class Forest *forest, unsigned int *census, const std::vector<unsigned int> &yTest, unsigned int *conf, std::vector<double> &error, double *prob);
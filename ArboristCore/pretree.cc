@@ -29,25 +29,23 @@
 // the need to revise dangling non-terminals from an earlier level.
 //
 
-unsigned int PreTree::heightEst = 0;
-
 /**
-   @brief Caches the row count and computes an initial estimate of node count.
+   @brief Computes an initial estimate of node count.
 
    @param _nSamp is the number of samples.
 
    @param _minH is the minimal splitable index node size.
 
-   @return void.
+   @return initial height estimate.
  */
-void PreTree::Immutables(unsigned int _nSamp, unsigned int _minH) {
+unsigned int PreTree::HeightEst(unsigned int _nSamp, unsigned int _minH) {
   // Static initial estimate of pre-tree heights employs a minimal enclosing
   // balanced tree.  This is probably naive, given that decision trees
   // are not generally balanced.
   //
-  // In any case, 'heightEst' is re-estimated following construction of the
-  // first PreTree block.  Hence the value is not really immutable.  Nodes
-  // can also be reallocated during the interlevel pass as needed.
+  // In any case, the estimate is refined following construction of the
+  // first PreTree block.  Nodes can also be reallocated during the
+  // interlevel pass as needed.
   //
   unsigned twoL = 1; // 2^level, beginning from level zero (root).
   while (twoL * _minH < _nSamp) {
@@ -55,23 +53,18 @@ void PreTree::Immutables(unsigned int _nSamp, unsigned int _minH) {
   }
 
   // Terminals plus accumulated nonterminals.
-  heightEst = (twoL << 2); // - 1, for exact count.
-}
-
-
-void PreTree::DeImmutables() {
-  heightEst = 0;
+  return twoL << 2; // - 1, for exact count.
 }
 
 
 /**
    @brief Per-tree initializations.
 
-   @param _treeBlock is the number of PreTree initialize.
+   @param heightEst is the current estimate of node count.
 
    @return void.
  */
-PreTree::PreTree(const PMTrain *_pmTrain, unsigned int _bagCount) : pmTrain(_pmTrain), height(1), leafCount(1), bitEnd(0), bagCount(_bagCount), info(std::vector<double>(pmTrain->NPred())) {
+PreTree::PreTree(const PMTrain *_pmTrain, unsigned int _bagCount, unsigned int heightEst) : pmTrain(_pmTrain), height(1), leafCount(1), bitEnd(0), bagCount(_bagCount), info(std::vector<double>(pmTrain->NPred())) {
   std::fill(info.begin(), info.end(), 0.0);
 
   nodeCount = heightEst;   // Initial height estimate.
@@ -87,6 +80,7 @@ PreTree::PreTree(const PMTrain *_pmTrain, unsigned int _bagCount) : pmTrain(_pmT
  */
 PreTree::~PreTree() {
   delete [] nodeVec;
+  delete splitBits;
 }
 
 
@@ -110,9 +104,11 @@ void PreTree::LHBit(int idx, unsigned int pos) {
 
    @param height is an actual height value.
 
-   @return void.
+   @param heightEst is the running estimate, updated in place.
+
+   @return void, with output reference parameter.
  */
-void PreTree::Reserve(unsigned int height) {
+void PreTree::Reserve(unsigned int height, unsigned int &heightEst) {
   while (heightEst <= height) // Assigns next power-of-two above 'height'.
     heightEst <<= 1;
 }
@@ -256,6 +252,7 @@ const std::vector<unsigned int> PreTree::DecTree(ForestTrain *forest, unsigned i
   NodeConsume(forest, tIdx);
   forest->BitProduce(splitBits, bitEnd);
   delete splitBits;
+  splitBits = 0;
 
   for (unsigned int i = 0; i < info.size(); i++)
     predInfo[i] += info[i];
@@ -308,7 +305,9 @@ void PTNode::Consume(const PMTrain *pmTrain, ForestTrain *forest, unsigned int t
    @return void, with side-effected frontier map.
  */
 void PreTree::SubtreeFrontier(const std::vector<TermKey> &stKey, const std::vector<unsigned int> &stTerm) {
-  for (auto & key : stKey) {
+  unsigned int termBase = termST.size(); // Nonzero iff subtrees grafted.
+  for (auto key : stKey) {
+    key.base += termBase;
     termKey.push_back(key);
   }
 
@@ -318,6 +317,71 @@ void PreTree::SubtreeFrontier(const std::vector<TermKey> &stKey, const std::vect
 }
 
 
+/**
+   @brief Splices a locally-completed subtree in place of a terminal.
+   Subtree nodes other than the root are appended, so that offsets to
+   left-hand successors remain positive.  Factor bits are appended as
+   well.
+
+   A subtree whose root did not split leaves the terminal, together with
+   its frontier entry, unchanged.
+
+   @param subtree is the completed subtree.
+
+   @param ptRoot is the index of the terminal replaced by the subtree.
+
+   @param local2ST maps subtree sample indices to those of this tree.
+
+   @return void.
+ */
+void PreTree::Graft(const PreTree *subtree, unsigned int ptRoot, const std::vector<unsigned int> &local2ST) {
+  if (subtree->height == 1)
+    return;
+
+  unsigned int ptBase = height - 1; // Local nodes other than root.
+  while (height + subtree->height - 1 > nodeCount) {
+    ReNodes();
+  }
+  splitBits = splitBits->Resize(bitEnd + subtree->bitEnd);
+
+  for (unsigned int idx = 0; idx < subtree->height; idx++) {
+    PTNode node = subtree->nodeVec[idx];
+    node.id = idx == 0 ? ptRoot : ptBase + idx;
+    if (node.lhId > 0) {
+      node.lhId += ptBase;
+      if (pmTrain->IsFactor(node.predIdx)) {
+        unsigned int offLocal = node.splitVal.offset;
+        node.splitVal.offset += bitEnd;
+        unsigned int facCard = pmTrain->FacCard(node.predIdx);
+        for (unsigned int pos = 0; pos < facCard; pos++) {
+          if (subtree->splitBits->TestBit(offLocal + pos)) {
+            splitBits->SetBit(node.splitVal.offset + pos);
+          }
+        }
+      }
+    }
+    nodeVec[node.id] = node;
+  }
+
+  for (unsigned int predIdx = 0; predIdx < info.size(); predIdx++) {
+    info[predIdx] += subtree->info[predIdx];
+  }
+  bitEnd += subtree->bitEnd;
+  height += subtree->height - 1;
+  leafCount += subtree->leafCount - 1;
+
+  unsigned int termBase = termST.size();
+  for (auto key : subtree->termKey) {
+    key.base += termBase;
+    key.ptId = key.ptId == 0 ? ptRoot : ptBase + key.ptId;
+    termKey.push_back(key);
+  }
+  for (auto stLocal : subtree->termST) {
+    termST.push_back(local2ST[stLocal]);
+  }
+}
+
+
 /**
    @brief Constructs mapping from sample indices to leaf indices.
 
@@ -326,10 +390,12 @@ void PreTree::SubtreeFrontier(const std::vector<TermKey> &stKey, const std::vect
    @return Reference to rewritten map, with side-effected Forest.
  */
 const std::vector<unsigned int> PreTree::FrontierToLeaf(ForestTrain *forest, unsigned int tIdx) {
-  std::vector<unsigned int> frontierMap(termST.size());
+  std::vector<unsigned int> frontierMap(bagCount);
   unsigned int leafIdx = 0;
   unsigned int check = 0;
   for (auto & key : termKey) {
+    if (NonTerminal(key.ptId)) // Superseded by grafted subtree.
+      continue;
     for (unsigned int idx = key.base ; idx < key.base + key.extent; idx++) {
       unsigned int stIdx = termST[idx];
       frontierMap[stIdx] = leafIdx;
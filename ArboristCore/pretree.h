@@ -65,7 +65,6 @@ class PTNode {
 
 
 class PreTree {
-  static unsigned int heightEst;
   const class PMTrain *pmTrain;
   PTNode *nodeVec; // Vector of tree nodes.
   unsigned int nodeCount; // Allocation height of node vector.
@@ -83,11 +82,10 @@ class PreTree {
   unsigned int BitWidth();
 
  public:
-  PreTree(const class PMTrain *_pmTrain, unsigned int _bagCount);
+  PreTree(const class PMTrain *_pmTrain, unsigned int _bagCount, unsigned int heightEst);
   ~PreTree();
-  static void Immutables(unsigned int _nSamp, unsigned int _minH);
-  static void DeImmutables();
-  static void Reserve(unsigned int height);
+  static unsigned int HeightEst(unsigned int _nSamp, unsigned int _minH);
+  static void Reserve(unsigned int height, unsigned int &heightEst);
 
   const std::vector<unsigned int> DecTree(class ForestTrain *forest, unsigned int tIdx, std::vector<double> &predInfo);
   void NodeConsume(class ForestTrain *forest, unsigned int tIdx);
@@ -98,6 +96,7 @@ class PreTree {
   void Level(unsigned int splitNext, unsigned int leafNext);
   void ReNodes();
   void SubtreeFrontier(const std::vector<TermKey> &stKey, const std::vector<unsigned int> &stTerm);
+  void Graft(const PreTree *subtree, unsigned int ptRoot, const std::vector<unsigned int> &local2ST);
 
   
   /**
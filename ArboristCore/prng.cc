@@ -0,0 +1,83 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file prng.cc
+
+   @brief Methods implementing the counter-based generator.
+
+   @author Mark Seligman
+ */
+
+#include "prng.h"
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Splits the seed into the two key words.
+
+   @param seed is the 64-bit seed, typically drawn from the front end.
+ */
+PRNG::PRNG(uint64_t seed) : key0(static_cast<uint32_t>(seed)), key1(static_cast<uint32_t>(seed >> 32)) {
+}
+
+
+/**
+   @brief Applies the keyed Philox rounds to a counter block, in place.
+
+   @param ctr is the counter on input and the random block on output.
+
+   @return void, with side-effected counter.
+ */
+void PRNG::Bijection(uint32_t ctr[4]) const {
+  uint32_t k0 = key0;
+  uint32_t k1 = key1;
+  for (unsigned int round = 0; round < nRound; round++) {
+    uint64_t prod0 = static_cast<uint64_t>(mult0) * ctr[0];
+    uint64_t prod1 = static_cast<uint64_t>(mult1) * ctr[2];
+    uint32_t hi0 = static_cast<uint32_t>(prod0 >> 32);
+    uint32_t lo0 = static_cast<uint32_t>(prod0);
+    uint32_t hi1 = static_cast<uint32_t>(prod1 >> 32);
+    uint32_t lo1 = static_cast<uint32_t>(prod1);
+    ctr[0] = hi1 ^ ctr[1] ^ k0;
+    ctr[1] = lo1;
+    ctr[2] = hi0 ^ ctr[3] ^ k1;
+    ctr[3] = lo0;
+    k0 += weyl0;
+    k1 += weyl1;
+  }
+}
+
+
+/**
+   @brief Fills a vector with uniform variates on the open unit interval.
+
+   @param tIdx is the absolute index of the tree.
+
+   @param level is the level, or other client-defined round number.
+
+   @param stream is the tag of the requesting client.
+
+   @param len is the number of variates to generate.
+
+   @param out outputs the variates.
+
+   @return void, with output parameter vector.
+ */
+void PRNG::Uniform(unsigned int tIdx, unsigned int level, unsigned int stream, unsigned int len, double out[]) const {
+  for (unsigned int blockIdx = 0; 4 * blockIdx < len; blockIdx++) {
+    uint32_t ctr[4] = { blockIdx, level, tIdx, stream };
+    Bijection(ctr);
+    unsigned int base = 4 * blockIdx;
+    unsigned int supIdx = len - base < 4 ? len - base : 4;
+    for (unsigned int i = 0; i < supIdx; i++) {
+      out[base + i] = (ctr[i] + 0.5) * scale;
+    }
+  }
+}
@@ -0,0 +1,76 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file prng.h
+
+   @brief Class definition for the core's counter-based random number
+   generator.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_PRNG_H
+#define ARBORIST_PRNG_H
+
+#include <cstdint>
+
+/**
+   @brief Philox-4x32-10 counter-based generator.
+
+   Variates are a pure function of the key, derived from the seed, and
+   a counter composed of the tree index, the level and a stream tag
+   identifying the client.  No state is carried between calls, so trees
+   and levels may draw concurrently and reproduce the same values
+   irrespective of thread count or scheduling order.
+ */
+class PRNG {
+  static constexpr uint32_t mult0 = 0xD2511F53;
+  static constexpr uint32_t mult1 = 0xCD9E8D57;
+  static constexpr uint32_t weyl0 = 0x9E3779B9;
+  static constexpr uint32_t weyl1 = 0xBB67AE85;
+  static constexpr unsigned int nRound = 10;
+  static constexpr double scale = 1.0 / 4294967296.0; // 2^-32.
+
+  const uint32_t key0;
+  const uint32_t key1;
+
+  void Bijection(uint32_t ctr[4]) const;
+
+ public:
+  // Stream tags distinguish clients drawing at the same tree and level.
+  static const unsigned int streamRow = 0; // Row sampling.
+  static const unsigned int streamPred = 1; // Predictor scheduling.
+  static const unsigned int streamMono = 2; // Monotonicity constraints.
+  static const unsigned int streamRun = 3; // Retired:  formerly wide-factor run sampling.
+  static const unsigned int streamCut = 4; // Randomized cut selection.
+  static const unsigned int streamBits = 8; // Width of tag within stream.
+
+  PRNG(uint64_t seed);
+
+
+  /**
+     @brief Composes a stream from a client tag and a subtree key, so
+     that locally-completed subtrees draw independently of the tree
+     proper at the same level.
+
+     @param tag is the client's stream tag.
+
+     @param subKey is the pretree index of the subtree root, zero iff
+     the tree proper.
+
+     @return composite stream value.
+   */
+  static inline unsigned int Stream(unsigned int tag, unsigned int subKey) {
+    return tag | (subKey << streamBits);
+  }
+
+
+  void Uniform(unsigned int tIdx, unsigned int level, unsigned int stream, unsigned int len, double out[]) const;
+};
+
+#endif
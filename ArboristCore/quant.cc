@@ -17,6 +17,7 @@
 #include "quant.h"
 #include "leaf.h"
 #include "predict.h"
+#include "taskpool.h"
 #include <algorithm>
 
 //#include <iostream>
@@ -63,14 +64,9 @@ void Quant::PredictAcross(unsigned int rowStart, unsigned int rowEnd, double qPr
   if (rankCount.size() == 0)
     return; // Insufficient leaf information.
  
-  int row;
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = rowStart; row < int(rowEnd); row++) {
-      Leaves(row - rowStart, &qPred[qCount * row]);
-    }
-  }
+  predictReg->Pool()->Run(rowEnd - rowStart, [&](unsigned int blockRow) {
+      Leaves(blockRow, &qPred[qCount * (rowStart + blockRow)]);
+    }, leafReg->NTree() + binSize);
 }
 
 
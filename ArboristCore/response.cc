@@ -22,6 +22,8 @@
 #include "rowrank.h"
 #include "index.h"
 #include "pretree.h"
+#include "trainctx.h"
+#include "taskpool.h"
 
 //#include <iostream>
 using namespace std;
@@ -36,8 +38,8 @@ using namespace std;
 
    @return void.
 */
-ResponseCtg *Response::FactoryCtg(const std::vector<unsigned int> &feCtg, const std::vector<double> &feProxy, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) {
-  return new ResponseCtg(feCtg, feProxy, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits, weight, ctgWidth);
+ResponseCtg *Response::FactoryCtg(TrainCtx *_ctx, const std::vector<unsigned int> &feCtg, const std::vector<double> &feProxy, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) {
+  return new ResponseCtg(_ctx, feCtg, feProxy, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits, weight, ctgWidth);
 }
 
 
@@ -47,7 +49,7 @@ ResponseCtg *Response::FactoryCtg(const std::vector<unsigned int> &feCtg, const
  @param _proxy is the associated numerical proxy response.
 
 */
-ResponseCtg::ResponseCtg(const std::vector<unsigned int> &_yCtg, const std::vector<double> &_proxy, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) : Response(_proxy, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits, weight, ctgWidth), yCtg(_yCtg) {
+ResponseCtg::ResponseCtg(TrainCtx *_ctx, const std::vector<unsigned int> &_yCtg, const std::vector<double> &_proxy, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) : Response(_ctx, _proxy, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits, weight, ctgWidth), yCtg(_yCtg) {
 }
 
 
@@ -57,7 +59,7 @@ ResponseCtg::ResponseCtg(const std::vector<unsigned int> &_yCtg, const std::vect
    @param _y is the vector numerical/proxy response values.
 
  */
-Response::Response(const std::vector<double> &_y, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) : y(_y), leaf(new LeafCtg(leafOrigin, leafNode, bagLeaf, bagBits, y.size(), weight, ctgWidth)), pmTrain(_pmTrain) {
+Response::Response(TrainCtx *_ctx, const std::vector<double> &_y, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth) : y(_y), leaf(new LeafCtg(leafOrigin, leafNode, bagLeaf, bagBits, y.size(), _ctx->thinLeaves, weight, ctgWidth)), ctx(_ctx), pmTrain(_pmTrain) {
 }
 
 
@@ -67,7 +69,17 @@ Response::Response(const std::vector<double> &_y, const PMTrain *_pmTrain, std::
    @param _y is the vector numerical/proxy response values.
 
  */
-Response::Response(const std::vector<double> &_y, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) : y(_y), leaf(new LeafReg(leafOrigin, leafNode, bagLeaf, bagBits, y.size())), pmTrain(_pmTrain) {
+Response::Response(TrainCtx *_ctx, const std::vector<double> &_y, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) : y(_y), leaf(new LeafReg(leafOrigin, leafNode, bagLeaf, bagBits, y.size(), _ctx->thinLeaves)), ctx(_ctx), pmTrain(_pmTrain) {
+}
+
+
+/**
+   @brief Base class constructor, with leaf object supplied by the
+   subclass.
+
+   @param _leaf is the leaf object, now owned by this.
+ */
+Response::Response(TrainCtx *_ctx, const std::vector<double> &_y, const PMTrain *_pmTrain, Leaf *_leaf) : y(_y), leaf(_leaf), ctx(_ctx), pmTrain(_pmTrain) {
 }
 
 
@@ -84,6 +96,10 @@ ResponseReg::~ResponseReg() {
 }
 
 
+ResponseMulti::~ResponseMulti() {
+}
+
+
 /**
    @brief Regression-specific entry to factory methods.
 
@@ -91,8 +107,8 @@ ResponseReg::~ResponseReg() {
 
    @return void, with output reference vector.
  */
-ResponseReg *Response::FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) {
-  return new ResponseReg(yNum, _row2Rank, _pmTrain, _leafOrigin, _leafNode, bagLeaf, bagBits);
+ResponseReg *Response::FactoryReg(TrainCtx *_ctx, const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) {
+  return new ResponseReg(_ctx, yNum, _row2Rank, _pmTrain, _leafOrigin, _leafNode, bagLeaf, bagBits);
 }
 
 
@@ -102,7 +118,36 @@ ResponseReg *Response::FactoryReg(const std::vector<double> &yNum, const std::ve
    @param _y is the response vector.
 
  */
-ResponseReg::ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) : Response(_y, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits), row2Rank(_row2Rank) {
+ResponseReg::ResponseReg(TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits) : Response(_ctx, _y, _pmTrain, leafOrigin, leafNode, bagLeaf, bagBits), row2Rank(_row2Rank) {
+}
+
+
+/**
+   @brief Multi-output entry to factory methods.
+
+   @param yPrimary is the response of the first output.
+
+   @param yOut is the response of all outputs, by output.
+
+   @param nOut is the number of outputs.
+
+   @param scoreOut outputs the per-output leaf scores.
+
+   @return new multi-output response.
+ */
+ResponseMulti *Response::FactoryMulti(TrainCtx *_ctx, const std::vector<double> &yPrimary, const std::vector<double> &yOut, unsigned int nOut, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &scoreOut) {
+  return new ResponseMulti(_ctx, yPrimary, yOut, nOut, _row2Rank, _pmTrain, _leafOrigin, _leafNode, bagLeaf, bagBits, scoreOut);
+}
+
+
+/**
+   @brief Multi-output subclass constructor.
+
+   @param _y is the primary response.
+
+   @param _yOut is the response of all outputs, by output.
+ */
+ResponseMulti::ResponseMulti(TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<double> &_yOut, unsigned int _nOut, const std::vector<unsigned int> &_row2Rank, const PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &scoreOut) : Response(_ctx, _y, _pmTrain, new LeafMulti(leafOrigin, leafNode, bagLeaf, bagBits, _y.size(), _ctx->thinLeaves, scoreOut, _nOut)), row2Rank(_row2Rank), yOut(_yOut), nOut(_nOut) {
 }
 
 
@@ -111,33 +156,53 @@ ResponseReg::ResponseReg(const std::vector<double> &_y, const std::vector<unsign
 
    @param rowRank is the predictor rank information.
 
+   @param tStart is the absolute index of the first tree in the block.
+
    @param blockSize is the number of trees in the block.
 
    @return block of SampleCtg instances.
  */
-PreTree **Response::BlockTree(const RowRank *rowRank, unsigned int blockSize) {
+PreTree **Response::BlockTree(const RowRank *rowRank, unsigned int tStart, unsigned int blockSize) {
   sampleBlock = new Sample*[blockSize];
-  for (unsigned int i = 0; i < blockSize; i++) {
-    sampleBlock[i] = Sampler(rowRank);
+
+  // Core-generated variates are keyed by tree, so the block can be
+  // sampled concurrently.  Front-end sampling remains serial.
+  if (ctx->feRNG) {
+    for (unsigned int blockIdx = 0; blockIdx < blockSize; blockIdx++) {
+      sampleBlock[blockIdx] = Sampler(rowRank, tStart + blockIdx);
+    }
+  }
+  else {
+    ctx->taskPool->Run(blockSize, [&](unsigned int blockIdx) {
+        sampleBlock[blockIdx] = Sampler(rowRank, tStart + blockIdx);
+      }, ctx->nSamp);
   }
 
-  return IndexLevel::BlockTrees(pmTrain, sampleBlock, blockSize);
+  return IndexLevel::BlockTrees(ctx, pmTrain, sampleBlock, blockSize);
 }
 
 
 /**
    @return Regression-style Sample object.
  */
-Sample *ResponseReg::Sampler(const RowRank *rowRank) {
-  return Sample::FactoryReg(pmTrain, Y(), rowRank, row2Rank);
+Sample *ResponseReg::Sampler(const RowRank *rowRank, unsigned int tIdx) {
+  return Sample::FactoryReg(ctx, pmTrain, Y(), rowRank, row2Rank, tIdx);
+}
+
+
+/**
+   @return Regression-style Sample object, summing all outputs.
+ */
+Sample *ResponseMulti::Sampler(const RowRank *rowRank, unsigned int tIdx) {
+  return Sample::FactoryReg(ctx, pmTrain, Y(), rowRank, row2Rank, tIdx, &yOut[0], nOut);
 }
 
 
 /**
    @return Classification-style Sample object.
  */
-Sample *ResponseCtg::Sampler(const class RowRank *rowRank) {
-  return Sample::FactoryCtg(pmTrain, Y(), rowRank, yCtg);
+Sample *ResponseCtg::Sampler(const class RowRank *rowRank, unsigned int tIdx) {
+  return Sample::FactoryCtg(ctx, pmTrain, Y(), rowRank, yCtg, tIdx);
 }
 
 
@@ -197,3 +262,13 @@ const BV *Response::TreeBag(unsigned int blockIdx) {
 void Response::LeafReserve(unsigned int leafEst, unsigned int bagEst) {
   leaf->Reserve(leafEst, bagEst);
 }
+
+
+/**
+   @brief Exports the completed leaf and bag records to the front end.
+
+   @return void, with side-effected leaf object.
+ */
+void Response::LeafExport() {
+  leaf->Export();
+}
@@ -28,25 +28,34 @@ class Response {
   class Leaf *leaf;
   class Sample** sampleBlock;
  protected:
+  class TrainCtx *ctx;
   const class PMTrain *pmTrain;
  public:
-  Response(const std::vector<double> &_y, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
-  Response(const std::vector<double> &_y, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
+  Response(class TrainCtx *_ctx, const std::vector<double> &_y, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
+  Response(class TrainCtx *_ctx, const std::vector<double> &_y, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
+  Response(class TrainCtx *_ctx, const std::vector<double> &_y, const class PMTrain *_pmTrain, class Leaf *_leaf);
   virtual ~Response();
 
   const std::vector<double> &Y() {
     return y;
   }
-  static class ResponseReg *FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
-  static class ResponseCtg *FactoryCtg(const std::vector<unsigned int> &feCtg, const std::vector<double> &feProxy, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
 
-  class PreTree **BlockTree(const class RowRank *rowRank, unsigned int blockSize);
+
+  const class Leaf *GetLeaf() const {
+    return leaf;
+  }
+  static class ResponseReg *FactoryReg(class TrainCtx *_ctx, const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
+  static class ResponseMulti *FactoryMulti(class TrainCtx *_ctx, const std::vector<double> &yPrimary, const std::vector<double> &yOut, unsigned int nOut, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &scoreOut);
+  static class ResponseCtg *FactoryCtg(class TrainCtx *_ctx, const std::vector<unsigned int> &feCtg, const std::vector<double> &feProxy, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
+
+  class PreTree **BlockTree(const class RowRank *rowRank, unsigned int tStart, unsigned int blockSize);
   const class BV *TreeBag(unsigned int blockIdx);
   void LeafReserve(unsigned int leafEst, unsigned int bagEst);
+  void LeafExport();
   void DeBlock(unsigned int blockSize);
   void Leaves(const std::vector<unsigned int> &leafMap, unsigned int blockIdx, unsigned int tIdx);
 
-  virtual class Sample* Sampler(const class RowRank *rowRank) = 0;
+  virtual class Sample* Sampler(const class RowRank *rowRank, unsigned int tIdx) = 0;
 };
 
 
@@ -57,11 +66,27 @@ class ResponseReg : public Response {
   const std::vector<unsigned int> &row2Rank; // Facilitates rank[] output.
  public:
 
-  ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
+  ResponseReg(class TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits);
   ~ResponseReg();
-  class Sample *Sampler(const class RowRank *rowRank);
+  class Sample *Sampler(const class RowRank *rowRank, unsigned int tIdx);
+};
+
+/**
+   @brief Specialization to multi-output regression trees.  The first
+   output is primary.
+ */
+class ResponseMulti : public Response {
+  const std::vector<unsigned int> &row2Rank; // Primary output only.
+  const std::vector<double> &yOut; // All outputs, by output.
+  const unsigned int nOut;
+ public:
+
+  ResponseMulti(class TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<double> &_yOut, unsigned int _nOut, const std::vector<unsigned int> &_row2Rank, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &scoreOut);
+  ~ResponseMulti();
+  class Sample *Sampler(const class RowRank *rowRank, unsigned int tIdx);
 };
 
+
 /**
    @brief Specialization to classification trees.
  */
@@ -69,9 +94,9 @@ class ResponseCtg : public Response {
   const std::vector<unsigned int> &yCtg; // 0-based factor-valued response.
  public:
 
-  ResponseCtg(const std::vector<unsigned int> &_yCtg, const std::vector<double> &_proxy, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
+  ResponseCtg(class TrainCtx *_ctx, const std::vector<unsigned int> &_yCtg, const std::vector<double> &_proxy, const class PMTrain *_pmTrain, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<class BagLeaf> &bagLeaf, std::vector<unsigned int> &bagBits, std::vector<double> &weight, unsigned int ctgWidth);
   ~ResponseCtg();
-  class Sample *Sampler(const class RowRank *rowRank);
+  class Sample *Sampler(const class RowRank *rowRank, unsigned int tIdx);
 };
 
 #endif
@@ -15,8 +15,10 @@
 
 #include "rowrank.h"
 #include "predblock.h"
+#include "taskpool.h"
 
 #include <algorithm>
+#include <cstring>
 
 // Testing only:
 //#include <iostream>
@@ -25,10 +27,17 @@
 // Observations are blocked according to type.  Blocks written in separate
 // calls from front-end interface.
 
+constexpr unsigned int RowRank::noBin;
+
 
 /**
    @brief Numeric predictor presort to parallel output vectors.
 
+   Predictors are sorted concurrently in blocks, buffering per-predictor
+   output, then appended in predictor order.  Blocks span one predictor
+   per worker, bounding the transient storage.  The pool lives only for
+   the presort, which runs once per design.
+
    @param feNum is a block of numeric predictor values.
 
    @param nPredNum is the number of numeric predictors.
@@ -37,16 +46,52 @@
 
    @param rank outputs the tie-classed predictor ranks.
 
+   @param radix is true iff sorting by radix rather than by comparison.
+
    @output void, with output vector parameters.
  */
-void RowRank::PreSortNum(const double _feNum[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<unsigned int> &numOffOut, std::vector<double> &numOut) {
-  for (unsigned int numIdx = 0; numIdx < _nPredNum; numIdx++) {
-    numOffOut[numIdx] = numOut.size();
-    NumSortRaw(&_feNum[numIdx * _nRow], _nRow, rowOut, rankOut, rleOut, numOut);
+void RowRank::PreSortNum(const double _feNum[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<unsigned int> &numOffOut, std::vector<double> &numOut, bool radix) {
+  TaskPool taskPool;
+  unsigned int sortBlock = taskPool.NWorker();
+  for (unsigned int blockStart = 0; blockStart < _nPredNum; blockStart += sortBlock) {
+    unsigned int blockEnd = std::min(_nPredNum, blockStart + sortBlock);
+    std::vector<SortBuf> sortBuf(blockEnd - blockStart);
+    taskPool.Run(blockEnd - blockStart, [&](unsigned int bufIdx) {
+        SortBuf &buf = sortBuf[bufIdx];
+        NumSortRaw(&_feNum[size_t(blockStart + bufIdx) * _nRow], _nRow, buf.row, buf.rank, buf.rle, buf.num, radix);
+      }, _nRow);
+
+    for (unsigned int blockIdx = blockStart; blockIdx < blockEnd; blockIdx++) {
+      numOffOut[blockIdx] = numOut.size();
+      sortBuf[blockIdx - blockStart].Append(rowOut, rankOut, rleOut, numOut);
+    }
   }
 }
 
 
+/**
+   @brief Appends buffered presort output to the front end's vectors.
+
+   @return void, with output vector parameters.
+ */
+void SortBuf::Append(std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut) {
+  rowOut.insert(rowOut.end(), row.begin(), row.end());
+  rankOut.insert(rankOut.end(), rank.begin(), rank.end());
+  rleOut.insert(rleOut.end(), rle.begin(), rle.end());
+}
+
+
+/**
+   @brief As above, but also appends the rank-ordered numerical values.
+
+   @return void, with output vector parameters.
+ */
+void SortBuf::Append(std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut) {
+  Append(rowOut, rankOut, rleOut);
+  numOut.insert(numOut.end(), num.begin(), num.end());
+}
+
+
 void RowRank::PreSortNumRLE(const double valNum[], const unsigned int rowStart[], const unsigned int runLength[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<unsigned int> &numOffOut, std::vector<double> &numOut) {
   unsigned int colOff = 0;
   for (unsigned int numIdx = 0; numIdx < _nPredNum; numIdx++) {
@@ -77,18 +122,108 @@ unsigned int RowRank::NumSortRLE(const double colNum[], unsigned int _nRow, cons
 
 
 /**
-   @brief
+   @brief Sorts a column of numerical predictor values, ties broken by row.
+
+   @param radix is true iff sorting by radix rather than by comparison.
 
    @return void.
  */
-void RowRank::NumSortRaw(const double colNum[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut) {
+void RowRank::NumSortRaw(const double colNum[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut, bool radix) {
   std::vector<ValRowD> valRow(_nRow);
+  if (radix) {
+    NumRadix(colNum, _nRow, valRow);
+  }
+  else {
+    for (unsigned int row = 0; row < _nRow; row++) {
+      valRow[row] = std::make_pair(colNum[row], row);
+    }
+    std::sort(valRow.begin(), valRow.end());  // Stable sort.
+  }
+  RankNum(valRow, rowOut, rankOut, rleOut, numOut);
+}
+
+
+/**
+   @brief Maps a double to an unsigned key having the same ordering.
+
+   Negative values have all bits flipped and nonnegative values have the
+   sign bit set.  Signed zeroes share a key, as they compare equal, and
+   NaNs are keyed last.
+
+   @param val is the value to map.
+
+   @return order-preserving key.
+ */
+uint64_t RowRank::NumKey(double val) {
+  if (val != val) {
+    return ~uint64_t(0);
+  }
+  else if (val == 0.0) {
+    val = 0.0;
+  }
+
+  uint64_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  const uint64_t signBit = uint64_t(1) << 63;
+  return (bits & signBit) ? ~bits : bits | signBit;
+}
+
+
+/**
+   @brief Least-significant-digit radix sort of a numerical column.
+
+   Each pass scatters stably, so rows of equal value remain in increasing
+   order, as with the comparison sort.  Digits shared by all keys are
+   skipped.
+
+   @param valRow outputs the sorted value/row pairs.
+
+   @return void, with output vector parameter.
+ */
+void RowRank::NumRadix(const double colNum[], unsigned int _nRow, std::vector<ValRowD> &valRow) {
+  const unsigned int nDigit = (64 + radixBits - 1) / radixBits;
+  const unsigned int nBucket = 1 << radixBits;
+  const uint64_t digitMask = nBucket - 1;
+
+  std::vector<uint64_t> key(_nRow);
+  std::vector<unsigned int> rowIdx(_nRow);
+  std::vector<unsigned int> count(nDigit * nBucket);
   for (unsigned int row = 0; row < _nRow; row++) {
-    valRow[row] = std::make_pair(colNum[row], row);
+    uint64_t keyRow = NumKey(colNum[row]);
+    key[row] = keyRow;
+    rowIdx[row] = row;
+    for (unsigned int digit = 0; digit < nDigit; digit++) {
+      count[digit * nBucket + ((keyRow >> (digit * radixBits)) & digitMask)]++;
+    }
   }
 
-  std::sort(valRow.begin(), valRow.end());  // Stable sort.
-  RankNum(valRow, rowOut, rankOut, rleOut, numOut);
+  std::vector<uint64_t> keyTemp(_nRow);
+  std::vector<unsigned int> rowTemp(_nRow);
+  std::vector<unsigned int> offset(nBucket);
+  for (unsigned int digit = 0; digit < nDigit && _nRow > 0; digit++) {
+    const unsigned int *digitCount = &count[digit * nBucket];
+    unsigned int shift = digit * radixBits;
+    if (digitCount[(key[0] >> shift) & digitMask] == _nRow)
+      continue;
+
+    unsigned int tot = 0;
+    for (unsigned int bucket = 0; bucket < nBucket; bucket++) {
+      offset[bucket] = tot;
+      tot += digitCount[bucket];
+    }
+    for (unsigned int idx = 0; idx < _nRow; idx++) {
+      unsigned int dest = offset[(key[idx] >> shift) & digitMask]++;
+      keyTemp[dest] = key[idx];
+      rowTemp[dest] = rowIdx[idx];
+    }
+    key.swap(keyTemp);
+    rowIdx.swap(rowTemp);
+  }
+
+  for (unsigned int idx = 0; idx < _nRow; idx++) {
+    unsigned int row = rowIdx[idx];
+    valRow[idx] = std::make_pair(colNum[row], row);
+  }
 }
 
 
@@ -173,14 +308,27 @@ void RowRank::RankNum(const std::vector<RLENum> &rleNum, std::vector<unsigned in
 
    @param rank Outputs the tie-classed predictor ranks.
 
+   @param radix is true iff sorting by counts rather than by comparison.
+
    @output void, with output vector parameters.
  */
-void RowRank::PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &runLength) {
+void RowRank::PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &runLength, bool radix) {
   // Builds the ranked factor block.  Assumes 0-justification has been 
   // performed by bridge.
   //
-  for (unsigned int facIdx = 0; facIdx < _nPredFac; facIdx++) {
-    FacSort(&_feFac[facIdx * _nRow], _nRow, rowOut, rankOut, runLength);
+  TaskPool taskPool;
+  unsigned int sortBlock = taskPool.NWorker();
+  for (unsigned int blockStart = 0; blockStart < _nPredFac; blockStart += sortBlock) {
+    unsigned int blockEnd = std::min(_nPredFac, blockStart + sortBlock);
+    std::vector<SortBuf> sortBuf(blockEnd - blockStart);
+    taskPool.Run(blockEnd - blockStart, [&](unsigned int bufIdx) {
+        SortBuf &buf = sortBuf[bufIdx];
+        FacSort(&_feFac[size_t(blockStart + bufIdx) * _nRow], _nRow, buf.row, buf.rank, buf.rle, radix);
+      }, _nRow);
+
+    for (auto & buf : sortBuf) {
+      buf.Append(rowOut, rankOut, runLength);
+    }
   }
 }
 
@@ -188,18 +336,54 @@ void RowRank::PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, un
 /**
    @brief Sorts factors and stores as rank-ordered run-length encoding.
 
+   @param radix is true iff sorting by counts rather than by comparison.
+
    @return void.
  */
-void RowRank::FacSort(const unsigned int predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut) {
+void RowRank::FacSort(const unsigned int predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, bool radix) {
   std::vector<ValRowI> valRow(_nRow);
-  for (unsigned int row = 0; row < _nRow; row++) {
-    valRow[row] = std::make_pair(predCol[row], row);
+  if (radix) {
+    FacCount(predCol, _nRow, valRow);
+  }
+  else {
+    for (unsigned int row = 0; row < _nRow; row++) {
+      valRow[row] = std::make_pair(predCol[row], row);
+    }
+    std::sort(valRow.begin(), valRow.end()); // Stable sort.
   }
-  std::sort(valRow.begin(), valRow.end()); // Stable sort.
   RankFac(valRow, rowOut, rankOut, rleOut);
 }
 
 
+/**
+   @brief Counting sort of a factor column, scattering rows in increasing
+   order within each factor code.
+
+   @param valRow outputs the sorted code/row pairs.
+
+   @return void, with output vector parameter.
+ */
+void RowRank::FacCount(const unsigned int predCol[], unsigned int _nRow, std::vector<ValRowI> &valRow) {
+  unsigned int codeMax = _nRow == 0 ? 0 : *std::max_element(predCol, predCol + _nRow);
+  std::vector<unsigned int> offset(codeMax + 1);
+  for (unsigned int row = 0; row < _nRow; row++) {
+    offset[predCol[row]]++;
+  }
+
+  unsigned int tot = 0;
+  for (auto & off : offset) {
+    unsigned int codeCount = off;
+    off = tot;
+    tot += codeCount;
+  }
+
+  for (unsigned int row = 0; row < _nRow; row++) {
+    unsigned int code = predCol[row];
+    valRow[offset[code]++] = std::make_pair(code, row);
+  }
+}
+
+
 /**
    @brief Builds rank-ordered run-length encoding to hold factor values.
 
@@ -243,7 +427,14 @@ void RowRank::RankFac(const std::vector<ValRowI> &valRow, std::vector<unsigned i
    @param feRank is the vector of ranks allocated by the front end.
 
  */
-RowRank::RowRank(const PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int *_numOffset, const double *_numVal, const unsigned int feRLE[], unsigned int rleLength) : nRow(pmTrain->NRow()), nPred(pmTrain->NPred()), noRank(std::max(nRow, pmTrain->CardMax())), numOffset(_numOffset), numVal(_numVal), nonCompact(0), accumCompact(0), denseRank(std::vector<unsigned int>(nPred)), rrCount(std::vector<unsigned int>(nPred)), rrStart(std::vector<unsigned int>(nPred)), safeOffset(std::vector<unsigned int>(nPred)) {
+RowRank::RowRank(const PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int *_numOffset, const double *_numVal, const unsigned int feRLE[], unsigned int rleLength, unsigned int rankBins) : nRow(pmTrain->NRow()), nPred(pmTrain->NPred()), noRank(std::max(nRow, pmTrain->CardMax())), nPredNum(pmTrain->NPredNum()), numOffset(_numOffset), numVal(_numVal), nonCompact(0), accumCompact(0), denseRank(std::vector<unsigned int>(nPred)), rrCount(std::vector<unsigned int>(nPred)), rrStart(std::vector<unsigned int>(nPred)), safeOffset(std::vector<unsigned int>(nPred)), binBase(std::vector<unsigned int>(nPredNum, noBin)) {
+  std::vector<unsigned int> rankBinned;
+  if (rankBins > 0) {
+    rankBinned = std::vector<unsigned int>(feRank, feRank + rleLength);
+    BinRanks(feRLE, rleLength, rankBins, rankBinned);
+    feRank = &rankBinned[0];
+  }
+
   DenseBlock(feRank, feRLE, rleLength);
   unsigned int rrSlots = ModeOffsets();
   rrNode = new RRNode[rrSlots];
@@ -252,6 +443,73 @@ RowRank::RowRank(const PMTrain *pmTrain, const unsigned int feRow[], const unsig
 }
 
 
+/**
+   @brief Replaces the ranks of numerical predictors having many distinct
+   values with bin codes.  The front end's ranks are not modified, so the
+   same presort may be trained with or without binning.
+
+   @param feRLE are the run lengths corresponding to RLE entries.
+
+   @param rleLength is the count of RLE entries.
+
+   @param rankBins is the maximal number of bins per predictor.
+
+   @param rank inputs the RLE ranks and outputs ranks or bin codes.
+
+   @return void, with output vector parameter.
+ */
+void RowRank::BinRanks(const unsigned int feRLE[], unsigned int rleLength, unsigned int rankBins, std::vector<unsigned int> &rank) {
+  unsigned int rleIdx = 0;
+  for (unsigned int numIdx = 0; numIdx < nPredNum; numIdx++) {
+    unsigned int rleStart = rleIdx;
+    for (unsigned int rowTot = 0; rowTot < nRow && rleIdx < rleLength; rowTot += feRLE[rleIdx++]);
+    unsigned int rankCount = rank[rleIdx - 1] + 1; // Entries are rank-ordered.
+    if (rankCount > rankBins) {
+      BinPred(numIdx, &feRLE[rleStart], &rank[rleStart], rleIdx - rleStart, rankBins, rankCount);
+    }
+  }
+}
+
+
+/**
+   @brief Assigns the ranks of a single predictor to bins of roughly
+   equal row count.  Bins close only between distinct ranks, so tied
+   values are never separated and a heavily-tied rank occupies a bin of
+   its own.
+
+   @param numIdx is the numerical predictor index.
+
+   @param rle are the predictor's run lengths.
+
+   @param rank inputs the predictor's ranks and outputs their bin codes.
+
+   @param entryCount is the number of RLE entries for the predictor.
+
+   @param rankCount is the number of distinct ranks.
+
+   @return void, with output parameter vector.
+ */
+void RowRank::BinPred(unsigned int numIdx, const unsigned int rle[], unsigned int rank[], unsigned int entryCount, unsigned int rankBins, unsigned int rankCount) {
+  binBase[numIdx] = binStart.size();
+  binStart.push_back(0);
+  unsigned int bin = 0;
+  unsigned int rankPrev = rank[0];
+  uint64_t rowBinned = 0;
+  for (unsigned int rleIdx = 0; rleIdx < entryCount; rleIdx++) {
+    if (rank[rleIdx] != rankPrev) {
+      rankPrev = rank[rleIdx];
+      if (bin + 1 < rankBins && rowBinned * rankBins >= uint64_t(bin + 1) * nRow) {
+        bin++;
+        binStart.push_back(rankPrev);
+      }
+    }
+    rowBinned += rle[rleIdx];
+    rank[rleIdx] = bin;
+  }
+  binStart.push_back(rankCount);
+}
+
+
 /**
    @brief Walks the design matrix as RLE entries, merging adjacent
    entries with identical ranks.
@@ -19,6 +19,7 @@
 #include <vector>
 #include <tuple>
 #include <cmath>
+#include <cstdint>
 
 #include "param.h"
 //#include <iostream>
@@ -29,6 +30,22 @@ typedef std::tuple<double, unsigned int, unsigned int> RLENum;
 typedef std::pair<unsigned int, unsigned int> ValRowI;
 
 
+/**
+   @brief Buffers the presort output of a single predictor, so that
+   predictors may be sorted concurrently and then appended in order.
+ */
+class SortBuf {
+ public:
+  std::vector<unsigned int> row;
+  std::vector<unsigned int> rank;
+  std::vector<unsigned int> rle;
+  std::vector<double> num;
+
+  void Append(std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut);
+  void Append(std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut);
+};
+
+
 class RRNode {
   unsigned int row;
   unsigned int rank;
@@ -59,7 +76,10 @@ class RowRank {
   const unsigned int nRow;
   const unsigned int nPred;
   const unsigned int noRank; // Inattainable rank value.
+  const unsigned int nPredNum;
+  static constexpr unsigned int noBin = 0xffffffff; // Unbinned predictor.
   static constexpr double plurality = 0.25;
+  static const unsigned int radixBits = 11; // Digit width for radix presort.
 
   // Jagged array holding numerical predictor values for split assignment.
   const unsigned int *numOffset; // Per-predictor starting offsets.
@@ -73,9 +93,17 @@ class RowRank {
   std::vector<unsigned int> rrStart;
   std::vector<unsigned int> safeOffset; // Either an index or an accumulated count.
 
+  // Rank quantization, numerical predictors only.  Binned predictors
+  // present bin codes in place of ranks.
+  std::vector<unsigned int> binBase; // Offset into 'binStart', else 'noBin'.
+  std::vector<unsigned int> binStart; // Lowest rank per bin, plus sentinel.
+
   
-  static void FacSort(const unsigned int predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rle);
-  static void NumSortRaw(const double predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut);
+  static void FacSort(const unsigned int predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rle, bool radix);
+  static void FacCount(const unsigned int predCol[], unsigned int _nRow, std::vector<ValRowI> &valRow);
+  static void NumSortRaw(const double predCol[], unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<double> &numOut, bool radix);
+  static void NumRadix(const double predCol[], unsigned int _nRow, std::vector<ValRowD> &valRow);
+  static inline uint64_t NumKey(double val);
   static unsigned int NumSortRLE(const double colNum[], unsigned int _nRow, const unsigned int rowStart[], const unsigned int runLength[], std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rlOut, std::vector<double> &numOut);
 
   static void RankFac(const std::vector<ValRowI> &valRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut);
@@ -96,6 +124,8 @@ class RowRank {
   };
 
   
+  void BinRanks(const unsigned int feRLE[], unsigned int feRLELength, unsigned int rankBins, std::vector<unsigned int> &rank);
+  void BinPred(unsigned int numIdx, const unsigned int rle[], unsigned int rank[], unsigned int entryCount, unsigned int rankBins, unsigned int rankCount);
   void DenseBlock(const unsigned int feRank[], const unsigned int feRLE[], unsigned int feRLELength);
   void DenseMode(unsigned int predIdx, unsigned int denseMax, unsigned int argMax);
   unsigned int ModeOffsets();
@@ -106,14 +136,14 @@ class RowRank {
   }
   
  public:
-  static void PreSortNum(const double _feNum[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<unsigned int> &valOffOut, std::vector<double> &numOut);
+  static void PreSortNum(const double _feNum[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rleOut, std::vector<unsigned int> &valOffOut, std::vector<double> &numOut, bool radix = true);
 
   static void PreSortNumRLE(const double valNum[], const unsigned int rowStart[], const unsigned int runLength[], unsigned int _nPredNum, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &rlOut, std::vector<unsigned int> &valOffOut, std::vector<double> &numOut);
   
-  static void PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &runLength);
+  static void PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, unsigned int _nRow, std::vector<unsigned int> &rowOut, std::vector<unsigned int> &rankOut, std::vector<unsigned int> &runLength, bool radix = true);
 
 
-  RowRank(const class PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int _numOffset[], const double _numVal[], const unsigned int feRLE[], unsigned int feRLELength);
+  RowRank(const class PMTrain *pmTrain, const unsigned int feRow[], const unsigned int feRank[], const unsigned int _numOffset[], const double _numVal[], const unsigned int feRLE[], unsigned int feRLELength, unsigned int rankBins = 0);
   ~RowRank();
 
   
@@ -175,17 +205,38 @@ class RowRank {
   }
 
 
+  /**
+     @brief Maps a pair of bin codes to the ranks bounding the gap between
+     the two bins, so that split values fall exactly between bins.
+
+     @param predIdx is the predictor index.
+
+     @param rankRange is a range of ranks or, if binned, of bin codes.
+
+     @return range of unbinned ranks.
+   */
+  inline RankRange RawRange(unsigned int predIdx, RankRange rankRange) const {
+    unsigned int base = binBase[predIdx];
+    if (base != noBin) {
+      rankRange.rankLow = binStart[base + rankRange.rankLow + 1] - 1;
+      rankRange.rankHigh = binStart[base + rankRange.rankHigh];
+    }
+    return rankRange;
+  }
+
+
   /**
      @brief Derives split values for a numerical predictor by synthesizing
      a fractional intermediate rank and interpolating.
 
      @param predIdx is the predictor index.
 
-     @param rankRange is the range of ranks.
+     @param binRange is the range of ranks, or of bin codes if binned.
 
      @return predictor value at mean rank, computed by PBTrain method.
   */
-  inline double QuantRank(unsigned int predIdx, RankRange rankRange, const double splitQuant[]) const {
+  inline double QuantRank(unsigned int predIdx, RankRange binRange, const double splitQuant[]) const {
+  RankRange rankRange = RawRange(predIdx, binRange);
   double rankNum = rankRange.rankLow + splitQuant[predIdx] * (rankRange.rankHigh - rankRange.rankLow);
   unsigned int rankFloor = floor(rankNum);
   unsigned int rankCeil = ceil(rankNum);
@@ -0,0 +1,320 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file rowrankfile.cc
+
+   @brief Methods for writing and mapping presorted predictor files.
+
+   @author Mark Seligman
+ */
+
+#include "rowrankfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#ifdef _WIN32
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//#include <iostream>
+//using namespace std;
+
+const char RowRankFile::magic[8] = {'A', 'R', 'B', 'R', 'R', 'N', 'K', '\0'};
+
+
+/**
+   @brief Accumulates a 64-bit FNV-1a hash over a byte range.  Chaining
+   the result through successive calls hashes their concatenation.
+
+   @param bytes is the start of the range.
+
+   @param count is the number of bytes to hash.
+
+   @param hash is the hash of any preceding ranges.
+
+   @return updated hash.
+ */
+uint64_t RowRankFile::Hash(const void *bytes, size_t count, uint64_t hash) {
+  const unsigned char *byte = static_cast<const unsigned char*>(bytes);
+  for (size_t i = 0; i < count; i++) {
+    hash ^= byte[i];
+    hash *= 0x100000001b3ull; // FNV prime.
+  }
+
+  return hash;
+}
+
+
+/**
+   @brief Hashes the length of a byte range and a bounded number of
+   evenly-spaced blocks within it, so that the cost is independent of
+   the range's size.  Ranges no longer than the sampled blocks are
+   hashed in full.
+
+   @param bytes is the start of the range.
+
+   @param count is the number of bytes in the range.
+
+   @param hash is the hash of any preceding ranges.
+
+   @return updated hash.
+ */
+uint64_t RowRankFile::Sample(const void *bytes, size_t count, uint64_t hash) {
+  uint64_t count64 = count;
+  hash = Hash(&count64, sizeof(count64), hash);
+  if (count <= sampleBlocks * sampleBytes)
+    return Hash(bytes, count, hash);
+
+  const char *byte = static_cast<const char*>(bytes);
+  size_t stride = (count - sampleBytes) / (sampleBlocks - 1);
+  for (size_t blockIdx = 0; blockIdx < sampleBlocks; blockIdx++) {
+    hash = Hash(byte + blockIdx * stride, sampleBytes, hash);
+  }
+
+  return hash;
+}
+
+
+/**
+   @brief Writes a presorted predictor block to file, replacing any
+   existing file only once the new contents are complete.
+
+   @param path is the file name.
+
+   @param feRow, feRank and feRLE are the parallel RLE vectors produced
+   by the presort, of length '_rleLength'.
+
+   @param feNumOff are the per-predictor offsets into 'feNumVal'.
+
+   @param feNumVal are the rank-ordered numerical values.
+
+   @param feFacCard are the factor cardinalities.
+
+   @param _fingerprint is a sampled hash of the predictor values, by
+   which a reader may check that the file was built from its own design.
+
+   @return true iff the file was written successfully.
+ */
+bool RowRankFile::Write(const char *path, unsigned int _nRow, unsigned int _nPredNum, unsigned int _nPredFac, const unsigned int feRow[], const unsigned int feRank[], const unsigned int feRLE[], unsigned int _rleLength, const unsigned int feNumOff[], const double feNumVal[], unsigned int _numValLength, const unsigned int feFacCard[], uint64_t _fingerprint) {
+  RRFHeader hdr;
+  std::memset(&hdr, 0, sizeof(hdr));
+  std::memcpy(hdr.magic, magic, sizeof(magic));
+  hdr.version = version;
+  hdr.byteOrder = byteOrder;
+  hdr.nRow = _nRow;
+  hdr.nPredNum = _nPredNum;
+  hdr.nPredFac = _nPredFac;
+  hdr.rleLength = _rleLength;
+  hdr.numValLength = _numValLength;
+  hdr.fingerprint = _fingerprint;
+  hdr.rowOff = Align(sizeof(RRFHeader));
+  hdr.rankOff = Align(hdr.rowOff + _rleLength * sizeof(unsigned int));
+  hdr.rleOff = Align(hdr.rankOff + _rleLength * sizeof(unsigned int));
+  hdr.numOffOff = Align(hdr.rleOff + _rleLength * sizeof(unsigned int));
+  hdr.numValOff = Align(hdr.numOffOff + _nPredNum * sizeof(unsigned int));
+  hdr.facCardOff = Align(hdr.numValOff + uint64_t(_numValLength) * sizeof(double));
+
+  std::string tmpPath = std::string(path) + ".tmp";
+  std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+  const char pad[align] = {0};
+  uint64_t pos = 0;
+  auto put = [&](uint64_t off, const void *src, uint64_t bytes) {
+    out.write(pad, off - pos);
+    out.write(static_cast<const char*>(src), bytes);
+    pos = off + bytes;
+  };
+  put(0, &hdr, sizeof(hdr));
+  put(hdr.rowOff, feRow, uint64_t(_rleLength) * sizeof(unsigned int));
+  put(hdr.rankOff, feRank, uint64_t(_rleLength) * sizeof(unsigned int));
+  put(hdr.rleOff, feRLE, uint64_t(_rleLength) * sizeof(unsigned int));
+  put(hdr.numOffOff, feNumOff, _nPredNum * sizeof(unsigned int));
+  put(hdr.numValOff, feNumVal, uint64_t(_numValLength) * sizeof(double));
+  put(hdr.facCardOff, feFacCard, _nPredFac * sizeof(unsigned int));
+  out.close();
+
+  if (!out || std::rename(tmpPath.c_str(), path) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @brief Maps a file read-only and validates its header.  On failure the
+   object is left invalid, as reported by Valid().
+
+   @param path is the file name.
+ */
+RowRankFile::RowRankFile(const char *path) : base(0), length(0), header(0) {
+#ifdef _WIN32
+  // No mapping:  reads the file into a buffer.
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in)
+    return;
+  length = in.tellg();
+  char *buf = new char[length];
+  in.seekg(0);
+  if (!in.read(buf, length)) {
+    delete [] buf;
+    return;
+  }
+  base = buf;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    length = st.st_size;
+    void *addr = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    base = addr == MAP_FAILED ? 0 : addr;
+  }
+  close(fd); // Mapping persists.
+  if (base == 0)
+    return;
+#endif
+
+  header = static_cast<const RRFHeader*>(base);
+  if (!Conforms()) {
+    header = 0;
+    Release();
+  }
+}
+
+
+/**
+   @brief Checks header identification, that every section lies within
+   the file and that the numerical offsets lie within the values.  The
+   per-predictor sections are small, so the check is cheap.
+
+   @return true iff the header describes a readable file.
+ */
+bool RowRankFile::Conforms() const {
+  if (length < sizeof(RRFHeader) || std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version || header->byteOrder != byteOrder)
+    return false;
+
+  const uint64_t countMax = std::numeric_limits<unsigned int>::max();
+  if (header->rleLength > countMax || header->numValLength > countMax)
+    return false;
+
+  if (!(SectionFits(header->rowOff, header->rleLength, sizeof(unsigned int))
+        && SectionFits(header->rankOff, header->rleLength, sizeof(unsigned int))
+        && SectionFits(header->rleOff, header->rleLength, sizeof(unsigned int))
+        && SectionFits(header->numOffOff, header->nPredNum, sizeof(unsigned int))
+        && SectionFits(header->numValOff, header->numValLength, sizeof(double))
+        && SectionFits(header->facCardOff, header->nPredFac, sizeof(unsigned int))))
+    return false;
+
+  const unsigned int *numOff = NumOff();
+  for (unsigned int numIdx = 0; numIdx < header->nPredNum; numIdx++) {
+    if (numOff[numIdx] > header->numValLength || (numIdx > 0 && numOff[numIdx] < numOff[numIdx - 1]))
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @brief Checks the contents of the run sections:  every run lies
+   within the rows, the runs of each predictor cover exactly the rows
+   in nondecreasing rank order, and every rank lies within its
+   predictor's cardinality.  Reads each run once, so is as costly as a
+   pass over the presort, which training performs in any case.
+
+   @return true iff the runs may be trusted by the RowRank constructor.
+ */
+bool RowRankFile::Validate() const {
+  const unsigned int *numOff = NumOff();
+  const unsigned int *facCard = FacCard();
+  uint64_t rleIdx = 0;
+  for (unsigned int numIdx = 0; numIdx < header->nPredNum; numIdx++) {
+    unsigned int numEnd = numIdx + 1 < header->nPredNum ? numOff[numIdx + 1] : header->numValLength;
+    if (!RunsConform(numEnd - numOff[numIdx], rleIdx))
+      return false;
+  }
+  for (unsigned int facIdx = 0; facIdx < header->nPredFac; facIdx++) {
+    if (!RunsConform(facCard[facIdx], rleIdx))
+      return false;
+  }
+
+  return rleIdx == header->rleLength;
+}
+
+
+/**
+   @brief Checks the runs of a single predictor.
+
+   @param card is the number of distinct ranks the predictor may take.
+
+   @param rleIdx inputs the predictor's first run and outputs the run
+   following its last.
+
+   @return true iff the predictor's runs conform.
+ */
+bool RowRankFile::RunsConform(unsigned int card, uint64_t &rleIdx) const {
+  const unsigned int *row = Row();
+  const unsigned int *rank = Rank();
+  const unsigned int *rle = RLE();
+  const unsigned int nRow = header->nRow;
+  unsigned int rankPrev = 0;
+  for (unsigned int rowTot = 0; rowTot < nRow; rleIdx++) {
+    if (rleIdx == header->rleLength)
+      return false;
+    unsigned int runLength = rle[rleIdx];
+    if (runLength == 0 || row[rleIdx] >= nRow || runLength > nRow - row[rleIdx] || runLength > nRow - rowTot)
+      return false;
+    if (rank[rleIdx] >= card || rank[rleIdx] < rankPrev)
+      return false;
+    rankPrev = rank[rleIdx];
+    rowTot += runLength;
+  }
+
+  return true;
+}
+
+
+/**
+   @return true iff section is aligned and lies within the file.
+ */
+bool RowRankFile::SectionFits(uint64_t off, uint64_t count, size_t eltSize) const {
+  return off % align == 0 && off >= sizeof(RRFHeader) && off <= length && count * eltSize <= length - off;
+}
+
+
+/**
+   @brief Unmaps or frees the file contents.
+
+   @return void.
+ */
+void RowRankFile::Release() {
+  if (base == 0)
+    return;
+#ifdef _WIN32
+  delete [] static_cast<char*>(base);
+#else
+  munmap(base, length);
+#endif
+  base = 0;
+}
+
+
+RowRankFile::~RowRankFile() {
+  Release();
+}
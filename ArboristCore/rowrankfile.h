@@ -0,0 +1,166 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file rowrankfile.h
+
+   @brief Class definitions for persistent storage of presorted
+   predictor orderings.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_ROWRANKFILE_H
+#define ARBORIST_ROWRANKFILE_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+   @brief Fixed-size file header.  Section offsets are in bytes from the
+   start of the file and aligned to 'RowRankFile::align'.
+ */
+struct RRFHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder; // Written natively:  detects foreign endianness.
+  uint32_t nRow;
+  uint32_t nPredNum;
+  uint32_t nPredFac;
+  uint32_t unused;
+  uint64_t rleLength; // # entries in each of row, rank and RLE.
+  uint64_t numValLength; // # distinct numerical values, all predictors.
+  uint64_t rowOff;
+  uint64_t rankOff;
+  uint64_t rleOff;
+  uint64_t numOffOff;
+  uint64_t numValOff;
+  uint64_t facCardOff;
+  uint64_t fingerprint; // Sampled hash of the predictor values presorted.
+};
+
+
+/**
+   @brief Versioned on-disk image of the presorted predictor block, as
+   consumed by the RowRank constructor.
+
+   The file is mapped read-only, so that repeated training over the same
+   design requires neither re-sorting nor copying:  sections are handed
+   to the core as raw pointers into the mapping, paged in on demand.
+ */
+class RowRankFile {
+  static const char magic[8];
+  static const uint32_t version = 3;
+  static const uint32_t byteOrder = 0x01020304;
+  static const uint64_t align = 64;
+
+  void *base; // Start of mapping, or of buffer if mapping unavailable.
+  size_t length; // Byte length of file.
+  const RRFHeader *header;
+
+  static uint64_t Align(uint64_t off) {
+    return (off + align - 1) & ~(align - 1);
+  }
+
+  bool Conforms() const;
+  bool SectionFits(uint64_t off, uint64_t count, size_t eltSize) const;
+  bool RunsConform(unsigned int card, uint64_t &rleIdx) const;
+  void Release();
+
+ public:
+  static const uint64_t hashBasis = 0xcbf29ce484222325ull; // FNV-1a offset.
+  static const size_t sampleBlocks = 64; // Blocks hashed by Sample().
+  static const size_t sampleBytes = 4096; // Bytes per sampled block.
+
+  static uint64_t Hash(const void *bytes, size_t count, uint64_t hash = hashBasis);
+  static uint64_t Sample(const void *bytes, size_t count, uint64_t hash = hashBasis);
+  static bool Write(const char *path, unsigned int _nRow, unsigned int _nPredNum, unsigned int _nPredFac, const unsigned int feRow[], const unsigned int feRank[], const unsigned int feRLE[], unsigned int _rleLength, const unsigned int feNumOff[], const double feNumVal[], unsigned int _numValLength, const unsigned int feFacCard[], uint64_t _fingerprint);
+
+  RowRankFile(const char *path);
+  ~RowRankFile();
+
+  bool Validate() const;
+
+
+  /**
+     @return true iff the file was mapped and its header validated.
+   */
+  inline bool Valid() const {
+    return header != 0;
+  }
+
+
+  inline unsigned int NRow() const {
+    return header->nRow;
+  }
+
+
+  inline unsigned int NPredNum() const {
+    return header->nPredNum;
+  }
+
+
+  inline unsigned int NPredFac() const {
+    return header->nPredFac;
+  }
+
+
+  /**
+     @return sampled hash of the predictor values from which the file
+     was built.
+   */
+  inline uint64_t Fingerprint() const {
+    return header->fingerprint;
+  }
+
+
+  inline unsigned int RLELength() const {
+    return header->rleLength;
+  }
+
+
+  inline unsigned int NumValLength() const {
+    return header->numValLength;
+  }
+
+
+  inline const unsigned int *Row() const {
+    return Section<unsigned int>(header->rowOff);
+  }
+
+
+  inline const unsigned int *Rank() const {
+    return Section<unsigned int>(header->rankOff);
+  }
+
+
+  inline const unsigned int *RLE() const {
+    return Section<unsigned int>(header->rleOff);
+  }
+
+
+  inline const unsigned int *NumOff() const {
+    return Section<unsigned int>(header->numOffOff);
+  }
+
+
+  inline const double *NumVal() const {
+    return Section<double>(header->numValOff);
+  }
+
+
+  inline const unsigned int *FacCard() const {
+    return Section<unsigned int>(header->facCardOff);
+  }
+
+
+  template<typename T> const T *Section(uint64_t off) const {
+    return reinterpret_cast<const T*>(static_cast<const char*>(base) + off);
+  }
+};
+
+#endif
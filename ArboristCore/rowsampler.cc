@@ -0,0 +1,156 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file rowsampler.cc
+
+   @brief Methods implementing weighted row sampling.
+
+   @author Mark Seligman
+ */
+
+#include "rowsampler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Constructor.  Builds the alias table or caches the weights,
+   according to sampling mode.
+
+   @param _nRow is the number of rows eligible for sampling.
+
+   @param _weight is the per-row sampling weight.
+
+   @param _withRepl is true iff sampling with replacement.
+ */
+RowSampler::RowSampler(unsigned int _nRow, const double _weight[], bool _withRepl) : nRow(_nRow), withRepl(_withRepl), weight(std::vector<double>(_weight, _weight + _nRow)), rowLive(0) {
+  rowLive = std::count_if(weight.begin(), weight.end(), [](double wt) { return wt > 0.0; });
+  if (withRepl) {
+    AliasInit();
+    weight.clear();
+  }
+}
+
+
+/**
+   @brief Builds the alias table by Vose's method.
+
+   @return void.
+ */
+void RowSampler::AliasInit() {
+  prob = std::vector<double>(nRow);
+  alias = std::vector<unsigned int>(nRow);
+  double scale = nRow / std::accumulate(weight.begin(), weight.end(), 0.0);
+
+  std::vector<unsigned int> small, large;
+  for (unsigned int row = 0; row < nRow; row++) {
+    prob[row] = weight[row] * scale;
+    alias[row] = row;
+    if (prob[row] < 1.0)
+      small.push_back(row);
+    else
+      large.push_back(row);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    unsigned int rowSmall = small.back();
+    small.pop_back();
+    unsigned int rowLarge = large.back();
+    large.pop_back();
+    alias[rowSmall] = rowLarge;
+    prob[rowLarge] += prob[rowSmall] - 1.0;
+    if (prob[rowLarge] < 1.0)
+      small.push_back(rowLarge);
+    else
+      large.push_back(rowLarge);
+  }
+
+  // Residual entries owe their imbalance to rounding:  always accepted.
+  for (auto row : small)
+    prob[row] = 1.0;
+  for (auto row : large)
+    prob[row] = 1.0;
+}
+
+
+/**
+   @brief Reports the number of variates consumed by a call to Sample().
+
+   @param nSamp is the number of samples requested.
+
+   @return count of uniform variates to supply.
+ */
+unsigned int RowSampler::VarCount(unsigned int nSamp) const {
+  return withRepl ? 2 * nSamp : nRow;
+}
+
+
+/**
+   @brief Draws a weighted sample of rows.
+
+   @param nSamp is the number of samples requested.
+
+   @param ru holds VarCount(nSamp) uniform variates on the unit interval.
+
+   @param out outputs the sampled rows.
+
+   @return count of rows drawn:  less than 'nSamp' only if sampling without
+   replacement and fewer rows have positive weight.
+ */
+unsigned int RowSampler::Sample(unsigned int nSamp, const double ru[], int out[]) const {
+  return withRepl ? SampleRepl(nSamp, ru, out) : SampleNoRepl(nSamp, ru, out);
+}
+
+
+/**
+   @brief Alias-table lookup, two variates per draw.
+
+   @return count of rows drawn.
+ */
+unsigned int RowSampler::SampleRepl(unsigned int nSamp, const double ru[], int out[]) const {
+  for (unsigned int i = 0; i < nSamp; i++) {
+    unsigned int col = ru[2*i] * nRow;
+    col = col < nRow ? col : nRow - 1;
+    out[i] = ru[2*i + 1] < prob[col] ? col : alias[col];
+  }
+
+  return nSamp;
+}
+
+
+/**
+   @brief Exponential-key selection, one variate per row.
+
+   Row keys are exponential variates scaled by the reciprocal weight, so
+   that the 'nSamp' smallest keys form a weighted sample without
+   replacement.  Rows of zero weight are never selected.
+
+   @return count of rows drawn.
+ */
+unsigned int RowSampler::SampleNoRepl(unsigned int nSamp, const double ru[], int out[]) const {
+  std::vector<double> key(nRow);
+  for (unsigned int row = 0; row < nRow; row++) {
+    key[row] = weight[row] > 0.0 ? -std::log1p(-ru[row]) / weight[row] : std::numeric_limits<double>::infinity();
+  }
+
+  std::vector<unsigned int> rowKey(nRow);
+  std::iota(rowKey.begin(), rowKey.end(), 0);
+  unsigned int sampCount = std::min(nSamp, rowLive);
+  if (sampCount < nRow) {
+    std::nth_element(rowKey.begin(), rowKey.begin() + sampCount, rowKey.end(), [&key](unsigned int a, unsigned int b) { return key[a] < key[b]; });
+  }
+  std::copy(rowKey.begin(), rowKey.begin() + sampCount, out);
+
+  return sampCount;
+}
@@ -0,0 +1,50 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file rowsampler.h
+
+   @brief Class definition for weighted sampling of rows.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_ROWSAMPLER_H
+#define ARBORIST_ROWSAMPLER_H
+
+#include <vector>
+
+/**
+   @brief Weighted row sampling, with or without replacement.
+
+   The sampler consumes uniform variates supplied by the caller, so that
+   the core generator and the front ends' generators may be used
+   interchangeably.  Sampling with replacement employs an alias table,
+   for constant time per draw.  Sampling without replacement assigns
+   each row an exponential key scaled by its weight and selects the
+   smallest keys, in time linear in the row count.
+ */
+class RowSampler {
+  const unsigned int nRow;
+  const bool withRepl;
+  std::vector<double> weight; // Without replacement only.
+  std::vector<double> prob; // With replacement:  alias-table threshold.
+  std::vector<unsigned int> alias; // With replacement:  alias-table row.
+  unsigned int rowLive; // # rows having positive weight.
+
+  void AliasInit();
+  unsigned int SampleRepl(unsigned int nSamp, const double ru[], int out[]) const;
+  unsigned int SampleNoRepl(unsigned int nSamp, const double ru[], int out[]) const;
+
+ public:
+  RowSampler(unsigned int _nRow, const double _weight[], bool _withRepl);
+
+  unsigned int VarCount(unsigned int nSamp) const;
+  unsigned int Sample(unsigned int nSamp, const double ru[], int out[]) const;
+};
+
+#endif
@@ -14,16 +14,11 @@
  */
 
 #include "runset.h"
-#include "callback.h"
 
 // Testing only:
 //#include <iostream>
 //using namespace std;
 
-unsigned int RunSet::ctgWidth = 0;
-unsigned int RunSet::noStart = 0;
-
-
 /**
    Run objects are allocated per-tree, and live throughout training.
 
@@ -61,14 +56,11 @@ unsigned int RunSet::noStart = 0;
    @brief Constructor initializes predictor run length either to cardinality, 
    for factors, or to a nonsensical zero, for numerical.
  */
-Run::Run(unsigned int _ctgWidth, unsigned int nRow, unsigned int bagCount) : noRun(nRow * bagCount), ctgWidth(_ctgWidth) {
-  RunSet::ctgWidth = ctgWidth;
-  RunSet::noStart = nRow; // Inattainable start value, irrespective of tree.
+Run::Run(unsigned int _ctgWidth, unsigned int nRow, unsigned int bagCount) : noRun(nRow * bagCount), noStart(nRow), ctgWidth(_ctgWidth) {
   runSet = 0;
   facRun = 0;
   bHeap = 0;
   lhOut = 0;
-  rvWide = 0;
   ctgSum = 0;
 }
 
@@ -85,14 +77,15 @@ void Run::RunSets(const std::vector<unsigned int> &safeCount) {
   if (setCount > 0) {
     runSet = new RunSet[setCount];
     for (unsigned int setIdx = 0; setIdx < setCount; setIdx++) {
-      CountSafe(setIdx, safeCount[setIdx]);
+      runSet[setIdx].Init(ctgWidth, noStart, safeCount[setIdx]);
     }
   }
 }
 
 
 /**
-   @brief Regression:  all runs employ a heap.
+   @brief Regression:  all runs employ a heap.  Multiple outputs are
+   summed by run over a checkerboard, as are categories.
 
    @return void.
  */
@@ -106,6 +99,13 @@ void Run::OffsetsReg() {
     runCount += runSet[i].CountSafe();
   }
 
+  if (ctgWidth > 0) {
+    unsigned int boardWidth = runCount * ctgWidth;
+    ctgSum = new double[boardWidth];
+    for (unsigned int i = 0; i < boardWidth; i++)
+      ctgSum[i] = 0.0;
+  }
+
   facRun = new FRNode[runCount];
   bHeap = new BHPair[runCount];
   lhOut = new unsigned int[runCount];
@@ -115,10 +115,9 @@ void Run::OffsetsReg() {
 
 
 /**
-   @brief Classification:  only wide run sets use the heap.
+   @brief Classification:  only binary and wide run sets use the heap.
 
    @return void.
-
 */
 void Run::OffsetsCtg() {
   if (setCount == 0)
@@ -135,10 +134,10 @@ void Run::OffsetsCtg() {
       heapRuns += rCount;
       outRuns += rCount;
     }
-    else if (rCount > RunSet::maxWidth) {
+    else if (rCount > RunSet::maxWidth) { // Wide sorts by category.
       runSet[i].OffsetCache(runCount, heapRuns, outRuns);
       heapRuns += rCount;
-      outRuns += RunSet::maxWidth;
+      outRuns += rCount;
     }
     else {
       runSet[i].OffsetCache(runCount, 0, outRuns);
@@ -152,11 +151,6 @@ void Run::OffsetsCtg() {
   for (unsigned int i = 0; i < boardWidth; i++)
     ctgSum[i] = 0.0;
 
-  if (ctgWidth > 2 && heapRuns > 0) { // Wide non-binary:  w.o. replacement.
-    rvWide = new double[heapRuns];
-    CallBack::RUnif(heapRuns, rvWide);
-  }
-
   facRun = new FRNode[runCount];
   bHeap = new BHPair[heapRuns];
   lhOut = new unsigned int[outRuns];
@@ -172,7 +166,7 @@ void Run::OffsetsCtg() {
  */
 void Run::ResetRuns() {
   for (unsigned int i = 0; i < setCount; i++) {
-    runSet[i].Reset(facRun, bHeap, lhOut, ctgSum, rvWide);
+    runSet[i].Reset(facRun, bHeap, lhOut, ctgSum);
   }
 }
 
@@ -182,8 +176,6 @@ void Run::LevelClear() {
     delete [] runSet;
     delete [] facRun;
     delete [] lhOut;
-    if (rvWide != 0)
-      delete [] rvWide;
     if (ctgSum != 0)
       delete [] ctgSum;
     if (bHeap != 0)
@@ -191,7 +183,6 @@ void Run::LevelClear() {
     runSet = 0;
     facRun = 0;
     lhOut = 0;
-    rvWide = 0;
     ctgSum = 0;
     bHeap = 0;
     setCount = 0;
@@ -199,6 +190,24 @@ void Run::LevelClear() {
 }
 
 
+/**
+   @brief Caches tree-invariant values and a conservative run count.
+
+   @param _ctgWidth is the response cardinality.
+
+   @param _noStart is the start value reserved for implicit runs.
+
+   @param _safeRunCount is a conservative run count.
+
+   @return void.
+ */
+void RunSet::Init(unsigned int _ctgWidth, unsigned int _noStart, unsigned int _safeRunCount) {
+  ctgWidth = _ctgWidth;
+  noStart = _noStart;
+  safeRunCount = _safeRunCount;
+}
+
+
 /**
    @brief Records only the (casted) relative vector offsets, as absolute
    base addresses not yet known.
@@ -214,36 +223,53 @@ void RunSet::OffsetCache(unsigned int _runOff, unsigned int _heapOff, unsigned i
    @brief Updates relative vector addresses with their respective base
    addresses, now known.
  */
-void RunSet::Reset(FRNode *runBase, BHPair *heapBase, unsigned int *outBase, double *ctgBase, double *rvBase) {
+void RunSet::Reset(FRNode *runBase, BHPair *heapBase, unsigned int *outBase, double *ctgBase) {
   runZero = runBase + runOff;
   heapZero = heapBase + heapOff;
   outZero = outBase + outOff;
-  rvZero = rvBase + heapOff;
   ctgZero = ctgBase + (runOff * ctgWidth);
   runCount = 0;
 }
 
 
 /**
-   @brief Writes to heap arbitrarily:  sampling w/o replacement.
+   @brief Writes to heap, weighting by slot mean response.
 
    @return void.
  */
-void RunSet::HeapRandom() {
+void RunSet::HeapMean() {
   for (unsigned int slot = 0; slot < runCount; slot++) {
-    BHeap::Insert(heapZero, slot, rvZero[slot]);
+    BHeap::Insert(heapZero, slot, runZero[slot].sum / runZero[slot].sCount);
   }
 }
 
 
 /**
-   @brief Writes to heap, weighting by slot mean response.
+   @brief Writes to heap, weighting by slot mean of a single output.
+
+   @param outIdx is the output by which to order.
 
    @return void.
  */
-void RunSet::HeapMean() {
+void RunSet::HeapOut(unsigned int outIdx) {
   for (unsigned int slot = 0; slot < runCount; slot++) {
-    BHeap::Insert(heapZero, slot, runZero[slot].sum / runZero[slot].sCount);
+    BHeap::Insert(heapZero, slot, SumCtg(slot, outIdx) / runZero[slot].sCount);
+  }
+}
+
+
+/**
+   @brief Writes to heap, weighting by the proportion of a single
+   category.  Generalizes the binary ordering to one category versus
+   the rest.
+
+   @param yCtg is the category by which to order.
+
+   @return void.
+ */
+void RunSet::HeapCtg(unsigned int yCtg) {
+  for (unsigned int slot = 0; slot < runCount; slot++) {
+    BHeap::Insert(heapZero, slot, SumCtg(slot, yCtg) / runZero[slot].sum);
   }
 }
 
@@ -293,17 +319,19 @@ void RunSet::WriteImplicit(unsigned int denseRank, unsigned int sCountTot, doubl
     }
   }
 
-  Write(denseRank, sCountTot, sumTot, denseCount);
+  Write(denseRank, sCountTot, sumTot, denseCount, noStart);
 }
 
 
 /**
    @brief Implicit runs are characterized by a start value of 'noStart'.
 
+   @param noStart is the start value reserved for implicit runs.
+
    @return Whether this run is dense.
  */
-bool FRNode::IsImplicit() {
-  return start == RunSet::noStart;
+bool FRNode::IsImplicit(unsigned int noStart) {
+  return start == noStart;
 }
 
 
@@ -330,7 +358,7 @@ bool RunSet::ImplicitLeft() {
 
   for (unsigned int runIdx = 0; runIdx < runsLH; runIdx++) {
     unsigned int outSlot = outZero[runIdx];
-    if (runZero[outSlot].IsImplicit()) {
+    if (runZero[outSlot].IsImplicit(noStart)) {
       return true;
     }
   }
@@ -351,44 +379,6 @@ void RunSet::DePop(unsigned int pop) {
 }
 
 
-/**
-   @brief Hammers the pair's run contents with runs selected for
-   sampling.  Since the runs are to be read numerous times, performance
-   may be benefit from this elimination of a level of indirection.
-
-
-   @return post-shrink run count.
- */
-unsigned int RunSet::DeWide() {
-  if (runCount <= maxWidth)
-    return runCount;
-
-  HeapRandom();
-  FRNode tempRun[maxWidth];
-  double *tempSum = new double[ctgWidth * maxWidth];
-  // Copies runs referenced by the slot list to a temporary area.
-  DePop(maxWidth);
-  for (unsigned int i = 0; i < maxWidth; i++) {
-    unsigned int outSlot = outZero[i];
-    tempRun[i] = runZero[outSlot];
-    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-      tempSum[i * ctgWidth + ctg] = ctgZero[outSlot * ctgWidth + ctg];
-    }
-  }
-
-  // Overwrites existing runs with the shrunken list
-  for (unsigned int i = 0; i < maxWidth; i++) {
-    runZero[i] = tempRun[i];
-    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-      ctgZero[i * ctgWidth + ctg] = tempSum[i * ctgWidth + ctg];
-    }
-  }
-  delete [] tempSum;
-
-  return maxWidth;
-}
-
-
 /**
    @brief Decodes bit vector of slot indices and stores LH indices.
 
@@ -400,7 +390,7 @@ unsigned int RunSet::DeWide() {
 */
 unsigned int RunSet::LHBits(unsigned int lhBits, unsigned int &lhSampCt) {
   unsigned int lhExtent = 0;
-  unsigned int slotSup = EffCount() - 1;
+  unsigned int slotSup = runCount - 1;
   runsLH = 0;
   lhSampCt = 0;
   if (lhBits != 0) {
@@ -421,7 +411,7 @@ unsigned int RunSet::LHBits(unsigned int lhBits, unsigned int &lhSampCt) {
 
   if (ImplicitLeft()) {
     unsigned int rhIdx = runsLH;
-    for (unsigned int slot = 0; slot < EffCount(); slot++) {
+    for (unsigned int slot = 0; slot < runCount; slot++) {
       if ((lhBits & (1 << slot)) == 0) {
         outZero[rhIdx++] = slot;
       }
@@ -37,7 +37,7 @@ class FRNode {
 
   FRNode() : start(0), extent(0), sCount(0), sum(0.0) {}
 
-  bool IsImplicit();
+  bool IsImplicit(unsigned int noStart);
 
   
   inline void Init(unsigned int _rank, unsigned int _sCount, double _sum, unsigned int _start, unsigned int _extent) {
@@ -91,26 +91,26 @@ class RunSet {
   FRNode *runZero; // Base for this run set.
   BHPair *heapZero; // Heap workspace.
   unsigned int *outZero; // Final LH and/or output for heap-ordered slots.
-  double *ctgZero; // Categorical:  run x ctg checkerboard.
-  double *rvZero; // Non-binary wide runs:  random variates for sampling.
+  double *ctgZero; // Categorical, multi-output:  run x ctg/output checkerboard.
   unsigned int runCount;  // Current high watermark:  not subject to shrinking.
   unsigned int runsLH; // Count of LH runs.
+  unsigned int ctgWidth; // Response cardinality, or output count:  zero iff single regression.
+  unsigned int noStart; // Inattainable start value, marking implicit run.
  public:
-  const static unsigned int maxWidth = 10;
-  static unsigned int ctgWidth;
-  static unsigned int noStart;
+  const static unsigned int maxWidth = 10; // Widest run set searched exhaustively.
   unsigned int safeRunCount;
 
-  RunSet() : hasImplicit(false), runOff(0), heapOff(0), outOff(0), runZero(0), heapZero(0), outZero(0), ctgZero(0), rvZero(0), runCount(0), runsLH(0), safeRunCount(0) {}
+  RunSet() : hasImplicit(false), runOff(0), heapOff(0), outOff(0), runZero(0), heapZero(0), outZero(0), ctgZero(0), runCount(0), runsLH(0), ctgWidth(0), noStart(0), safeRunCount(0) {}
 
+  void Init(unsigned int _ctgWidth, unsigned int _noStart, unsigned int _safeRunCount);
   bool ImplicitLeft();
   void WriteImplicit(unsigned int denseRank, unsigned int sCountTot, double sumTot, unsigned int denseCount, const double nodeSum[] = 0);
-  unsigned int DeWide();
   void DePop(unsigned int pop = 0);
-  void Reset(FRNode*, BHPair*, unsigned int*, double*, double*);
+  void Reset(FRNode*, BHPair*, unsigned int*, double*);
   void OffsetCache(unsigned int _runOff, unsigned int _heapOff, unsigned int _outOff);
-  void HeapRandom();
   void HeapMean();
+  void HeapOut(unsigned int outIdx);
+  void HeapCtg(unsigned int yCtg);
   void HeapBinary();
 
 
@@ -129,17 +129,6 @@ class RunSet {
   }
   
   
-  /**
-     @brief "Effective" run count, for the sake of splitting, is the lesser
-     of the true run count and 'maxWidth'.
-
-     @return effective run count
-   */
-  inline unsigned int EffCount() {
-    return runCount > maxWidth ? maxWidth : runCount;
-  }
-
-
   /**
      @brief Looks up sum and sample count associated with a given output slot.
 
@@ -156,12 +145,22 @@ class RunSet {
     return runZero[slot].sum;
   }
 
+  /**
+     @brief Looks up the run slot sorted into a given output position.
+
+     @return slot index.
+   */
+  inline unsigned int OutSlot(unsigned int outPos) const {
+    return outZero[outPos];
+  }
+
+
   /**
      @brief Sets run parameters and increments run count.
 
      @return void.
    */
-  inline void Write(unsigned int rank, unsigned int sCount, double sum, unsigned int extent, unsigned int start = noStart) {
+  inline void Write(unsigned int rank, unsigned int sCount, double sum, unsigned int extent, unsigned int start) {
     runZero[runCount++].Init(rank, sCount, sum, start, extent);
     hasImplicit = (start == noStart ? true : false);
   }
@@ -251,12 +250,12 @@ class RunSet {
 
 class Run {
   const unsigned int noRun;  // Inattainable run index for tree.
+  const unsigned int noStart; // Inattainable start value, irrespective of tree.
   unsigned int setCount;
   RunSet *runSet;
   FRNode *facRun; // Workspace for FRNodes used along level.
   BHPair *bHeap;
   unsigned int *lhOut; // Vector of lh-bound slot indices.
-  double *rvWide;
   double *ctgSum;
 
   void ResetRuns();
@@ -15,67 +15,23 @@
 
 #include "sample.h"
 #include "bv.h"
-#include "callback.h"
 #include "rowrank.h"
 #include "samplepred.h"
 #include "bottom.h"
+#include "trainctx.h"
+#include "taskpool.h"
 
 //#include <iostream>
 //using namespace std;
 
-// Simulation-invariant values.
-//
-unsigned int Sample::nRow = 0;
-unsigned int Sample::nSamp = 0;
-
-unsigned int SampleCtg::ctgWidth = 0;
-
 /**
- @brief Lights off initializations needed for sampling.
-
- @param _nRow is the number of response/observation rows.
-
- @param _nSamp is the number of samples.
-
- @return void.
-*/
-void Sample::Immutables(unsigned int _nSamp, const std::vector<double> &_feSampleWeight, bool _withRepl, unsigned int _ctgWidth, unsigned int _nTree) {
-  nRow = _feSampleWeight.size();
-  nSamp = _nSamp;
-  CallBack::SampleInit(nRow, &_feSampleWeight[0], _withRepl);
-  if (_ctgWidth > 0)
-    SampleCtg::Immutables(_ctgWidth, _nTree);
-}
+   @brief Base constructor.
 
+   @param _ctx is the training context.
 
-/**
-   @return void.
+   @param _tIdx is the absolute index of the tree, keying its variates.
  */
-void SampleCtg::Immutables(unsigned int _ctgWidth, unsigned int _nTree) {
-  ctgWidth = _ctgWidth;
-}
-
-
-/**
- */
-void SampleCtg::DeImmutables() {
-  ctgWidth = 0;
-}
-
-
-/**
-   @brief Finalizer.
-
-   @return void.
-*/
-void Sample::DeImmutables() {
-  nRow = 0;
-  nSamp = 0;
-  SampleCtg::DeImmutables();
-}
-
-
-Sample::Sample() : treeBag(new BV(nRow)), row2Sample(std::vector<unsigned int>(nRow)), noSample(nRow) {
+Sample::Sample(const TrainCtx *_ctx, unsigned int _tIdx) : treeBag(new BV(_ctx->nRow)), row2Sample(std::vector<unsigned int>(_ctx->nRow)), ctx(_ctx), tIdx(_tIdx), nRow(ctx->nRow), nSamp(ctx->nSamp), noSample(nRow) {
   std::fill(row2Sample.begin(), row2Sample.end(), noSample);
   sampleNode.reserve(nSamp);
 }
@@ -98,8 +54,8 @@ Sample::~Sample() {
 */
 void Sample::RowSample(std::vector<unsigned int> &sCountRow) {
   int *rvRow = new int[nSamp];
-  CallBack::SampleRows(nSamp, rvRow);
-  for (unsigned int i = 0; i < nSamp; i++) {
+  unsigned int sampCount = ctx->SampleRows(tIdx, rvRow);
+  for (unsigned int i = 0; i < sampCount; i++) {
     int row = rvRow[i];
     sCountRow[row]++;
   }
@@ -111,8 +67,8 @@ void Sample::RowSample(std::vector<unsigned int> &sCountRow) {
 /**
    @brief Static entry for classification.
  */
-SampleCtg *Sample::FactoryCtg(const PMTrain *pmTrain, const std::vector<double> &y, const RowRank *rowRank,  const std::vector<unsigned int> &yCtg) {
-  SampleCtg *sampleCtg = new SampleCtg();
+SampleCtg *Sample::FactoryCtg(const TrainCtx *_ctx, const PMTrain *pmTrain, const std::vector<double> &y, const RowRank *rowRank,  const std::vector<unsigned int> &yCtg, unsigned int _tIdx) {
+  SampleCtg *sampleCtg = new SampleCtg(_ctx, _tIdx);
   sampleCtg->Stage(pmTrain, yCtg, y, rowRank);
 
   return sampleCtg;
@@ -122,10 +78,13 @@ SampleCtg *Sample::FactoryCtg(const PMTrain *pmTrain, const std::vector<double>
 /**
    @brief Static entry for regression response.
 
+   @param yOut is the multi-output response, by output:  null iff single.
+
+   @param nOut is the number of response outputs.
  */
-SampleReg *Sample::FactoryReg(const PMTrain *pmTrain, const std::vector<double> &y, const RowRank *rowRank, const std::vector<unsigned int> &row2Rank) {
-  SampleReg *sampleReg = new SampleReg();
-  sampleReg->Stage(pmTrain, y, row2Rank, rowRank);
+SampleReg *Sample::FactoryReg(const TrainCtx *_ctx, const PMTrain *pmTrain, const std::vector<double> &y, const RowRank *rowRank, const std::vector<unsigned int> &row2Rank, unsigned int _tIdx, const double yOut[], unsigned int nOut) {
+  SampleReg *sampleReg = new SampleReg(_ctx, _tIdx);
+  sampleReg->Stage(pmTrain, y, row2Rank, rowRank, yOut, nOut);
 
   return sampleReg;
 }
@@ -134,7 +93,7 @@ SampleReg *Sample::FactoryReg(const PMTrain *pmTrain, const std::vector<double>
 /**
    @brief Constructor.
  */
-SampleReg::SampleReg() : Sample() {
+SampleReg::SampleReg(const TrainCtx *_ctx, unsigned int _tIdx) : Sample(_ctx, _tIdx), nOut(1) {
 }
 
 
@@ -150,18 +109,47 @@ SampleReg::SampleReg() : Sample() {
 
    @param bagSum is the sum of in-bag sample values.  Used for initializing index tree root.
 
+   @param yOut is the multi-output response, by output:  null iff single.
+
+   @param _nOut is the number of response outputs.
+
    @return count of in-bag samples.
 */
-void SampleReg::Stage(const PMTrain *pmTrain, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const RowRank *rowRank) {
+void SampleReg::Stage(const PMTrain *pmTrain, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const RowRank *rowRank, const double yOut[], unsigned int _nOut) {
   std::vector<unsigned int> ctgProxy(nRow);
   std::fill(ctgProxy.begin(), ctgProxy.end(), 0);
   bagCount = Sample::PreStage(y, ctgProxy, rowRank, samplePred);
-  bottom = Bottom::FactoryReg(pmTrain, rowRank, samplePred, bagCount);
+  nOut = _nOut;
+  if (yOut != 0) { // Scored per output, even if only one.
+    SetOutputs(yOut);
+  }
+  bottom = Bottom::FactoryReg(ctx, pmTrain, rowRank, this, samplePred, bagCount, tIdx, nOut, nOut > 1 ? &sumOut[0] : 0);
   Sample::Stage(rowRank);
   SetRank(row2Rank);
 }
 
 
+/**
+   @brief Weights each output of the sampled rows by sample count, as
+   the primary response is weighted in SampleNode.
+
+   @param yOut is the response, by output, of which the first is primary.
+
+   @return void, with side-effected sample sums.
+ */
+void SampleReg::SetOutputs(const double yOut[]) {
+  sumOut = std::vector<double>(bagCount * nOut);
+  for (unsigned int row = 0; row < nRow; row++) {
+    unsigned int sIdx;
+    if (SampleIdx(row, sIdx)) {
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        sumOut[sIdx * nOut + outIdx] = SCount(sIdx) * yOut[outIdx * nRow + row];
+      }
+    }
+  }
+}
+
+
 /**
    @brief Compresses row->rank map to sIdx->rank.
 
@@ -184,7 +172,7 @@ void SampleReg::SetRank(const std::vector<unsigned int> &row2Rank) {
 /**
    @brief Constructor.
  */
-SampleCtg::SampleCtg() : Sample() {
+SampleCtg::SampleCtg(const TrainCtx *_ctx, unsigned int _tIdx) : Sample(_ctx, _tIdx) {
 }
 
 
@@ -202,7 +190,7 @@ SampleCtg::SampleCtg() : Sample() {
 //
 void SampleCtg::Stage(const PMTrain *pmTrain, const std::vector<unsigned int> &yCtg, const std::vector<double> &y, const RowRank *rowRank) {
   bagCount = Sample::PreStage(y, yCtg, rowRank, samplePred);
-  bottom = Bottom::FactoryCtg(pmTrain, rowRank, samplePred, sampleNode, bagCount);
+  bottom = Bottom::FactoryCtg(ctx, pmTrain, rowRank, this, samplePred, sampleNode, bagCount, tIdx);
   Sample::Stage(rowRank);
 }
 
@@ -244,26 +232,24 @@ unsigned int Sample::PreStage(const std::vector<double> &y, const std::vector<un
   }
 
   unsigned int sIdx = sampleNode.size();
-  _samplePred = SamplePred::Factory(rowRank->NPred(), sIdx, rowRank->SafeSize(sIdx));
+  _samplePred = SamplePred::Factory(rowRank->NPred(), sIdx, ctx->lazyStage ? 0 : rowRank->SafeSize(sIdx), ctx->ctgShift, ctx->columnLayout);
   return sIdx;
 }
 
 
 /**
-   @brief Loops through the predictors to stage.
+   @brief Loops through the predictors to stage.  Lazy staging defers
+   each predictor until first scheduled.
 
    @return void.
  */
 void Sample::Stage(const RowRank *rowRank) {
-  int predIdx;
+  if (ctx->lazyStage)
+    return;
 
-#pragma omp parallel default(shared) private(predIdx)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (predIdx = 0; predIdx < int(rowRank->NPred()); predIdx++) {
+  ctx->taskPool->Run(rowRank->NPred(), [&](unsigned int predIdx) {
       Stage(rowRank, predIdx);
-    }
-  }
+    }, bagCount);
 }
 
 
@@ -276,6 +262,25 @@ void Sample::Stage(const RowRank *rowRank) {
 */
 void Sample::Stage(const RowRank *rowRank, unsigned int predIdx) {
   std::vector<StagePack> stagePack;
+  Pack(rowRank, predIdx, stagePack);
+  bottom->RootDef(predIdx, bagCount - stagePack.size());
+
+  unsigned int extent;
+  unsigned int safeOffset = rowRank->SafeOffset(predIdx, bagCount, extent);
+  samplePred->Stage(stagePack, predIdx, safeOffset, extent);
+}
+
+
+/**
+   @brief Packs the sampled explicit indices of a predictor.
+
+   @param predIdx is the predictor index.
+
+   @param stagePack outputs the packed indices, in rank order.
+
+   @return void, with output vector.
+ */
+void Sample::Pack(const RowRank *rowRank, unsigned int predIdx, std::vector<StagePack> &stagePack) const {
   stagePack.reserve(bagCount); // Too big iff implicits present.
   unsigned int idxCount = rowRank->ExplicitCount(predIdx);
   for (unsigned int idx = 0; idx < idxCount; idx++) {
@@ -283,11 +288,30 @@ void Sample::Stage(const RowRank *rowRank, unsigned int predIdx) {
     rowRank->Ref(predIdx, idx, row, rank);
     PackIndex(row, rank, stagePack);
   }
-  bottom->RootDef(predIdx, bagCount - stagePack.size());
+}
 
-  unsigned int extent;
-  unsigned int safeOffset = rowRank->SafeOffset(predIdx, bagCount, extent);
-  samplePred->Stage(stagePack, predIdx, safeOffset, extent);
+
+/**
+   @brief Counts the sampled rows taking a predictor's dense rank,
+   without staging.
+
+   @param predIdx is the predictor index.
+
+   @return count of implicit sample indices.
+ */
+unsigned int Sample::ImplicitCount(const RowRank *rowRank, unsigned int predIdx) const {
+  unsigned int idxCount = rowRank->ExplicitCount(predIdx);
+  if (idxCount == nRow) // No rows implicit.
+    return 0;
+
+  unsigned int explCount = 0;
+  for (unsigned int idx = 0; idx < idxCount; idx++) {
+    unsigned int row, rank, sIdx;
+    rowRank->Ref(predIdx, idx, row, rank);
+    explCount += SampleIdx(row, sIdx) ? 1 : 0;
+  }
+
+  return bagCount - explCount;
 }
 
 
@@ -296,7 +320,7 @@ void Sample::Stage(const RowRank *rowRank, unsigned int predIdx) {
 
    @return void.
  */
-void Sample::PackIndex(unsigned int row, unsigned int predRank, std::vector<StagePack> &stagePack) {
+void Sample::PackIndex(unsigned int row, unsigned int predRank, std::vector<StagePack> &stagePack) const {
   unsigned int sIdx;
   if (SampleIdx(row, sIdx)) {
     StagePack packItem;
@@ -88,9 +88,11 @@ class Sample {
   class BV *treeBag;
   std::vector<unsigned int> row2Sample;
  protected:
+  const class TrainCtx *ctx;
+  const unsigned int tIdx; // Absolute tree index.
+  const unsigned int nRow;
+  const unsigned int nSamp;
   const unsigned int noSample; // Inattainable sample index.
-  static unsigned int nRow;
-  static unsigned int nSamp;
   std::vector<SampleNode> sampleNode;
   unsigned int bagCount;
   double bagSum;
@@ -99,24 +101,23 @@ class Sample {
   unsigned int PreStage(const std::vector<double> &y, const std::vector<unsigned int> &yCtg, const class RowRank *rowRank, class SamplePred *&_samplePred);
   void Stage(const class RowRank *rowRank);
   void Stage(const class RowRank *rowRank, unsigned int predIdx);
-  void PackIndex(unsigned int row, unsigned int predRank, std::vector<class StagePack> &stagePack);
+  void PackIndex(unsigned int row, unsigned int predRank, std::vector<class StagePack> &stagePack) const;
 
-  static void RowSample(std::vector<unsigned int> &sCountRow);
+  void RowSample(std::vector<unsigned int> &sCountRow);
 
  public:
-  static class SampleCtg *FactoryCtg(const class PMTrain *pmTrain, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &yCtg);
-  static class SampleReg *FactoryReg(const class PMTrain *pmTrain, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &row2Rank);
+  static class SampleCtg *FactoryCtg(const class TrainCtx *_ctx, const class PMTrain *pmTrain, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &yCtg, unsigned int _tIdx);
+  static class SampleReg *FactoryReg(const class TrainCtx *_ctx, const class PMTrain *pmTrain, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &row2Rank, unsigned int _tIdx, const double yOut[] = 0, unsigned int nOut = 1);
 
-  static void Immutables(unsigned int _nSamp, const std::vector<double> &_feSampleWeight, bool _withRepl, unsigned int _ctgWidth, unsigned int _nTree);
-  static void DeImmutables();
-
-  Sample();
+  Sample(const class TrainCtx *_ctx, unsigned int _tIdx);
   void RowInvert(std::vector<unsigned int> &sample2Row) const;
+  void Pack(const class RowRank *rowRank, unsigned int predIdx, std::vector<class StagePack> &stagePack) const;
+  unsigned int ImplicitCount(const class RowRank *rowRank, unsigned int predIdx) const;
   
   /**
      @brief Accessor for sample count.
    */
-  static inline unsigned int NSamp() {
+  inline unsigned int NSamp() const {
     return nSamp;
   }
 
@@ -189,9 +190,12 @@ class Sample {
 */
 class SampleReg : public Sample {
   unsigned int *sample2Rank; // Only client currently leaf-based methods.
+  unsigned int nOut; // # response outputs:  unity unless multi-output.
+  std::vector<double> sumOut; // Per-sample output sums:  empty iff single output.
   void SetRank(const std::vector<unsigned int> &row2Rank);
+  void SetOutputs(const double yOut[]);
  public:
-  SampleReg();
+  SampleReg(const class TrainCtx *_ctx, unsigned int _tIdx);
   ~SampleReg();
 
   inline unsigned int Rank(unsigned int sIdx) const {
@@ -199,7 +203,26 @@ class SampleReg : public Sample {
   }
 
 
-  void Stage(const class PMTrain *pmTrain, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const class RowRank *rowRank);
+  /**
+     @brief Accessor for output count.
+   */
+  inline unsigned int NOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @brief Looks up the response sums of a sample, by output.  Only
+     valid for multi-output response.
+
+     @return row of output sums.
+   */
+  inline const double *SumOut(unsigned int sIdx) const {
+    return &sumOut[sIdx * nOut];
+  }
+
+
+  void Stage(const class PMTrain *pmTrain, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const class RowRank *rowRank, const double yOut[] = 0, unsigned int _nOut = 1);
 };
 
 
@@ -207,12 +230,9 @@ class SampleReg : public Sample {
  @brief Classification-specific sampling.
 */
 class SampleCtg : public Sample {
-  static unsigned int ctgWidth;
  public:
-  SampleCtg();
+  SampleCtg(const class TrainCtx *_ctx, unsigned int _tIdx);
   ~SampleCtg();
-  static void Immutables(unsigned int _ctgWidth, unsigned int _nTree);
-  static void DeImmutables();
 
   
   void Stage(const class PMTrain *pmTrain, const std::vector<unsigned int> &yCtg, const std::vector<double> &y, const class RowRank *rowRank);
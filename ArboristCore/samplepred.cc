@@ -18,48 +18,52 @@
 #include "bv.h"
 
 #include <numeric>
+#include <algorithm>
 
 //#include <iostream>
 //using namespace std;
 
-unsigned int SPNode::ctgShift = 0;
-
 /**
    @brief Computes a packing width sufficient to hold all (zero-based) response
    category values.
 
    @param ctgWidth is the response cardinality.
 
-   @return void.
+   @return packing shift, zero iff regression.
  */
-void SPNode::Immutables(unsigned int ctgWidth) {
+unsigned int SPNode::CtgShift(unsigned int ctgWidth) {
   unsigned int bits = 1;
-  ctgShift = 0;
+  unsigned int ctgShift = 0;
   // Ctg values are zero-based, so the first power of 2 greater than or
   // equal to 'ctgWidth' has sufficient bits to hold all response values.
   while (bits < ctgWidth) {
     bits <<= 1;
     ctgShift++;
   }
-}
-
 
-/*
-**/
-void SPNode::DeImmutables() {
-  ctgShift = 0;
+  return ctgShift;
 }
 
 
 /**
    @brief Base class constructor.
+
+   @param _bufferSize is the size of the staged workspace, or zero if
+   columns are to be allocated as predictors are staged.
+
+   @param _columnar is true iff buffers are to be laid out by field.
  */
-SamplePred::SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize) : bagCount(_bagCount), nPred(_nPred), bufferSize(_bufferSize), pitchSP(_bagCount * sizeof(SamplePred)), pitchSIdx(_bagCount * sizeof(unsigned int)) {
+SamplePred::SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize, unsigned int _ctgShift, bool _columnar) : bagCount(_bagCount), nPred(_nPred), ctgShift(_ctgShift), columnar(_columnar), bufferSize(_bufferSize), pitchSP(_bagCount * sizeof(SamplePred)), pitchSIdx(_bagCount * sizeof(unsigned int)), stageExtent(std::vector<unsigned int>(nPred)), nodeVec(0), ySumVec(0), rankVec(0), sCountVec(0), predNode(std::vector<SPNode*>(2 * nPred)), predCol(std::vector<SPCol>(2 * nPred)), predSIdx(std::vector<unsigned int*>(2 * nPred)), predPath(std::vector<unsigned int*>(nPred)), poolTop(0), poolCap(0) {
   indexBase = new unsigned int[2* bufferSize];
-  nodeVec = new SPNode[2 * bufferSize];
-  
-  stageOffset.reserve(nPred);
-  stageExtent.reserve(nPred);
+  if (columnar) {
+    ySumVec = new FltVal[2 * bufferSize];
+    rankVec = new unsigned int[2 * bufferSize];
+    sCountVec = new unsigned int[2 * bufferSize];
+  }
+  else {
+    nodeVec = new SPNode[2 * bufferSize];
+  }
+  pathBase = new unsigned int[bufferSize];
 }
 
 
@@ -68,17 +72,34 @@ SamplePred::SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int
  */
 SamplePred::~SamplePred() {
   delete [] nodeVec;
+  delete [] ySumVec;
+  delete [] rankVec;
+  delete [] sCountVec;
   delete [] indexBase;
+  delete [] pathBase;
+  for (auto block : poolNode) {
+    delete [] block;
+  }
+  for (auto block : poolSum) {
+    delete [] block;
+  }
+  for (auto block : poolIdx) {
+    delete [] block;
+  }
 }
 
 
 /**
    @brief Static entry for sample staging.
 
+   @param _ctgShift is the response packing width, zero iff regression.
+
+   @param _columnar is true iff buffers are to be laid out by field.
+
    @return SamplePred object for tree.
  */
-SamplePred *SamplePred::Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize) {
-  SamplePred *samplePred = new SamplePred(_nPred, _bagCount, _bufferSize);
+SamplePred *SamplePred::Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize, unsigned int _ctgShift, bool _columnar) {
+  SamplePred *samplePred = new SamplePred(_nPred, _bagCount, _bufferSize, _ctgShift, _columnar);
 
   return samplePred;
 }
@@ -94,16 +115,156 @@ SamplePred *SamplePred::Factory(unsigned int _nPred, unsigned int _bagCount, uns
    @return void.
  */
 void SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx, unsigned int safeOffset, unsigned int extent) {
-  stageOffset[predIdx] = safeOffset;
-  stageExtent[predIdx] = extent;
+  if (columnar) {
+    unsigned int off0 = safeOffset;
+    unsigned int off1 = bufferSize + safeOffset;
+    Column(predIdx, SPCol(ySumVec + off0, rankVec + off0, sCountVec + off0), SPCol(ySumVec + off1, rankVec + off1, sCountVec + off1), indexBase + off0, indexBase + off1, pathBase + safeOffset, extent);
+    StageRoot<SPCol>(stagePack, predIdx);
+  }
+  else {
+    Column(predIdx, nodeVec + safeOffset, nodeVec + bufferSize + safeOffset, indexBase + safeOffset, indexBase + bufferSize + safeOffset, pathBase + safeOffset, extent);
+    StageRoot<SPRow>(stagePack, predIdx);
+  }
+}
+
+
+/**
+   @brief As above, but into a column already carved from the pool.
+
+   @return void.
+ */
+void SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx) {
+  if (columnar) {
+    StageRoot<SPCol>(stagePack, predIdx);
+  }
+  else {
+    StageRoot<SPRow>(stagePack, predIdx);
+  }
+}
 
+
+/**
+   @brief Initializes a predictor's root column in the layout specified.
+
+   @return void.
+ */
+template<typename Layout> void SamplePred::StageRoot(const std::vector<StagePack> &stagePack, unsigned int predIdx) {
   unsigned int *smpIdx;
-  SPNode *spn = Buffers(predIdx, 0, smpIdx);
+  Layout spn;
+  Buffers(predIdx, 0, spn, smpIdx);
   for (unsigned int idx = 0; idx < stagePack.size(); idx++) {
-    unsigned int sIdx = spn++->Init(stagePack[idx]);
-    *smpIdx++ = sIdx;
+    smpIdx[idx] = spn.Init(idx, stagePack[idx], ctgShift);
   }
-  spn = Buffers(predIdx, 0, smpIdx);
+}
+
+
+/**
+   @brief Initializes a lazily-staged column in the node layout of a
+   level other than the root.
+
+   @param stagePack holds the sampled explicit indices, in rank order.
+
+   @param stNode maps sample index to node, inattainable if extinct.
+
+   @param stIdx maps sample index to the index value to be recorded.
+
+   @param idxOff holds the next free position in each node.
+
+   @return base of the staged buffer.
+ */
+template<typename Layout> Layout SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff) {
+  unsigned int *smpIdx;
+  Layout spn;
+  Buffers(predIdx, 0, spn, smpIdx);
+  for (auto & pack : stagePack) {
+    unsigned int nodeIdx = stNode[pack.SIdx()];
+    if (nodeIdx < idxOff.size()) {
+      unsigned int destIdx = idxOff[nodeIdx]++;
+      smpIdx[destIdx] = stIdx[spn.Init(destIdx, pack, ctgShift)];
+    }
+  }
+
+  return spn;
+}
+
+
+/**
+   @brief Recovers the staging values of a cell, in buffer order, so that
+   they may be staged anew within another SamplePred.
+
+   @param bufIdx is the buffer holding the cell.
+
+   @param idxStart is the starting position of the cell.
+
+   @param extent is the number of explicit indices in the cell.
+
+   @param idxLocal maps the cell's buffered indices to those to be staged.
+
+   @param stagePack outputs the packed cell.
+
+   @return void, with output vector.
+ */
+void SamplePred::Pack(unsigned int predIdx, unsigned int bufIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &idxLocal, std::vector<StagePack> &stagePack) const {
+  if (columnar) {
+    PackCell<SPCol>(predIdx, bufIdx, idxStart, extent, idxLocal, stagePack);
+  }
+  else {
+    PackCell<SPRow>(predIdx, bufIdx, idxStart, extent, idxLocal, stagePack);
+  }
+}
+
+
+template<typename Layout> void SamplePred::PackCell(unsigned int predIdx, unsigned int bufIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &idxLocal, std::vector<StagePack> &stagePack) const {
+  unsigned int *smpIdx;
+  Layout spn;
+  Buffers(predIdx, bufIdx, spn, smpIdx);
+  stagePack.resize(extent);
+  for (unsigned int i = 0; i < extent; i++) {
+    FltVal ySum;
+    unsigned int rank, yCtg;
+    unsigned int sCount = spn[idxStart + i].CtgFields(ySum, rank, yCtg, ctgShift);
+    stagePack[i].Init(idxLocal[smpIdx[idxStart + i]], rank, sCount, yCtg, ySum);
+  }
+}
+
+
+/**
+   @brief Carves a predictor's column from the pool, adding a block if
+   the current block has insufficient room.  Not thread-safe.
+
+   @param predIdx is the predictor index.
+
+   @param extent is the number of slots required by each buffer.
+
+   @return void.
+ */
+void SamplePred::Allocate(unsigned int predIdx, unsigned int extent) {
+  // Column-major blocks append rank and count slots to the index block.
+  unsigned int idxWidth = columnar ? 7 : 3;
+  if (poolTop + extent > poolCap) {
+    poolCap = std::max(extent, poolCols * bagCount);
+    if (columnar) {
+      poolSum.push_back(new FltVal[2 * poolCap]);
+    }
+    else {
+      poolNode.push_back(new SPNode[2 * poolCap]);
+    }
+    poolIdx.push_back(new unsigned int[idxWidth * poolCap]);
+    poolTop = 0;
+  }
+
+  unsigned int *idx = poolIdx.back() + idxWidth * poolTop;
+  if (columnar) {
+    FltVal *ySum = poolSum.back() + 2 * poolTop;
+    unsigned int *rank = idx + 3 * extent;
+    unsigned int *sCount = idx + 5 * extent;
+    Column(predIdx, SPCol(ySum, rank, sCount), SPCol(ySum + extent, rank + extent, sCount + extent), idx, idx + extent, idx + 2 * extent, extent);
+  }
+  else {
+    SPNode *node = poolNode.back() + 2 * poolTop;
+    Column(predIdx, node, node + extent, idx, idx + extent, idx + 2 * extent, extent);
+  }
+  poolTop += extent;
 }
 
 
@@ -112,9 +273,11 @@ void SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int pre
 
    @param stagePack holds packed staging values.
 
+   @param ctgShift is the packing width of the response.
+
    @return upacked sample index.
  */
-unsigned int SPNode::Init(const StagePack &stagePack) {
+unsigned int SPNode::Init(const StagePack &stagePack, unsigned int ctgShift) {
   unsigned int sIdx, ctg;
   stagePack.Ref(sIdx, rank, sCount, ctg, ySum);
   sCount = (sCount << ctgShift) | ctg; // Packed representation.
@@ -142,8 +305,14 @@ unsigned int SPNode::Init(const StagePack &stagePack) {
    @return sum of responses within the block.
  */
 double SamplePred::BlockReplay(unsigned int predIdx, unsigned int sourceBit, unsigned int start, unsigned int extent, BV *replayExpl) {
+  return columnar ? Replay<SPCol>(predIdx, sourceBit, start, extent, replayExpl) : Replay<SPRow>(predIdx, sourceBit, start, extent, replayExpl);
+}
+
+
+template<typename Layout> double SamplePred::Replay(unsigned int predIdx, unsigned int sourceBit, unsigned int start, unsigned int extent, BV *replayExpl) {
   unsigned int *idx;
-  SPNode *spn = Buffers(predIdx, sourceBit, idx);
+  Layout spn;
+  Buffers(predIdx, sourceBit, spn, idx);
 
   double sum = 0.0;
   for (unsigned int spIdx = start; spIdx < start + extent; spIdx++) {
@@ -155,8 +324,8 @@ double SamplePred::BlockReplay(unsigned int predIdx, unsigned int sourceBit, uns
 }
 
 
-SPNode *SamplePred::RestageStxGen(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel) {
-  SPNode *source, *targ;
+template<typename Layout> Layout SamplePred::RestageStxGen(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel) {
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(predIdx, bufIdx, source, idxSource, targ, idxTarg);
 
@@ -165,7 +334,7 @@ SPNode *SamplePred::RestageStxGen(unsigned int reachOffset[], unsigned int predI
     unsigned int path;
     if (stPath->PathLive(relSource, pathMask, path)) {
       unsigned int destIdx = reachOffset[path]++;
-      targ[destIdx] = source[idx];
+      targ.Move(destIdx, source, idx);
       // RelFront() performs (slow) sIdx-to-relIdx mapping:  transition only.
       idxTarg[destIdx] = nodeRel ? stPath->RelFront(relSource) : relSource;
     }
@@ -176,22 +345,38 @@ SPNode *SamplePred::RestageStxGen(unsigned int reachOffset[], unsigned int predI
 
 
 
-SPNode *SamplePred::RestageStxOne(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel) {
-  SPNode *source, *targ;
+/**
+   @brief Restages along a single path bit, a block of samples at a time.
+   Each block is classified by successor, then compacted into the two
+   targets.
+
+   @return view of the target buffer.
+ */
+template<typename Layout> Layout SamplePred::RestageStxOne(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel) {
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(predIdx, bufIdx, source, idxSource, targ, idxTarg);
 
   unsigned int leftOff = reachOffset[0];
   unsigned int rightOff = reachOffset[1];
-  for (unsigned int idx = startIdx; idx < startIdx + extent; idx++) {
-    unsigned int relSource = idxSource[idx];
-    unsigned int path;
-    if (stPath->PathLive(relSource, pathMask, path)) {
-      unsigned int destIdx = path == 0 ? leftOff++ : rightOff++;
-      targ[destIdx] = source[idx];
-      // RelFront() performs (slow) sIdx-to-relIdx mapping:  transition only.
-      idxTarg[destIdx] = nodeRel ? stPath->RelFront(relSource) : relSource;
+  unsigned int relBlock[PathCompact::blockSize];
+  for (unsigned int idx = startIdx; idx < startIdx + extent; idx += PathCompact::blockSize) {
+    unsigned int count = std::min(PathCompact::blockSize, startIdx + extent - idx);
+    uint64_t leftBits, rightBits;
+    PathCompact::Classify(idxSource + idx, count, stPath->PathBase(), pathMask, leftBits, rightBits);
+
+    // RelFront() performs (slow) sIdx-to-relIdx mapping:  transition only.
+    const unsigned int *relSource = idxSource + idx;
+    if (nodeRel) {
+      for (unsigned int k = 0; k < count; k++) {
+        relBlock[k] = stPath->RelFront(relSource[k]);
+      }
+      relSource = relBlock;
     }
+    PathCompact::Compress(relSource, count, leftBits, idxTarg + leftOff);
+    PathCompact::Compress(relSource, count, rightBits, idxTarg + rightOff);
+    leftOff += targ.Compact(leftOff, source, idx, count, leftBits);
+    rightOff += targ.Compact(rightOff, source, idx, count, rightBits);
   }
 
   reachOffset[0] = leftOff;
@@ -201,8 +386,8 @@ SPNode *SamplePred::RestageStxOne(unsigned int reachOffset[], unsigned int predI
 }
 
 
-SPNode *SamplePred::RestageNdxGen(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent) {
-  SPNode *source, *targ;
+template<typename Layout> Layout SamplePred::RestageNdxGen(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent) {
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(predIdx, bufIdx, source, idxSource, targ, idxTarg);
 
@@ -211,7 +396,7 @@ SPNode *SamplePred::RestageNdxGen(unsigned int reachOffset[], const unsigned int
     unsigned int path, offRel;
     if (frontPath->RefLive(relSource, pathMask, path, offRel)) {
       unsigned int destIdx = reachOffset[path]++;
-      targ[destIdx] = source[idx];
+      targ.Move(destIdx, source, idx);
       idxTarg[destIdx] = reachBase[path] + offRel;
     }
   }
@@ -220,21 +405,32 @@ SPNode *SamplePred::RestageNdxGen(unsigned int reachOffset[], const unsigned int
 }
 
 
-SPNode *SamplePred::RestageNdxOne(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent) {
-  SPNode *source, *targ;
+/**
+   @brief Node-relative analogue of RestageStxOne().
+
+   @return view of the target buffer.
+ */
+template<typename Layout> Layout SamplePred::RestageNdxOne(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent) {
+  Layout source, targ;
   unsigned int *idxSource, *idxTarg;
   Buffers(predIdx, bufIdx, source, idxSource, targ, idxTarg);
 
   unsigned int leftOff = reachOffset[0];
   unsigned int rightOff = reachOffset[1];
-  for (unsigned int idx = startIdx; idx < startIdx + extent; idx++) {
-    unsigned int relSource = idxSource[idx];
-    unsigned int path, offRel;
-    if (frontPath->RefLive(relSource, pathMask, path, offRel)) {
-      unsigned int destIdx = path == 0 ? leftOff++ : rightOff++;
-      targ[destIdx] = source[idx];
-      idxTarg[destIdx] = reachBase[path] + offRel;
+  unsigned int relBlock[PathCompact::blockSize];
+  for (unsigned int idx = startIdx; idx < startIdx + extent; idx += PathCompact::blockSize) {
+    unsigned int count = std::min(PathCompact::blockSize, startIdx + extent - idx);
+    uint64_t leftBits, rightBits;
+    PathCompact::Classify(idxSource + idx, count, frontPath->PathBase(), pathMask, leftBits, rightBits);
+
+    // Offsets of extinct samples are undefined, but go unselected.
+    for (unsigned int k = 0; k < count; k++) {
+      relBlock[k] = reachBase[(rightBits >> k) & 1] + frontPath->OffFront(idxSource[idx + k]);
     }
+    PathCompact::Compress(relBlock, count, leftBits, idxTarg + leftOff);
+    PathCompact::Compress(relBlock, count, rightBits, idxTarg + rightOff);
+    leftOff += targ.Compact(leftOff, source, idx, count, leftBits);
+    rightOff += targ.Compact(rightOff, source, idx, count, rightBits);
   }
 
   reachOffset[0] = leftOff;
@@ -242,3 +438,17 @@ SPNode *SamplePred::RestageNdxOne(unsigned int reachOffset[], const unsigned int
 
   return targ;
 }
+
+
+// Instantiates layout-generic methods invoked by other modules.
+//
+template SPRow SamplePred::Stage<SPRow>(const std::vector<StagePack> &stagePack, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff);
+template SPCol SamplePred::Stage<SPCol>(const std::vector<StagePack> &stagePack, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff);
+template SPRow SamplePred::RestageStxGen<SPRow>(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+template SPCol SamplePred::RestageStxGen<SPCol>(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+template SPRow SamplePred::RestageStxOne<SPRow>(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+template SPCol SamplePred::RestageStxOne<SPCol>(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+template SPRow SamplePred::RestageNdxGen<SPRow>(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent);
+template SPCol SamplePred::RestageNdxGen<SPCol>(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent);
+template SPRow SamplePred::RestageNdxOne<SPRow>(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent);
+template SPCol SamplePred::RestageNdxOne<SPCol>(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, IdxPath *frontPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent);
@@ -19,6 +19,7 @@
 #define ARBORIST_SAMPLEPRED_H
 
 #include "param.h"
+#include "pathcompact.h"
 
 #include <vector>
 
@@ -33,6 +34,11 @@ class StagePack {
   unsigned int ctg;
   FltVal ySum;
  public:
+  inline unsigned int SIdx() const {
+    return sIdx;
+  }
+
+
   inline void Ref(unsigned int &_sIdx, unsigned int &_rank, unsigned int &_sCount, unsigned int &_ctg, FltVal &_ySum) const {
     _sIdx = sIdx;
     _rank = rank;
@@ -54,9 +60,6 @@ class StagePack {
 /**
  */
 class SPNode {
-  static unsigned int ctgShift; // Pack:  nonzero iff categorical response.
-
-
  protected:
   FltVal ySum; // sum of response values associated with sample.
   unsigned int rank; // Rank, up to tie, or factor group.
@@ -65,9 +68,8 @@ class SPNode {
 
 
  public:
-  static void Immutables(unsigned int ctgWidth);
-  static void DeImmutables();
-  unsigned int Init(const StagePack &stagePack);
+  static unsigned int CtgShift(unsigned int ctgWidth);
+  unsigned int Init(const StagePack &stagePack, unsigned int ctgShift);
   
   inline void Init(FltVal _ySum, unsigned int _sCount, unsigned int _rank) {
     ySum = _ySum;
@@ -115,9 +117,11 @@ class SPNode {
 
      @param _yCtg outputs the response value.
 
+     @param ctgShift is the packing width of the response.
+
      @return sample count, with output reference parameters.
    */
-  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_rank, unsigned int &_yCtg) const {
+  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_rank, unsigned int &_yCtg, unsigned int ctgShift) const {
     _ySum = ySum;
     _rank = rank;
     _yCtg = sCount & ((1 << ctgShift) - 1);
@@ -141,10 +145,158 @@ class SPNode {
 
      @return sum of y-values for sample.
    */
-  inline FltVal YSum() {
+  inline FltVal YSum() const {
+    return ySum;
+  }
+
+};
+
+
+/**
+   @brief Row-major view of a SamplePred buffer:  the fields of each
+   sample are adjacent, as in SPNode.
+ */
+class SPRow {
+  SPNode *node;
+
+ public:
+  SPRow(SPNode *_node = 0) : node(_node) {
+  }
+
+
+  /**
+     @return reference to the record at 'idx'.
+   */
+  inline const SPNode &operator[](unsigned int idx) const {
+    return node[idx];
+  }
+
+
+  /**
+     @brief Initializes the record at 'idx' from staging values.
+
+     @return unpacked sample index.
+   */
+  inline unsigned int Init(unsigned int idx, const StagePack &stagePack, unsigned int ctgShift) const {
+    return node[idx].Init(stagePack, ctgShift);
+  }
+
+
+  /**
+     @brief Copies a record from another buffer.
+
+     @return void.
+   */
+  inline void Move(unsigned int destIdx, const SPRow &source, unsigned int idx) const {
+    node[destIdx] = source.node[idx];
+  }
+
+
+  /**
+     @brief Copies the records of a block selected by a mask.
+
+     @param idx is the starting source position of the block.
+
+     @param bits selects records of the block to copy.  The block's
+     sample count, passed for the columnar layout, is implied here.
+
+     @return number of records copied.
+   */
+  inline unsigned int Compact(unsigned int destIdx, const SPRow &source, unsigned int idx, unsigned int, uint64_t bits) const {
+    SPNode *dest = node + destIdx;
+    const SPNode *src = source.node + idx;
+    unsigned int outCount = 0;
+    for (; bits != 0; bits &= bits - 1) {
+      dest[outCount++] = src[PathCompact::LowBit(bits)];
+    }
+
+    return outCount;
+  }
+};
+
+
+/**
+   @brief Column-major view of a SamplePred buffer:  each field occupies
+   its own vector.  As with SPNode, the response category of a
+   classification tree is packed with the sample count.
+ */
+class SPCol {
+  FltVal *ySum;
+  unsigned int *rank;
+  unsigned int *sCount;
+
+ public:
+  SPCol(FltVal *_ySum = 0, unsigned int *_rank = 0, unsigned int *_sCount = 0) : ySum(_ySum), rank(_rank), sCount(_sCount) {
+  }
+
+
+  /**
+     @brief Assembles a record from the columns.  Fields not consumed by
+     the caller are not loaded, once inlined.
+
+     @return record at 'idx'.
+   */
+  inline SPNode operator[](unsigned int idx) const {
+    SPNode spn;
+    spn.Init(ySum[idx], sCount[idx], rank[idx]);
+
+    return spn;
+  }
+
+
+  /**
+     @brief Initializes the fields at 'idx' from staging values.
+
+     @return unpacked sample index.
+   */
+  inline unsigned int Init(unsigned int idx, const StagePack &stagePack, unsigned int ctgShift) const {
+    unsigned int sIdx, ctg;
+    stagePack.Ref(sIdx, rank[idx], sCount[idx], ctg, ySum[idx]);
+    sCount[idx] = (sCount[idx] << ctgShift) | ctg;
+
+    return sIdx;
+  }
+
+
+  /**
+     @brief Copies the fields at 'idx' from another buffer.
+
+     @return void.
+   */
+  inline void Move(unsigned int destIdx, const SPCol &source, unsigned int idx) const {
+    ySum[destIdx] = source.ySum[idx];
+    rank[destIdx] = source.rank[idx];
+    sCount[destIdx] = source.sCount[idx];
+  }
+
+
+  /**
+     @brief Packs the fields of a block selected by a mask, a column at
+     a time.
+
+     @return number of samples copied.
+   */
+  inline unsigned int Compact(unsigned int destIdx, const SPCol &source, unsigned int idx, unsigned int count, uint64_t bits) const {
+    PathCompact::Compress(source.ySum + idx, count, bits, ySum + destIdx);
+    PathCompact::Compress(source.rank + idx, count, bits, rank + destIdx);
+    return PathCompact::Compress(source.sCount + idx, count, bits, sCount + destIdx);
+  }
+
+
+  /**
+     @return base of the response column.
+   */
+  inline const FltVal *YSum() const {
     return ySum;
   }
 
+
+  /**
+     @return base of the rank column.
+   */
+  inline const unsigned int *Rank() const {
+    return rank;
+  }
 };
 
 
@@ -158,16 +310,20 @@ class SamplePred {
 
   const unsigned int bagCount;
   const unsigned int nPred;
+  const unsigned int ctgShift; // Pack:  nonzero iff categorical response.
+  const bool columnar; // Whether buffers are laid out by field.
 
   // Predictor-based sample orderings, double-buffered by level value.
   //
-  const unsigned int bufferSize; // <= nRow * nPred.
+  const unsigned int bufferSize; // <= nRow * nPred:  zero iff lazy.
   const unsigned int pitchSP; // Pitch of SPNode vector, in bytes.
   const unsigned int pitchSIdx; // Pitch of SIdx vector, in bytes.
 
-  std::vector<unsigned int> stageOffset;
   std::vector<unsigned int> stageExtent; // Client:  debugging only.
-  SPNode* nodeVec;
+  SPNode* nodeVec; // Row-major layout only.
+  FltVal *ySumVec; // Column-major layout only, as are the following.
+  unsigned int *rankVec;
+  unsigned int *sCountVec;
 
   // 'indexBase' could be boxed with SPNode.  While it is used in both
   // replaying and restaging, though, it plays no role in splitting.  Maintaining
@@ -176,19 +332,91 @@ class SamplePred {
   // coprocessor.
   //
   unsigned int *indexBase; // RV index for this row.  Used by CTG as well as on replay.
+  unsigned int *pathBase; // Restaging paths, dense predictors:  single-buffered.
+
+  // Column addresses, set when a predictor is staged.  Buffer pairs are
+  // indexed by '2 * predIdx + bufBit'.
+  //
+  std::vector<SPNode*> predNode; // Row-major.
+  std::vector<SPCol> predCol; // Column-major.
+  std::vector<unsigned int*> predSIdx;
+  std::vector<unsigned int*> predPath;
+
+  // Lazy staging carves columns from pooled blocks as they are needed,
+  // so that storage scales with the number of predictors scheduled.
+  //
+  static const unsigned int poolCols = 16; // Minimal block width, in columns.
+  std::vector<SPNode*> poolNode; // Row-major.
+  std::vector<FltVal*> poolSum; // Column-major.
+  std::vector<unsigned int*> poolIdx; // Index, path and column-major slots.
+  unsigned int poolTop; // Next free slot in current block.
+  unsigned int poolCap; // Slot count of current block.
+
+  
+  /**
+     @brief Records the addresses of a predictor's column.
+
+     @return void.
+   */
+  inline void Column(unsigned int predIdx, SPNode *node0, SPNode *node1, unsigned int *sIdx0, unsigned int *sIdx1, unsigned int *path, unsigned int extent) {
+    predNode[2 * predIdx] = node0;
+    predNode[2 * predIdx + 1] = node1;
+    Column(predIdx, sIdx0, sIdx1, path, extent);
+  }
+
+
+  /**
+     @brief As above, but for column-major buffers.
+   */
+  inline void Column(unsigned int predIdx, const SPCol &col0, const SPCol &col1, unsigned int *sIdx0, unsigned int *sIdx1, unsigned int *path, unsigned int extent) {
+    predCol[2 * predIdx] = col0;
+    predCol[2 * predIdx + 1] = col1;
+    Column(predIdx, sIdx0, sIdx1, path, extent);
+  }
+
+
+  /**
+     @brief Records the addresses of index and path vectors.
+   */
+  inline void Column(unsigned int predIdx, unsigned int *sIdx0, unsigned int *sIdx1, unsigned int *path, unsigned int extent) {
+    predSIdx[2 * predIdx] = sIdx0;
+    predSIdx[2 * predIdx + 1] = sIdx1;
+    predPath[predIdx] = path;
+    stageExtent[predIdx] = extent;
+  }
+
+  template<typename Layout> void StageRoot(const std::vector<StagePack> &stagePack, unsigned int predIdx);
+  template<typename Layout> void PackCell(unsigned int predIdx, unsigned int bufIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &idxLocal, std::vector<StagePack> &stagePack) const;
+  template<typename Layout> double Replay(unsigned int predIdx, unsigned int sourceBit, unsigned int start, unsigned int extent, class BV *replayExpl);
+
  public:
-  SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize);
+  SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize, unsigned int _ctgShift, bool _columnar);
   ~SamplePred();
-  static SamplePred *Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize);
+  static SamplePred *Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _bufferSize, unsigned int _ctgShift, bool _columnar = false);
 
   void Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx, unsigned int safeOffset, unsigned int extent);
+  void Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx);
+  void Pack(unsigned int predIdx, unsigned int bufIdx, unsigned int idxStart, unsigned int extent, const std::vector<unsigned int> &idxLocal, std::vector<StagePack> &stagePack) const;
+  template<typename Layout> Layout Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx, const std::vector<unsigned int> &stNode, const std::vector<unsigned int> &stIdx, std::vector<unsigned int> &idxOff);
+  void Allocate(unsigned int predIdx, unsigned int extent);
   double BlockReplay(unsigned int predIdx, unsigned int sourceBit, unsigned int start, unsigned int end, class BV *replayExpl);
 
-  SPNode *RestageStxGen(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
-  SPNode *RestageStxOne(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+  template<typename Layout> Layout RestageStxGen(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+  template<typename Layout> Layout RestageStxOne(unsigned int reachOffset[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *stPath, unsigned int pathMask, unsigned int startIdx, unsigned int extent, bool nodeRel);
+
+  template<typename Layout> Layout RestageNdxGen(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *frontPath, unsigned int patHMask, unsigned int startIdx, unsigned int extent);
+  template<typename Layout> Layout RestageNdxOne(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *frontPath, unsigned int patHMask, unsigned int startIdx, unsigned int extent);
 
-  SPNode *RestageNdxGen(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *frontPath, unsigned int patHMask, unsigned int startIdx, unsigned int extent);
-  SPNode *RestageNdxOne(unsigned int reachOffset[], const unsigned int reachBase[], unsigned int predIdx, unsigned int bufIdx, class IdxPath *frontPath, unsigned int patHMask, unsigned int startIdx, unsigned int extent);
+
+  /**
+     @brief Indicates which buffer layout is in use.  Layout-generic
+     clients dispatch on this value.
+
+     @return true iff buffers are column-major.
+   */
+  inline bool Columnar() const {
+    return columnar;
+  }
 
   
   inline unsigned int PitchSP() {
@@ -200,8 +428,13 @@ class SamplePred {
   }
 
 
-  inline unsigned int StageOffset(unsigned int predIdx) {
-    return stageOffset[predIdx];
+  /**
+     @brief Accessor for a predictor's restaging path block.
+
+     @return base of path block, indexed as the predictor's buffers.
+   */
+  inline unsigned int *PathBlock(unsigned int predIdx) {
+    return predPath[predIdx];
   }
 
 
@@ -214,55 +447,50 @@ class SamplePred {
   //
 
   /**
-     @brief Toggles between positions in workspace double buffer, by level.
+     @brief Looks up a predictor's row-major buffer within the workspace.
 
-     @return workspace starting position for this level.
-   */
-  inline unsigned int BuffOffset(unsigned int bufferBit) const {
-    return (bufferBit & 1) == 0 ? 0 : bufferSize;
-  }
+     @param predIdx is the predictor coordinate.
 
-  /**
+     @param bufBit is the containing buffer, currently 0/1.
 
-     @param predIdx is the predictor coordinate.
+     @param node outputs the node vector section for this predictor.
 
-     @param level is the current level.
+     @param sIdx outputs the corresponding sample-index buffer.
 
-     @return starting position within workspace.
+     @return void, with output reference parameters.
    */
-  inline unsigned int BufferOff(unsigned int predIdx, unsigned int bufBit) const {
-    return stageOffset[predIdx] + BuffOffset(bufBit);
+  inline void Buffers(unsigned int predIdx, unsigned int bufBit, SPRow &node, unsigned int*& sIdx) const {
+    unsigned int slot = 2 * predIdx + (bufBit & 1);
+    sIdx = predSIdx[slot];
+    node = SPRow(predNode[slot]);
   }
 
-  
+
   /**
+     @brief As above, but for column-major buffers.
    */
-  inline SPNode* Buffers(unsigned int predIdx, unsigned int bufBit, unsigned int*& sIdx) {
-    unsigned int offset = BufferOff(predIdx, bufBit);
-    sIdx = indexBase + offset;
-    return nodeVec + offset;
+  inline void Buffers(unsigned int predIdx, unsigned int bufBit, SPCol &node, unsigned int*& sIdx) const {
+    unsigned int slot = 2 * predIdx + (bufBit & 1);
+    sIdx = predSIdx[slot];
+    node = predCol[slot];
   }
 
 
   /**
-     @brief Allows lightweight lookup of predictor's SPNode vector.
+     @brief Returns buffer containing splitting information.
 
-     @param bufBit is the containing buffer, currently 0/1.
- 
      @param predIdx is the predictor index.
 
-     @return node vector section for this predictor.
-   */
-  SPNode* PredBase(unsigned int predIdx, unsigned int bufBit) const {
-    return nodeVec + BufferOff(predIdx, bufBit);
-  }
-  
+     @param bufBit is the containing buffer, currently 0/1.
 
-  /**
-     @brief Returns buffer containing splitting information.
+     @return view of the node vector section for this predictor.
    */
-  inline SPNode* SplitBuffer(unsigned int predIdx, unsigned int bufBit) {
-    return nodeVec + BufferOff(predIdx, bufBit);
+  template<typename Layout> inline Layout SplitBuffer(unsigned int predIdx, unsigned int bufBit) const {
+    Layout node;
+    unsigned int *sIdx;
+    Buffers(predIdx, bufBit, node, sIdx);
+
+    return node;
   }
 
 
@@ -275,9 +503,9 @@ class SamplePred {
 
    @return void, with output parameter vectors.
  */
-  inline void Buffers(int predIdx, unsigned int bufBit, SPNode *&source, unsigned int *&sIdxSource, SPNode *&targ, unsigned int *&sIdxTarg) {
-    source = Buffers(predIdx, bufBit, sIdxSource);
-    targ = Buffers(predIdx, 1 - bufBit, sIdxTarg);
+  template<typename Layout> inline void Buffers(unsigned int predIdx, unsigned int bufBit, Layout &source, unsigned int *&sIdxSource, Layout &targ, unsigned int *&sIdxTarg) const {
+    Buffers(predIdx, bufBit, source, sIdxSource);
+    Buffers(predIdx, 1 - bufBit, targ, sIdxTarg);
   }
 
 
@@ -0,0 +1,221 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file segvec.h
+
+   @brief Segmented vector, appending without relocation.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_SEGVEC_H
+#define ARBORIST_SEGVEC_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+/**
+   @brief Append-only sequence held as a list of fixed-capacity segments.
+
+   A segment, once opened, never grows beyond its reserved capacity, so
+   elements are never relocated and a forest-wide estimate which proves
+   too small costs only an additional segment.  Each run of elements
+   appended by a single call is contiguous, so that per-tree sections
+   may be addressed by base pointer.  A contiguous copy is materialized
+   only on export.
+ */
+template<class T> class SegVec {
+  static const size_t segMin = 1 << 12; // Minimal segment capacity.
+
+  std::vector<std::vector<T> > seg;
+  std::vector<size_t> segStart; // Index of first element, per segment.
+  size_t total; // # elements, over all segments.
+  size_t capHint; // Capacity of next segment opened:  zero iff default.
+
+
+  /**
+     @brief Ensures that the final segment has room for 'count' further
+     elements, opening a new segment if not.
+
+     @return reference to final segment.
+   */
+  std::vector<T> &Room(size_t count) {
+    if (seg.empty() || seg.back().capacity() - seg.back().size() < count) {
+      size_t cap = std::max(std::max(count, segMin), std::max(capHint, total / 2));
+      capHint = 0;
+      segStart.push_back(total);
+      seg.emplace_back();
+      seg.back().reserve(cap);
+    }
+    return seg.back();
+  }
+
+
+  /**
+     @brief Locates the segment holding an element.  The final segment,
+     to which appends are directed, is checked first.
+
+     @return segment index.
+   */
+  inline size_t SegIdx(size_t idx) const {
+    if (idx >= segStart.back())
+      return seg.size() - 1;
+    return std::upper_bound(segStart.begin(), segStart.end(), idx) - segStart.begin() - 1;
+  }
+
+ public:
+  SegVec() : total(0), capHint(0) {
+  }
+
+
+  /**
+     @return # elements held.
+   */
+  inline size_t size() const {
+    return total;
+  }
+
+
+  inline T &operator[](size_t idx) {
+    size_t segIdx = SegIdx(idx);
+    return seg[segIdx][idx - segStart[segIdx]];
+  }
+
+
+  inline const T &operator[](size_t idx) const {
+    size_t segIdx = SegIdx(idx);
+    return seg[segIdx][idx - segStart[segIdx]];
+  }
+
+
+  /**
+     @brief Looks up the base of a contiguous run beginning at 'idx'.
+
+     @return address of element, or null if beyond the final element.
+   */
+  inline const T *Base(size_t idx) const {
+    return idx < total ? &(*this)[idx] : 0;
+  }
+
+
+  /**
+     @brief Sizes the next segment to be opened, should the current one
+     lack room for 'count' elements.  Advisory only:  an underestimate
+     opens further segments rather than relocating.
+
+     @return void.
+   */
+  void Reserve(size_t count) {
+    if (seg.empty() || seg.back().capacity() - seg.back().size() < count)
+      capHint = count;
+  }
+
+
+  /**
+     @brief Appends a contiguous run of initialized elements.
+
+     @return base address of the run.
+   */
+  T *Extend(size_t count, const T &init) {
+    std::vector<T> &tail = Room(count);
+    size_t off = tail.size();
+    tail.insert(tail.end(), count, init);
+    total += count;
+    return tail.data() + off;
+  }
+
+
+  /**
+     @brief Appends a contiguous run copied from 'src'.
+
+     @return void.
+   */
+  void Append(const T src[], size_t count) {
+    std::vector<T> &tail = Room(count);
+    tail.insert(tail.end(), src, src + count);
+    total += count;
+  }
+
+
+  inline void push_back(const T &elt) {
+    Room(1).push_back(elt);
+    total++;
+  }
+
+
+  /**
+     @brief Takes over the contents of a vector, without copying, as a
+     leading segment.  Prior contents are thereby preserved on warm start.
+
+     @param vec is emptied.
+
+     @return void.
+   */
+  void Adopt(std::vector<T> &vec) {
+    if (vec.empty())
+      return;
+
+    segStart.push_back(total);
+    total += vec.size();
+    seg.emplace_back();
+    seg.back().swap(vec);
+  }
+
+
+  /**
+     @brief Copies a range of elements, possibly spanning segments.
+
+     @return void, with output array.
+   */
+  void CopyOut(size_t start, size_t count, T dst[]) const {
+    while (count > 0) {
+      size_t segIdx = SegIdx(start);
+      size_t off = start - segStart[segIdx];
+      size_t len = std::min(count, seg[segIdx].size() - off);
+      std::copy(seg[segIdx].begin() + off, seg[segIdx].begin() + off + len, dst);
+      dst += len;
+      start += len;
+      count -= len;
+    }
+  }
+
+
+  /**
+     @brief Moves the contents into a single contiguous vector, releasing
+     each segment as it is copied.  A lone segment is handed over without
+     copying.
+
+     @param out outputs the elements, in order.
+
+     @return void, with output vector and this emptied.
+   */
+  void Export(std::vector<T> &out) {
+    std::vector<T> flat;
+    if (seg.size() == 1) {
+      flat.swap(seg[0]);
+    }
+    else {
+      flat.reserve(total);
+      for (auto &segment : seg) {
+        flat.insert(flat.end(), segment.begin(), segment.end());
+        std::vector<T>().swap(segment);
+      }
+    }
+    out.swap(flat);
+
+    seg.clear();
+    segStart.clear();
+    total = 0;
+    capHint = 0;
+  }
+};
+
+template<class T> const size_t SegVec<T>::segMin;
+
+#endif
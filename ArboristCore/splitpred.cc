@@ -22,23 +22,20 @@
 #include "bottom.h"
 #include "runset.h"
 #include "samplepred.h"
-#include "callback.h"
 #include "sample.h"
 #include "predblock.h"
 #include "rowrank.h"
+#include "trainctx.h"
+#include "prng.h"
+#include "splitscan.h"
+#include "taskpool.h"
 
-unsigned int SplitPred::nPred = 0;
-unsigned int SplitPred::predFixed = 0;
-const double *SplitPred::predProb = 0;
-
-const double *SPReg::feMono = 0;
-unsigned int SPReg::predMono = 0;
-unsigned int SPCtg::ctgWidth = 0;
+#include <algorithm>
 
 /**
   @brief Constructor.  Initializes 'runFlags' to zero for the single-split root.
  */
-SplitPred::SplitPred(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, unsigned int _bagCount) : rowRank(_rowRank), pmTrain(_pmTrain), bagCount(_bagCount), samplePred(_samplePred) {
+SplitPred::SplitPred(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, unsigned int _bagCount, unsigned int _tIdx, unsigned int _subKey) : predFixed(_ctx->predFixed), predProb(&_ctx->predProb[0]), extraTrees(_ctx->extraTrees), approxMin(_ctx->approxMin), ctx(_ctx), pmTrain(_pmTrain), rowRank(_rowRank), segWidth(_ctx->segWidth), segMin(2 * segWidth), nPred(_ctx->nPred), bagCount(_bagCount), tIdx(_tIdx), subKey(_subKey), level(0), samplePred(_samplePred) {
 }
 
 
@@ -51,58 +48,49 @@ SplitPred::~SplitPred() {
 }
 
 
-void SplitPred::Immutables(unsigned int _nPred, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[]) {
-  nPred = _nPred; // TODO:  Derive from predProb.size(), when changed to be vector.
-  predFixed = _predFixed;
-  predProb = _predProb;
+/**
+   @brief Constructor.
 
-  if (_ctgWidth > 0) {
-    SPCtg::Immutables(_ctgWidth);
-  }
-  else {
-    SPReg::Immutables(nPred, _regMono);
-  }
-}
+   @param samplePred holds (re)staged node contents.
 
+   @param _subKey is the pretree index of the root, if a local subtree.
 
-void SplitPred::DeImmutables() {
-  nPred = 0;
-  predFixed = 0;
+   @param _nOut is the number of response outputs.
 
-  // 'ctgWidth' distinguishes regression from classification.
-  if (SPCtg::CtgWidth() > 0)
-    SPCtg::DeImmutables();
-  else
-    SPReg::DeImmutables();
+   @param _sumOut holds the per-sample output sums:  null iff single output.
+ */
+SPReg::SPReg(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, unsigned int _bagCount, unsigned int _tIdx, unsigned int _subKey, unsigned int _nOut, const double _sumOut[]) : SplitPred(_ctx, _pmTrain, _rowRank, _samplePred, _bagCount, _tIdx, _subKey), predMono(_ctx->predMono), ruMono(0), nOut(_nOut), sumOut(_sumOut) {
+  run = new Run(nOut > 1 ? nOut : 0, pmTrain->NRow(), _bagCount);
 }
 
 
 /**
-   @brief Caches a local copy of the mono[] vector.
- */
-
-void SPReg::Immutables(unsigned int _nPred, const double _mono[]) {
-  predMono = 0;
-  feMono = _mono;
-  for (unsigned int i = 0; i < _nPred; i++) {
-    double monoProb = feMono[i];
-    predMono += monoProb != 0.0;
-  }
-}
+   @brief Builds a splitter of like response for a locally-completed
+   subtree.
 
+   @param _samplePred holds the subtree's staged contents.
 
-void SPReg::DeImmutables() {
-  predMono = 0;
-}
-
+   @param stageSample holds the subtree's samples.
 
-void SPCtg::Immutables(unsigned int _ctgWidth) {
-  ctgWidth = _ctgWidth;
-}
+   @param local2ST maps each local sample to its subtree index in the
+   tree proper.
 
+   @param _subKey is the pretree index of the subtree root.
 
-void SPCtg::DeImmutables() {
-  ctgWidth = 0;
+   @return new splitter, owned by the subtree.
+ */
+SplitPred *SPReg::Spawn(SamplePred *_samplePred, const std::vector<SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int _subKey) const {
+  SPReg *spReg = new SPReg(ctx, pmTrain, rowRank, _samplePred, stageSample.size(), tIdx, _subKey, nOut);
+  if (nOut > 1) { // Output sums follow the samples into local order.
+    spReg->sumLocal = std::vector<double>(local2ST.size() * nOut);
+    for (unsigned int local = 0; local < local2ST.size(); local++) {
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        spReg->sumLocal[local * nOut + outIdx] = sumOut[local2ST[local] * nOut + outIdx];
+      }
+    }
+    spReg->sumOut = &spReg->sumLocal[0];
+  }
+  return spReg;
 }
 
 
@@ -110,21 +98,20 @@ void SPCtg::DeImmutables() {
    @brief Constructor.
 
    @param samplePred holds (re)staged node contents.
+
+   @param sampleCtg is the sample vector for the tree, included for category lookup.
  */
-SPReg::SPReg(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, unsigned int _bagCount) : SplitPred(_pmTrain, _rowRank, _samplePred, _bagCount), ruMono(0) {
-  run = new Run(0, pmTrain->NRow(), _bagCount);
+SPCtg::SPCtg(const TrainCtx *_ctx, const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, const std::vector<SampleNode> &_sampleCtg, unsigned int _bagCount, unsigned int _tIdx, unsigned int _subKey): SplitPred(_ctx, _pmTrain, _rowRank, _samplePred, _bagCount, _tIdx, _subKey), ctgWidth(_ctx->ctgWidth), ctgShift(_ctx->ctgShift), sampleCtg(_sampleCtg) {
+  run = new Run(ctgWidth, pmTrain->NRow(), _bagCount);
 }
 
 
 /**
-   @brief Constructor.
-
-   @param samplePred holds (re)staged node contents.
-
-   @param sampleCtg is the sample vector for the tree, included for category lookup.
+   @brief As above, but for classification.  Categories are read from
+   the subtree's own samples, so no map to tree order is consulted.
  */
-SPCtg::SPCtg(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samplePred, const std::vector<SampleNode> &_sampleCtg, unsigned int _bagCount): SplitPred(_pmTrain, _rowRank, _samplePred, _bagCount), sampleCtg(_sampleCtg) {
-  run = new Run(ctgWidth, pmTrain->NRow(), _bagCount);
+SplitPred *SPCtg::Spawn(SamplePred *_samplePred, const std::vector<SampleNode> &stageSample, const std::vector<unsigned int> &, unsigned int _subKey) const {
+  return new SPCtg(ctx, pmTrain, rowRank, _samplePred, stageSample, stageSample.size(), tIdx, _subKey);
 }
 
 
@@ -138,16 +125,23 @@ SPCtg::SPCtg(const PMTrain *_pmTrain, const RowRank *_rowRank, SamplePred *_samp
    @return split count.
 */
 void SplitPred::LevelInit(IndexLevel &index) {
+  level = index.Level();
   levelCount = index.LevelCount();
   std::vector<bool> unsplitable(levelCount);
   std::fill(unsplitable.begin(), unsplitable.end(), false);
   LevelPreset(index, unsplitable);
+  index.Handoff(unsplitable);
 
   std::vector<unsigned int> safeCount;
   Splitable(unsplitable, safeCount);
 
   SetPrebias(index); // Depends on state from LevelPreset()
   RunOffsets(safeCount);
+
+  if (extraTrees && !splitCoord.empty()) {
+    ruCut = std::vector<double>(splitCoord.size());
+    ctx->RUnif(tIdx, level, PRNG::Stream(PRNG::streamCut, subKey), ruCut.size(), &ruCut[0]);
+  }
 }
 
 
@@ -185,7 +179,7 @@ void SPReg::LevelInit(IndexLevel &index) {
   if (predMono > 0) {
     unsigned int monoCount = levelCount * nPred; // Clearly too big.
     ruMono = new double[monoCount];
-    CallBack::RUnif(monoCount, ruMono);
+    ctx->RUnif(tIdx, level, PRNG::Stream(PRNG::streamMono, subKey), monoCount, ruMono);
   }
   else {
     ruMono = 0;
@@ -225,7 +219,7 @@ void SplitPred::Splitable(const std::vector<bool> &unsplitable, std::vector<unsi
   int cellCount = levelCount * nPred;
 
   double *ruPred = new double[cellCount];
-  CallBack::RUnif(cellCount, ruPred);
+  ctx->RUnif(tIdx, level, PRNG::Stream(PRNG::streamPred, subKey), cellCount, ruPred);
 
   BHPair *heap;
   if (predFixed > 0)
@@ -323,6 +317,8 @@ bool SplitPred::ScheduleSplit(unsigned int levelIdx, unsigned int predIdx, std::
    @return void.
  */
 void SplitPred::LevelClear() {
+  splitCoord.clear();
+  ruCut.clear();
   run->LevelClear();
 }
 
@@ -363,15 +359,21 @@ void SPCtg::LevelClear() {
 
 
 /**
-   @brief Currently just a stub.
+   @brief Multi-output only:  gathers the output sums of the level's
+   live indices, both by buffered index and by node.  Otherwise a stub.
 
-   @param index is not used by this instantiation.
+   @param index holds the level's live nodes.
 
-   @param levelCount is the number of live index nodes.
+   @param unsplitable is not used by this instantiation.
 
-   @return vector of unsplitable indices.
+   @return void.
 */
 void SPReg::LevelPreset(const IndexLevel &index, std::vector<bool> &unsplitable) {
+  if (nOut > 1) {
+    idxOut = std::vector<double>(bagCount * nOut);
+    nodeOut = std::vector<double>(levelCount * nOut);
+    index.SumsOut(bottom->LevelFront()->NodeRel(), nOut, sumOut, idxOut, nodeOut);
+  }
 }
 
 
@@ -384,12 +386,21 @@ void SPReg::LevelPreset(const IndexLevel &index, std::vector<bool> &unsplitable)
 
   @param sum is the sum of samples subsumed by the index node.
 
-  @return square squared, divided by sample count.
+  @return square squared, divided by sample count.  Summed over
+  outputs, if multi-output.
 */
 double SPReg::Prebias(const IndexLevel &index, unsigned int levelIdx) {
   unsigned int sCount;
   double sum;
   index.PrebiasFields(levelIdx, sCount, sum);
+  if (nOut > 1) {
+    const double *out = NodeOut(levelIdx);
+    double ssOut = 0.0;
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      ssOut += out[outIdx] * out[outIdx];
+    }
+    return ssOut / sCount;
+  }
   return (sum * sum) / sCount;
 }
 
@@ -453,7 +464,7 @@ int SPReg::MonoMode(unsigned int levelIdx, unsigned int predIdx) const {
   if (predMono == 0)
     return 0;
 
-  double monoProb = feMono[predIdx];
+  double monoProb = ctx->Mono(predIdx);
   int sign = monoProb > 0.0 ? 1 : (monoProb < 0.0 ? -1 : 0);
   return sign * ruMono[levelIdx] < monoProb ? sign : 0;
 }
@@ -492,51 +503,427 @@ void SplitCoord::InitLate(const Bottom *bottom, const IndexLevel &index) {
 }
 
  
-void SPReg::Split(const IndexLevel &index) {
-  // Guards cast to int for OpenMP 2.0 back-compatibility.
-  int splitPos;
-#pragma omp parallel default(shared) private(splitPos)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (splitPos = 0; splitPos < int(splitCoord.size()); splitPos++) {
-      splitCoord[splitPos].Split(this, bottom, samplePred, index);
+/**
+   @brief Splits the scheduled coordinates of the current level.
+
+   @return void.
+ */
+void SplitPred::Split(const IndexLevel &index) {
+  SplitPrepare(index);
+  ctx->taskPool->Run(taskCost, [&](unsigned int taskIdx) {
+      SplitTask(taskIdx);
+    });
+  SplitReduce();
+}
+
+
+/**
+   @brief Completes the coordinates' initialization following restaging
+   and builds the level's task list, estimating the cost of each task.
+   Wide numerical scans are apportioned into segments, whose response
+   totals are accumulated here so that the segments may be walked
+   independently.
+
+   @return void.
+ */
+void SplitPred::SplitPrepare(const IndexLevel &index) {
+  taskPos.clear();
+  taskCost.clear();
+  scanSeg.clear();
+  segCoord.clear();
+  segStart.clear();
+  for (unsigned int splitPos = 0; splitPos < splitCoord.size(); splitPos++) {
+    SplitCoord &coord = splitCoord[splitPos];
+    coord.InitLate(bottom, index);
+    int monoMode;
+    if (Segmentable(coord, monoMode)) {
+      segCoord.push_back(splitPos);
+      segStart.push_back(scanSeg.size());
+      coord.Segment(scanSeg, monoMode, DenseRank(coord.PredIdx()), segWidth);
+    }
+    else {
+      taskPos.push_back(splitPos);
+      taskCost.push_back(coord.Cost(this, bottom, ctx->ctgWidth));
     }
   }
+  if (scanSeg.empty())
+    return;
 
-  splitCoord.clear();
+  segStart.push_back(scanSeg.size());
+  std::vector<unsigned int> segCost(scanSeg.size());
+  for (unsigned int segIdx = 0; segIdx < scanSeg.size(); segIdx++) {
+    segCost[segIdx] = scanSeg[segIdx].idxTop - scanSeg[segIdx].idxBottom + 1;
+  }
+  taskCost.insert(taskCost.end(), segCost.begin(), segCost.end());
+
+  ctx->taskPool->Run(segCost, [&](unsigned int segIdx) {
+      splitCoord[scanSeg[segIdx].splitPos].SegTotals(samplePred, scanSeg[segIdx]);
+    });
+  for (unsigned int segPos = 0; segPos < segCoord.size(); segPos++) {
+    splitCoord[segCoord[segPos]].SegPrefix(scanSeg, segStart[segPos], segStart[segPos + 1]);
+  }
+}
+
+
+/**
+   @brief Executes a single task from the level's list.  Tasks are
+   independent, so may be interleaved with those of other trees.
+
+   @param taskIdx indexes the task list:  coordinates split whole precede
+   scan segments.
+
+   @return void.
+ */
+void SplitPred::SplitTask(unsigned int taskIdx) {
+  if (taskIdx < taskPos.size()) {
+    Split(taskPos[taskIdx]);
+  }
+  else {
+    ScanSeg &seg = scanSeg[taskIdx - taskPos.size()];
+    splitCoord[seg.splitPos].SegScan(samplePred, seg);
+  }
+}
+
+
+/**
+   @brief Reduces the segments of each segmented scan to a single
+   candidate split.
+
+   @return void.
+ */
+void SplitPred::SplitReduce() {
+  for (unsigned int segPos = 0; segPos < segCoord.size(); segPos++) {
+    splitCoord[segCoord[segPos]].SegReduce(bottom, scanSeg, segStart[segPos], segStart[segPos + 1]);
+  }
+}
+
+
+/**
+   @brief Segments wide numerical scans.  Factor scans accumulate runs
+   not easily apportioned, while randomized cuts need only a single
+   pass and approximate scans are already bounded.
+
+   @return true iff the coordinate's scan is to be segmented.
+ */
+bool SPReg::Segmentable(const SplitCoord &coord, int &monoMode) const {
+  if (nOut > 1 || ExtraTrees() || IsFactor(coord.PredIdx()) || bottom->Singleton(coord.LevelIdx(), coord.PredIdx()) || coord.Extent() < segMin || coord.Approximate(this))
+    return false;
+
+  monoMode = MonoMode(coord.SplitPos(), coord.PredIdx());
+  return true;
+}
+
+
+/**
+   @brief Splits a single scheduled coordinate.
+
+   @param splitPos is the position of the coordinate in the schedule.
+
+   @return void.
+ */
+void SPReg::Split(unsigned int splitPos) {
+  splitCoord[splitPos].Split(this, bottom, samplePred);
+}
+
+
+void SPCtg::Split(unsigned int splitPos) {
+  splitCoord[splitPos].Split(this, bottom, samplePred);
+}
+
+
+/**
+   @brief Determines whether the coordinate's numerical scan is to be
+   approximated.  Dense scans are always exact.
+
+   @return true iff approximation enabled and node sufficiently wide.
+ */
+bool SplitCoord::Approximate(const SplitPred *splitPred) const {
+  return splitPred->ApproxMin() > 0 && denseCount == 0 && Extent() > splitPred->ApproxMin();
+}
+
+
+/**
+   @brief Estimates the cost of splitting the coordinate whole.  Scans
+   are linear in the extent, with residual imputation doubling the cost
+   of dense numerical scans.  Factor splitting adds a term in the run
+   count, which for multiclass responses includes the enumeration of
+   run subsets.
+
+   @param ctgWidth is the response cardinality, zero iff regression.
+
+   @return cost estimate, in units of buffer indices visited.
+ */
+unsigned int SplitCoord::Cost(const SplitPred *splitPred, const Bottom *bottom, unsigned int ctgWidth) const {
+  if (bottom->Singleton(levelIdx, predIdx))
+    return 1;
+
+  unsigned int extent = Extent();
+  if (!splitPred->IsFactor(predIdx)) {
+    return denseCount > 0 ? 2 * extent : extent;
+  }
+
+  unsigned int runCount = splitPred->RSet(setIdx)->CountSafe();
+  unsigned int cost = extent + runCount * std::max(1u, ctgWidth);
+  if (ctgWidth > 2 && runCount > RunSet::maxWidth) {
+    cost += runCount * ctgWidth * ctgWidth;
+  }
+  else if (ctgWidth > 2 && runCount > 2) {
+    cost += (1u << (runCount - 1)) * ctgWidth;
+  }
+
+  return cost;
+}
+
+
+/**
+   @brief Apportions the scan into segments of fixed width, the first
+   segment topmost, as the walk proceeds downward.
+
+   @param scanSeg accumulates the segments.
+
+   @param _denseRank is the predictor's dense rank, if any.
+
+   @return void.
+ */
+void SplitCoord::Segment(std::vector<ScanSeg> &scanSeg, int monoMode, unsigned int _denseRank, unsigned int segWidth) {
+  denseRank = _denseRank;
+  unsigned int extent = Extent();
+  for (unsigned int off = 0; off < extent; off += segWidth) {
+    ScanSeg seg = ScanSeg();
+    seg.splitPos = splitPos;
+    seg.idxTop = idxEnd - off;
+    seg.idxBottom = idxEnd - std::min(extent - 1, off + segWidth - 1);
+    seg.monoMode = monoMode;
+    scanSeg.push_back(seg);
+  }
+}
+
+
+/**
+   @brief Accumulates the response totals of a segment, together with
+   the information needed to place the dense blob.
+
+   @return void, with totals recorded in the segment.
+ */
+void SplitCoord::SegTotals(const SamplePred *samplePred, ScanSeg &seg) const {
+  if (samplePred->Columnar()) {
+    SegTotalsLayout(samplePred->SplitBuffer<SPCol>(predIdx, bufIdx), seg);
+  }
+  else {
+    SegTotalsLayout(samplePred->SplitBuffer<SPRow>(predIdx, bufIdx), seg);
+  }
+}
+
+
+template<typename Layout> void SplitCoord::SegTotalsLayout(const Layout &spn, ScanSeg &seg) const {
+  double sumSeg = 0.0;
+  unsigned int sCountSeg = 0;
+  unsigned int denseInf = idxEnd + 1;
+  for (unsigned int idx = seg.idxBottom; idx <= seg.idxTop; idx++) {
+    unsigned int rank, sampleCount;
+    FltVal ySum;
+    spn[idx].RegFields(ySum, rank, sampleCount);
+    sumSeg += ySum;
+    sCountSeg += sampleCount;
+    denseInf = (rank >= denseRank && idx < denseInf) ? idx : denseInf;
+  }
+  seg.sumSeg = sumSeg;
+  seg.sCountSeg = sCountSeg;
+  seg.denseInf = denseInf;
+  seg.rankTop = spn[seg.idxTop].Rank();
+  seg.rankBottom = spn[seg.idxBottom].Rank();
+}
+
+
+/**
+   @brief Derives, for each segment, the totals of the segments lying
+   above it.  Places the dense blob, if any, as does Residuals().
+
+   @param segStart is the first segment of the coordinate.
+
+   @param segEnd is the sup of the coordinate's segments.
+
+   @return void.
+ */
+void SplitCoord::SegPrefix(std::vector<ScanSeg> &scanSeg, unsigned int segStart, unsigned int segEnd) {
+  double sumR = 0.0;
+  unsigned int sCountR = 0;
+  unsigned int denseInf = idxEnd + 1;
+  for (unsigned int segIdx = segStart; segIdx < segEnd; segIdx++) {
+    scanSeg[segIdx].sumR = sumR;
+    scanSeg[segIdx].sCountR = sCountR;
+    sumR += scanSeg[segIdx].sumSeg;
+    sCountR += scanSeg[segIdx].sCountSeg;
+    denseInf = std::min(denseInf, scanSeg[segIdx].denseInf);
+  }
+  if (denseCount == 0)
+    return;
+
+  denseCut = denseInf > idxStart ? denseInf - 1 : idxStart;
+  sumDense = sum - sumR;
+  sCountDense = sCount - sCountR;
+  denseRight = (denseCut == idxEnd && scanSeg[segStart].rankTop < denseRank);
+  denseLeft = (denseCut == idxStart && scanSeg[segEnd - 1].rankBottom > denseRank);
+  idxFinal = (denseRight || denseLeft) ? idxStart : denseCut + 1;
+}
+
+
+/**
+   @brief Walks a single segment of a wide scan, recording the segment's
+   best cut.
+
+   @return void, with best cut recorded in the segment.
+ */
+void SplitCoord::SegScan(const SamplePred *samplePred, ScanSeg &seg) const {
+  if (samplePred->Columnar()) {
+    SegScanLayout(samplePred->SplitBuffer<SPCol>(predIdx, bufIdx), seg);
+  }
+  else {
+    SegScanLayout(samplePred->SplitBuffer<SPRow>(predIdx, bufIdx), seg);
+  }
 }
 
 
-void SPCtg::Split(const IndexLevel &index) {
-  // Guards cast to int for OpenMP 2.0 back-compatibility.
-  int splitPos;
-#pragma omp parallel default(shared) private(splitPos)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (splitPos = 0; splitPos < int(splitCoord.size()); splitPos++) {
-      splitCoord[splitPos].Split(this, bottom, samplePred, index);
+/**
+   @brief Resumes the walk at the top of the segment, as though the
+   segments above had just been walked.  The topmost segment begins as
+   does the unsegmented walk.
+
+   In the presence of a dense blob, the walk proceeds as in
+   SplitNumDense():  explicit indices down to 'idxFinal', then the blob,
+   then the remaining explicit indices.  Only the segment straddling
+   'idxFinal' evaluates the blob, while segments lying wholly below
+   begin with the blob already walked.
+ */
+template<typename Layout> void SplitCoord::SegScanLayout(const Layout &spn, ScanSeg &seg) const {
+  bool dense = denseCount > 0;
+  bool evalDense = dense && denseCut != idxEnd; // Evaluates the blob.
+  bool walkLow = evalDense && !denseLeft; // Walks below the blob.
+  int idxUpper = dense ? int(idxFinal) : int(idxStart); // Upper walk's final index.
+
+  unsigned int rkRight, sCountL;
+  double sumR;
+  int idxNext;
+  if (seg.idxTop == idxEnd) {
+    if (dense && denseRight) {
+      rkRight = denseRank;
+      sumR = sumDense;
+      sCountL = sCount - sCountDense;
+      idxNext = int(idxEnd);
+    }
+    else {
+      unsigned int sampleCount;
+      FltVal ySum;
+      spn[idxEnd].RegFields(ySum, rkRight, sampleCount);
+      sumR = ySum;
+      sCountL = sCount - sampleCount;
+      idxNext = int(idxEnd) - 1;
+    }
+  }
+  else {
+    rkRight = spn[seg.idxTop + 1].Rank();
+    sumR = seg.sumR;
+    sCountL = sCount - seg.sCountR;
+    idxNext = int(seg.idxTop);
+    if ((dense && denseRight) || (walkLow && int(seg.idxTop) < idxUpper)) {
+      sumR += sumDense;
+      sCountL -= sCountDense;
+      rkRight = (!denseRight && seg.idxTop + 1 == idxFinal) ? denseRank : rkRight;
+    }
+  }
+
+  seg.improved = false;
+  seg.maxInfo = preBias;
+  seg.lhSampCt = 0;
+  seg.rhInf = idxEnd + 1;
+  unsigned int lhSup;
+  if (RegScan(spn, idxNext, std::max(int(seg.idxBottom), idxUpper), seg.monoMode, rkRight, sumR, sCountL, seg.maxInfo, seg.lhSampCt, lhSup, seg.rankLH, seg.rankRH)) {
+    seg.improved = true;
+    seg.rhInf = lhSup + 1;
+  }
+
+  if (evalDense && seg.idxBottom <= idxFinal && idxFinal <= seg.idxTop) {
+    unsigned int sCountR = sCount - sCountL;
+    double sumL = sum - sumR;
+    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
+    if (idxGini > seg.maxInfo) {
+      seg.lhSampCt = sCountL;
+      seg.rhInf = idxFinal;
+      seg.rankLH = denseRank;
+      seg.rankRH = rkRight;
+      seg.maxInfo = idxGini;
+      seg.improved = true;
+    }
+    if (walkLow) {
+      sCountL -= sCountDense;
+      sumR += sumDense;
+      rkRight = denseRank;
     }
   }
-  splitCoord.clear();
+
+  if (walkLow && RegScan(spn, std::min(int(seg.idxTop), int(idxFinal) - 1), int(seg.idxBottom), seg.monoMode, rkRight, sumR, sCountL, seg.maxInfo, seg.lhSampCt, lhSup, seg.rankLH, seg.rankRH)) {
+    seg.improved = true;
+    seg.rhInf = lhSup + 1;
+  }
 }
 
 
 /**
-   @brief  Regression splitting based on type:  numeric or factor.
+   @brief Selects the best of the segments' cuts.  Segments are visited
+   in walk order and improvement is strict, so ties resolve as in the
+   unsegmented walk.
+
+   @return void.
  */
-void SplitCoord::Split(const SPReg *spReg, const Bottom *bottom, const SamplePred *samplePred, const IndexLevel &index) {
-  InitLate(bottom, index);
+void SplitCoord::SegReduce(const Bottom *bottom, const std::vector<ScanSeg> &scanSeg, unsigned int segStart, unsigned int segEnd) const {
+  const ScanSeg *segMax = 0;
+  double maxInfo = preBias;
+  for (unsigned int segIdx = segStart; segIdx < segEnd; segIdx++) {
+    if (scanSeg[segIdx].improved && scanSeg[segIdx].maxInfo > maxInfo) {
+      segMax = &scanSeg[segIdx];
+      maxInfo = segMax->maxInfo;
+    }
+  }
+
+  if (segMax != 0) {
+    unsigned int lhDense = (denseCount > 0 && segMax->rankLH >= denseRank) ? denseCount : 0;
+    NuxLH nux;
+    nux.InitNum(idxStart, segMax->rhInf - idxStart + lhDense, segMax->lhSampCt, maxInfo - preBias, segMax->rankLH, segMax->rankRH, lhDense);
+    bottom->SSWrite(levelIdx, predIdx, setIdx, bufIdx, nux);
+  }
+}
+
 
+/**
+   @brief  Regression splitting based on type:  numeric or factor.
+ */
+void SplitCoord::Split(const SPReg *spReg, const Bottom *bottom, const SamplePred *samplePred) {
   // Bagging or restaging may precipitate new singletons.
   //
   if (bottom->Singleton(levelIdx, predIdx))
     return;
 
+  if (spReg->NOut() > 1) {
+    SplitMulti(spReg, bottom, samplePred);
+  }
+  else if (samplePred->Columnar()) {
+    SplitLayout(spReg, bottom, samplePred->SplitBuffer<SPCol>(predIdx, bufIdx));
+  }
+  else {
+    SplitLayout(spReg, bottom, samplePred->SplitBuffer<SPRow>(predIdx, bufIdx));
+  }
+}
+
+
+/**
+   @brief Regression splitting, specialized by buffer layout.
+ */
+template<typename Layout> void SplitCoord::SplitLayout(const SPReg *spReg, const Bottom *bottom, const Layout &spn) {
   if (spReg->IsFactor(predIdx)) {
-    SplitFac(spReg, bottom, samplePred->PredBase(predIdx, bufIdx));
+    SplitFac(spReg, bottom, spn);
   }
   else {
-    SplitNum(spReg, bottom, samplePred->PredBase(predIdx, bufIdx));
+    SplitNum(spReg, bottom, spn);
   }
 }
 
@@ -544,24 +931,35 @@ void SplitCoord::Split(const SPReg *spReg, const Bottom *bottom, const SamplePre
 /**
    @brief Categorical splitting based on type:  numeric or factor.
  */
-void SplitCoord::Split(SPCtg *spCtg, const Bottom *bottom, const SamplePred *samplePred, const IndexLevel &index) {
-  InitLate(bottom, index);
-  
+void SplitCoord::Split(SPCtg *spCtg, const Bottom *bottom, const SamplePred *samplePred) {
   // Bagging or restaging may precipitate new singletons.
   //
   if (bottom->Singleton(levelIdx, predIdx))
     return;
 
+  if (samplePred->Columnar()) {
+    SplitLayout(spCtg, bottom, samplePred->SplitBuffer<SPCol>(predIdx, bufIdx));
+  }
+  else {
+    SplitLayout(spCtg, bottom, samplePred->SplitBuffer<SPRow>(predIdx, bufIdx));
+  }
+}
+
+
+/**
+   @brief Categorical splitting, specialized by buffer layout.
+ */
+template<typename Layout> void SplitCoord::SplitLayout(SPCtg *spCtg, const Bottom *bottom, const Layout &spn) {
   if (spCtg->IsFactor(predIdx)) {
-    SplitFac(spCtg, bottom, samplePred->PredBase(predIdx, bufIdx));
+    SplitFac(spCtg, bottom, spn);
   }
   else {
-    SplitNum(spCtg, bottom, samplePred->PredBase(predIdx, bufIdx));
+    SplitNum(spCtg, bottom, spn);
   }
 }
 
 
-void SplitCoord::SplitNum(const SPReg *spReg, const Bottom *bottom, const SPNode spn[]) {
+template<typename Layout> void SplitCoord::SplitNum(const SPReg *spReg, const Bottom *bottom, const Layout &spn) {
   NuxLH nux;
   if (SplitNum(spReg, spn, nux)) {
     bottom->SSWrite(levelIdx, predIdx, setIdx, bufIdx, nux);
@@ -574,7 +972,7 @@ void SplitCoord::SplitNum(const SPReg *spReg, const Bottom *bottom, const SPNode
 
    @return void.
 */
-void SplitCoord::SplitNum(SPCtg *spCtg, const Bottom *bottom, const SPNode spn[]) {
+template<typename Layout> void SplitCoord::SplitNum(SPCtg *spCtg, const Bottom *bottom, const Layout &spn) {
   NuxLH nux;
   if (SplitNum(spCtg, spn, nux)) {
     bottom->SSWrite(levelIdx, predIdx, setIdx, bufIdx, nux);
@@ -582,7 +980,7 @@ void SplitCoord::SplitNum(SPCtg *spCtg, const Bottom *bottom, const SPNode spn[]
 }
 
 
-void SplitCoord::SplitFac(const SPReg *spReg, const Bottom *bottom, const SPNode spn[]) {
+template<typename Layout> void SplitCoord::SplitFac(const SPReg *spReg, const Bottom *bottom, const Layout &spn) {
   NuxLH nux;
   unsigned int runCount;
   if (SplitFac(spReg, spn, runCount, nux)) {
@@ -592,7 +990,7 @@ void SplitCoord::SplitFac(const SPReg *spReg, const Bottom *bottom, const SPNode
 }
 
 
-void SplitCoord::SplitFac(const SPCtg *spCtg, const Bottom *bottom, const SPNode spn[]) {
+template<typename Layout> void SplitCoord::SplitFac(const SPCtg *spCtg, const Bottom *bottom, const Layout &spn) {
   NuxLH nux;
   unsigned int runCount;
   if (SplitFac(spCtg, spn, runCount, nux)) {
@@ -602,7 +1000,7 @@ void SplitCoord::SplitFac(const SPCtg *spCtg, const Bottom *bottom, const SPNode
 }
 
 
-bool SplitCoord::SplitFac(const SPCtg *spCtg, const SPNode spn[], unsigned int &runCount, NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitFac(const SPCtg *spCtg, const Layout &spn, unsigned int &runCount, NuxLH &nux) {
   RunSet *runSet = spCtg->RSet(setIdx);
   runCount = RunsCtg(spCtg, runSet, spn);
 
@@ -629,13 +1027,15 @@ bool SplitCoord::SplitFac(const SPCtg *spCtg, const SPNode spn[], unsigned int &
 
    @return true iff pair splits.
  */
-bool SplitCoord::SplitFac(const SPReg *spReg, const SPNode spn[], unsigned int &runCount, NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitFac(const SPReg *spReg, const Layout &spn, unsigned int &runCount, NuxLH &nux) {
   RunSet *runSet = spReg->RSet(setIdx);
   runCount = RunsReg(runSet, spn, spReg->DenseRank(predIdx));
   runSet->HeapMean();
   runSet->DePop();
 
-  return HeapSplit(runSet, nux);
+  // Randomized cuts are drawn from among the mean-ordered slots.
+  int slotDraw = (spReg->ExtraTrees() && runSet->RunCount() > 1) ? SplitPred::Draw(runSet->RunCount() - 1, spReg->CutVariate(splitPos)) : -1;
+  return HeapSplit(runSet, nux, slotDraw);
 }
 
 
@@ -648,9 +1048,15 @@ bool SplitCoord::SplitFac(const SPReg *spReg, const SPNode spn[], unsigned int &
 
    @return void.
 */
-bool SplitCoord::SplitNum(const SPReg *spReg, const SPNode spn[], NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitNum(const SPReg *spReg, const Layout &spn, NuxLH &nux) {
   int monoMode = spReg->MonoMode(splitPos, predIdx);
-  if (monoMode != 0) {
+  if (spReg->ExtraTrees()) {
+    return SplitNumExtra(spn, spReg->DenseRank(predIdx), spReg->CutVariate(splitPos), monoMode, nux);
+  }
+  else if (Approximate(spReg)) {
+    return SplitNumApprox(spn, monoMode, nux);
+  }
+  else if (monoMode != 0) {
     return denseCount > 0 ? SplitNumDenseMono(monoMode > 0, spn, spReg, nux) : SplitNumMono(monoMode > 0, spn, nux);
   }
   else {
@@ -665,7 +1071,7 @@ bool SplitCoord::SplitNum(const SPReg *spReg, const SPNode spn[], NuxLH &nux) {
 
    @return void.
 */
-bool SplitCoord::SplitNum(const SPNode spn[], NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitNum(const Layout &spn, NuxLH &nux) {
   unsigned int rkRight, sampleCount;
   FltVal ySum;
   spn[idxEnd].RegFields(ySum, rkRight, sampleCount);
@@ -676,22 +1082,10 @@ bool SplitCoord::SplitNum(const SPNode spn[], NuxLH &nux) {
   double maxInfo = preBias;
 
   // Walks samples backward from the end of nodes so that ties are not split.
-  // Signing values avoids decrementing below zero.
-  for (int i = int(idxEnd) - 1; i >= int(idxStart); i--) {
-    unsigned int sCountR = sCount - sCountL;
-    double sumL = sum - sumR;
-    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-    unsigned int rkThis;
-    spn[i].RegFields(ySum, rkThis, sampleCount);
-    if (idxGini > maxInfo && rkThis != rkRight) {
-      lhSampCt = sCountL;
-      lhSup = i;
-      maxInfo = idxGini;
-    }
-    sCountL -= sampleCount;
-    sumR += ySum;
-    rkRight = rkThis;
-  }
+  // The criterion is evaluated only between distinct ranks, hence once per
+  // bin if ranks are binned.  Signing values avoids decrementing below zero.
+  unsigned int rankLH, rankRH;
+  (void) RegScan(spn, int(idxEnd) - 1, int(idxStart), 0, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH);
 
   if (maxInfo > preBias) {
     nux.InitNum(idxStart, lhSup + 1 - idxStart, lhSampCt, maxInfo - preBias, spn[lhSup].Rank(), spn[lhSup+1].Rank());
@@ -708,7 +1102,7 @@ bool SplitCoord::SplitNum(const SPNode spn[], NuxLH &nux) {
 
    @return void.
 */
-bool SplitCoord::SplitNumDense(const SPNode spn[], const SPReg *spReg, NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitNumDense(const Layout &spn, const SPReg *spReg, NuxLH &nux) {
   unsigned int denseRank = spReg->DenseRank(predIdx);
   double sumDense = sum;
   unsigned int sCountDense = sCount;
@@ -738,22 +1132,9 @@ bool SplitCoord::SplitNumDense(const SPNode spn[], const SPReg *spReg, NuxLH &nu
   unsigned int rankLH = 0;
   unsigned int rankRH = 0; // Splitting rank bounds.
   unsigned int rhInf = idxEnd + 1;  // Always non-negative.
-  for (int i = int(idxNext); i >= int(idxFinal); i--) {
-    unsigned int sCountR = sCount - sCountL;
-    double sumL = sum - sumR;
-    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-    unsigned int rkThis;
-    spn[i].RegFields(ySum, rkThis, sampleCount);
-    if (idxGini > maxInfo && rkThis != rkRight) {
-      lhSampCt = sCountL;
-      rankLH = rkThis;
-      rankRH = rkRight;
-      rhInf = i + 1;
-      maxInfo = idxGini;
-    }
-    sCountL -= sampleCount;
-    sumR += ySum;
-    rkRight = rkThis;
+  unsigned int lhSup;
+  if (RegScan(spn, int(idxNext), int(idxFinal), 0, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH)) {
+    rhInf = lhSup + 1;
   }
 
   // Evaluates the dense component, if not of highest rank.
@@ -773,22 +1154,8 @@ bool SplitCoord::SplitNumDense(const SPNode spn[], const SPReg *spReg, NuxLH &nu
       sCountL -= sCountDense;
       sumR += sumDense;
       rkRight = denseRank;
-      for (int i = idxFinal - 1; i >= int(idxStart); i--) {
-	unsigned int sCountR = sCount - sCountL;
-	double sumL = sum - sumR;
-	double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-	unsigned int rkThis;
-	spn[i].RegFields(ySum, rkThis, sampleCount);
-	if (idxGini > maxInfo && rkThis != rkRight) {
-	  lhSampCt = sCountL;
-	  rhInf = i + 1;
-	  rankLH = rkThis;
-	  rankRH = rkRight;
-	  maxInfo = idxGini;
-	}
-	sCountL -= sampleCount;
-	sumR += ySum;
-	rkRight = rkThis;
+      if (RegScan(spn, int(idxFinal) - 1, int(idxStart), 0, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH)) {
+        rhInf = lhSup + 1;
       }
     }
   }
@@ -810,7 +1177,7 @@ bool SplitCoord::SplitNumDense(const SPNode spn[], const SPReg *spReg, NuxLH &nu
 
    @return void.
 */
-bool SplitCoord::SplitNumDenseMono(bool increasing, const SPNode spn[], const SPReg *spReg, NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitNumDenseMono(bool increasing, const Layout &spn, const SPReg *spReg, NuxLH &nux) {
   unsigned int denseRank = spReg->DenseRank(predIdx);
   double sumDense = sum;
   unsigned int sCountDense = sCount;
@@ -840,25 +1207,9 @@ bool SplitCoord::SplitNumDenseMono(bool increasing, const SPNode spn[], const SP
   unsigned int rankLH = 0;
   unsigned int rankRH = 0; // Splitting rank bounds.
   unsigned int rhInf = idxEnd + 1;  // Always non-negative.
-  for (int i = int(idxNext); i >= int(idxFinal); i--) {
-    unsigned int sCountR = sCount - sCountL;
-    double sumL = sum - sumR;
-    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-    unsigned int rkThis;
-    spn[i].RegFields(ySum, rkThis, sampleCount);
-    if (idxGini > maxInfo && rkThis != rkRight) {
-      bool up = (sumL * sCountR <= sumR * sCountL);
-      if (increasing ? up : !up) {
-        lhSampCt = sCountL;
-        rankLH = rkThis;
-        rankRH = rkRight;
-        rhInf = i + 1;
-        maxInfo = idxGini;
-      }
-    }
-    sCountL -= sampleCount;
-    sumR += ySum;
-    rkRight = rkThis;
+  unsigned int lhSup;
+  if (RegScan(spn, int(idxNext), int(idxFinal), increasing ? 1 : -1, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH)) {
+    rhInf = lhSup + 1;
   }
 
   // Evaluates the dense component, if not of highest rank.
@@ -878,25 +1229,8 @@ bool SplitCoord::SplitNumDenseMono(bool increasing, const SPNode spn[], const SP
       sCountL -= sCountDense;
       sumR += sumDense;
       rkRight = denseRank;
-      for (int i = idxFinal - 1; i >= int(idxStart); i--) {
-	unsigned int sCountR = sCount - sCountL;
-	double sumL = sum - sumR;
-	double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-	unsigned int rkThis;
-	spn[i].RegFields(ySum, rkThis, sampleCount);
-	if (idxGini > maxInfo && rkThis != rkRight) {
-	  bool up = (sumL * sCountR <= sumR * sCountL);
-	  if (increasing ? up : !up) {
-	    lhSampCt = sCountL;
-	    rhInf = i + 1;
-	    rankLH = rkThis;
-	    rankRH = rkRight;
-	    maxInfo = idxGini;
-	  }
-	}
-	sCountL -= sampleCount;
-	sumR += ySum;
-	rkRight = rkThis;
+      if (RegScan(spn, int(idxFinal) - 1, int(idxStart), increasing ? 1 : -1, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH)) {
+        rhInf = lhSup + 1;
       }
     }
   }
@@ -918,7 +1252,7 @@ bool SplitCoord::SplitNumDenseMono(bool increasing, const SPNode spn[], const SP
 
    @return void.
 */
-bool SplitCoord::SplitNumMono(bool increasing, const SPNode spn[], NuxLH &nux) {
+template<typename Layout> bool SplitCoord::SplitNumMono(bool increasing, const Layout &spn, NuxLH &nux) {
   unsigned int rkRight, sampleCount;
   FltVal ySum;
   spn[idxEnd].RegFields(ySum, rkRight, sampleCount);
@@ -930,24 +1264,9 @@ bool SplitCoord::SplitNumMono(bool increasing, const SPNode spn[], NuxLH &nux) {
 
   // Walks samples backward from the end of nodes so that ties are not split.
   // Signing values avoids decrementing below zero.
-  for (int i = int(idxEnd) - 1; i >= int(idxStart); i--) {
-    int sCountR = sCount - sCountL;
-    double sumL = sum - sumR;
-    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
-    unsigned int rkThis;
-    spn[i].RegFields(ySum, rkThis, sampleCount);
-    if (idxGini > maxInfo && rkThis != rkRight) {
-      bool up = (sumL * sCountR <= sumR * sCountL);
-      if (increasing ? up : !up) {
-        lhSampCt = sCountL;
-        lhSup = i;
-        maxInfo = idxGini;
-      }
-    }
-    sCountL -= sampleCount;
-    sumR += ySum;
-    rkRight = rkThis;
-  }
+  unsigned int rankLH, rankRH;
+  (void) RegScan(spn, int(idxEnd) - 1, int(idxStart), increasing ? 1 : -1, rkRight, sumR, sCountL, maxInfo, lhSampCt, lhSup, rankLH, rankRH);
+
   if (maxInfo > preBias) {
     nux.InitNum(idxStart, lhSup + 1 - idxStart, lhSampCt, maxInfo - preBias, spn[lhSup].Rank(), spn[lhSup + 1].Rank());
     return true;
@@ -975,15 +1294,15 @@ bool SplitCoord::SplitNumMono(bool increasing, const SPNode spn[], NuxLH &nux) {
 
    @return true iff left bound has rank less than dense value.
 */
-unsigned int SPReg::Residuals(const SPNode spn[], unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, unsigned int &denseLeft, unsigned int &denseRight, double &sumDense, unsigned int &sCountDense) const {
-  unsigned int denseCut = idxStart; // Defaults to lowest index.
+template<typename Layout> unsigned int SPReg::Residuals(const Layout &spn, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, unsigned int &denseLeft, unsigned int &denseRight, double &sumDense, unsigned int &sCountDense) const {
+  unsigned int denseCut = idxStart; // Highest index ranked below dense.
   double sumTot = 0.0;
   unsigned int sCountTot = 0;
   for (int idx = int(idxEnd); idx >= int(idxStart); idx--) {
     unsigned int sampleCount, rkThis;
     FltVal ySum;
     spn[idx].RegFields(ySum, rkThis, sampleCount);
-    denseCut = rkThis >= denseRank ? idx : denseCut;
+    denseCut = (rkThis < denseRank && int(denseCut) < idx) ? idx : denseCut;
     sCountTot += sampleCount;
     sumTot += ySum;
   }
@@ -1006,7 +1325,7 @@ unsigned int SPReg::Residuals(const SPNode spn[], unsigned int idxStart, unsigne
 
    @return true iff left bound has rank less than dense rank.
 */
-unsigned int SPCtg::Residuals(const SPNode spn[], unsigned int levelIdx, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, bool &denseLeft, bool &denseRight, double &sumDense, unsigned int &sCountDense, std::vector<double> &ctgSumDense) const {
+template<typename Layout> unsigned int SPCtg::Residuals(const Layout &spn, unsigned int levelIdx, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, bool &denseLeft, bool &denseRight, double &sumDense, unsigned int &sCountDense, std::vector<double> &ctgSumDense) const {
   std::vector<double> ctgAccum;
   ctgSumDense.reserve(ctgWidth);
   ctgAccum.reserve(ctgWidth);
@@ -1014,16 +1333,16 @@ unsigned int SPCtg::Residuals(const SPNode spn[], unsigned int levelIdx, unsigne
     ctgSumDense.push_back(CtgSum(levelIdx, ctg));
     ctgAccum.push_back(0.0);
   }
-  unsigned int denseCut = idxStart; // Defaults to lowest index.
+  unsigned int denseCut = idxStart; // Highest index ranked below dense.
   double sumTot = 0.0;
   unsigned int sCountTot = 0;
   for (int idx = int(idxEnd); idx >= int(idxStart); idx--) {
     // Accumulates statistics over explicit range.
     unsigned int yCtg, rkThis;
     FltVal ySum;
-    unsigned int sampleCount = spn[idx].CtgFields(ySum, rkThis, yCtg);
+    unsigned int sampleCount = spn[idx].CtgFields(ySum, rkThis, yCtg, ctgShift);
     ctgAccum[yCtg] += ySum;
-    denseCut = rkThis >= denseRank ? idx : denseCut;
+    denseCut = (rkThis < denseRank && int(denseCut) < idx) ? idx : denseCut;
     sCountTot += sampleCount;
     sumTot += ySum;
   }
@@ -1053,8 +1372,14 @@ void SPCtg::ApplyResiduals(unsigned int levelIdx, unsigned int predIdx, double &
 }
 
 
-bool SplitCoord::SplitNum(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
-  if (denseCount > 0) {
+template<typename Layout> bool SplitCoord::SplitNum(SPCtg *spCtg, const Layout &spn, NuxLH &nux) {
+  if (spCtg->ExtraTrees()) {
+    return NumCtgExtra(spCtg, spn, spCtg->CutVariate(splitPos), nux);
+  }
+  else if (Approximate(spCtg)) {
+    return NumCtgApprox(spCtg, spn, nux);
+  }
+  else if (denseCount > 0) {
     return NumCtgDense(spCtg, spn, nux);
   }
   else {
@@ -1063,7 +1388,7 @@ bool SplitCoord::SplitNum(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
 }
 
 
-bool SplitCoord::NumCtg(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
+template<typename Layout> bool SplitCoord::NumCtg(SPCtg *spCtg, const Layout &spn, NuxLH &nux) {
   unsigned int sCountL = sCount;
   unsigned int rkRight = spn[idxEnd].Rank();
   double sumL = sum;
@@ -1087,41 +1412,602 @@ bool SplitCoord::NumCtg(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
 }
 
 
-unsigned int SplitCoord::NumCtgGini(SPCtg *spCtg, const SPNode spn[], unsigned int idxNext, unsigned int idxFinal, unsigned int &sCountL, unsigned int &rkRight, double &sumL, double &ssL, double &ssR, double &maxGini, unsigned int &rankLH, unsigned int &rankRH, unsigned int &rhInf) {
+template<typename Layout> unsigned int SplitCoord::NumCtgGini(SPCtg *spCtg, const Layout &spn, unsigned int idxNext, unsigned int idxFinal, unsigned int &sCountL, unsigned int &rkRight, double &sumL, double &ssL, double &ssR, double &maxGini, unsigned int &rankLH, unsigned int &rankRH, unsigned int &rhInf) {
   unsigned int lhSampCt = 0;
   unsigned int numIdx = spCtg->NumIdx(predIdx);
   // Signing values avoids decrementing below zero.
-  for (int idx = int(idxNext); idx >= int(idxFinal); idx--) {
-    FltVal ySum;    
-    unsigned int yCtg, rkThis;
-    unsigned int sampleCount = spn[idx].CtgFields(ySum, rkThis, yCtg);
-    FltVal sumR = sum - sumL;
-    if (rkThis != rkRight && spCtg->StableDenoms(sumL, sumR)) {
-      FltVal cutGini = ssL / sumL + ssR / sumR;
-      if (cutGini > maxGini) {
-        lhSampCt = sCountL;
-	rankLH = rkThis;
-	rankRH = rkRight;
-	rhInf = idx + 1;
-        maxGini = cutGini;
+  if (int(idxNext) - int(idxFinal) + 1 < int(SplitScan::serialMax)) {
+    for (int idx = int(idxNext); idx >= int(idxFinal); idx--) {
+      FltVal ySum;    
+      unsigned int yCtg, rkThis;
+      unsigned int sampleCount = spn[idx].CtgFields(ySum, rkThis, yCtg, spCtg->CtgShift());
+      FltVal sumR = sum - sumL;
+      if (rkThis != rkRight && spCtg->StableDenoms(sumL, sumR)) {
+        FltVal cutGini = ssL / sumL + ssR / sumR;
+        if (cutGini > maxGini) {
+          lhSampCt = sCountL;
+          rankLH = rkThis;
+          rankRH = rkRight;
+          rhInf = idx + 1;
+          maxGini = cutGini;
+        }
       }
-    }
-    rkRight = rkThis;
+      rkRight = rkThis;
 
-    sCountL -= sampleCount;
-    sumL -= ySum;
+      sCountL -= sampleCount;
+      sumL -= ySum;
 
-    double sumRCtg = spCtg->CtgSumAccum(levelIdx, numIdx, yCtg, ySum);
-    ssR += ySum * (ySum + 2.0 * sumRCtg);
-    double sumLCtg = spCtg->CtgSum(levelIdx, yCtg) - sumRCtg;
-    ssL += ySum * (ySum - 2.0 * sumLCtg);
+      double sumRCtg = spCtg->CtgSumAccum(levelIdx, numIdx, yCtg, ySum);
+      ssR += ySum * (ySum + 2.0 * sumRCtg);
+      double sumLCtg = spCtg->CtgSum(levelIdx, yCtg) - sumRCtg;
+      ssL += ySum * (ySum - 2.0 * sumLCtg);
+    }
+    return lhSampCt;
+  }
+
+  // Accumulates a block of cuts in walk order, then evaluates the block.
+  double cutSsL[SplitScan::blockSize];
+  double cutSsR[SplitScan::blockSize];
+  double cutSumL[SplitScan::blockSize];
+  unsigned int cutCountL[SplitScan::blockSize];
+  unsigned int rank[SplitScan::blockSize + 1];
+  for (int blockTop = int(idxNext); blockTop >= int(idxFinal); blockTop -= SplitScan::blockSize) {
+    unsigned int cutCount = std::min(SplitScan::blockSize, static_cast<unsigned int>(blockTop - int(idxFinal) + 1));
+    unsigned int liveCount = 0;
+    rank[0] = rkRight;
+    for (unsigned int cut = 0; cut < cutCount; cut++) {
+      FltVal ySum;    
+      unsigned int yCtg, rkThis;
+      unsigned int sampleCount = spn[blockTop - cut].CtgFields(ySum, rkThis, yCtg, spCtg->CtgShift());
+      liveCount += rkThis != rkRight;
+      rank[cut + 1] = rkThis;
+      cutSsL[cut] = ssL;
+      cutSsR[cut] = ssR;
+      cutSumL[cut] = sumL;
+      cutCountL[cut] = sCountL;
+      rkRight = rkThis;
+
+      sCountL -= sampleCount;
+      sumL -= ySum;
+
+      double sumRCtg = spCtg->CtgSumAccum(levelIdx, numIdx, yCtg, ySum);
+      ssR += ySum * (ySum + 2.0 * sumRCtg);
+      double sumLCtg = spCtg->CtgSum(levelIdx, yCtg) - sumRCtg;
+      ssL += ySum * (ySum - 2.0 * sumLCtg);
+    }
+
+    unsigned int argMax = SplitScan::ArgMaxCtg(cutSsL, cutSsR, cutSumL, rank + 1, cutCount, liveCount, sum, spCtg->MinDenom(), maxGini);
+    if (argMax < cutCount) {
+      lhSampCt = cutCountL[argMax];
+      rankLH = rank[argMax + 1];
+      rankRH = rank[argMax];
+      rhInf = blockTop - argMax + 1;
+    }
   }
 
   return lhSampCt;
 }
 
 
-bool SplitCoord::NumCtgDense(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
+/**
+   @brief Weighted-variance splitting of a wide node, approximated by
+   locating a candidate cut from a stratified subsample, then scanning
+   exactly about the candidate.  Reverts to the exact scan if the
+   subsample suggests no candidate.
+
+   @return true iff pair splits.
+ */
+template<typename Layout> bool SplitCoord::SplitNumApprox(const Layout &spn, int monoMode, NuxLH &nux) {
+  unsigned int strata = SplitPred::approxStrata;
+  unsigned int lhSup;
+  if (SampleReg(spn, strata, monoMode, lhSup)) {
+    return RefineReg(spn, lhSup, Extent() / strata, monoMode, nux);
+  }
+  else {
+    return monoMode != 0 ? SplitNumMono(monoMode > 0, spn, nux) : SplitNum(spn, nux);
+  }
+}
+
+
+/**
+   @brief Evaluates cuts between strata of equal width, estimating the
+   response sums from a single sample drawn at the middle of each
+   stratum.  Sample counts are scaled to the node's total.
+
+   @param strata is the number of strata.
+
+   @param lhSup outputs the left-hand index supremum of the best cut.
+
+   @return true iff some stratum boundary separates distinct ranks.
+ */
+template<typename Layout> bool SplitCoord::SampleReg(const Layout &spn, unsigned int strata, int monoMode, unsigned int &lhSup) const {
+  unsigned int width = Extent() / strata;
+  std::vector<double> ySample(strata);
+  std::vector<unsigned int> sCountSample(strata);
+  unsigned int sCountTot = 0;
+  for (unsigned int stratum = 0; stratum < strata; stratum++) {
+    unsigned int rank;
+    FltVal ySum;
+    spn[idxEnd - stratum * width - width / 2].RegFields(ySum, rank, sCountSample[stratum]);
+    ySample[stratum] = ySum;
+    sCountTot += sCountSample[stratum];
+  }
+
+  double scale = double(sCount) / sCountTot;
+  double sumR = 0.0;
+  double sCountR = 0.0;
+  double maxInfo = 0.0;
+  bool found = false;
+  for (unsigned int stratum = 0; stratum < strata - 1; stratum++) {
+    sumR += scale * ySample[stratum];
+    sCountR += scale * sCountSample[stratum];
+    unsigned int idxCut = idxEnd - (stratum + 1) * width;
+    double sCountL = sCount - sCountR;
+    if (spn[idxCut].Rank() == spn[idxCut + 1].Rank() || sCountL <= 0.0)
+      continue;
+
+    double sumL = sum - sumR;
+    double info = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
+    bool up = (sumL * sCountR <= sumR * sCountL);
+    if ((!found || info > maxInfo) && (monoMode == 0 || (monoMode > 0 ? up : !up))) {
+      maxInfo = info;
+      lhSup = idxCut;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+
+/**
+   @brief Scans exactly within two strata either side of a candidate
+   cut.  The right-hand state at the top of the neighborhood is
+   accumulated from whichever side of the node is narrower.
+
+   @param lhSup is the left-hand index supremum of the candidate.
+
+   @param width is the stratum width.
+
+   @return true iff an informative cut is found.
+ */
+template<typename Layout> bool SplitCoord::RefineReg(const Layout &spn, unsigned int lhSup, unsigned int width, int monoMode, NuxLH &nux) const {
+  unsigned int idxTop = std::min(idxEnd, lhSup + 2 * width);
+  unsigned int idxBottom = lhSup + 1 - idxStart > 2 * width ? lhSup + 1 - 2 * width : idxStart;
+
+  double sumR = 0.0;
+  unsigned int sCountL = 0;
+  if (idxEnd - idxTop <= idxTop - idxStart) {
+    sCountL = sCount;
+    for (unsigned int idx = idxTop + 1; idx <= idxEnd; idx++) {
+      unsigned int rank, sampleCount;
+      FltVal ySum;
+      spn[idx].RegFields(ySum, rank, sampleCount);
+      sumR += ySum;
+      sCountL -= sampleCount;
+    }
+  }
+  else {
+    double sumL = 0.0;
+    for (unsigned int idx = idxStart; idx <= idxTop; idx++) {
+      unsigned int rank, sampleCount;
+      FltVal ySum;
+      spn[idx].RegFields(ySum, rank, sampleCount);
+      sumL += ySum;
+      sCountL += sampleCount;
+    }
+    sumR = sum - sumL;
+  }
+
+  // Walk begins at 'idxTop', which only contributes to the right-hand
+  // state if it is the node's highest index.
+  unsigned int rkRight = spn[idxTop < idxEnd ? idxTop + 1 : idxEnd].Rank();
+  double maxInfo = preBias;
+  unsigned int lhSampCt = 0;
+  unsigned int cutSup = idxEnd;
+  unsigned int rankLH, rankRH;
+  if (RegScan(spn, int(idxTop), int(idxBottom), monoMode, rkRight, sumR, sCountL, maxInfo, lhSampCt, cutSup, rankLH, rankRH)) {
+    nux.InitNum(idxStart, cutSup + 1 - idxStart, lhSampCt, maxInfo - preBias, rankLH, rankRH);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief Gini splitting of a wide node, approximated as with weighted
+   variance.
+
+   @return true iff pair splits.
+ */
+template<typename Layout> bool SplitCoord::NumCtgApprox(SPCtg *spCtg, const Layout &spn, NuxLH &nux) {
+  unsigned int strata = SplitPred::approxStrata;
+  unsigned int lhSup;
+  if (SampleCtg(spCtg, spn, strata, lhSup)) {
+    return RefineCtg(spCtg, spn, lhSup, Extent() / strata, nux);
+  }
+  else {
+    return NumCtg(spCtg, spn, nux);
+  }
+}
+
+
+/**
+   @brief Evaluates the Gini criterion between strata, estimating the
+   per-category sums from a single sample per stratum.
+
+   @return true iff some stratum boundary separates distinct ranks.
+ */
+template<typename Layout> bool SplitCoord::SampleCtg(const SPCtg *spCtg, const Layout &spn, unsigned int strata, unsigned int &lhSup) const {
+  unsigned int width = Extent() / strata;
+  std::vector<double> ySample(strata);
+  std::vector<unsigned int> ctgSample(strata);
+  unsigned int sCountTot = 0;
+  for (unsigned int stratum = 0; stratum < strata; stratum++) {
+    unsigned int rank;
+    FltVal ySum;
+    sCountTot += spn[idxEnd - stratum * width - width / 2].CtgFields(ySum, rank, ctgSample[stratum], spCtg->CtgShift());
+    ySample[stratum] = ySum;
+  }
+
+  // Scales by sample counts, as responses are weighted.
+  double scale = double(sCount) / sCountTot;
+  std::vector<double> ctgR(spCtg->CtgWidth());
+  double sumR = 0.0;
+  double maxInfo = 0.0;
+  bool found = false;
+  for (unsigned int stratum = 0; stratum < strata - 1; stratum++) {
+    ctgR[ctgSample[stratum]] += scale * ySample[stratum];
+    sumR += scale * ySample[stratum];
+    unsigned int idxCut = idxEnd - (stratum + 1) * width;
+    double sumL = sum - sumR;
+    if (spn[idxCut].Rank() == spn[idxCut + 1].Rank() || !spCtg->StableDenoms(sumL, sumR))
+      continue;
+
+    double ssL = 0.0;
+    double ssR = 0.0;
+    for (unsigned int ctg = 0; ctg < ctgR.size(); ctg++) {
+      double sumLCtg = spCtg->CtgSum(levelIdx, ctg) - ctgR[ctg];
+      ssL += sumLCtg * sumLCtg;
+      ssR += ctgR[ctg] * ctgR[ctg];
+    }
+    double info = ssL / sumL + ssR / sumR;
+    if (!found || info > maxInfo) {
+      maxInfo = info;
+      lhSup = idxCut;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+
+/**
+   @brief Scans exactly about a candidate cut, as with weighted variance.
+   The pair's running category sums are primed with the right-hand
+   state at the top of the neighborhood.
+
+   @return true iff an informative cut is found.
+ */
+template<typename Layout> bool SplitCoord::RefineCtg(SPCtg *spCtg, const Layout &spn, unsigned int lhSup, unsigned int width, NuxLH &nux) {
+  unsigned int idxTop = std::min(idxEnd, lhSup + 2 * width);
+  unsigned int idxBottom = lhSup + 1 - idxStart > 2 * width ? lhSup + 1 - 2 * width : idxStart;
+
+  unsigned int ctgWidth = spCtg->CtgWidth();
+  std::vector<double> ctgR(ctgWidth);
+  double sumR = 0.0;
+  unsigned int sCountR = 0;
+  if (idxEnd - idxTop <= idxTop - idxStart) {
+    for (unsigned int idx = idxTop + 1; idx <= idxEnd; idx++) {
+      unsigned int rank, yCtg;
+      FltVal ySum;
+      sCountR += spn[idx].CtgFields(ySum, rank, yCtg, spCtg->CtgShift());
+      ctgR[yCtg] += ySum;
+      sumR += ySum;
+    }
+  }
+  else {
+    std::vector<double> ctgL(ctgWidth);
+    double sumL = 0.0;
+    unsigned int sCountL = 0;
+    for (unsigned int idx = idxStart; idx <= idxTop; idx++) {
+      unsigned int rank, yCtg;
+      FltVal ySum;
+      sCountL += spn[idx].CtgFields(ySum, rank, yCtg, spCtg->CtgShift());
+      ctgL[yCtg] += ySum;
+      sumL += ySum;
+    }
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+      ctgR[ctg] = spCtg->CtgSum(levelIdx, ctg) - ctgL[ctg];
+    }
+    sumR = sum - sumL;
+    sCountR = sCount - sCountL;
+  }
+
+  unsigned int numIdx = spCtg->NumIdx(predIdx);
+  double ssL = 0.0;
+  double ssR = 0.0;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    (void) spCtg->CtgSumAccum(levelIdx, numIdx, ctg, ctgR[ctg]);
+    double sumLCtg = spCtg->CtgSum(levelIdx, ctg) - ctgR[ctg];
+    ssL += sumLCtg * sumLCtg;
+    ssR += ctgR[ctg] * ctgR[ctg];
+  }
+
+  unsigned int sCountL = sCount - sCountR;
+  double sumL = sum - sumR;
+  unsigned int rkRight = spn[idxTop < idxEnd ? idxTop + 1 : idxEnd].Rank();
+  double maxInfo = preBias;
+  unsigned int rankLH = 0;
+  unsigned int rankRH = 0;
+  unsigned int rhInf = idxEnd;
+  unsigned int lhSampCt = NumCtgGini(spCtg, spn, idxTop, idxBottom, sCountL, rkRight, sumL, ssL, ssR, maxInfo, rankLH, rankRH, rhInf);
+  if (maxInfo > preBias) {
+    nux.InitNum(idxStart, rhInf - idxStart, lhSampCt, maxInfo - preBias, rankLH, rankRH, 0);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief Draws a cut rank uniformly from the node's rank range,
+   including the dense rank, if any.  Cuts separate ranks at or below
+   the drawn rank from those above, so both sides are nonempty.
+
+   @param ruCut is the pair's uniform variate.
+
+   @param rankCut outputs the greatest rank lying to the left.
+
+   @return true iff the node spans more than a single rank.
+ */
+template<typename Layout> bool SplitCoord::CutRank(const Layout &spn, unsigned int denseRank, double ruCut, unsigned int &rankCut) const {
+  unsigned int rankLow = spn[idxStart].Rank();
+  unsigned int rankHigh = spn[idxEnd].Rank();
+  if (denseCount > 0) {
+    rankLow = std::min(rankLow, denseRank);
+    rankHigh = std::max(rankHigh, denseRank);
+  }
+  if (rankLow == rankHigh)
+    return false;
+
+  rankCut = rankLow + SplitPred::Draw(rankHigh - rankLow, ruCut);
+  return true;
+}
+
+
+/**
+   @brief Weighted-variance evaluation of a single, randomly-drawn cut.
+   A single pass accumulates the left-hand sums, together with the
+   explicit totals from which the dense residuals are derived.
+
+   @return true iff the cut is informative.
+ */
+template<typename Layout> bool SplitCoord::SplitNumExtra(const Layout &spn, unsigned int denseRank, double ruCut, int monoMode, NuxLH &nux) const {
+  unsigned int rankCut;
+  if (!CutRank(spn, denseRank, ruCut, rankCut))
+    return false;
+
+  double sumL = 0.0;
+  double sumExpl = 0.0;
+  unsigned int sCountL = 0;
+  unsigned int sCountExpl = 0;
+  unsigned int lhIdxCount = 0;
+  unsigned int rankLH = rankCut;
+  unsigned int rankRH = rankCut + 1;
+  for (unsigned int idx = idxStart; idx <= idxEnd; idx++) {
+    unsigned int rank, sampleCount;
+    FltVal ySum;
+    spn[idx].RegFields(ySum, rank, sampleCount);
+    sumExpl += ySum;
+    sCountExpl += sampleCount;
+    if (rank <= rankCut) {
+      sumL += ySum;
+      sCountL += sampleCount;
+      rankLH = rank;
+      lhIdxCount++;
+    }
+    else if (idx == idxStart + lhIdxCount) {
+      rankRH = rank;
+    }
+  }
+
+  unsigned int lhDense = 0;
+  if (denseCount > 0) {
+    if (denseRank <= rankCut) {
+      sumL += sum - sumExpl;
+      sCountL += sCount - sCountExpl;
+      lhDense = denseCount;
+      rankLH = lhIdxCount > 0 ? std::max(rankLH, denseRank) : denseRank;
+    }
+    else {
+      rankRH = lhIdxCount <= idxEnd - idxStart ? std::min(rankRH, denseRank) : denseRank;
+    }
+  }
+
+  unsigned int sCountR = sCount - sCountL;
+  if (sCountL == 0 || sCountR == 0)
+    return false;
+
+  double sumR = sum - sumL;
+  bool up = (sumL * sCountR <= sumR * sCountL);
+  if (monoMode != 0 && (monoMode > 0 ? !up : up))
+    return false;
+
+  double info = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
+  if (info > preBias) {
+    nux.InitNum(idxStart, lhIdxCount + lhDense, sCountL, info - preBias, rankLH, rankRH, lhDense);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief Gini evaluation of a single, randomly-drawn cut.  As with
+   weighted-variance evaluation, a single pass suffices.
+
+   @return true iff the cut is informative.
+ */
+template<typename Layout> bool SplitCoord::NumCtgExtra(const SPCtg *spCtg, const Layout &spn, double ruCut, NuxLH &nux) const {
+  unsigned int denseRank = spCtg->DenseRank(predIdx);
+  unsigned int rankCut;
+  if (!CutRank(spn, denseRank, ruCut, rankCut))
+    return false;
+
+  unsigned int ctgWidth = spCtg->CtgWidth();
+  std::vector<double> ctgL(ctgWidth);
+  std::vector<double> ctgExpl(ctgWidth);
+  double sumL = 0.0;
+  unsigned int sCountL = 0;
+  unsigned int sCountExpl = 0;
+  unsigned int lhIdxCount = 0;
+  unsigned int rankLH = rankCut;
+  unsigned int rankRH = rankCut + 1;
+  for (unsigned int idx = idxStart; idx <= idxEnd; idx++) {
+    unsigned int rank, yCtg;
+    FltVal ySum;
+    unsigned int sampleCount = spn[idx].CtgFields(ySum, rank, yCtg, spCtg->CtgShift());
+    ctgExpl[yCtg] += ySum;
+    sCountExpl += sampleCount;
+    if (rank <= rankCut) {
+      ctgL[yCtg] += ySum;
+      sumL += ySum;
+      sCountL += sampleCount;
+      rankLH = rank;
+      lhIdxCount++;
+    }
+    else if (idx == idxStart + lhIdxCount) {
+      rankRH = rank;
+    }
+  }
+
+  unsigned int lhDense = 0;
+  if (denseCount > 0) {
+    if (denseRank <= rankCut) {
+      for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+        double sumDense = spCtg->CtgSum(levelIdx, ctg) - ctgExpl[ctg];
+        ctgL[ctg] += sumDense;
+        sumL += sumDense;
+      }
+      sCountL += sCount - sCountExpl;
+      lhDense = denseCount;
+      rankLH = lhIdxCount > 0 ? std::max(rankLH, denseRank) : denseRank;
+    }
+    else {
+      rankRH = lhIdxCount <= idxEnd - idxStart ? std::min(rankRH, denseRank) : denseRank;
+    }
+  }
+
+  double sumR = sum - sumL;
+  if (!spCtg->StableDenoms(sumL, sumR))
+    return false;
+
+  double ssL = 0.0;
+  double ssR = 0.0;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    double sumRCtg = spCtg->CtgSum(levelIdx, ctg) - ctgL[ctg];
+    ssL += ctgL[ctg] * ctgL[ctg];
+    ssR += sumRCtg * sumRCtg;
+  }
+  double info = ssL / sumL + ssR / sumR;
+  if (info > preBias) {
+    nux.InitNum(idxStart, lhIdxCount + lhDense, sCountL, info - preBias, rankLH, rankRH, lhDense);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief Walks indices backward from 'idxNext' through 'idxFinal',
+   evaluating the weighted-variance criterion between distinct ranks.
+   Short walks evaluate as they accumulate.  Longer walks accumulate a
+   block of cuts at a time, each block then evaluated by SplitScan.
+
+   @param monoMode is positive (negative) iff the cut must be increasing
+   (decreasing), else zero.
+
+   @param rkRight inputs the rank preceding 'idxNext' in the walk and
+   outputs the rank at 'idxFinal'.
+
+   @param lhSup outputs the greatest left-hand index of an improving cut.
+
+   @return true iff an improving cut was found, with output reference
+   parameters.
+ */
+template<typename Layout> bool SplitCoord::RegScan(const Layout &spn, int idxNext, int idxFinal, int monoMode, unsigned int &rkRight, double &sumR, unsigned int &sCountL, double &maxInfo, unsigned int &lhSampCt, unsigned int &lhSup, unsigned int &rankLH, unsigned int &rankRH) const {
+  bool improved = false;
+  if (idxNext - idxFinal + 1 < int(SplitScan::serialMax)) {
+    for (int i = idxNext; i >= idxFinal; i--) {
+      unsigned int rkThis, sampleCount;
+      FltVal ySum;
+      spn[i].RegFields(ySum, rkThis, sampleCount);
+      if (rkThis != rkRight) {
+        unsigned int sCountR = sCount - sCountL;
+        double sumL = sum - sumR;
+        double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
+        bool up = (sumL * sCountR <= sumR * sCountL);
+        if (idxGini > maxInfo && (monoMode == 0 || (monoMode > 0 ? up : !up))) {
+          lhSampCt = sCountL;
+          lhSup = i;
+          rankLH = rkThis;
+          rankRH = rkRight;
+          maxInfo = idxGini;
+          improved = true;
+        }
+      }
+      sCountL -= sampleCount;
+      sumR += ySum;
+      rkRight = rkThis;
+    }
+    return improved;
+  }
+
+  double cutSumR[SplitScan::blockSize];
+  unsigned int cutCountL[SplitScan::blockSize];
+  unsigned int rank[SplitScan::blockSize + 1];
+  for (int blockTop = idxNext; blockTop >= idxFinal; blockTop -= SplitScan::blockSize) {
+    unsigned int cutCount = std::min(SplitScan::blockSize, static_cast<unsigned int>(blockTop - idxFinal + 1));
+    unsigned int liveCount = 0;
+    rank[0] = rkRight;
+    for (unsigned int cut = 0; cut < cutCount; cut++) {
+      unsigned int rkThis, sampleCount;
+      FltVal ySum;
+      spn[blockTop - cut].RegFields(ySum, rkThis, sampleCount);
+      liveCount += rkThis != rkRight;
+      rank[cut + 1] = rkThis;
+      cutSumR[cut] = sumR;
+      cutCountL[cut] = sCountL;
+      sCountL -= sampleCount;
+      sumR += ySum;
+      rkRight = rkThis;
+    }
+
+    unsigned int argMax = SplitScan::ArgMaxReg(cutSumR, cutCountL, rank + 1, cutCount, liveCount, sum, sCount, monoMode, maxInfo);
+    if (argMax < cutCount) {
+      lhSup = blockTop - argMax;
+      lhSampCt = cutCountL[argMax];
+      rankLH = rank[argMax + 1];
+      rankRH = rank[argMax];
+      improved = true;
+    }
+  }
+
+  return improved;
+}
+
+
+template<typename Layout> bool SplitCoord::NumCtgDense(SPCtg *spCtg, const Layout &spn, NuxLH &nux) {
   unsigned int denseRank = spCtg->DenseRank(predIdx);
   double sumDense = sum;
   unsigned int sCountDense = sCount;
@@ -1171,7 +2057,9 @@ bool SplitCoord::NumCtgDense(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
       spCtg->ApplyResiduals(levelIdx, predIdx, ssR, ssL, sumDenseCtg);
       sCountL -= sCountDense;
       sumL -= sumDense;
-      lhSampCt = NumCtgGini(spCtg, spn, denseCut, idxStart, sCountL, rkRight, sumL, ssL, ssR, maxInfo, rankLH, rankRH, rhInf);
+      rkRight = denseRank;
+      unsigned int lhLow = NumCtgGini(spCtg, spn, denseCut, idxStart, sCountL, rkRight, sumL, ssL, ssR, maxInfo, rankLH, rankRH, rhInf);
+      lhSampCt = lhLow > 0 ? lhLow : lhSampCt; // Zero iff no improvement.
     }
   }
 
@@ -1190,7 +2078,7 @@ bool SplitCoord::NumCtgDense(SPCtg *spCtg, const SPNode spn[], NuxLH &nux) {
 /**
    Regression runs always maintained by heap.
 */
-unsigned int SplitCoord::RunsReg(RunSet *runSet, const SPNode spn[], unsigned int denseRank) const {
+template<typename Layout> unsigned int SplitCoord::RunsReg(RunSet *runSet, const Layout &spn, unsigned int denseRank) const {
   double sumHeap = 0.0;
   unsigned int sCountHeap = 0;
   unsigned int rkThis = spn[idxEnd].Rank();
@@ -1235,9 +2123,11 @@ unsigned int SplitCoord::RunsReg(RunSet *runSet, const SPNode spn[], unsigned in
 
    @param outputs computed split parameters.
 
+   @param slotDraw is the only slot evaluated as a cut, if nonnegative.
+
    @return true iff node splits.
 */
-bool SplitCoord::HeapSplit(RunSet *runSet, NuxLH &nux) const {
+bool SplitCoord::HeapSplit(RunSet *runSet, NuxLH &nux, int slotDraw) const {
   unsigned int lhSCount = 0;
   double sumL = 0.0;
   int cut = -1; // Top index of lh ords in 'facOrd' (q.v.).
@@ -1249,7 +2139,7 @@ bool SplitCoord::HeapSplit(RunSet *runSet, NuxLH &nux) const {
     unsigned int sCountR = sCount - lhSCount;
     double sumR = sum - sumL;
     double cutGini = (sumL * sumL) / lhSCount + (sumR * sumR) / sCountR;
-    if (cutGini > maxGini) {
+    if (cutGini > maxGini && (slotDraw < 0 || int(outSlot) == slotDraw)) {
       maxGini = cutGini;
       cut = outSlot;
     }
@@ -1266,13 +2156,263 @@ bool SplitCoord::HeapSplit(RunSet *runSet, NuxLH &nux) const {
 }
 
 
+/**
+   @brief Multi-output regression splitting.  Output sums are looked up
+   through the buffered sample indices, which restaging maintains
+   alongside the nodes.
+
+   @return void.
+ */
+void SplitCoord::SplitMulti(const SPReg *spReg, const Bottom *bottom, const SamplePred *samplePred) {
+  unsigned int *sIdx;
+  if (samplePred->Columnar()) {
+    SPCol spn;
+    samplePred->Buffers(predIdx, bufIdx, spn, sIdx);
+    SplitMultiLayout(spReg, bottom, spn, sIdx);
+  }
+  else {
+    SPRow spn;
+    samplePred->Buffers(predIdx, bufIdx, spn, sIdx);
+    SplitMultiLayout(spReg, bottom, spn, sIdx);
+  }
+}
+
+
+/**
+   @brief Multi-output splitting, specialized by buffer layout.
+
+   @param sIdx holds the buffered sample indices of the pair.
+
+   @return void.
+ */
+template<typename Layout> void SplitCoord::SplitMultiLayout(const SPReg *spReg, const Bottom *bottom, const Layout &spn, const unsigned int sIdx[]) {
+  NuxLH nux;
+  if (spReg->IsFactor(predIdx)) {
+    unsigned int runCount;
+    if (SplitFacMulti(spReg, spn, sIdx, runCount, nux)) {
+      bottom->SSWrite(levelIdx, predIdx, setIdx, bufIdx, nux);
+    }
+    bottom->SetRunCount(levelIdx, predIdx, runCount);
+  }
+  else if (SplitNumMulti(spReg, spn, sIdx, nux)) {
+    bottom->SSWrite(levelIdx, predIdx, setIdx, bufIdx, nux);
+  }
+}
+
+
+/**
+   @brief Weighted-variance splitting summed over outputs.  Walks ranks
+   downward, as does the single-output scan, inserting the residual
+   dense block at its rank.
+
+   @param sIdx holds the buffered sample indices of the pair.
+
+   @param nux outputs split nucleus.
+
+   @return true iff pair splits.
+ */
+template<typename Layout> bool SplitCoord::SplitNumMulti(const SPReg *spReg, const Layout &spn, const unsigned int sIdx[], NuxLH &nux) const {
+  unsigned int nOut = spReg->NOut();
+  const double *nodeOut = spReg->NodeOut(levelIdx);
+  unsigned int denseRank = denseCount > 0 ? spReg->DenseRank(predIdx) : 0;
+  std::vector<double> sumDense(nOut);
+  unsigned int sCountDense = 0;
+  if (denseCount > 0) { // Dense block holds the residuals.
+    std::copy(nodeOut, nodeOut + nOut, sumDense.begin());
+    sCountDense = sCount;
+    for (unsigned int idx = idxStart; idx <= idxEnd; idx++) {
+      unsigned int rkThis, sampleCount;
+      FltVal ySum;
+      spn[idx].RegFields(ySum, rkThis, sampleCount);
+      sCountDense -= sampleCount;
+      const double *out = spReg->IdxOut(sIdx[idx]);
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        sumDense[outIdx] -= out[outIdx];
+      }
+    }
+  }
+
+  std::vector<double> sumR(nOut);
+  unsigned int sCountR = 0;
+  unsigned int rkRight = 0; // Lowest rank on right.
+  unsigned int rhInf = idxEnd + 1; // Lowest explicit index on right.
+  double maxInfo = preBias;
+  unsigned int lhSampCt = 0;
+  unsigned int rankLH = 0;
+  unsigned int rankRH = 0;
+  unsigned int rhCut = idxEnd + 1; // Value of 'rhInf' at best cut.
+
+  // Evaluates the cut lying above rank 'rkLeft', the highest remaining
+  // on the left.  Ties do not split.
+  auto cut = [&](unsigned int rkLeft) {
+    if (sCountR == 0 || sCountR == sCount || rkLeft == rkRight)
+      return;
+    unsigned int sCountL = sCount - sCountR;
+    double info = 0.0;
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      double sumL = nodeOut[outIdx] - sumR[outIdx];
+      info += (sumL * sumL) / sCountL + (sumR[outIdx] * sumR[outIdx]) / sCountR;
+    }
+    if (info > maxInfo) {
+      maxInfo = info;
+      lhSampCt = sCountL;
+      rankLH = rkLeft;
+      rankRH = rkRight;
+      rhCut = rhInf;
+    }
+  };
+
+  bool denseRight = denseCount == 0; // Whether dense block walked.
+  for (int idx = int(idxEnd); idx >= int(idxStart); idx--) {
+    unsigned int rkThis, sampleCount;
+    FltVal ySum;
+    spn[idx].RegFields(ySum, rkThis, sampleCount);
+    if (!denseRight && denseRank > rkThis) {
+      cut(denseRank);
+      sCountR += sCountDense;
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+        sumR[outIdx] += sumDense[outIdx];
+      }
+      rkRight = denseRank;
+      denseRight = true;
+    }
+    cut(rkThis);
+    sCountR += sampleCount;
+    const double *out = spReg->IdxOut(sIdx[idx]);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      sumR[outIdx] += out[outIdx];
+    }
+    rkRight = rkThis;
+    rhInf = idx;
+  }
+  if (!denseRight) { // Dense block lowest:  sole left-hand candidate.
+    cut(denseRank);
+  }
+
+  if (maxInfo > preBias) {
+    unsigned int lhDense = (denseCount > 0 && rankLH >= denseRank) ? denseCount : 0;
+    nux.InitNum(idxStart, rhCut - idxStart + lhDense, lhSampCt, maxInfo - preBias, rankLH, rankRH, lhDense);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief Multi-output factor splitting.  Runs are ordered by mean of
+   each output in turn, as the single-output split orders by mean
+   response, and the best prefix under the summed criterion is taken.
+
+   @param runCount outputs recently-updated run count.
+
+   @param nux outputs split nucleus.
+
+   @return true iff pair splits.
+ */
+template<typename Layout> bool SplitCoord::SplitFacMulti(const SPReg *spReg, const Layout &spn, const unsigned int sIdx[], unsigned int &runCount, NuxLH &nux) const {
+  RunSet *runSet = spReg->RSet(setIdx);
+  runCount = RunsMulti(spReg, runSet, spn, sIdx);
+
+  unsigned int nOut = spReg->NOut();
+  const double *nodeOut = spReg->NodeOut(levelIdx);
+  std::vector<double> sumL(nOut);
+  double maxInfo = preBias;
+  int cut = -1;
+  unsigned int outCut = 0;
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+    runSet->HeapOut(outIdx);
+    runSet->DePop();
+    std::fill(sumL.begin(), sumL.end(), 0.0);
+    unsigned int sCountL = 0;
+    for (unsigned int outPos = 0; outPos < runSet->RunCount() - 1; outPos++) {
+      unsigned int slot = runSet->OutSlot(outPos);
+      unsigned int sCountRun;
+      runSet->LHCounts(slot, sCountRun);
+      sCountL += sCountRun;
+      unsigned int sCountR = sCount - sCountL;
+      double info = 0.0;
+      for (unsigned int j = 0; j < nOut; j++) {
+        sumL[j] += runSet->SumCtg(slot, j);
+        double sumR = nodeOut[j] - sumL[j];
+        info += (sumL[j] * sumL[j]) / sCountL + (sumR * sumR) / sCountR;
+      }
+      if (info > maxInfo) {
+        maxInfo = info;
+        cut = outPos;
+        outCut = outIdx;
+      }
+    }
+  }
+
+  if (cut >= 0) {
+    if (outCut != nOut - 1) { // Restores the winning order.
+      runSet->HeapOut(outCut);
+      runSet->DePop();
+    }
+    unsigned int lhSCount;
+    unsigned int lhIdxCount = runSet->LHSlots(cut, lhSCount);
+    nux.Init(idxStart, lhIdxCount, lhSCount, maxInfo - preBias);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
+/**
+   @brief As regression runs, but also sums each output by run.
+
+   @return count of runs.
+ */
+template<typename Layout> unsigned int SplitCoord::RunsMulti(const SPReg *spReg, RunSet *runSet, const Layout &spn, const unsigned int sIdx[]) const {
+  unsigned int nOut = spReg->NOut();
+  double sumHeap = 0.0;
+  unsigned int sCountHeap = 0;
+  unsigned int rkThis = spn[idxEnd].Rank();
+  unsigned int frEnd = idxEnd;
+
+  for (int i = int(idxEnd); i >= int(idxStart); i--) {
+    unsigned int rkRight = rkThis;
+    unsigned int sampleCount;
+    FltVal ySum;
+    spn[i].RegFields(ySum, rkThis, sampleCount);
+
+    if (rkThis == rkRight) { // Same run:  counters accumulate.
+      sumHeap += ySum;
+      sCountHeap += sampleCount;
+    }
+    else { // New run:  flush accumulated counters and reset.
+      runSet->Write(rkRight, sCountHeap, sumHeap, frEnd - i, i+1);
+
+      sumHeap = ySum;
+      sCountHeap = sampleCount;
+      frEnd = i;
+    }
+    const double *out = spReg->IdxOut(sIdx[i]);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      runSet->AccumCtg(outIdx, out[outIdx]);
+    }
+  }
+
+  runSet->Write(rkThis, sCountHeap, sumHeap, frEnd - idxStart + 1, idxStart);
+  if (denseCount > 0) {
+    runSet->WriteImplicit(spReg->DenseRank(predIdx), sCount, sum, denseCount, spReg->NodeOut(levelIdx));
+  }
+
+  return runSet->RunCount();
+}
+
+
 /**
    @brief Builds categorical runs.  Very similar to regression case, but the runs
    also resolve response sum by category.  Further, heap is optional, passed only
    when run count has been estimated to be wide:
 
 */
-unsigned int SplitCoord::RunsCtg(const SPCtg *spCtg, RunSet *runSet, const SPNode spn[]) const {
+template<typename Layout> unsigned int SplitCoord::RunsCtg(const SPCtg *spCtg, RunSet *runSet, const Layout &spn) const {
   double sumLoc = 0.0;
   unsigned int sCountLoc = 0;
   unsigned int rkThis = spn[idxEnd].Rank();
@@ -1283,7 +2423,7 @@ unsigned int SplitCoord::RunsCtg(const SPCtg *spCtg, RunSet *runSet, const SPNod
     unsigned int rkRight = rkThis;
     unsigned int yCtg;
     FltVal ySum;
-    unsigned int sampleCount = spn[i].CtgFields(ySum, rkThis, yCtg);
+    unsigned int sampleCount = spn[i].CtgFields(ySum, rkThis, yCtg, spCtg->CtgShift());
 
     if (rkThis == rkRight) { // Current run's counters accumulate.
       sumLoc += ySum;
@@ -1328,17 +2468,28 @@ unsigned int SplitCoord::RunsCtg(const SPCtg *spCtg, RunSet *runSet, const SPNod
    Iterates over nontrivial subsets, coded by integers as bit patterns.  By
    convention, the final run is incorporated into the RHS of the split, if any.
    Excluding the final run, then, the number of candidate LHS subsets is
-   '2^(runCount-1) - 1'.
+   '2^(runCount-1) - 1'.  Run sets wider than 'maxWidth' are instead
+   searched along category orderings.
 */
 bool SplitCoord::SplitRuns(const SPCtg *spCtg, RunSet *runSet, NuxLH &nux) {
-  unsigned int countEff = runSet->DeWide();
+  if (runSet->RunCount() > RunSet::maxWidth) {
+    return SplitWide(spCtg, runSet, nux);
+  }
 
-  unsigned int slotSup = countEff - 1; // Uses post-shrink value.
+  unsigned int slotSup = runSet->RunCount() - 1;
   unsigned int lhBits = 0;
   unsigned int leftFull = (1 << slotSup) - 1;
   double maxGini = preBias;
+
+  // Randomized cuts evaluate a single subset.
+  unsigned int subsetFirst = 1;
+  unsigned int subsetLast = leftFull;
+  if (spCtg->ExtraTrees() && leftFull > 0) {
+    subsetFirst = subsetLast = 1 + SplitPred::Draw(leftFull, spCtg->CutVariate(splitPos));
+  }
+
   // Nonempty subsets as binary-encoded integers:
-  for (unsigned int subset = 1; subset <= leftFull; subset++) {
+  for (unsigned int subset = subsetFirst; subset <= subsetLast; subset++) {
     double sumL = 0.0;
     double ssL = 0.0;
     double ssR = 0.0;
@@ -1377,6 +2528,77 @@ bool SplitCoord::SplitRuns(const SPCtg *spCtg, RunSet *runSet, NuxLH &nux) {
 }
 
 
+/**
+   @brief Splits a wide run set by searching, for each category in turn,
+   the cuts of the runs ordered by that category's proportion.  Cost is
+   linear in the response cardinality, rather than exponential in the
+   run count, and no runs are excluded from consideration.
+
+   @return true iff pair splits.
+ */
+bool SplitCoord::SplitWide(const SPCtg *spCtg, RunSet *runSet, NuxLH &nux) {
+  unsigned int ctgWidth = spCtg->CtgWidth();
+  unsigned int slotSup = runSet->RunCount() - 1;
+
+  // Randomized cuts evaluate a single ordering and slot.
+  unsigned int ctgFirst = 0;
+  unsigned int ctgLast = ctgWidth - 1;
+  int slotDraw = -1;
+  if (spCtg->ExtraTrees()) {
+    unsigned int draw = SplitPred::Draw(ctgWidth * slotSup, spCtg->CutVariate(splitPos));
+    ctgFirst = ctgLast = draw / slotSup;
+    slotDraw = draw % slotSup;
+  }
+
+  double maxGini = preBias;
+  int cut = -1;
+  unsigned int ctgCut = 0;
+  std::vector<double> sumLCtg(ctgWidth);
+  for (unsigned int ctgOrd = ctgFirst; ctgOrd <= ctgLast; ctgOrd++) {
+    runSet->HeapCtg(ctgOrd);
+    runSet->DePop();
+    std::fill(sumLCtg.begin(), sumLCtg.end(), 0.0);
+    double sumL = 0.0;
+    double ssL = 0.0;
+    double ssR = spCtg->SumSquares(levelIdx);
+    for (unsigned int outSlot = 0; outSlot < slotSup; outSlot++) {
+      unsigned int sCountRun;
+      sumL += runSet->SumHeap(outSlot, sCountRun);
+      for (unsigned int yCtg = 0; yCtg < ctgWidth; yCtg++) {
+        double cell = runSet->SumCtg(runSet->OutSlot(outSlot), yCtg);
+        double sumRCtg = spCtg->CtgSum(levelIdx, yCtg) - sumLCtg[yCtg];
+        ssL += cell * (cell + 2.0 * sumLCtg[yCtg]);
+        ssR += cell * (cell - 2.0 * sumRCtg);
+        sumLCtg[yCtg] += cell;
+      }
+      double sumR = sum - sumL;
+      if ((slotDraw < 0 || int(outSlot) == slotDraw) && spCtg->StableDenoms(sumL, sumR)) {
+        double cutGini = ssR / sumR + ssL / sumL;
+        if (cutGini > maxGini) {
+          maxGini = cutGini;
+          cut = outSlot;
+          ctgCut = ctgOrd;
+        }
+      }
+    }
+  }
+
+  if (cut >= 0) {
+    if (ctgCut != ctgLast) { // Restores the winning order.
+      runSet->HeapCtg(ctgCut);
+      runSet->DePop();
+    }
+    unsigned int sCountL;
+    unsigned int lhIdxCount = runSet->LHSlots(cut, sCountL);
+    nux.Init(idxStart, lhIdxCount, sCountL, maxGini - preBias);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+
 /**
    @brief Adapated from SplitRuns().  Specialized for two-category case in
    which LH subsets accumulate.  This permits running LH 0/1 sums to be
@@ -1394,6 +2616,7 @@ bool SplitCoord::SplitBinary(const SPCtg *spCtg, RunSet *runSet, NuxLH &nux) {
   double sumL0 = 0.0; // Running sum at category 0 over subset slots.
   double sumL1 = 0.0; // "" 1 " 
   int cut = -1;
+  int slotDraw = (spCtg->ExtraTrees() && runSet->RunCount() > 1) ? SplitPred::Draw(runSet->RunCount() - 1, spCtg->CutVariate(splitPos)) : -1;
   for (unsigned int outSlot = 0; outSlot < runSet->RunCount() - 1; outSlot++) {
     double cell0, cell1;
     bool splitable = runSet->SumBinary(outSlot, cell0, cell1);
@@ -1404,7 +2627,7 @@ bool SplitCoord::SplitBinary(const SPCtg *spCtg, RunSet *runSet, NuxLH &nux) {
     FltVal sumL = sumL0 + sumL1;
     FltVal sumR = sum - sumL;
     // sumR, sumL magnitudes can be ignored if no large case/class weightings.
-    if (splitable && spCtg->StableDenoms(sumL, sumR)) {
+    if (splitable && (slotDraw < 0 || int(outSlot) == slotDraw) && spCtg->StableDenoms(sumL, sumR)) {
       FltVal ssL = sumL0 * sumL0 + sumL1 * sumL1;
       FltVal ssR = (totR0 - sumL0) * (totR0 - sumL0) + (totR1 - sumL1) * (totR1 - sumL1);
       FltVal cutGini = ssR / sumR + ssL / sumL;
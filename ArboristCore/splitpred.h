@@ -21,6 +21,32 @@
 #include <vector>
 
 
+/**
+   @brief Segment of a numerical scan too wide to walk as a single task.
+   Segments of a scan are walked concurrently, then reduced.
+ */
+class ScanSeg {
+ public:
+  unsigned int splitPos; // Position of the scanned coordinate.
+  unsigned int idxTop; // Highest index of segment:  walk begins here.
+  unsigned int idxBottom; // Lowest index of segment.
+  int monoMode; // Monotonicity constraint, if any, of the scan.
+  double sumSeg; // Response sum over segment.
+  unsigned int sCountSeg; // Sample count over segment.
+  unsigned int rankTop; // Rank at highest index.
+  unsigned int rankBottom; // Rank at lowest index.
+  unsigned int denseInf; // Lowest index ranked at or above dense rank, if any.
+  double sumR; // Response sum above segment.
+  unsigned int sCountR; // Sample count above segment.
+  bool improved; // Whether segment holds an improving cut.
+  double maxInfo; // Best information within segment.
+  unsigned int lhSampCt; // Left-hand sample count of best cut.
+  unsigned int rhInf; // Right-hand index infimum of best cut.
+  unsigned int rankLH; // Left-hand rank of best cut.
+  unsigned int rankRH; // Right-hand rank of best cut.
+};
+
+
 /**
    @brief Encapsulates information needed to drive splitting.
  */
@@ -36,34 +62,96 @@ class SplitCoord {
   unsigned int denseCount; // Per pair:  post restage.
   unsigned int idxEnd; // Per pair:  post restage.
   unsigned char bufIdx; // Per pair.
+  unsigned int denseRank; // Per pair:  segmented scans only.
+  unsigned int denseCut; // Per pair:  segmented dense scans only.
+  unsigned int idxFinal; // " "
+  unsigned int sCountDense; // " "
+  double sumDense; // " "
+  bool denseLeft; // " "
+  bool denseRight; // " "
+
  public:
 
   void InitEarly(unsigned int _splitPos, unsigned int _levelIdx, unsigned int _predIdx, unsigned int _bufIdx, unsigned int _setIdx);
+
+  inline unsigned int LevelIdx() const {
+    return levelIdx;
+  }
+
+
+  inline unsigned int SplitPos() const {
+    return splitPos;
+  }
+
   void InitLate(const class Bottom *bottom, const class IndexLevel &index);
+  bool Approximate(const class SplitPred *splitPred) const;
+  unsigned int Cost(const class SplitPred *splitPred, const class Bottom *bottom, unsigned int ctgWidth) const;
+  void Segment(std::vector<ScanSeg> &scanSeg, int monoMode, unsigned int _denseRank, unsigned int segWidth);
+  void SegTotals(const class SamplePred *samplePred, ScanSeg &seg) const;
+  void SegPrefix(std::vector<ScanSeg> &scanSeg, unsigned int segStart, unsigned int segEnd);
+  void SegScan(const class SamplePred *samplePred, ScanSeg &seg) const;
+  void SegReduce(const class Bottom *bottom, const std::vector<ScanSeg> &scanSeg, unsigned int segStart, unsigned int segEnd) const;
+  template<typename Layout> void SegTotalsLayout(const Layout &spn, ScanSeg &seg) const;
+  template<typename Layout> void SegScanLayout(const Layout &spn, ScanSeg &seg) const;
+
+  inline unsigned int PredIdx() const {
+    return predIdx;
+  }
+
+
+  inline unsigned int DenseCount() const {
+    return denseCount;
+  }
+
+
+  /**
+     @brief Explicit extent, valid following InitLate() for nonsingletons.
+   */
+  inline unsigned int Extent() const {
+    return idxEnd - idxStart + 1;
+  }
   
-  void Split(const class SPReg *spReg, const class Bottom *bottom, const class SamplePred *samplePred, const class IndexLevel &index);
-  void Split(class SPCtg *spCtg, const class Bottom *bottom, const class SamplePred *samplePred, const class IndexLevel &index);
-  void SplitNum(const class SPReg *splitReg, const class Bottom *bottom, const class SPNode spn[]);
-  void SplitNum(class SPCtg *splitCtg, const class Bottom *bottom, const class SPNode spn[]);
-  bool SplitNum(const class SPReg *spReg, const class SPNode spn[], class NuxLH &nux);
-  bool SplitNum(const class SPNode spn[], class NuxLH &nux);
-  bool SplitNumDense(const class SPNode spn[], const class SPReg *spReg, class NuxLH &nux);
-  bool SplitNumDenseMono(bool increasing, const class SPNode spn[], const class SPReg *spReg, class NuxLH &nux);
-  bool SplitNumMono(bool increasing, const class SPNode spn[], class NuxLH &nux);
-  bool SplitNum(class SPCtg *spCtg, const class SPNode spn[], class NuxLH &nux);
-  bool NumCtgDense(class SPCtg *spCtg, const class SPNode spn[], class NuxLH &nux);
-  bool NumCtg(class SPCtg *spCtg, const class SPNode spn[], class NuxLH &nux);
-  unsigned int NumCtgGini(SPCtg *spCtg, const class SPNode spn[], unsigned int idxNext, unsigned int idxFinal, unsigned int &sCountL, unsigned int &rkRight, double &sumL, double &ssL, double &ssR, double &maxGini, unsigned int &rankLH, unsigned int &rankRH, unsigned int &rhInf);
-  void SplitFac(const class SPReg *splitReg, const class Bottom *bottom, const class SPNode spn[]);
-  void SplitFac(const class SPCtg *splitCtg, const class Bottom *bottom, const class SPNode spn[]);
-  bool SplitFac(const class SPReg *spReg, const class SPNode spn[], unsigned int &runCount, class NuxLH &nux);
-  bool SplitFac(const class SPCtg *spCtg, const class SPNode spn[], unsigned int &runCount, class NuxLH &nux);
+  void Split(const class SPReg *spReg, const class Bottom *bottom, const class SamplePred *samplePred);
+  void Split(class SPCtg *spCtg, const class Bottom *bottom, const class SamplePred *samplePred);
+  template<typename Layout> void SplitLayout(const class SPReg *spReg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> void SplitLayout(class SPCtg *spCtg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> void SplitNum(const class SPReg *splitReg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> void SplitNum(class SPCtg *splitCtg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> bool SplitNum(const class SPReg *spReg, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool SplitNum(const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool SplitNumDense(const Layout &spn, const class SPReg *spReg, class NuxLH &nux);
+  template<typename Layout> bool SplitNumDenseMono(bool increasing, const Layout &spn, const class SPReg *spReg, class NuxLH &nux);
+  template<typename Layout> bool SplitNumMono(bool increasing, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool SplitNum(class SPCtg *spCtg, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool NumCtgDense(class SPCtg *spCtg, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool NumCtg(class SPCtg *spCtg, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> unsigned int NumCtgGini(SPCtg *spCtg, const Layout &spn, unsigned int idxNext, unsigned int idxFinal, unsigned int &sCountL, unsigned int &rkRight, double &sumL, double &ssL, double &ssR, double &maxGini, unsigned int &rankLH, unsigned int &rankRH, unsigned int &rhInf);
+  template<typename Layout> bool SplitNumApprox(const Layout &spn, int monoMode, class NuxLH &nux);
+  template<typename Layout> bool SampleReg(const Layout &spn, unsigned int strata, int monoMode, unsigned int &lhSup) const;
+  template<typename Layout> bool RefineReg(const Layout &spn, unsigned int lhSup, unsigned int width, int monoMode, class NuxLH &nux) const;
+  template<typename Layout> bool NumCtgApprox(class SPCtg *spCtg, const Layout &spn, class NuxLH &nux);
+  template<typename Layout> bool SampleCtg(const class SPCtg *spCtg, const Layout &spn, unsigned int strata, unsigned int &lhSup) const;
+  template<typename Layout> bool RefineCtg(class SPCtg *spCtg, const Layout &spn, unsigned int lhSup, unsigned int width, class NuxLH &nux);
+  template<typename Layout> bool CutRank(const Layout &spn, unsigned int denseRank, double ruCut, unsigned int &rankCut) const;
+  template<typename Layout> bool SplitNumExtra(const Layout &spn, unsigned int denseRank, double ruCut, int monoMode, class NuxLH &nux) const;
+  template<typename Layout> bool NumCtgExtra(const class SPCtg *spCtg, const Layout &spn, double ruCut, class NuxLH &nux) const;
+  template<typename Layout> bool RegScan(const Layout &spn, int idxNext, int idxFinal, int monoMode, unsigned int &rkRight, double &sumR, unsigned int &sCountL, double &maxInfo, unsigned int &lhSampCt, unsigned int &lhSup, unsigned int &rankLH, unsigned int &rankRH) const;
+  template<typename Layout> void SplitFac(const class SPReg *splitReg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> void SplitFac(const class SPCtg *splitCtg, const class Bottom *bottom, const Layout &spn);
+  template<typename Layout> bool SplitFac(const class SPReg *spReg, const Layout &spn, unsigned int &runCount, class NuxLH &nux);
+  template<typename Layout> bool SplitFac(const class SPCtg *spCtg, const Layout &spn, unsigned int &runCount, class NuxLH &nux);
   bool SplitBinary(const class SPCtg *spCtg, class RunSet *runSet, class NuxLH &nux);
   bool SplitRuns(const class SPCtg *spCtg, class RunSet *runSet, class NuxLH &nux);
-
-  unsigned int RunsReg(class RunSet *runSet, const class SPNode spn[], unsigned int denseRank) const;
-  bool HeapSplit(class RunSet *runSet, class NuxLH &nux) const;
-  unsigned int RunsCtg(const class SPCtg *spCtg, class RunSet *runSet, const SPNode spn[]) const;
+  bool SplitWide(const class SPCtg *spCtg, class RunSet *runSet, class NuxLH &nux);
+
+  template<typename Layout> unsigned int RunsReg(class RunSet *runSet, const Layout &spn, unsigned int denseRank) const;
+  void SplitMulti(const class SPReg *spReg, const class Bottom *bottom, const class SamplePred *samplePred);
+  template<typename Layout> void SplitMultiLayout(const class SPReg *spReg, const class Bottom *bottom, const Layout &spn, const unsigned int sIdx[]);
+  template<typename Layout> bool SplitNumMulti(const class SPReg *spReg, const Layout &spn, const unsigned int sIdx[], class NuxLH &nux) const;
+  template<typename Layout> bool SplitFacMulti(const class SPReg *spReg, const Layout &spn, const unsigned int sIdx[], unsigned int &runCount, class NuxLH &nux) const;
+  template<typename Layout> unsigned int RunsMulti(const class SPReg *spReg, class RunSet *runSet, const Layout &spn, const unsigned int sIdx[]) const;
+  bool HeapSplit(class RunSet *runSet, class NuxLH &nux, int slotDraw = -1) const;
+  template<typename Layout> unsigned int RunsCtg(const class SPCtg *spCtg, class RunSet *runSet, const Layout &spn) const;
 };
 
 
@@ -75,9 +163,11 @@ class SplitCoord {
 // type of predictor:  { regression, categorical } x { numeric, factor }.
 //
 class SplitPred {
-  const class RowRank *rowRank;
-  static unsigned int predFixed;
-  static const double *predProb;
+  const unsigned int predFixed;
+  const double *predProb;
+  const bool extraTrees; // Whether a single cut is drawn per pair.
+  const unsigned int approxMin; // Extent scanned approximately:  zero iff none.
+  std::vector<double> ruCut; // Per-pair cut variates:  extra trees only.
 
   void SetPrebias(class IndexLevel &level);
   void SplitFlags(bool unsplitable[]);
@@ -86,19 +176,29 @@ class SplitPred {
   bool ScheduleSplit(unsigned int levelIdx, unsigned int predIdx, std::vector<unsigned int> &safeCount);
   
  protected:
+  const class TrainCtx *ctx;
   const class PMTrain *pmTrain;
-  static unsigned int nPred;
+  const class RowRank *rowRank;
+  const unsigned int segWidth; // Indices per scan segment.
+  const unsigned int segMin; // Narrowest segmented scan:  twice the width.
+  const unsigned int nPred;
   const unsigned int bagCount;
+  const unsigned int tIdx; // Absolute tree index, keying variates.
+  const unsigned int subKey; // Subtree root, keying variates:  zero iff tree proper.
+  unsigned int level; // Current level, keying variates.
   class Bottom *bottom;
   unsigned int levelCount; // # subtree nodes at current level.
   class Run *run;
   std::vector<SplitCoord> splitCoord; // Schedule of splits.
+  std::vector<unsigned int> taskPos; // Coordinates split as single tasks.
+  std::vector<unsigned int> taskCost; // Estimated cost of each task.
+  std::vector<ScanSeg> scanSeg; // Segments of wide scans, following tasks.
+  std::vector<unsigned int> segCoord; // Coordinates scanned by segment.
+  std::vector<unsigned int> segStart; // First segment of each such coordinate.
   void Splitable(const std::vector<bool> &unsplitable, std::vector<unsigned int> &safeCount);
  public:
   class SamplePred *samplePred;
-  SplitPred(const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, unsigned int bagCount);
-  static void Immutables(unsigned int _nPred, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[]);
-  static void DeImmutables();
+  SplitPred(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, unsigned int bagCount, unsigned int _tIdx, unsigned int _subKey);
   unsigned int DenseRank(unsigned int predIdx) const;
   bool IsFactor(unsigned int predIdx) const;
   unsigned int NumIdx(unsigned int predIdx) const;
@@ -113,7 +213,83 @@ class SplitPred {
     bottom = _bottom;
   }
 
-  virtual void Split(const class IndexLevel &index) = 0;
+
+  static const unsigned int approxStrata = 256; // Subsample size of approximate scans.
+  static const unsigned int approxFloor = 8 * approxStrata; // Narrowest approximate scan.
+
+  inline bool ExtraTrees() const {
+    return extraTrees;
+  }
+
+
+  inline unsigned int ApproxMin() const {
+    return approxMin;
+  }
+
+
+  /**
+     @brief Accessor for a pair's cut variate.
+
+     @param splitPos is the pair's position in the schedule.
+
+     @return uniform variate drawn for the pair, extra trees only.
+   */
+  inline double CutVariate(unsigned int splitPos) const {
+    return ruCut[splitPos];
+  }
+
+
+  /**
+     @brief Maps a uniform variate onto a random selection.
+
+     @param count is the number of items, assumed positive.
+
+     @return index of selected item.
+   */
+  static inline unsigned int Draw(unsigned int count, double ru) {
+    unsigned int idx = ru * count;
+    return idx < count ? idx : count - 1;
+  }
+
+  void Split(const class IndexLevel &index);
+  virtual void Split(unsigned int splitPos) = 0;
+  void SplitPrepare(const class IndexLevel &index);
+  void SplitTask(unsigned int taskIdx);
+  void SplitReduce();
+
+
+  /**
+     @brief Determines whether a coordinate is scanned by segment.
+     Base implementation never segments, so consults neither the
+     coordinate nor the monotonicity output.
+
+     @return true iff the coordinate's scan is to be segmented.
+   */
+  virtual bool Segmentable(const SplitCoord &, int &) const {
+    return false;
+  }
+
+
+  /**
+     @brief Accessor for the size of the level's task list.
+
+     @return count of split tasks, including scan segments.
+   */
+  inline unsigned int TaskCount() const {
+    return taskCost.size();
+  }
+
+
+  /**
+     @brief Accessor for a task's estimated cost.
+
+     @return cost estimate, in units of buffer indices visited.
+   */
+  inline unsigned int TaskCost(unsigned int taskIdx) const {
+    return taskCost[taskIdx];
+  }
+
+  virtual SplitPred *Spawn(class SamplePred *_samplePred, const std::vector<class SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int _subKey) const = 0;
   
   virtual ~SplitPred();
   virtual void LevelInit(class IndexLevel &index);
@@ -128,24 +304,60 @@ class SplitPred {
    @brief Splitting facilities specific regression trees.
  */
 class SPReg : public SplitPred {
-  static unsigned int predMono;
-  static const double *feMono;
+  const unsigned int predMono;
   double *ruMono;
-
-  void Split(const class IndexLevel &index);
+  const unsigned int nOut; // # response outputs:  unity unless multi-output.
+  std::vector<double> sumLocal; // Subtrees only:  output sums in local order.
+  const double *sumOut; // Per-sample output sums:  null iff single output.
+  std::vector<double> idxOut; // Per-level output sums, by buffered index.
+  std::vector<double> nodeOut; // Per-level output sums, by node.
 
  public:
-  unsigned int Residuals(const SPNode spn[], unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, unsigned int &denseLeft, unsigned int &denseRight, double &sumDense, unsigned int &sCountDense) const;
-  static void Immutables(unsigned int _nPred, const double *_mono);
-  static void DeImmutables();
-  SPReg(const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, unsigned int bagCount);
+  template<typename Layout> unsigned int Residuals(const Layout &spn, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, unsigned int &denseLeft, unsigned int &denseRight, double &sumDense, unsigned int &sCountDense) const;
+  SPReg(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, unsigned int bagCount, unsigned int _tIdx, unsigned int _subKey = 0, unsigned int _nOut = 1, const double _sumOut[] = 0);
   ~SPReg();
+  SplitPred *Spawn(class SamplePred *_samplePred, const std::vector<class SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int _subKey) const;
+  void Split(unsigned int splitPos);
+  bool Segmentable(const SplitCoord &coord, int &monoMode) const;
   int MonoMode(unsigned int splitIdx, unsigned int predIdx) const;
   void RunOffsets(const std::vector<unsigned int> &safeCount);
   void LevelPreset(const class IndexLevel &index, std::vector<bool> &unsplitable);
   double Prebias(const class IndexLevel &index, unsigned int spiltIdx);
   void LevelInit(class IndexLevel &index);
   void LevelClear();
+
+
+  /**
+     @brief Accessor for output count.
+   */
+  inline unsigned int NOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @brief Looks up the output sums of a buffered index.  Multi-output
+     only.
+
+     @param bufIdx is an index recorded in the staging buffers.
+
+     @return row of output sums.
+   */
+  inline const double *IdxOut(unsigned int bufIdx) const {
+    return &idxOut[bufIdx * nOut];
+  }
+
+
+  /**
+     @brief Looks up the output sums of a node.  Multi-output only.
+
+     @param levelIdx is the level-relative node index.
+
+     @return row of output sums.
+   */
+  inline const double *NodeOut(unsigned int levelIdx) const {
+    return &nodeOut[levelIdx * nOut];
+  }
 };
 
 
@@ -158,7 +370,8 @@ class SPCtg : public SplitPred {
   static constexpr double minSumL = 1.0e-8;
   static constexpr double minSumR = 1.0e-5;
 
-  static unsigned int ctgWidth;
+  const unsigned int ctgWidth;
+  const unsigned int ctgShift; // Packing width of response in SPNode.
   std::vector<double> sumSquares; // Per-level sum of squares, by split.
   std::vector<double> ctgSum; // Per-level sum, by split/category pair.
   std::vector<double> ctgSumAccum; // Numeric predictors:  accumulate sums.
@@ -166,18 +379,17 @@ class SPCtg : public SplitPred {
   void LevelPreset(const class IndexLevel &index, std::vector<bool> &unsplitable);
   double Prebias(const class IndexLevel &index, unsigned int levelIdx);
   void LevelClear();
-  void Split(const class IndexLevel &index);
   void RunOffsets(const std::vector<unsigned int> &safeCount);
   unsigned int LHBits(unsigned int lhBits, unsigned int pairOffset, unsigned int depth, unsigned int &lhSampCt);
   void LevelInitSumR(unsigned int nPredNum);
 
 
  public:
-  SPCtg(const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, const std::vector<class SampleNode> &_sampleCtg, unsigned int bagCount);
+  SPCtg(const class TrainCtx *_ctx, const class PMTrain *_pmTrain, const class RowRank *_rowRank, class SamplePred *_samplePred, const std::vector<class SampleNode> &_sampleCtg, unsigned int bagCount, unsigned int _tIdx, unsigned int _subKey = 0);
   ~SPCtg();
-  static void Immutables(unsigned int _ctgWidth);
-  static void DeImmutables();
-  unsigned int Residuals(const SPNode spn[], unsigned int levelIdx, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, bool &denseLeft, bool &denseRight, double &sumDense, unsigned int &sCountDense, std::vector<double> &ctgSumDense) const;
+  SplitPred *Spawn(class SamplePred *_samplePred, const std::vector<class SampleNode> &stageSample, const std::vector<unsigned int> &local2ST, unsigned int _subKey) const;
+  void Split(unsigned int splitPos);
+  template<typename Layout> unsigned int Residuals(const Layout &spn, unsigned int levelIdx, unsigned int idxStart, unsigned int idxEnd, unsigned int denseRank, bool &denseLeft, bool &denseRight, double &sumDense, unsigned int &sCountDense, std::vector<double> &ctgSumDense) const;
   void ApplyResiduals(unsigned int levelIdx, unsigned int predIdx, double &ssL, double &ssr, std::vector<double> &sumDenseCtg);
   /**
      @brief Determine whether a pair of square-sums is acceptably stable
@@ -196,6 +408,14 @@ class SPCtg : public SplitPred {
   inline bool StableDenoms(double sumL, double sumR) const {
     return sumL > minDenom && sumR > minDenom;
   }
+
+
+  /**
+     @brief Exposes the stability threshold to vectorized gain evaluation.
+   */
+  static inline double MinDenom() {
+    return minDenom;
+  }
   
 
   /**
@@ -244,12 +464,20 @@ class SPCtg : public SplitPred {
   }
 
 
-  static inline unsigned int CtgWidth() {
+  inline unsigned int CtgWidth() const {
     return ctgWidth;
   }
 
+
+  /**
+     @return packing width of category values in SPNode.
+   */
+  inline unsigned int CtgShift() const {
+    return ctgShift;
+  }
+
   
-  double SumSquares(unsigned int levelIdx) {
+  double SumSquares(unsigned int levelIdx) const {
     return sumSquares[levelIdx];
   }
 };
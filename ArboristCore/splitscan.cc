@@ -0,0 +1,371 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file splitscan.cc
+
+   @brief Serial and vector kernels evaluating numerical cut points.
+
+   @author Mark Seligman
+ */
+
+#include "splitscan.h"
+#include "param.h"
+
+#include <cmath>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ARBORIST_SPLITSCAN_X86
+#include <immintrin.h>
+// Serial evaluation is inlined into the vector kernels, and so encoded
+// in kind, to avoid penalties on transition between instruction sets.
+#define SCAN_INLINE inline __attribute__((always_inline))
+#else
+#define SCAN_INLINE inline
+#endif
+
+//#include <iostream>
+//using namespace std;
+
+
+// Relative margins by which screening undercuts the running maximum.
+// Cross-multiplied gains differ from divided gains by a few units in the
+// last place.  Gini gains are, moreover, rounded to single precision.
+static const double regSlack = 1.0e-9;
+static const double ctgSlack = 1.0e-6;
+
+
+/**
+   @return value beyond which screening admits candidates.
+ */
+static inline double Bound(double maxInfo, double slack) {
+  return maxInfo - std::fabs(maxInfo) * slack;
+}
+
+
+/**
+   @brief Exact evaluation, in walk order, as performed by the original
+   serial walk.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+static SCAN_INLINE unsigned int RegEval(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo) {
+  unsigned int argMax = cutCount;
+  for (unsigned int cut = 0; cut < cutCount; cut++) {
+    if (rank[cut] != (rank - 1)[cut]) {
+      unsigned int sCountR = sCount - sCountL[cut];
+      double sumL = sum - sumR[cut];
+      double gini = (sumL * sumL) / sCountL[cut] + (sumR[cut] * sumR[cut]) / sCountR;
+      bool up = (sumL * sCountR <= sumR[cut] * sCountL[cut]);
+      if (gini > maxInfo && (monoMode == 0 || (monoMode > 0 ? up : !up))) {
+        maxInfo = gini;
+        argMax = cut;
+      }
+    }
+  }
+
+  return argMax;
+}
+
+
+/**
+   @brief Exact Gini evaluation.  Gains are rounded to single precision,
+   as in the original serial walk.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+static SCAN_INLINE unsigned int CtgEval(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo) {
+  unsigned int argMax = cutCount;
+  for (unsigned int cut = 0; cut < cutCount; cut++) {
+    FltVal sumR = sum - sumL[cut];
+    if (rank[cut] != (rank - 1)[cut] && sumL[cut] > minDenom && sumR > minDenom) {
+      FltVal gini = ssL[cut] / sumL[cut] + ssR[cut] / sumR;
+      if (gini > maxInfo) {
+        maxInfo = gini;
+        argMax = cut;
+      }
+    }
+  }
+
+  return argMax;
+}
+
+
+unsigned int SplitScan::RegSerial(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo) {
+  return RegEval(sumR, sCountL, rank, cutCount, sum, sCount, monoMode, maxInfo);
+}
+
+
+unsigned int SplitScan::CtgSerial(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo) {
+  return CtgEval(ssL, ssR, sumL, rank, cutCount, sum, minDenom, maxInfo);
+}
+
+
+#ifdef ARBORIST_SPLITSCAN_X86
+/**
+   @brief Screens four cuts per iteration.  Counts are converted as
+   signed values, a range sample counts do not approach.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+__attribute__((target("avx2"))) static unsigned int RegAVX2(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo) {
+  const __m256d vSum = _mm256_set1_pd(sum);
+  const __m128i vCount = _mm_set1_epi32(sCount);
+  __m256d vBound = _mm256_set1_pd(Bound(maxInfo, regSlack));
+  unsigned int argMax = cutCount;
+  unsigned int cut = 0;
+  for (; cut + 4 <= cutCount; cut += 4) {
+    __m128i tied = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rank + cut)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(rank + cut - 1)));
+    int candidate = ~_mm_movemask_ps(_mm_castsi128_ps(tied)) & 0xf;
+    if (candidate == 0)
+      continue;
+
+    __m256d sR = _mm256_loadu_pd(sumR + cut);
+    __m256d sL = _mm256_sub_pd(vSum, sR);
+    __m128i countL = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sCountL + cut));
+    __m256d cL = _mm256_cvtepi32_pd(countL);
+    __m256d cR = _mm256_cvtepi32_pd(_mm_sub_epi32(vCount, countL));
+    __m256d prodL = _mm256_mul_pd(sL, cR);
+    __m256d prodR = _mm256_mul_pd(sR, cL);
+    __m256d num = _mm256_add_pd(_mm256_mul_pd(sL, prodL), _mm256_mul_pd(sR, prodR));
+    candidate &= _mm256_movemask_pd(_mm256_cmp_pd(num, _mm256_mul_pd(vBound, _mm256_mul_pd(cL, cR)), _CMP_GT_OQ));
+    if (monoMode > 0) {
+      candidate &= _mm256_movemask_pd(_mm256_cmp_pd(prodL, prodR, _CMP_LE_OQ));
+    }
+    else if (monoMode < 0) {
+      candidate &= _mm256_movemask_pd(_mm256_cmp_pd(prodL, prodR, _CMP_NLE_UQ));
+    }
+
+    if (candidate != 0) {
+      unsigned int laneMax = RegEval(sumR + cut, sCountL + cut, rank + cut, 4, sum, sCount, monoMode, maxInfo);
+      if (laneMax < 4) {
+        argMax = cut + laneMax;
+        vBound = _mm256_set1_pd(Bound(maxInfo, regSlack));
+      }
+    }
+  }
+  unsigned int tailMax = RegEval(sumR + cut, sCountL + cut, rank + cut, cutCount - cut, sum, sCount, monoMode, maxInfo);
+  _mm256_zeroupper();
+
+  return tailMax < cutCount - cut ? cut + tailMax : argMax;
+}
+
+
+/**
+   @brief Screens four cuts per iteration.  Both denominators exceed
+   'minDenom' for eligible cuts, so cross-multiplication preserves order.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+__attribute__((target("avx2"))) static unsigned int CtgAVX2(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo) {
+  const __m256d vSum = _mm256_set1_pd(sum);
+  const __m256d vMin = _mm256_set1_pd(minDenom);
+  __m256d vBound = _mm256_set1_pd(Bound(maxInfo, ctgSlack));
+  unsigned int argMax = cutCount;
+  unsigned int cut = 0;
+  for (; cut + 4 <= cutCount; cut += 4) {
+    __m128i tied = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rank + cut)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(rank + cut - 1)));
+    int candidate = ~_mm_movemask_ps(_mm_castsi128_ps(tied)) & 0xf;
+    if (candidate == 0)
+      continue;
+
+    __m256d sL = _mm256_loadu_pd(sumL + cut);
+    __m256d sR = _mm256_cvtps_pd(_mm256_cvtpd_ps(_mm256_sub_pd(vSum, sL)));
+    __m256d stable = _mm256_and_pd(_mm256_cmp_pd(sL, vMin, _CMP_GT_OQ), _mm256_cmp_pd(sR, vMin, _CMP_GT_OQ));
+    __m256d num = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(ssL + cut), sR), _mm256_mul_pd(_mm256_loadu_pd(ssR + cut), sL));
+    __m256d improving = _mm256_cmp_pd(num, _mm256_mul_pd(vBound, _mm256_mul_pd(sL, sR)), _CMP_GT_OQ);
+    candidate &= _mm256_movemask_pd(_mm256_and_pd(stable, improving));
+
+    if (candidate != 0) {
+      unsigned int laneMax = CtgEval(ssL + cut, ssR + cut, sumL + cut, rank + cut, 4, sum, minDenom, maxInfo);
+      if (laneMax < 4) {
+        argMax = cut + laneMax;
+        vBound = _mm256_set1_pd(Bound(maxInfo, ctgSlack));
+      }
+    }
+  }
+  unsigned int tailMax = CtgEval(ssL + cut, ssR + cut, sumL + cut, rank + cut, cutCount - cut, sum, minDenom, maxInfo);
+  _mm256_zeroupper();
+
+  return tailMax < cutCount - cut ? cut + tailMax : argMax;
+}
+
+
+/**
+   @brief Rounds lanes to single precision.  Masked conversions avoid
+   reading an undefined source register.
+ */
+__attribute__((target("avx512f"))) static inline __m512d Single512(__m512d x) {
+  return _mm512_mask_cvtps_pd(_mm512_setzero_pd(), 0xff, _mm512_mask_cvtpd_ps(_mm256_setzero_ps(), 0xff, x));
+}
+
+
+/**
+   @brief Widens unsigned counts, masked as above.
+ */
+__attribute__((target("avx512f"))) static inline __m512d Count512(__m256i x) {
+  return _mm512_mask_cvtepu32_pd(_mm512_setzero_pd(), 0xff, x);
+}
+
+
+/**
+   @brief Screens eight cuts per iteration.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+__attribute__((target("avx512f"))) static unsigned int RegAVX512(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo) {
+  const __m512d vSum = _mm512_set1_pd(sum);
+  const __m256i vCount = _mm256_set1_epi32(sCount);
+  __m512d vBound = _mm512_set1_pd(Bound(maxInfo, regSlack));
+  unsigned int argMax = cutCount;
+  unsigned int cut = 0;
+  for (; cut + 8 <= cutCount; cut += 8) {
+    __m256i tied = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rank + cut)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rank + cut - 1)));
+    __mmask8 candidate = ~_mm256_movemask_ps(_mm256_castsi256_ps(tied)) & 0xff;
+    if (candidate == 0)
+      continue;
+
+    __m512d sR = _mm512_loadu_pd(sumR + cut);
+    __m512d sL = _mm512_sub_pd(vSum, sR);
+    __m256i countL = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sCountL + cut));
+    __m512d cL = Count512(countL);
+    __m512d cR = Count512(_mm256_sub_epi32(vCount, countL));
+    __m512d prodL = _mm512_mul_pd(sL, cR);
+    __m512d prodR = _mm512_mul_pd(sR, cL);
+    __m512d num = _mm512_add_pd(_mm512_mul_pd(sL, prodL), _mm512_mul_pd(sR, prodR));
+    candidate &= _mm512_cmp_pd_mask(num, _mm512_mul_pd(vBound, _mm512_mul_pd(cL, cR)), _CMP_GT_OQ);
+    if (monoMode > 0) {
+      candidate &= _mm512_cmp_pd_mask(prodL, prodR, _CMP_LE_OQ);
+    }
+    else if (monoMode < 0) {
+      candidate &= _mm512_cmp_pd_mask(prodL, prodR, _CMP_NLE_UQ);
+    }
+
+    if (candidate != 0) {
+      unsigned int laneMax = RegEval(sumR + cut, sCountL + cut, rank + cut, 8, sum, sCount, monoMode, maxInfo);
+      if (laneMax < 8) {
+        argMax = cut + laneMax;
+        vBound = _mm512_set1_pd(Bound(maxInfo, regSlack));
+      }
+    }
+  }
+  unsigned int tailMax = RegEval(sumR + cut, sCountL + cut, rank + cut, cutCount - cut, sum, sCount, monoMode, maxInfo);
+  _mm256_zeroupper();
+
+  return tailMax < cutCount - cut ? cut + tailMax : argMax;
+}
+
+
+/**
+   @brief Screens eight cuts per iteration.
+
+   @return position of the last improving cut, else 'cutCount'.
+ */
+__attribute__((target("avx512f"))) static unsigned int CtgAVX512(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo) {
+  const __m512d vSum = _mm512_set1_pd(sum);
+  const __m512d vMin = _mm512_set1_pd(minDenom);
+  __m512d vBound = _mm512_set1_pd(Bound(maxInfo, ctgSlack));
+  unsigned int argMax = cutCount;
+  unsigned int cut = 0;
+  for (; cut + 8 <= cutCount; cut += 8) {
+    __m256i tied = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rank + cut)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rank + cut - 1)));
+    __mmask8 candidate = ~_mm256_movemask_ps(_mm256_castsi256_ps(tied)) & 0xff;
+    if (candidate == 0)
+      continue;
+
+    __m512d sL = _mm512_loadu_pd(sumL + cut);
+    __m512d sR = Single512(_mm512_sub_pd(vSum, sL));
+    candidate &= _mm512_cmp_pd_mask(sL, vMin, _CMP_GT_OQ) & _mm512_cmp_pd_mask(sR, vMin, _CMP_GT_OQ);
+    __m512d num = _mm512_add_pd(_mm512_mul_pd(_mm512_loadu_pd(ssL + cut), sR), _mm512_mul_pd(_mm512_loadu_pd(ssR + cut), sL));
+    candidate &= _mm512_cmp_pd_mask(num, _mm512_mul_pd(vBound, _mm512_mul_pd(sL, sR)), _CMP_GT_OQ);
+
+    if (candidate != 0) {
+      unsigned int laneMax = CtgEval(ssL + cut, ssR + cut, sumL + cut, rank + cut, 8, sum, minDenom, maxInfo);
+      if (laneMax < 8) {
+        argMax = cut + laneMax;
+        vBound = _mm512_set1_pd(Bound(maxInfo, ctgSlack));
+      }
+    }
+  }
+  unsigned int tailMax = CtgEval(ssL + cut, ssR + cut, sumL + cut, rank + cut, cutCount - cut, sum, minDenom, maxInfo);
+  _mm256_zeroupper();
+
+  return tailMax < cutCount - cut ? cut + tailMax : argMax;
+}
+#endif
+
+
+const unsigned int SplitScan::blockSize;
+SplitScan::RegKernel SplitScan::regKernel = SplitScan::RegSerial;
+SplitScan::CtgKernel SplitScan::ctgKernel = SplitScan::CtgSerial;
+unsigned int SplitScan::laneCount = 0;
+const char *SplitScan::kernelName = "serial";
+const bool SplitScan::selected = SplitScan::Select();
+
+
+/**
+   @brief Selects the widest kernel supported by the host.  Invoked once,
+   during static initialization.  Serial evaluation is in place until
+   then.
+
+   @return true.
+ */
+bool SplitScan::Select() {
+  if (!Use("avx512"))
+    Use("avx2");
+
+  return true;
+}
+
+
+/**
+   @brief Overrides the kernel in use, as for testing or benchmarking.
+   The selection is process-wide, so must not change while any training
+   is in progress.
+
+   @param name is one of "serial", "avx2" or "avx512".
+
+   @return true iff the kernel is known and supported by the host, else
+   false with the selection unchanged.
+ */
+bool SplitScan::Use(const char *name) {
+  if (std::strcmp(name, "serial") == 0) {
+    regKernel = RegSerial;
+    ctgKernel = CtgSerial;
+    laneCount = 0;
+    kernelName = "serial";
+    return true;
+  }
+#ifdef ARBORIST_SPLITSCAN_X86
+  __builtin_cpu_init();
+  if (std::strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")) {
+    regKernel = RegAVX512;
+    ctgKernel = CtgAVX512;
+    laneCount = 8;
+    kernelName = "avx512";
+    return true;
+  }
+  if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+    regKernel = RegAVX2;
+    ctgKernel = CtgAVX2;
+    laneCount = 4;
+    kernelName = "avx2";
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+
+/**
+   @return name of the kernel in use.
+ */
+const char *SplitScan::Kernel() {
+  return kernelName;
+}
@@ -0,0 +1,123 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file splitscan.h
+
+   @brief Class definitions for vectorized evaluation of numerical cut
+   points.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_SPLITSCAN_H
+#define ARBORIST_SPLITSCAN_H
+
+/**
+   @brief Evaluates the splitting criterion over a block of candidate cuts.
+
+   Splitting walks a node's indices backward, accumulating response sums
+   and sample counts.  The accumulation is inherently serial, and is
+   retained in walk order so that sums round exactly as before.  The
+   walker records the accumulators of each cut, together with the rank
+   to its left, and hands them here a block at a time.
+
+   The vector kernels screen several cuts to a register without dividing:
+   a cut is a candidate only if its gain, cross-multiplied by its
+   denominators, could exceed the running maximum.  Cuts separating tied
+   ranks, or violating a monotonicity constraint, are masked out.  Only
+   the rare candidates are then evaluated exactly, serially and in order,
+   so that the result is identical to that of the scalar walk.
+
+   The kernel is chosen once, at load time, from the instruction sets
+   supported by the host, but may be overridden by name so that each
+   kernel can be checked against the others.  Blocks having mostly tied
+   cuts gain little from screening and are evaluated serially.
+ */
+class SplitScan {
+  typedef unsigned int (*RegKernel)(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo);
+  typedef unsigned int (*CtgKernel)(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo);
+
+  static RegKernel regKernel;
+  static CtgKernel ctgKernel;
+  static unsigned int laneCount; // Zero iff no vector kernel.
+  static const char *kernelName;
+
+  static bool Select();
+  static const bool selected;
+
+ public:
+  static const unsigned int blockSize = 64; // Cuts per evaluation.
+  static const unsigned int serialMax = 32; // Walks this short remain fused.
+
+  static unsigned int RegSerial(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, double sum, unsigned int sCount, int monoMode, double &maxInfo);
+  static unsigned int CtgSerial(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, double sum, double minDenom, double &maxInfo);
+  static const char *Kernel();
+  static bool Use(const char *name);
+
+
+  /**
+     @brief Determines whether screening a block is worthwhile.
+
+     @param cutCount is the number of cuts in the block.
+
+     @param liveCount is the number of cuts separating distinct ranks.
+
+     @return true iff the block should be screened by the vector kernel.
+   */
+  static inline bool Screen(unsigned int cutCount, unsigned int liveCount) {
+    return laneCount > 0 && cutCount >= 2 * laneCount && 2 * liveCount >= cutCount;
+  }
+
+
+  /**
+     @brief Evaluates weighted-variance gain over a block of cuts.
+
+     @param sumR holds the response sum to the right of each cut.
+
+     @param sCountL holds the sample count to the left of each cut.
+
+     @param rank holds the rank to the left of each cut.  The rank to
+     the right of the first cut is at position -1.
+
+     @param cutCount is the number of cuts in the block.
+
+     @param liveCount is the number of cuts separating distinct ranks.
+
+     @param sum is the node's response sum.
+
+     @param sCount is the node's sample count.
+
+     @param monoMode is positive (negative) iff the left mean must not
+     exceed (fall below) the right mean, else zero.
+
+     @param maxInfo inputs the running maximum and outputs its update.
+
+     @return position of the last improving cut, if any, else 'cutCount'.
+   */
+  static inline unsigned int ArgMaxReg(const double sumR[], const unsigned int sCountL[], const unsigned int rank[], unsigned int cutCount, unsigned int liveCount, double sum, unsigned int sCount, int monoMode, double &maxInfo) {
+    return Screen(cutCount, liveCount) ? regKernel(sumR, sCountL, rank, cutCount, sum, sCount, monoMode, maxInfo) : RegSerial(sumR, sCountL, rank, cutCount, sum, sCount, monoMode, maxInfo);
+  }
+
+
+  /**
+     @brief Evaluates Gini gain over a block of cuts.
+
+     @param ssL, ssR hold the left, right sums of squares at each cut.
+
+     @param sumL holds the response sum to the left of each cut.
+
+     @param minDenom is the least stable denominator.
+
+     @return position of the last improving cut, if any, else 'cutCount'.
+   */
+  static inline unsigned int ArgMaxCtg(const double ssL[], const double ssR[], const double sumL[], const unsigned int rank[], unsigned int cutCount, unsigned int liveCount, double sum, double minDenom, double &maxInfo) {
+    return Screen(cutCount, liveCount) ? ctgKernel(ssL, ssR, sumL, rank, cutCount, sum, minDenom, maxInfo) : CtgSerial(ssL, ssR, sumL, rank, cutCount, sum, minDenom, maxInfo);
+  }
+};
+
+#endif
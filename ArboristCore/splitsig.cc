@@ -29,32 +29,9 @@
    pass one (splitting) through argmax pass two.
 */
 
-double SSNode::minRatio = 0.0;
-
 // TODO:  Economize on width (nPred) here et seq.
 //
 
-/**
-   @brief Sets immutable static values.
-
-   @param _minRatio is an inf information content for splitting.  Must
-   be non-negative, as otherwise ArgMax cannot distinguish splitting
-   candidates from unset SSNodes, which have initial 'info' == 0.
-
-   @return void.
- */
-void SplitSig::Immutables(double _minRatio) {
-  SSNode::minRatio = _minRatio;
-}
-
-
-/**
-   @brief Finalizer.
-*/  
-void SplitSig::DeImmutables() {
-  SSNode::minRatio = 0.0;
-}
-
 
 /**
    @brief Sets splitting fields for a splitting predictor.
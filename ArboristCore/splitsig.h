@@ -85,8 +85,6 @@ class SSNode {
   unsigned int lhImplicit; // LHS implicit index count:  numeric only.
   unsigned char bufIdx;
   
-  static double minRatio;
-  
   // Ideally, there would be SplitSigFac and SplitSigNum subclasses, with
   // Replay() and NonTerminal() methods implemented virtually.  Coprocessor
   // may not support virtual invocation, however, so we opt for a less
@@ -96,9 +94,11 @@ class SSNode {
   /**
    @brief Derives an information threshold.
 
+   @param minRatio is the threshold ratio of successor to parent information.
+
    @return information threshold
   */
-  double inline MinInfo() {
+  double inline MinInfo(double minRatio) {
     return minRatio * info;
   }
 
@@ -155,9 +155,6 @@ class SplitSig {
  SplitSig(unsigned int _nPred) : nPred(_nPred), splitCount(0), levelSS(0) {
   }
 
-  static void Immutables(double _minRatio);
-  static void DeImmutables();
-
   SSNode *ArgMax(unsigned int levelIdx, double gainMax) const;
   void LevelInit(unsigned int _splitCount);
   void LevelClear();
@@ -0,0 +1,100 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file subtree.cc
+
+   @brief Methods for completing small nodes as local subtrees.
+
+   @author Mark Seligman
+ */
+
+#include "subtree.h"
+#include "bottom.h"
+#include "index.h"
+#include "pretree.h"
+#include "sample.h"
+#include "samplepred.h"
+#include "trainctx.h"
+
+
+/**
+   @brief Stages a front-level node of the tree proper as the root of a
+   local subtree.  Cells are copied from the tree proper's buffers, which
+   must be current for every predictor.
+
+   @param parent is the bottom of the tree proper.
+
+   @param index holds the front-level nodes of the tree proper.
+
+   @param splitIdx is the level index of the node.
+
+   @param buf2Local is a workspace mapping buffered to local indices.
+
+   Only the node's own entries are written.
+ */
+Subtree::Subtree(const TrainCtx *ctx, const Bottom *parent, const IndexLevel &index, unsigned int splitIdx, std::vector<unsigned int> &buf2Local) : ptRoot(index.PTId(splitIdx)) {
+  index.Localize(splitIdx, parent->LevelFront()->NodeRel(), stageSample, local2ST, buf2Local);
+  unsigned int extent = stageSample.size();
+  samplePred = SamplePred::Factory(ctx->nPred, extent, 0, ctx->ctgShift, ctx->columnLayout);
+  bottom = parent->Spawn(samplePred, stageSample, local2ST, ptRoot);
+
+  unsigned int idxStart = index.StartIdx(splitIdx);
+  for (unsigned int predIdx = 0; predIdx < ctx->nPred; predIdx++) {
+    std::vector<StagePack> stagePack;
+    unsigned int denseCount;
+    unsigned int runCount = parent->Pack(splitIdx, predIdx, idxStart, extent, buf2Local, stagePack, denseCount);
+    samplePred->Allocate(predIdx, extent - denseCount);
+    samplePred->Stage(stagePack, predIdx);
+    bottom->RootDef(predIdx, denseCount, runCount);
+  }
+  preTree = 0;
+}
+
+
+/**
+   @brief Destructor.
+ */
+Subtree::~Subtree() {
+  delete preTree;
+  delete bottom;
+  delete samplePred;
+}
+
+
+/**
+   @brief Splits the subtree to completion.
+
+   Levels are numbered as in the tree proper, so that level limits
+   continue to apply.
+
+   @return void.
+ */
+void Subtree::Grow(const TrainCtx *ctx, const PMTrain *pmTrain, const IndexLevel &index, unsigned int splitIdx) {
+  unsigned int sCount;
+  double sum;
+  index.PrebiasFields(splitIdx, sCount, sum);
+
+  preTree = new PreTree(pmTrain, stageSample.size(), PreTree::HeightEst(stageSample.size(), ctx->minNode));
+  IndexLevel *local = new IndexLevel(ctx, pmTrain, stageSample, sCount, sum, index.Level(), index.MinInfo(splitIdx));
+  local->Levels(bottom, preTree);
+  delete local;
+
+  bottom->SubtreeFrontier(preTree);
+}
+
+
+/**
+   @brief Splices the completed subtree onto the tree proper.
+
+   @param ptParent is the pretree of the tree proper.
+
+   @return void.
+ */
+void Subtree::Graft(PreTree *ptParent) const {
+  ptParent->Graft(preTree, ptRoot, local2ST);
+}
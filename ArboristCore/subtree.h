@@ -0,0 +1,48 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file subtree.h
+
+   @brief Definitions for subtrees completed apart from the tree proper.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_SUBTREE_H
+#define ARBORIST_SUBTREE_H
+
+#include <vector>
+
+
+/**
+   @brief A node of the tree proper whose extent has fallen below the
+   handoff threshold, trained to completion in buffers sized to the node.
+
+   Late levels of a tree typically consist of many small nodes scattered
+   across bag-wide buffers.  Copying such a node's cells into its own,
+   cache-sized, SamplePred allows the remainder of its levels to proceed
+   without restaging the tree proper's buffers.  The subtree splits just
+   as the tree proper would, drawing variates from streams keyed by its
+   root, and is then grafted in place of the node.
+ */
+class Subtree {
+  const unsigned int ptRoot; // Pretree index of root within tree proper.
+  std::vector<class SampleNode> stageSample; // Samples, in local order.
+  std::vector<unsigned int> local2ST; // Local to tree-proper sample index.
+  class SamplePred *samplePred;
+  class Bottom *bottom;
+  class PreTree *preTree;
+
+ public:
+  Subtree(const class TrainCtx *ctx, const class Bottom *parent, const class IndexLevel &index, unsigned int splitIdx, std::vector<unsigned int> &buf2Local);
+  ~Subtree();
+  void Grow(const class TrainCtx *ctx, const class PMTrain *pmTrain, const class IndexLevel &index, unsigned int splitIdx);
+  void Graft(class PreTree *ptParent) const;
+};
+
+#endif
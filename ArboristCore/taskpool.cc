@@ -0,0 +1,265 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file taskpool.cc
+
+   @brief Methods for the persistent work-stealing task pool.
+
+   @author Mark Seligman
+ */
+
+#include "taskpool.h"
+
+#include <numeric>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+thread_local bool TaskPool::inTask = false;
+
+
+/**
+   @brief Appends a chunk to the back of the queue.
+
+   @return void.
+ */
+void TaskQueue::Push(unsigned int begin, unsigned int end) {
+  std::lock_guard<std::mutex> guard(lock);
+  chunk.push_back(std::make_pair(begin, end));
+}
+
+
+/**
+   @brief Takes the owner's next chunk.
+
+   @return true iff a chunk was available, with output range.
+ */
+bool TaskQueue::Pop(unsigned int &begin, unsigned int &end) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (chunk.empty())
+    return false;
+  begin = chunk.front().first;
+  end = chunk.front().second;
+  chunk.pop_front();
+  return true;
+}
+
+
+/**
+   @brief Takes a chunk on behalf of an idle peer.
+
+   @return true iff a chunk was available, with output range.
+ */
+bool TaskQueue::Steal(unsigned int &begin, unsigned int &end) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (chunk.empty())
+    return false;
+  begin = chunk.back().first;
+  end = chunk.back().second;
+  chunk.pop_back();
+  return true;
+}
+
+
+/**
+   @brief Constructor.  Launches the workers, which idle until a loop
+   is dispatched.
+
+   @param _nWorker is the number of participating threads, including
+   the caller.  Zero defaults to the OpenMP thread limit, if any, else
+   to the hardware concurrency.
+
+   @param _serialMax is the total loop cost below which a loop executes
+   serially.
+ */
+TaskPool::TaskPool(unsigned int _nWorker, size_t _serialMax) :
+  nWorker(_nWorker > 0 ? _nWorker :
+#ifdef _OPENMP
+          std::max(1, omp_get_max_threads())
+#else
+          std::max(1u, std::thread::hardware_concurrency())
+#endif
+          ),
+  serialMax(_serialMax),
+  queue(nWorker),
+  epoch(0),
+  exiting(false),
+  task(0),
+  chunkLeft(0) {
+  for (unsigned int workerIdx = 1; workerIdx < nWorker; workerIdx++) {
+    worker.emplace_back(&TaskPool::Worker, this, workerIdx);
+  }
+}
+
+
+/**
+   @brief Destructor.  Retires the workers.
+ */
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> guard(wakeLock);
+    exiting = true;
+  }
+  wake.notify_all();
+  for (auto & thr : worker) {
+    thr.join();
+  }
+}
+
+
+/**
+   @brief Idles until woken by a new loop, then drains.
+
+   @param workerIdx is the index of the worker's own queue.
+
+   @return void.
+ */
+void TaskPool::Worker(unsigned int workerIdx) {
+  inTask = true; // Loops issued by tasks run serially.
+  unsigned int seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> wait(wakeLock);
+      wake.wait(wait, [&] { return exiting || epoch != seen; });
+      if (exiting)
+        return;
+      seen = epoch;
+    }
+    Drain(workerIdx);
+  }
+}
+
+
+/**
+   @brief Executes chunks from the worker's own queue, then from those
+   of its peers, until none remain.
+
+   @return void.
+ */
+void TaskPool::Drain(unsigned int workerIdx) {
+  unsigned int begin, end;
+  while (true) {
+    bool found = queue[workerIdx].Pop(begin, end);
+    for (unsigned int off = 1; !found && off < nWorker; off++) {
+      found = queue[(workerIdx + off) % nWorker].Steal(begin, end);
+    }
+    if (!found)
+      return;
+
+    for (unsigned int pos = begin; pos < end; pos++) {
+      (*task)(order[pos]);
+    }
+    if (--chunkLeft == 0) {
+      std::lock_guard<std::mutex> guard(wakeLock);
+      done.notify_all();
+    }
+  }
+}
+
+
+/**
+   @brief Runs a loop of uniform-cost tasks.
+
+   @param nTask is the number of tasks.
+
+   @param _task is the loop body, invoked with the task index.
+
+   @param unitCost is the estimated cost of each task, in arbitrary
+   units commensurate with the serial threshold.
+
+   @return void.
+ */
+void TaskPool::Run(unsigned int nTask, const std::function<void(unsigned int)> &_task, unsigned int unitCost) {
+  size_t costTot = size_t(nTask) * unitCost;
+  std::unique_lock<std::mutex> busy(runLock, std::defer_lock);
+  if (nWorker == 1 || inTask || costTot < serialMax || nTask < 2 || !busy.try_lock()) {
+    for (unsigned int taskIdx = 0; taskIdx < nTask; taskIdx++) {
+      _task(taskIdx);
+    }
+    return;
+  }
+
+  order = std::vector<unsigned int>(nTask);
+  std::iota(order.begin(), order.end(), 0);
+  Dispatch(_task, std::vector<unsigned int>(nTask, unitCost), costTot);
+}
+
+
+/**
+   @brief Runs a loop of tasks having estimated costs.  Tasks are
+   dispatched in order of decreasing cost.
+
+   @param cost is the estimated cost of each task.
+
+   @param _task is the loop body, invoked with the task index.
+
+   @return void.
+ */
+void TaskPool::Run(const std::vector<unsigned int> &cost, const std::function<void(unsigned int)> &_task) {
+  size_t costTot = std::accumulate(cost.begin(), cost.end(), size_t(0));
+  std::unique_lock<std::mutex> busy(runLock, std::defer_lock);
+  if (nWorker == 1 || inTask || costTot < serialMax || cost.size() < 2 || !busy.try_lock()) {
+    for (unsigned int taskIdx = 0; taskIdx < cost.size(); taskIdx++) {
+      _task(taskIdx);
+    }
+    return;
+  }
+
+  order = std::vector<unsigned int>(cost.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&cost](unsigned int a, unsigned int b) { return cost[a] > cost[b]; });
+  Dispatch(_task, cost, costTot);
+}
+
+
+/**
+   @brief Chunks the dispatch order, deals the chunks over the queues
+   and participates in draining them.  Caller holds the run lock.
+
+   @param cost is the estimated cost of each task.
+
+   @param costTot is the sum of costs.
+
+   @return void, once all tasks have completed.
+ */
+void TaskPool::Dispatch(const std::function<void(unsigned int)> &_task, const std::vector<unsigned int> &cost, size_t costTot) {
+  size_t chunkCost = std::max(size_t(1), costTot / (nWorker * chunkPerWorker));
+  std::vector<unsigned int> chunkEnd;
+  size_t accum = 0;
+  for (unsigned int pos = 0; pos < order.size(); pos++) {
+    accum += cost[order[pos]];
+    if (accum >= chunkCost || pos + 1 == order.size()) {
+      chunkEnd.push_back(pos + 1);
+      accum = 0;
+    }
+  }
+
+  // Counts are set before any chunk becomes visible to a straggler.
+  {
+    std::lock_guard<std::mutex> guard(wakeLock);
+    task = &_task;
+    chunkLeft = chunkEnd.size();
+    unsigned int begin = 0;
+    for (unsigned int chunkIdx = 0; chunkIdx < chunkEnd.size(); chunkIdx++) {
+      queue[chunkIdx % nWorker].Push(begin, chunkEnd[chunkIdx]);
+      begin = chunkEnd[chunkIdx];
+    }
+    epoch++;
+  }
+  wake.notify_all();
+
+  inTask = true;
+  Drain(0);
+  inTask = false;
+
+  std::unique_lock<std::mutex> wait(wakeLock);
+  done.wait(wait, [&] { return chunkLeft == 0; });
+  task = 0;
+}
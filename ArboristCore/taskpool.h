@@ -0,0 +1,95 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file taskpool.h
+
+   @brief Definitions for the persistent work-stealing task pool.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_TASKPOOL_H
+#define ARBORIST_TASKPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+/**
+   @brief Per-worker queue of task chunks.  The owner takes from the
+   front, thieves from the back.
+ */
+class TaskQueue {
+  std::mutex lock;
+  std::deque<std::pair<unsigned int, unsigned int> > chunk; // Dispatch range.
+
+ public:
+  void Push(unsigned int begin, unsigned int end);
+  bool Pop(unsigned int &begin, unsigned int &end);
+  bool Steal(unsigned int &begin, unsigned int &end);
+};
+
+
+/**
+   @brief Worker threads persisting across levels, and across trees,
+   so that each parallel loop costs a wakeup rather than a fork/join.
+
+   Tasks are dealt out in chunks, round-robin over per-worker queues,
+   and idle workers steal from their peers.  When costs are supplied,
+   tasks are dispatched largest first and chunked so as to balance the
+   cost of each chunk.  Loops whose total cost falls below a threshold,
+   as well as loops issued from within a running loop or concurrently
+   with one, execute serially in the calling thread.
+ */
+class TaskPool {
+  static constexpr unsigned int chunkPerWorker = 8; // Chunks dealt per worker.
+  static constexpr size_t serialDefault = 4096; // Default serial threshold.
+  static thread_local bool inTask; // Whether thread is draining a loop.
+
+  const unsigned int nWorker; // Including the calling thread.
+  const size_t serialMax; // Total cost below which loops run serially.
+  std::vector<TaskQueue> queue;
+  std::vector<std::thread> worker;
+  std::mutex runLock; // Held by the loop in progress, if any.
+  std::mutex wakeLock;
+  std::condition_variable wake; // Signals workers of a new loop.
+  std::condition_variable done; // Signals caller of loop completion.
+  unsigned int epoch; // Loop count:  distinguishes wakeups.
+  bool exiting;
+  const std::function<void(unsigned int)> *task; // Body of current loop.
+  std::vector<unsigned int> order; // Dispatch order of current loop.
+  std::atomic<unsigned int> chunkLeft; // Chunks not yet completed.
+
+  void Worker(unsigned int workerIdx);
+  void Drain(unsigned int workerIdx);
+  void Dispatch(const std::function<void(unsigned int)> &_task, const std::vector<unsigned int> &cost, size_t costTot);
+
+ public:
+  TaskPool(unsigned int _nWorker = 0, size_t _serialMax = serialDefault);
+  ~TaskPool();
+
+  void Run(unsigned int nTask, const std::function<void(unsigned int)> &_task, unsigned int unitCost = 1);
+  void Run(const std::vector<unsigned int> &cost, const std::function<void(unsigned int)> &_task);
+
+
+  /**
+     @brief Accessor for worker count.
+
+     @return number of threads participating in a loop.
+   */
+  inline unsigned int NWorker() const {
+    return nWorker;
+  }
+};
+
+#endif
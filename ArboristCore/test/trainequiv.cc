@@ -0,0 +1,1087 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainequiv.cc
+
+   @brief Checks that training modes documented as exact reproduce the
+   reference regression and classification forests, that forests grown
+   from the core generator do not depend upon the thread count, that
+   rank quantization cuts only between bins, and that every split-scan
+   kernel supported by the host finds the same splits.  Local subtree
+   completion renumbers nodes, so is held to equivalence.  Randomized
+   cuts and approximate scans are held to reproducibility across
+   schedules, wide factors to an exact multiclass separation and joint
+   multi-output fits to agreement with the single-output forest.
+   Appending trees, and resuming from a truncated checkpoint, must
+   reproduce the forest trained at once.  Prediction must not depend
+   upon its tiling, nor upon walking the compact node format.
+
+   Not part of any package build.  From this directory:
+
+     g++ -O2 -std=c++11 -fopenmp -I.. -I../../ArboristBridgeR/Shared trainequiv.cc $(ls ../[a-z]*.cc) -o trainequiv
+     ./trainequiv
+
+   Exits with nonzero status if any check fails.
+
+   @author Mark Seligman
+ */
+
+#include "callback.h"
+#include "forest.h"
+#include "leaf.h"
+#include "predict.h"
+#include "rowrank.h"
+#include "rowsampler.h"
+#include "splitpred.h"
+#include "splitscan.h"
+#include "taskpool.h"
+#include "train.h"
+#include "trainctx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/**
+   @brief The front end is not exercised, but must be linked.
+ */
+static std::mt19937 feGen(1);
+
+unsigned int CallBack::SampleRows(const RowSampler *rowSampler, unsigned int nSamp, int out[]) {
+  std::vector<double> ru(rowSampler->VarCount(nSamp));
+  RUnif(ru.size(), &ru[0]);
+  return rowSampler->Sample(nSamp, &ru[0], out);
+}
+
+
+void CallBack::RUnif(int len, double out[]) {
+  std::uniform_real_distribution<double> unif;
+  for (int i = 0; i < len; i++)
+    out[i] = unif(feGen);
+}
+
+
+/**
+   @brief Synthetic design, presorted as by the front end, with both a
+   numerical and a categorical response.  Numerical predictors include a
+   column tied heavily enough to be stored densely, and factors are mixed
+   in, so that every splitting path is visited.
+ */
+struct Design {
+  static const unsigned int nRow = 10000;
+  static const unsigned int nPredNum = 6;
+  static const unsigned int nPredFac = 2;
+  static const unsigned int nPred = nPredNum + nPredFac;
+  static const unsigned int facCard = 5;
+  static const unsigned int ctgWidth = 3;
+
+  std::vector<double> num; // Column-major.
+  std::vector<unsigned int> fac; // Column-major.
+  std::vector<double> numT; // Row-major, for prediction.
+  std::vector<unsigned int> facT; // Row-major, for prediction.
+  std::vector<double> y;
+  std::vector<unsigned int> row2Rank;
+  std::vector<unsigned int> yCtg; // Terciles of the numerical response.
+  std::vector<double> proxy; // Balanced class weight, jittered.
+  std::vector<unsigned int> feRow, feRank, feRLE, numOff;
+  std::vector<double> numVal;
+  std::vector<unsigned int> feCard;
+
+  Design() : num(nRow * nPredNum), fac(nRow * nPredFac), numT(nRow * nPredNum), facT(nRow * nPredFac), y(nRow), row2Rank(nRow), yCtg(nRow), proxy(nRow), numOff(nPredNum), feCard(nPredFac, (unsigned int) facCard) {
+    std::mt19937 gen(5);
+    std::normal_distribution<double> norm;
+    for (unsigned int row = 0; row < nRow; row++) {
+      for (unsigned int predIdx = 0; predIdx < nPredNum; predIdx++) {
+        double val = norm(gen);
+        num[predIdx * nRow + row] = numT[row * nPredNum + predIdx] = predIdx == 3 ? std::round(val) : val;
+      }
+      for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++) {
+        fac[facIdx * nRow + row] = facT[row * nPredFac + facIdx] = gen() % facCard;
+      }
+      y[row] = 2.0 * num[row] - num[nRow + row] * num[2 * nRow + row] + (fac[row] % 2 == 1 ? 1.5 : -0.5) + 0.3 * norm(gen);
+    }
+
+    std::vector<double> ySorted(y);
+    std::sort(ySorted.begin(), ySorted.end());
+    std::uniform_real_distribution<double> unif;
+    for (unsigned int row = 0; row < nRow; row++) {
+      row2Rank[row] = std::lower_bound(ySorted.begin(), ySorted.end(), y[row]) - ySorted.begin();
+      yCtg[row] = (row2Rank[row] * ctgWidth) / nRow;
+      proxy[row] = 1.0 / ctgWidth + (unif(gen) - 0.5) * 0.5 / (double(nRow) * nRow);
+    }
+
+    RowRank::PreSortNum(&num[0], nPredNum, nRow, feRow, feRank, feRLE, numOff, numVal);
+    RowRank::PreSortFac(&fac[0], nPredFac, nRow, feRow, feRank, feRLE);
+  }
+};
+
+
+/**
+   @brief Training options varied by the checks.
+ */
+struct Mode {
+  bool treeParallel;
+  unsigned int rankBins;
+  bool lazyStage;
+  const double *regMono; // Per-predictor monotonicity:  null iff none.
+  bool columnLayout;
+  unsigned int subtreeMax;
+  bool levelSync;
+  unsigned int segWidth; // Indices per scan segment:  zero iff default.
+  bool extraTrees;
+  unsigned int approxMin; // Extent scanned approximately:  zero iff none.
+  unsigned int minNode;
+  const char *checkpointPath; // Null iff no checkpointing.
+
+  Mode() : treeParallel(false), rankBins(0), lazyStage(false), regMono(0), columnLayout(false), subtreeMax(0), levelSync(false), segWidth(0), extraTrees(false), approxMin(0), minNode(3), checkpointPath(0) {
+  }
+};
+
+
+/**
+   @brief A trained forest, as exported to the front end.
+ */
+struct Trained {
+  std::vector<unsigned int> origin, facOrigin, leafOrigin, facSplit, bagBits;
+  std::vector<double> predInfo;
+  std::vector<ForestNode> forestNode;
+  std::vector<LeafNode> leafNode;
+  std::vector<BagLeaf> bagLeaf;
+  std::vector<double> weight; // Classification only:  per-leaf category weights.
+  std::vector<double> scoreOut; // Multi-output only:  per-leaf output scores.
+
+  Trained(unsigned int nTree) : origin(nTree), facOrigin(nTree), leafOrigin(nTree), predInfo(Design::nPred) {
+  }
+};
+
+
+static const unsigned int trainBlock = 4;
+static const uint64_t seed = 7;
+static unsigned int failures = 0;
+
+
+/**
+   @brief Reports the outcome of a single check.
+
+   @return void.
+ */
+static void Check(const std::string &name, bool pass) {
+  std::cout << (pass ? "ok      " : "FAILED  ") << name << std::endl;
+  failures += pass ? 0 : 1;
+}
+
+
+/**
+   @param ctgWidth is the response cardinality, zero iff regression.
+
+   @return training context for the mode specified.
+ */
+static TrainCtx *Context(unsigned int nTree, const Mode &mode, unsigned int ctgWidth = 0) {
+  static const std::vector<double> sampleWeight(Design::nRow, 1.0);
+  TrainOpt opt(nTree, Design::nRow, seed);
+  opt.trainBlock = trainBlock;
+  opt.minNode = mode.minNode;
+  opt.ctgWidth = ctgWidth;
+  opt.treeParallel = mode.treeParallel;
+  opt.rankBins = mode.rankBins;
+  opt.lazyStage = mode.lazyStage;
+  opt.regMono = mode.regMono;
+  opt.columnLayout = mode.columnLayout;
+  opt.subtreeMax = mode.subtreeMax;
+  opt.levelSync = mode.levelSync;
+  opt.segWidth = mode.segWidth;
+  opt.extraTrees = mode.extraTrees;
+  opt.approxMin = mode.approxMin;
+  opt.checkpointPath = mode.checkpointPath;
+  return Train::Init(Design::nPred, sampleWeight, opt);
+}
+
+
+/**
+   @brief Sets the number of threads available to training for the
+   lifetime of the object.
+ */
+class Threads {
+  int threadsPrev; // Zero iff unchanged.
+
+ public:
+  Threads(unsigned int nThread) : threadsPrev(0) {
+#ifdef _OPENMP
+    if (nThread > 0) {
+      threadsPrev = omp_get_max_threads();
+      omp_set_num_threads(nThread);
+    }
+#else
+    (void) nThread;
+#endif
+  }
+
+  ~Threads() {
+#ifdef _OPENMP
+    if (threadsPrev > 0)
+      omp_set_num_threads(threadsPrev);
+#endif
+  }
+};
+
+
+/**
+   @brief Trains a regression forest in the mode specified.
+
+   @param nThread, if positive, is the number of threads to employ.
+
+   @return void, with output forest.
+ */
+static void Regression(const Design &design, const Mode &mode, Trained &trained, unsigned int nThread = 0) {
+  Threads threads(nThread);
+  TrainCtx *ctx = Context(trained.origin.size(), mode);
+  Train::Regression(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.y, design.row2Rank, trained.origin, trained.facOrigin, trained.predInfo, design.feCard, trained.forestNode, trained.facSplit, trained.leafOrigin, trained.leafNode, trained.bagLeaf, trained.bagBits);
+  delete ctx;
+}
+
+
+/**
+   @brief Trains a classification forest in the mode specified.
+
+   @param nThread, if positive, is the number of threads to employ.
+
+   @return void, with output forest.
+ */
+static void Classification(const Design &design, const Mode &mode, Trained &trained, unsigned int nThread = 0) {
+  Threads threads(nThread);
+  TrainCtx *ctx = Context(trained.origin.size(), mode, Design::ctgWidth);
+  Train::Classification(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.yCtg, Design::ctgWidth, design.proxy, trained.origin, trained.facOrigin, trained.predInfo, design.feCard, trained.forestNode, trained.facSplit, trained.leafOrigin, trained.leafNode, trained.bagLeaf, trained.bagBits, trained.weight);
+  delete ctx;
+}
+
+
+/**
+   @return true iff the two forests bag the same rows and agree in every
+   node, other than in leaf scores.
+ */
+static bool SameSplits(const Trained &a, const Trained &b) {
+  if (a.origin != b.origin || a.facOrigin != b.facOrigin || a.leafOrigin != b.leafOrigin || a.facSplit != b.facSplit || a.bagBits != b.bagBits || a.weight != b.weight || a.scoreOut != b.scoreOut)
+    return false;
+  if (a.forestNode.size() != b.forestNode.size() || a.leafNode.size() != b.leafNode.size())
+    return false;
+
+  for (unsigned int i = 0; i < a.forestNode.size(); i++) {
+    unsigned int predA, bumpA, predB, bumpB;
+    double numA, numB;
+    a.forestNode[i].Ref(predA, bumpA, numA);
+    b.forestNode[i].Ref(predB, bumpB, numB);
+    if (predA != predB || bumpA != bumpB || numA != numB)
+      return false;
+  }
+  for (unsigned int i = 0; i < a.leafNode.size(); i++) {
+    if (a.leafNode[i].Extent() != b.leafNode[i].Extent())
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @return true iff the two forests agree in every exported field, other
+   than predictor information.
+ */
+static bool SameForest(const Trained &a, const Trained &b) {
+  if (!SameSplits(a, b))
+    return false;
+
+  for (unsigned int i = 0; i < a.leafNode.size(); i++) {
+    if (a.leafNode[i].GetScore() != b.leafNode[i].GetScore())
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @return true iff the two classification forests agree in every node
+   and vote for the same category at every leaf.  Tie-breaking fractions
+   are ignored.
+ */
+static bool SameVotes(const Trained &a, const Trained &b) {
+  if (!SameSplits(a, b))
+    return false;
+
+  for (unsigned int i = 0; i < a.leafNode.size(); i++) {
+    if (std::floor(a.leafNode[i].GetScore()) != std::floor(b.leafNode[i].GetScore()))
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @return true iff the two forests agree in every exported field.
+ */
+static bool Same(const Trained &a, const Trained &b) {
+  return SameForest(a, b) && a.predInfo == b.predInfo;
+}
+
+
+/**
+   @return true iff predictor information agrees up to the order in which
+   it was accumulated.
+ */
+static bool InfoClose(const Trained &a, const Trained &b) {
+  for (unsigned int predIdx = 0; predIdx < Design::nPred; predIdx++) {
+    if (std::fabs(a.predInfo[predIdx] - b.predInfo[predIdx]) > 1.0e-9 * std::fabs(b.predInfo[predIdx]))
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+   @brief Predicts the training rows from a regression forest.
+
+   @param rowTile is the number of rows per traversal tile.
+
+   @param treeTile is the number of trees per traversal tile, zero iff all.
+
+   @param bagged is true iff bagged rows are to be predicted out of bag.
+
+   @param taskPool, if non-null, is the caller's pool of workers.
+
+   @param forestCompact, if non-null, is walked in place of the full nodes.
+
+   @return void, with output prediction vector.
+ */
+static void Predictions(const Design &design, const Trained &trained, std::vector<double> &yPred, unsigned int rowTile = Predict::rowTileDefault, unsigned int treeTile = 0, bool bagged = false, TaskPool *taskPool = 0, const ForestCompact *forestCompact = 0) {
+  std::vector<double> valNum;
+  std::vector<unsigned int> rowStart, runLength, predStart;
+  std::vector<unsigned int> leafOrigin(trained.leafOrigin);
+  std::vector<unsigned int> facSplit(trained.facSplit);
+  std::vector<unsigned int> bagBits(trained.bagBits);
+  yPred.assign(Design::nRow, 0.0);
+  Predict::Regression(valNum, rowStart, runLength, predStart, const_cast<double*>(&design.numT[0]), const_cast<unsigned int*>(&design.facT[0]), Design::nPredNum, Design::nPredFac, &trained.forestNode[0], &trained.origin[0], trained.origin.size(), facSplit.empty() ? 0 : &facSplit[0], facSplit.size(), &trained.facOrigin[0], trained.origin.size(), leafOrigin, &trained.leafNode[0], trained.leafNode.size(), bagged ? &bagBits[0] : 0, design.y, yPred, rowTile, treeTile, forestCompact, taskPool);
+}
+
+
+/**
+   @brief Predicts the training rows from a classification forest, as
+   with Predictions().
+
+   @return void, with output category, census and probability vectors.
+ */
+static void PredictionsCtg(const Design &design, const Trained &trained, std::vector<unsigned int> &yPred, std::vector<unsigned int> &census, std::vector<double> &prob, unsigned int rowTile = Predict::rowTileDefault, unsigned int treeTile = 0, bool bagged = false, TaskPool *taskPool = 0, const ForestCompact *forestCompact = 0) {
+  std::vector<double> valNum, error;
+  std::vector<unsigned int> rowStart, runLength, predStart, yTest;
+  std::vector<unsigned int> leafOrigin(trained.leafOrigin);
+  std::vector<unsigned int> facSplit(trained.facSplit);
+  std::vector<unsigned int> bagBits(trained.bagBits);
+  yPred.assign(Design::nRow, 0);
+  census.assign(Design::nRow * Design::ctgWidth, 0);
+  prob.assign(Design::nRow * Design::ctgWidth, 0.0);
+  Predict::Classification(valNum, rowStart, runLength, predStart, const_cast<double*>(&design.numT[0]), const_cast<unsigned int*>(&design.facT[0]), Design::nPredNum, Design::nPredFac, &trained.forestNode[0], &trained.origin[0], trained.origin.size(), facSplit.empty() ? 0 : &facSplit[0], facSplit.size(), &trained.facOrigin[0], trained.origin.size(), leafOrigin, &trained.leafNode[0], trained.leafNode.size(), bagged ? &bagBits[0] : 0, Design::nRow, &trained.weight[0], Design::ctgWidth, yPred, &census[0], yTest, 0, error, &prob[0], rowTile, treeTile, forestCompact, taskPool);
+}
+
+
+/**
+   @brief Weaker than Same():  tolerates renumbering of nodes within a
+   tree, and a reordered accumulation of predictor information.
+
+   @return true iff the forests bag the same rows, grow the same leaves
+   and, if regression, predict identically.
+ */
+static bool Equivalent(const Design &design, const Trained &a, const Trained &b) {
+  if (a.origin.size() != b.origin.size() || a.bagBits != b.bagBits || a.forestNode.size() != b.forestNode.size() || a.weight.size() != b.weight.size() || !InfoClose(a, b))
+    return false;
+
+  const unsigned int nTree = a.origin.size();
+  std::vector<std::vector<double> > scoreA(nTree), scoreB(nTree);
+  std::vector<std::vector<unsigned int> > extentA(nTree), extentB(nTree);
+  LeafNode::Export(a.leafOrigin, &a.leafNode[0], a.leafNode.size(), scoreA, extentA);
+  LeafNode::Export(b.leafOrigin, &b.leafNode[0], b.leafNode.size(), scoreB, extentB);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    std::vector<std::pair<double, unsigned int> > leafA, leafB;
+    for (unsigned int i = 0; i < scoreA[tIdx].size(); i++)
+      leafA.push_back(std::make_pair(scoreA[tIdx][i], extentA[tIdx][i]));
+    for (unsigned int i = 0; i < scoreB[tIdx].size(); i++)
+      leafB.push_back(std::make_pair(scoreB[tIdx][i], extentB[tIdx][i]));
+    std::sort(leafA.begin(), leafA.end());
+    std::sort(leafB.begin(), leafB.end());
+    if (leafA != leafB)
+      return false;
+  }
+  if (!a.weight.empty())
+    return true;
+
+  std::vector<double> yA, yB;
+  Predictions(design, a, yA);
+  Predictions(design, b, yB);
+  return yA == yB;
+}
+
+
+/**
+   @brief Exact modes:  each reorganizes the work but not the arithmetic,
+   so must reproduce the reference forests.
+
+   @return void.
+ */
+static void ExactModes(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  Mode mode;
+
+  mode = Mode();
+  mode.treeParallel = true;
+  Trained parallel(nTree);
+  Regression(design, mode, parallel);
+  Trained parallelCtg(nTree);
+  Classification(design, mode, parallelCtg);
+  Check("treeParallel reproduces reference forests", Same(parallel, reference) && Same(parallelCtg, referenceCtg));
+
+  mode = Mode();
+  mode.lazyStage = true;
+  Trained lazy(nTree);
+  Regression(design, mode, lazy);
+  Trained lazyCtg(nTree);
+  Classification(design, mode, lazyCtg);
+  Check("lazyStage reproduces reference forests", Same(lazy, reference) && Same(lazyCtg, referenceCtg));
+
+  mode = Mode();
+  mode.columnLayout = true;
+  Trained column(nTree);
+  Regression(design, mode, column);
+  Trained columnCtg(nTree);
+  Classification(design, mode, columnCtg);
+  Check("columnLayout reproduces reference forests", Same(column, reference) && Same(columnCtg, referenceCtg));
+
+  mode = Mode();
+  mode.subtreeMax = 256;
+  Trained subtree(nTree);
+  Regression(design, mode, subtree);
+  Trained subtreeCtg(nTree);
+  Classification(design, mode, subtreeCtg);
+  Check("subtreeMax grows equivalent forests", Equivalent(design, subtree, reference) && Equivalent(design, subtreeCtg, referenceCtg));
+
+  mode = Mode();
+  mode.levelSync = true;
+  Trained sync(nTree);
+  Regression(design, mode, sync);
+  Trained syncCtg(nTree);
+  Classification(design, mode, syncCtg);
+  Check("levelSync reproduces reference forests", Same(sync, reference) && Same(syncCtg, referenceCtg));
+
+  mode.lazyStage = true;
+  mode.columnLayout = true;
+  Trained syncLazy(nTree);
+  Regression(design, mode, syncLazy, 2);
+  Check("levelSync with lazy, columnar staging reproduces reference forest", Same(syncLazy, reference));
+
+  // Segments accumulate in walk order, however scheduled, so neither
+  // the width nor the thread count may alter the splits.
+  mode = Mode();
+  mode.segWidth = 512;
+  Trained segmented(nTree);
+  Regression(design, mode, segmented);
+  Trained segmentedThreads(nTree);
+  Regression(design, mode, segmentedThreads, 3);
+  Check("segmented scans reproduce reference forest", Same(segmented, reference) && Same(segmentedThreads, reference));
+
+  // The dense blob is evaluated by whichever segment straddles its
+  // position among the explicit indices, under either layout.
+  mode.columnLayout = true;
+  Trained segmentedColumn(nTree);
+  Regression(design, mode, segmentedColumn, 3);
+  Check("segmented scans of dense predictor reproduce reference forest under columnLayout", Same(segmentedColumn, reference));
+}
+
+
+/**
+   @brief The core generator is keyed by tree and level, so neither the
+   number of threads nor their schedule may alter the forest.
+
+   @return void.
+ */
+static void ThreadCount(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  Mode parallelMode;
+  parallelMode.treeParallel = true;
+  Mode subtreeMode;
+  subtreeMode.treeParallel = true;
+  subtreeMode.subtreeMax = 256;
+  Trained subtreeRef(nTree);
+  Regression(design, subtreeMode, subtreeRef, 1);
+
+  const unsigned int threadCount[] = {1, 2, 5};
+  for (auto nThread : threadCount) {
+    Trained serial(nTree);
+    Regression(design, Mode(), serial, nThread);
+    Trained serialCtg(nTree);
+    Classification(design, Mode(), serialCtg, nThread);
+    Trained parallel(nTree);
+    Regression(design, parallelMode, parallel, nThread);
+    Trained subtree(nTree);
+    Regression(design, subtreeMode, subtree, nThread);
+    Check(std::to_string(nThread) + " thread(s) reproduce reference forests", Same(serial, reference) && Same(serialCtg, referenceCtg) && Same(parallel, reference) && Same(subtree, subtreeRef));
+  }
+}
+
+
+/**
+   @return count of distinct values at which a numerical predictor is cut.
+ */
+static unsigned int CutCount(const Trained &trained, unsigned int predIdx) {
+  std::set<double> cut;
+  for (auto node : trained.forestNode) {
+    unsigned int pred, bump;
+    double num;
+    node.Ref(pred, bump, num);
+    if (bump > 0 && pred == predIdx)
+      cut.insert(num);
+  }
+
+  return cut.size();
+}
+
+
+/**
+   @brief Quantization at least as fine as the ranks is exact.  Coarser
+   quantization derives each cut from the pair of bins it separates, so
+   limits the distinct cuts of a numerical predictor, and remains
+   independent of the thread schedule.
+
+   @return void.
+ */
+static void RankBins(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  Mode mode;
+  mode.rankBins = Design::nRow;
+  Trained fine(nTree);
+  Regression(design, mode, fine);
+  Trained fineCtg(nTree);
+  Classification(design, mode, fineCtg);
+  Check("rankBins at the rank count reproduces reference forests", Same(fine, reference) && Same(fineCtg, referenceCtg));
+
+  mode.rankBins = 32;
+  Trained coarse(nTree);
+  Regression(design, mode, coarse);
+  Trained coarseCtg(nTree);
+  Classification(design, mode, coarseCtg);
+  const unsigned int binPairs = mode.rankBins * (mode.rankBins - 1) / 2;
+  bool pass = CutCount(reference, 0) > binPairs;
+  for (unsigned int predIdx = 0; predIdx < Design::nPredNum; predIdx++) {
+    pass = pass && CutCount(coarse, predIdx) <= binPairs && CutCount(coarseCtg, predIdx) <= binPairs;
+  }
+  Check("rankBins = " + std::to_string(mode.rankBins) + " cuts only between bins", pass);
+
+  mode.treeParallel = true;
+  Trained coarseParallel(nTree);
+  Regression(design, mode, coarseParallel, 2);
+  Check("rankBins = " + std::to_string(mode.rankBins) + " is independent of thread schedule", Same(coarseParallel, coarse));
+}
+
+
+/**
+   @brief The vector kernels screen cuts but evaluate candidates exactly
+   and in order, so each must reproduce the serial kernel's forests, with
+   and without monotonicity constraints.  Kernels the host does not
+   support are skipped.
+
+   @return void.
+ */
+static void Kernels(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  const std::string kernelPrev = SplitScan::Kernel();
+  const std::vector<double> regMono = {1.0, 0.0, 0.0, 0.0, -1.0, 0.0, 0.0, 0.0};
+  Mode monoMode;
+  monoMode.regMono = &regMono[0];
+
+  SplitScan::Use("serial");
+  Trained monoRef(nTree);
+  Regression(design, monoMode, monoRef);
+
+  const char *kernel[] = {"serial", "avx2", "avx512"};
+  for (auto name : kernel) {
+    if (!SplitScan::Use(name)) {
+      std::cout << "skip    " << name << " kernel unsupported by host" << std::endl;
+      continue;
+    }
+    Trained scanned(nTree);
+    Regression(design, Mode(), scanned);
+    Trained scannedCtg(nTree);
+    Classification(design, Mode(), scannedCtg);
+    Trained mono(nTree);
+    Regression(design, monoMode, mono);
+    Check(std::string(name) + " kernel reproduces reference forests", Same(scanned, reference) && Same(scannedCtg, referenceCtg) && Same(mono, monoRef));
+  }
+  SplitScan::Use(kernelPrev.c_str());
+}
+
+
+/**
+   @brief Randomized cuts are drawn from the core generator, keyed by tree
+   and level, so must not depend upon the thread count, the tree schedule
+   or the order in which levels are split.
+
+   @return void.
+ */
+static void ExtraTrees(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  Mode mode;
+  mode.extraTrees = true;
+  Trained extra(nTree);
+  Regression(design, mode, extra, 1);
+  Trained extraCtg(nTree);
+  Classification(design, mode, extraCtg, 1);
+  Check("extraTrees grows forests differing from reference", !SameForest(extra, reference) && !SameForest(extraCtg, referenceCtg));
+
+  Trained threaded(nTree);
+  Regression(design, mode, threaded, 3);
+  Trained threadedCtg(nTree);
+  Classification(design, mode, threadedCtg, 3);
+  mode.treeParallel = true;
+  Trained parallel(nTree);
+  Regression(design, mode, parallel, 2);
+  Trained parallelCtg(nTree);
+  Classification(design, mode, parallelCtg, 2);
+  mode.treeParallel = false;
+  mode.levelSync = true;
+  Trained sync(nTree);
+  Regression(design, mode, sync, 2);
+  Trained syncCtg(nTree);
+  Classification(design, mode, syncCtg, 2);
+  Check("extraTrees is independent of threads and tree schedule", Same(threaded, extra) && Same(threadedCtg, extraCtg) && Same(parallel, extra) && Same(parallelCtg, extraCtg) && Same(sync, extra) && Same(syncCtg, extraCtg));
+}
+
+
+/**
+   @brief Approximate scans alter only the splitting of nodes wider than
+   the threshold, and sample strata deterministically, so are independent
+   of the schedule.  Thresholds too narrow to stratify are rejected.
+
+   @return void.
+ */
+static void ApproxMin(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  static const std::vector<double> sampleWeight(Design::nRow, 1.0);
+  TrainOpt opt(nTree, Design::nRow, seed);
+  opt.approxMin = SplitPred::approxFloor - 1;
+  TrainCtx *ctx = Train::Init(Design::nPred, sampleWeight, opt);
+  Check("approxMin below " + std::to_string(SplitPred::approxFloor) + " is rejected", ctx == 0);
+  delete ctx;
+
+  Mode mode;
+  mode.approxMin = 2 * Design::nRow;
+  Trained wide(nTree);
+  Regression(design, mode, wide);
+  Trained wideCtg(nTree);
+  Classification(design, mode, wideCtg);
+  Check("approxMin above every extent reproduces reference forests", Same(wide, reference) && Same(wideCtg, referenceCtg));
+
+  mode.approxMin = SplitPred::approxFloor;
+  Trained approx(nTree);
+  Regression(design, mode, approx, 1);
+  Trained approxCtg(nTree);
+  Classification(design, mode, approxCtg, 1);
+  Check("approxMin = " + std::to_string(mode.approxMin) + " alters splits but not bagging", !SameForest(approx, reference) && !SameForest(approxCtg, referenceCtg) && approx.bagBits == reference.bagBits && approxCtg.bagBits == referenceCtg.bagBits);
+
+  Trained threaded(nTree);
+  Regression(design, mode, threaded, 3);
+  Trained threadedCtg(nTree);
+  Classification(design, mode, threadedCtg, 3);
+  mode.treeParallel = true;
+  Trained parallel(nTree);
+  Regression(design, mode, parallel, 2);
+  mode.treeParallel = false;
+  mode.levelSync = true;
+  Trained sync(nTree);
+  Regression(design, mode, sync, 2);
+  Check("approxMin = " + std::to_string(mode.approxMin) + " is independent of threads and tree schedule", Same(threaded, approx) && Same(threadedCtg, approxCtg) && Same(parallel, approx) && Same(sync, approx));
+}
+
+
+/**
+   @brief A factor wider than RunSet::maxWidth, whose categories each
+   determine the class, is split along a one-versus-rest ordering, so two
+   levels separate three classes exactly.  A numerical predictor of pure
+   noise competes for each split.
+
+   @param nThread is the number of threads to employ.
+
+   @return count of training rows misclassified, with output forest.
+ */
+static unsigned int WideFactor(Trained &trained, unsigned int nThread) {
+  static const unsigned int nRow = 3000;
+  static const unsigned int card = 24;
+  static const unsigned int ctgWidth = 3;
+  std::mt19937 gen(11);
+  std::normal_distribution<double> norm;
+  std::vector<unsigned int> cat2Ctg(card);
+  for (unsigned int cat = 0; cat < card; cat++)
+    cat2Ctg[cat] = cat % ctgWidth;
+  std::shuffle(cat2Ctg.begin(), cat2Ctg.end(), gen);
+
+  std::vector<double> num(nRow), proxy(nRow);
+  std::vector<unsigned int> fac(nRow), yCtg(nRow);
+  std::uniform_real_distribution<double> unif;
+  for (unsigned int row = 0; row < nRow; row++) {
+    num[row] = norm(gen);
+    fac[row] = gen() % card;
+    yCtg[row] = cat2Ctg[fac[row]];
+    proxy[row] = 1.0 / ctgWidth + (unif(gen) - 0.5) * 0.5 / (double(nRow) * nRow);
+  }
+  std::vector<unsigned int> feRow, feRank, feRLE, numOff(1);
+  std::vector<double> numVal;
+  RowRank::PreSortNum(&num[0], 1, nRow, feRow, feRank, feRLE, numOff, numVal);
+  RowRank::PreSortFac(&fac[0], 1, nRow, feRow, feRank, feRLE);
+
+  Threads threads(nThread);
+  const std::vector<double> sampleWeight(nRow, 1.0);
+  const std::vector<unsigned int> feCard(1, card);
+  TrainOpt opt(trained.origin.size(), nRow, seed);
+  opt.trainBlock = trainBlock;
+  opt.ctgWidth = ctgWidth;
+  opt.totLevels = 2;
+  TrainCtx *ctx = Train::Init(2, sampleWeight, opt);
+  trained.predInfo.assign(2, 0.0);
+  Train::Classification(ctx, &feRow[0], &feRank[0], &numOff[0], &numVal[0], &feRLE[0], feRLE.size(), yCtg, ctgWidth, proxy, trained.origin, trained.facOrigin, trained.predInfo, feCard, trained.forestNode, trained.facSplit, trained.leafOrigin, trained.leafNode, trained.bagLeaf, trained.bagBits, trained.weight);
+  delete ctx;
+
+  std::vector<double> valNum, error;
+  std::vector<unsigned int> rowStart, runLength, predStart, yTest;
+  std::vector<unsigned int> census(nRow * ctgWidth);
+  std::vector<unsigned int> yPred(nRow);
+  Predict::Classification(valNum, rowStart, runLength, predStart, &num[0], &fac[0], 1, 1, &trained.forestNode[0], &trained.origin[0], trained.origin.size(), &trained.facSplit[0], trained.facSplit.size(), &trained.facOrigin[0], trained.origin.size(), trained.leafOrigin, &trained.leafNode[0], trained.leafNode.size(), 0, nRow, &trained.weight[0], ctgWidth, yPred, &census[0], yTest, 0, error, 0);
+
+  unsigned int missed = 0;
+  for (unsigned int row = 0; row < nRow; row++)
+    missed += yPred[row] == yCtg[row] ? 0 : 1;
+
+  return missed;
+}
+
+
+/**
+   @brief Wide factors are searched deterministically, without sampling
+   runs, so separate categorical classes and do not depend upon the
+   thread count.
+
+   @return void.
+ */
+static void WideFactors() {
+  const unsigned int nTree = 12;
+  Trained wide(nTree);
+  unsigned int missed = WideFactor(wide, 1);
+  Trained wideThreads(nTree);
+  WideFactor(wideThreads, 3);
+  Check("wide factor separates classes within two levels", missed == 0);
+  Check("wide factor splitting is independent of threads", Same(wideThreads, wide));
+}
+
+
+/**
+   @brief Trains a multi-output regression forest in the mode specified.
+
+   @param nOut is the number of copies of the response to fit jointly.
+
+   @param nThread, if positive, is the number of threads to employ.
+
+   @return void, with output forest.
+ */
+static void RegressionMulti(const Design &design, const Mode &mode, unsigned int nOut, Trained &trained, unsigned int nThread = 0) {
+  Threads threads(nThread);
+  std::vector<double> yOut;
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+    yOut.insert(yOut.end(), design.y.begin(), design.y.end());
+  TrainCtx *ctx = Context(trained.origin.size(), mode);
+  Train::RegressionMulti(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), yOut, nOut, design.row2Rank, trained.origin, trained.facOrigin, trained.predInfo, design.feCard, trained.forestNode, trained.facSplit, trained.leafOrigin, trained.leafNode, trained.bagLeaf, trained.bagBits, trained.scoreOut);
+  delete ctx;
+}
+
+
+/**
+   @brief Copies of a single response are fit as one, so must score every
+   leaf identically.  The joint criterion scales the single-output
+   criterion, but accumulates in double rather than single precision, so
+   only splits clear of near-ties need agree with the single-output
+   forest:  the root splits are checked.  A single output reproduces the
+   single-output forest exactly, and its scores to single precision, in
+   which the primary scores are accumulated.  Joint training does not
+   depend upon the thread count or tree schedule.
+
+   @return void.
+ */
+static void MultiOutput(const Design &design, const Trained &reference) {
+  const unsigned int nTree = reference.origin.size();
+  Trained one(nTree);
+  RegressionMulti(design, Mode(), 1, one, 1);
+  bool pass = one.scoreOut.size() == one.leafNode.size();
+  for (unsigned int leafIdx = 0; pass && leafIdx < one.leafNode.size(); leafIdx++)
+    pass = std::fabs(one.scoreOut[leafIdx] - one.leafNode[leafIdx].GetScore()) <= 1.0e-5 * std::max(1.0, std::fabs(one.scoreOut[leafIdx]));
+  one.scoreOut.clear();
+  Check("single output reproduces reference forest and scores", pass && Same(one, reference));
+
+  const unsigned int nOut = 2;
+  Trained multi(nTree);
+  RegressionMulti(design, Mode(), nOut, multi, 1);
+  pass = multi.scoreOut.size() == nOut * multi.leafNode.size() && multi.bagBits == reference.bagBits;
+  for (unsigned int leafIdx = 0; pass && leafIdx < multi.leafNode.size(); leafIdx++) {
+    for (unsigned int outIdx = 1; outIdx < nOut; outIdx++)
+      pass = pass && multi.scoreOut[leafIdx * nOut + outIdx] == multi.scoreOut[leafIdx * nOut];
+  }
+  for (unsigned int tIdx = 0; pass && tIdx < nTree; tIdx++) {
+    unsigned int predA, bumpA, predB, bumpB;
+    double numA, numB;
+    multi.forestNode[multi.origin[tIdx]].Ref(predA, bumpA, numA);
+    reference.forestNode[reference.origin[tIdx]].Ref(predB, bumpB, numB);
+    pass = predA == predB && numA == numB;
+  }
+  Check("duplicated outputs score alike and share root splits with reference", pass);
+
+  Trained threaded(nTree);
+  RegressionMulti(design, Mode(), nOut, threaded, 3);
+  Mode mode;
+  mode.treeParallel = true;
+  Trained parallel(nTree);
+  RegressionMulti(design, mode, nOut, parallel, 2);
+  Check("multi-output training is independent of threads and tree schedule", Same(threaded, multi) && Same(parallel, multi));
+}
+
+
+/**
+   @brief Appending trees to a trained forest must yield the forest that
+   would have been trained at once, as the core generator is keyed by
+   absolute tree index.  Predictor information is summed block by block,
+   so is exact only if the appended trees begin a block.  Classification
+   leaves scale their tie-breaking fraction by the tree count at training
+   time, so are held only to the same vote.
+
+   @return void.
+ */
+static void Append(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  const unsigned int nBase[] = {trainBlock, trainBlock + 1};
+  for (auto baseCount : nBase) {
+    Trained appended(baseCount);
+    Regression(design, Mode(), appended);
+    TrainCtx *ctx = Context(nTree - baseCount, Mode());
+    Train::RegressionAppend(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.y, design.row2Rank, appended.origin, appended.facOrigin, appended.predInfo, design.feCard, appended.forestNode, appended.facSplit, appended.leafOrigin, appended.leafNode, appended.bagLeaf, appended.bagBits);
+    delete ctx;
+
+    Trained appendedCtg(baseCount);
+    Classification(design, Mode(), appendedCtg);
+    ctx = Context(nTree - baseCount, Mode(), Design::ctgWidth);
+    Train::ClassificationAppend(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.yCtg, Design::ctgWidth, design.proxy, appendedCtg.origin, appendedCtg.facOrigin, appendedCtg.predInfo, design.feCard, appendedCtg.forestNode, appendedCtg.facSplit, appendedCtg.leafOrigin, appendedCtg.leafNode, appendedCtg.bagLeaf, appendedCtg.bagBits, appendedCtg.weight);
+    delete ctx;
+
+    bool aligned = baseCount % trainBlock == 0;
+    bool pass = aligned ? Same(appended, reference) && appendedCtg.predInfo == referenceCtg.predInfo : SameForest(appended, reference) && InfoClose(appended, reference) && InfoClose(appendedCtg, referenceCtg);
+    pass = pass && SameVotes(appendedCtg, referenceCtg);
+    Check("appending " + std::to_string(nTree - baseCount) + " trees to " + std::to_string(baseCount) + " reproduces reference forests", pass);
+  }
+}
+
+
+/**
+   @brief Reads an entire file.
+
+   @return file contents, empty if unreadable.
+ */
+static std::string FileImage(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+
+/**
+   @brief Writes a prefix of a file image, as an interrupted training
+   might have left it.
+
+   @return void.
+ */
+static void Truncate(const char *path, const std::string &image, unsigned int percent) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(image.data(), image.size() * percent / 100);
+}
+
+
+/**
+   @brief Resuming from a checkpoint truncated at an arbitrary byte must
+   recover the complete blocks, retrain the remainder and so reproduce
+   both the uninterrupted forest and its checkpoint file.  A file
+   recorded under a different response or tree-altering option must
+   yield no trees, and is overwritten.  Checkpointing is rejected under
+   the front-end generator, whose state the core cannot record.
+
+   @return void.
+ */
+static void Resume(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  const char *path = "trainequiv.ckpt";
+  static const std::vector<double> sampleWeight(Design::nRow, 1.0);
+  TrainOpt opt(nTree, Design::nRow, seed);
+  opt.feRNG = true;
+  opt.checkpointPath = path;
+  TrainCtx *ctx = Train::Init(Design::nPred, sampleWeight, opt);
+  Check("checkpointing under the front-end generator is rejected", ctx == 0);
+  delete ctx;
+
+  std::remove(path);
+  Mode mode;
+  mode.checkpointPath = path;
+  Trained checkpointed(nTree);
+  Regression(design, mode, checkpointed);
+  Check("checkpointed training reproduces reference forest", Same(checkpointed, reference));
+
+  const std::string image = FileImage(path);
+  const unsigned int percent[] = {0, 13, 50, 81, 99, 100};
+  for (auto cut : percent) {
+    Truncate(path, image, cut);
+    Trained resumed(nTree);
+    ctx = Context(nTree, mode);
+    unsigned int recovered = Train::RegressionResume(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.y, design.row2Rank, resumed.origin, resumed.facOrigin, resumed.predInfo, design.feCard, resumed.forestNode, resumed.facSplit, resumed.leafOrigin, resumed.leafNode, resumed.bagLeaf, resumed.bagBits);
+    delete ctx;
+    Check("resuming " + std::to_string(recovered) + " trees from checkpoint cut at " + std::to_string(cut) + "% reproduces forest and file", Same(resumed, reference) && FileImage(path) == image);
+  }
+
+  // A complete file recorded under another response or option must
+  // yield no trees.
+  std::vector<double> yAlt(design.y);
+  yAlt[0] += 1.0;
+  const unsigned int minNodeAlt[] = {mode.minNode, mode.minNode + 2};
+  for (auto minNode : minNodeAlt) {
+    Truncate(path, image, 100);
+    Mode modeAlt(mode);
+    modeAlt.minNode = minNode;
+    bool altResponse = minNode == mode.minNode;
+    Trained resumed(nTree);
+    ctx = Context(nTree, modeAlt);
+    unsigned int recovered = Train::RegressionResume(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), altResponse ? yAlt : design.y, design.row2Rank, resumed.origin, resumed.facOrigin, resumed.predInfo, design.feCard, resumed.forestNode, resumed.facSplit, resumed.leafOrigin, resumed.leafNode, resumed.bagLeaf, resumed.bagBits);
+    delete ctx;
+    Check(std::string("resuming under a different ") + (altResponse ? "response" : "minNode") + " recovers no trees and rewrites file", recovered == 0 && FileImage(path) != image);
+  }
+
+  std::remove(path);
+  Trained checkpointedCtg(nTree);
+  Classification(design, mode, checkpointedCtg);
+  Truncate(path, FileImage(path), 50);
+  Trained resumedCtg(nTree);
+  ctx = Context(nTree, mode, Design::ctgWidth);
+  unsigned int recovered = Train::ClassificationResume(ctx, &design.feRow[0], &design.feRank[0], &design.numOff[0], &design.numVal[0], &design.feRLE[0], design.feRLE.size(), design.yCtg, Design::ctgWidth, design.proxy, resumedCtg.origin, resumedCtg.facOrigin, resumedCtg.predInfo, design.feCard, resumedCtg.forestNode, resumedCtg.facSplit, resumedCtg.leafOrigin, resumedCtg.leafNode, resumedCtg.bagLeaf, resumedCtg.bagBits, resumedCtg.weight);
+  delete ctx;
+  Check("resuming " + std::to_string(recovered) + " classification trees reproduces reference forest", recovered > 0 && Same(checkpointedCtg, referenceCtg) && Same(resumedCtg, referenceCtg));
+  std::remove(path);
+}
+
+
+/**
+   @brief Tiling reorders the walk but not the per-row sums, so may not
+   alter prediction, with or without bagging, nor may the number of
+   workers walking the tiles.
+
+   @return void.
+ */
+static void Tiling(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  const unsigned int rowTile[] = {0, 1, 32, Predict::rowTileDefault, Design::nRow};
+  const unsigned int treeTile[] = {0, 1, 5, nTree};
+  const unsigned int workerCount[] = {1, 3};
+  const bool bagging[] = {false, true};
+  for (auto bagged : bagging) {
+    std::vector<double> yRef, probRef;
+    Predictions(design, reference, yRef, Predict::rowTileDefault, 0, bagged);
+    std::vector<unsigned int> ctgRef, censusRef;
+    PredictionsCtg(design, referenceCtg, ctgRef, censusRef, probRef, Predict::rowTileDefault, 0, bagged);
+    bool pass = true;
+    for (auto nWorker : workerCount) {
+      TaskPool taskPool(nWorker);
+      for (auto rTile : rowTile) {
+        for (auto tTile : treeTile) {
+          std::vector<double> yTiled, probTiled;
+          Predictions(design, reference, yTiled, rTile, tTile, bagged, &taskPool);
+          std::vector<unsigned int> ctgTiled, censusTiled;
+          PredictionsCtg(design, referenceCtg, ctgTiled, censusTiled, probTiled, rTile, tTile, bagged, &taskPool);
+          pass = pass && yTiled == yRef && ctgTiled == ctgRef && censusTiled == censusRef && probTiled == probRef;
+        }
+      }
+    }
+    Check(std::string(bagged ? "bagged" : "unbagged") + " predictions agree across tiles and workers", pass);
+  }
+}
+
+
+/**
+   @brief The compact copy encodes the same splits as the full nodes, so
+   walking it may not alter prediction, however tiled.
+
+   @return void.
+ */
+static void Compact(const Design &design, const Trained &reference, const Trained &referenceCtg) {
+  const unsigned int nTree = reference.origin.size();
+  const ForestCompact compact(&reference.forestNode[0], &reference.origin[0], nTree, Design::nPredNum);
+  const ForestCompact compactCtg(&referenceCtg.forestNode[0], &referenceCtg.origin[0], nTree, Design::nPredNum);
+  const unsigned int rowTile[] = {1, Predict::rowTileDefault, Design::nRow};
+  const unsigned int treeTile[] = {0, 5};
+  const bool bagging[] = {false, true};
+  TaskPool taskPool(3);
+  bool pass = true;
+  for (auto bagged : bagging) {
+    std::vector<double> yRef, probRef;
+    Predictions(design, reference, yRef, Predict::rowTileDefault, 0, bagged);
+    std::vector<unsigned int> ctgRef, censusRef;
+    PredictionsCtg(design, referenceCtg, ctgRef, censusRef, probRef, Predict::rowTileDefault, 0, bagged);
+    for (auto rTile : rowTile) {
+      for (auto tTile : treeTile) {
+        std::vector<double> yCompact, probCompact;
+        Predictions(design, reference, yCompact, rTile, tTile, bagged, &taskPool, &compact);
+        std::vector<unsigned int> ctgCompact, censusCompact;
+        PredictionsCtg(design, referenceCtg, ctgCompact, censusCompact, probCompact, rTile, tTile, bagged, &taskPool, &compactCtg);
+        pass = pass && yCompact == yRef && ctgCompact == ctgRef && censusCompact == censusRef && probCompact == probRef;
+      }
+    }
+  }
+  Check("compact nodes predict as full nodes", pass);
+}
+
+
+int main() {
+  const unsigned int nTree = 12;
+  Design design;
+  Trained reference(nTree);
+  Regression(design, Mode(), reference);
+  Trained referenceCtg(nTree);
+  Classification(design, Mode(), referenceCtg);
+
+  ExactModes(design, reference, referenceCtg);
+  ThreadCount(design, reference, referenceCtg);
+  RankBins(design, reference, referenceCtg);
+  Kernels(design, reference, referenceCtg);
+  ExtraTrees(design, reference, referenceCtg);
+  ApproxMin(design, reference, referenceCtg);
+  WideFactors();
+  MultiOutput(design, reference);
+  Append(design, reference, referenceCtg);
+  Resume(design, reference, referenceCtg);
+  Tiling(design, reference, referenceCtg);
+  Compact(design, reference, referenceCtg);
+
+  std::cout << (failures == 0 ? "all checks passed" : std::to_string(failures) + " check(s) failed") << std::endl;
+  return failures == 0 ? 0 : 1;
+}
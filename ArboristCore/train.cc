@@ -26,70 +26,117 @@
 #include "response.h"
 #include "splitpred.h"
 #include "leaf.h"
+#include "trainctx.h"
+#include "bv.h"
+#include "checkpoint.h"
 
 #include <algorithm>
 // Testing only:
 //#include <iostream>
 //using namespace std;
 
-unsigned int Train::trainBlock = 0;
+/**
+   @brief Collects the simulation-invariant parameters into a context
+   private to a single training invocation.  Distinct contexts permit
+   independent trainings to proceed concurrently.  Trainings drawing
+   from the front end's generator remain safe to overlap, but interleave
+   their draws from the one generator, so do not reproduce.
 
+   @param _nPred is the number of predictors.
 
-/**
-   @brief Initializes immutable values for "top-level" classes directly,
-   for those instances in which static initialization seems to make
-   more sense.  These may, in turn, initialize subclasses or classes
-   with objects strictly local to them.
+   @param _feSampleWeight is the per-row sampling weight.
 
-   @param minNode is the minimal index node size on which to split.
+   @param _opt names the options, described here by field.  Those
+   not set by the caller take the defaults given in TrainOpt.
 
-   @param minRatio is a threshold ratio for determining whether to split.
+   minNode is the minimal index node size on which to split.
 
-   @param totLevels, if positive, limits the number of levels to build.
+   minRatio is a threshold ratio for determining whether to split.
 
-   @return void.
-*/
-void Train::Init(unsigned int _nPred, unsigned int _nTree, unsigned int _nSamp, const std::vector<double> &_feSampleWeight, bool _withRepl, unsigned int _trainBlock, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _ctgWidth, unsigned int _predFixed, const double _splitQuant[], const double _predProb[], bool _thinLeaves, const double _regMono[]) {
-  trainBlock = _trainBlock;
-  Sample::Immutables(_nSamp, _feSampleWeight, _withRepl, _ctgWidth, _nTree);
-  SPNode::Immutables(_ctgWidth);
-  SplitSig::Immutables(_minRatio);
-  IndexLevel::Immutables(_minNode, _totLevels);
-  Leaf::Immutables(_thinLeaves);
-  PreTree::Immutables(_nSamp, _minNode);
-  SplitPred::Immutables(_nPred, _ctgWidth, _predFixed, _predProb, _regMono);
-  ForestNode::Immutables(_splitQuant);
-}
+   totLevels, if positive, limits the number of levels to build.
 
+   treeParallel is true iff the trees of a block are to be grown
+   concurrently, rather than one at a time with level-wise parallelism.
+   Ignored if variates are drawn from the front end.
 
-/**
-   @brief Unsets immutables.
+   seed keys the core's counter-based generator.  It has no default,
+   but must be passed to the TrainOpt constructor:  a fixed seed reproduces the same forest on every run, so
+   callers wanting distinct forests must draw a fresh seed themselves,
+   as from their own generator or std::random_device.
 
-   @return void.
+   feRNG is true iff row sampling and uniform variates are to be
+   obtained by calling back to the front end.  Results then depend on
+   the thread schedule.
+
+   rankBins, if nonzero, quantizes the ranks of numerical
+   predictors into at most this many bins, capped at 65536.  Splits
+   are then sought only between bins.  Staging, restaging and the split
+   walks are otherwise unchanged.
+
+   lazyStage is true iff each tree is to stage a predictor only
+   upon first scheduling it for splitting.  Worthwhile for wide data
+   having few predictors tried per node.
+
+   columnLayout is true iff per-predictor sample buffers are to
+   be laid out as separate vectors of response, rank and count.
+
+   subtreeMax, if positive, is the extent at or below which a
+   node is completed as a local subtree, in its own buffers, rather than
+   carried through the remaining levels of the tree.
+
+   levelSync is true iff the trees of a block are to advance
+   level by level in lockstep, sharing a single restaging and splitting
+   schedule.  Ignored if trees are grown in parallel.
+
+   extraTrees is true iff each scheduled pair is to evaluate a
+   single, randomly-drawn cut rather than scanning for the best.
+
+   approxMin, if positive, is the extent above which numerical
+   splitting first locates a candidate cut from a stratified subsample
+   of the node, then scans exactly only in the candidate's neighborhood.
+   Restaging is unaffected.  Values below SplitPred::approxFloor, 2048,
+   are rejected:  narrower nodes are too small to stratify usefully.
+
+   segWidth, if positive, is the number of indices scanned by each
+   task of a segmented scan, in place of the default 65536.  Scans at
+   least twice this width are segmented.  Segmentation alters only the
+   schedule, not the splits chosen, so narrow widths serve chiefly to
+   exercise segmented scans on small data.
+
+   checkpointPath, if non-null, names a file to which each
+   block of trees is appended once trained, from which an interrupted
+   training may be resumed.  Rejected if variates are drawn from the
+   front end, whose generator state the core cannot record.
+
+   @return training context, to be deleted by the caller, or null if
+   the parameters are inconsistent.
 */
-void Train::DeImmutables() {
-  trainBlock = 0;
-  ForestNode::DeImmutables();
-  SplitSig::DeImmutables();
-  IndexLevel::DeImmutables();
-  Leaf::DeImmutables();
-  PreTree::DeImmutables();
-  Sample::DeImmutables();
-  SPNode::DeImmutables();
-  SplitPred::DeImmutables();
+TrainCtx *Train::Init(unsigned int _nPred, const std::vector<double> &_feSampleWeight, const TrainOpt &_opt) {
+  if (_opt.approxMin > 0 && _opt.approxMin < SplitPred::approxFloor)
+    return 0;
+  if (_opt.checkpointPath != 0 && _opt.feRNG)
+    return 0;
+
+  return new TrainCtx(_nPred, _feSampleWeight, _opt);
 }
 
 
 /**
    @brief Regression constructor.
+
+   @param _dataHash fingerprints the data, for checkpointing.
+
+   @param _tBase is the number of trees already present in the forest.
  */
-Train::Train(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const PMTrain *pmTrain, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits) : nTree(_origin.size()), forest(new ForestTrain(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryReg(_y, _row2Rank, pmTrain, _leafOrigin, _leafNode, _bagRow, _bagBits)) {
+Train::Train(TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, const PMTrain *pmTrain, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, uint64_t _dataHash, unsigned int _tBase) : ctx(_ctx), trainBlock(ctx->trainBlock), nTree(_origin.size()), tBase(_tBase), forest(new ForestTrain(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryReg(ctx, _y, _row2Rank, pmTrain, _leafOrigin, _leafNode, _bagRow, _bagBits)), checkpoint(Checkpoint::Factory(ctx, _dataHash, pmTrain->NRow(), _origin, _facOrigin, forest->Nodes(), forest->FacVec(), _leafOrigin, response->GetLeaf()->LeafNodes(), response->GetLeaf()->BagLeaves(), _bagBits, 0, 0, _tBase)) {
 }
 
 
 /**
    @brief Static entry for regression training.
 
+   @param ctx is the training context obtained from Init().
+
    @param trainBlock is the maximum number of trees trainable simultaneously.
 
    @param minNode is the mininal number of sample indices represented by a tree node.
@@ -98,47 +145,247 @@ Train::Train(const std::vector<double> &_y, const std::vector<unsigned int> &_ro
 
    @return forest height, with output reference parameter.
 */
-void Train::Regression(const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits) {
+void Train::Regression(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits) {
   PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _y.size());
-  Train *train = new Train(_y, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits);
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _feRLELength, _numOff, _numVal, &_y[0], _y.size());
+  Train *train = new Train(ctx, _y, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, dataHash);
 
-  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength);
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength, ctx->rankBins);
   train->TrainForest(pmTrain, rowRank);
 
   delete rowRank;
   delete train;
   delete pmTrain;
-  DeImmutables();
+}
+
+
+/**
+   @brief Static entry for resuming an interrupted regression training
+   from its checkpoint file.  Recovered trees replace the contents of
+   the forest and leaf vectors, and training continues from the first
+   tree not recorded.  Trains from scratch if no conforming checkpoint
+   is found:  a file recorded under a different seed, different
+   tree-altering options or different data is rejected, and is then
+   overwritten by the new training.
+
+   @param ctx is a training context obtained from Init(), with the
+   parameters and checkpoint path of the interrupted training.
+
+   @return number of trees recovered, with output reference parameters.
+*/
+unsigned int Train::RegressionResume(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits) {
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _y.size());
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _feRLELength, _numOff, _numVal, &_y[0], _y.size());
+  unsigned int tBase = Checkpoint::Load(ctx, dataHash, _y.size(), _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, 0, 0);
+  Train *train = new Train(ctx, _y, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, dataHash, tBase);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank, true);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+
+  return tBase;
+}
+
+
+/**
+   @brief Static entry for growing additional regression trees into a
+   previously-trained forest.  Forest and leaf vectors are extended in
+   place, with existing trees left untouched.
+
+   @param ctx is a training context obtained from Init(), its tree
+   count giving the number of trees to add.
+
+   @param _origin and remaining forest and leaf parameters are those
+   returned by the earlier training, which must have been performed on
+   the same observations and response.
+
+   @return void, with extended output reference parameters.
+*/
+void Train::RegressionAppend(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits) {
+  unsigned int tBase = Extend(ctx, _y.size(), _origin, _facOrigin, _leafOrigin, _bagBits);
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _y.size());
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _feRLELength, _numOff, _numVal, &_y[0], _y.size());
+  Train *train = new Train(ctx, _y, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, dataHash, tBase);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+}
+
+
+/**
+   @brief Multi-output regression constructor.
+
+   @param _dataHash fingerprints the data, for checkpointing.
+
+   @param _tBase is the number of trees already present in the forest.
+ */
+Train::Train(TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<double> &_yOut, unsigned int _nOut, const std::vector<unsigned int> &_row2Rank, const PMTrain *pmTrain, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_scoreOut, uint64_t _dataHash, unsigned int _tBase) : ctx(_ctx), trainBlock(ctx->trainBlock), nTree(_origin.size()), tBase(_tBase), forest(new ForestTrain(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryMulti(ctx, _y, _yOut, _nOut, _row2Rank, pmTrain, _leafOrigin, _leafNode, _bagRow, _bagBits, _scoreOut)), checkpoint(Checkpoint::Factory(ctx, _dataHash, pmTrain->NRow(), _origin, _facOrigin, forest->Nodes(), forest->FacVec(), _leafOrigin, response->GetLeaf()->LeafNodes(), response->GetLeaf()->BagLeaves(), _bagBits, &_scoreOut, _nOut, _tBase)) {
+}
+
+
+/**
+   @brief Static entry for multi-output regression training.  A single
+   forest is grown, sharing presorting and restaging, with splits
+   chosen by weighted variance summed over outputs.
+
+   @param _yOut is the response, by output, of which the first is
+   primary.
+
+   @param _nOut is the number of outputs.
+
+   @param _row2Rank ranks the primary output.
+
+   @param _scoreOut outputs the per-output leaf scores.
+
+   @return void, with output reference parameters.
+*/
+void Train::RegressionMulti(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_yOut, unsigned int _nOut, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_scoreOut) {
+  unsigned int nRow = _yOut.size() / _nOut;
+  std::vector<double> yPrimary(_yOut.begin(), _yOut.begin() + nRow);
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), nRow);
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _feRLELength, _numOff, _numVal, &_yOut[0], _yOut.size());
+  Train *train = new Train(ctx, yPrimary, _yOut, _nOut, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _scoreOut, dataHash);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+}
+
+
+/**
+   @brief Static entry for resuming an interrupted multi-output
+   regression training, as with regression.
+
+   @return number of trees recovered, with output reference parameters.
+*/
+unsigned int Train::RegressionMultiResume(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _feRLELength, const std::vector<double> &_yOut, unsigned int _nOut, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_scoreOut) {
+  unsigned int nRow = _yOut.size() / _nOut;
+  std::vector<double> yPrimary(_yOut.begin(), _yOut.begin() + nRow);
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), nRow);
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _feRLELength, _numOff, _numVal, &_yOut[0], _yOut.size());
+  unsigned int tBase = Checkpoint::Load(ctx, dataHash, nRow, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, &_scoreOut, _nOut);
+  Train *train = new Train(ctx, yPrimary, _yOut, _nOut, _row2Rank, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _scoreOut, dataHash, tBase);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _feRLELength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank, true);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+
+  return tBase;
 }
 
 
 /**
    @brief Classification constructor.
+
+   @param _dataHash fingerprints the data, for checkpointing.
+
+   @param _tBase is the number of trees already present in the forest.
  */
-Train::Train(const std::vector<unsigned int> &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, const PMTrain *pmTrain, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight) : nTree(_origin.size()), forest(new ForestTrain(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryCtg(_yCtg, _yProxy, pmTrain, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight, _ctgWidth)) {
+Train::Train(TrainCtx *_ctx, const std::vector<unsigned int> &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, const PMTrain *pmTrain, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight, uint64_t _dataHash, unsigned int _tBase) : ctx(_ctx), trainBlock(ctx->trainBlock), nTree(_origin.size()), tBase(_tBase), forest(new ForestTrain(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryCtg(ctx, _yCtg, _yProxy, pmTrain, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight, _ctgWidth)), checkpoint(Checkpoint::Factory(ctx, _dataHash, pmTrain->NRow(), _origin, _facOrigin, forest->Nodes(), forest->FacVec(), _leafOrigin, response->GetLeaf()->LeafNodes(), response->GetLeaf()->BagLeaves(), _bagBits, &_weight, _ctgWidth, _tBase)) {
 }
 
 
 /**
    @brief Static entry for regression training.
 
+   @param ctx is the training context obtained from Init().
+
    @return void.
 */
-void Train::Classification(const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _rleLength, const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight) {
+void Train::Classification(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _rleLength, const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight) {
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _yCtg.size());
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _rleLength, _numOff, _numVal, &_yProxy[0], _yProxy.size(), &_yCtg[0]);
+  Train *train = new Train(ctx, _yCtg, _ctgWidth, _yProxy, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight, dataHash);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _rleLength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+}
+
+
+/**
+   @brief Static entry for resuming an interrupted classification
+   training, as with regression.
+
+   @return number of trees recovered, with output reference parameters.
+*/
+unsigned int Train::ClassificationResume(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _rleLength, const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight) {
   PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _yCtg.size());
-  Train *train = new Train(_yCtg, _ctgWidth, _yProxy, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight);
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _rleLength, _numOff, _numVal, &_yProxy[0], _yProxy.size(), &_yCtg[0]);
+  unsigned int tBase = Checkpoint::Load(ctx, dataHash, _yCtg.size(), _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, &_weight, _ctgWidth);
+  Train *train = new Train(ctx, _yCtg, _ctgWidth, _yProxy, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight, dataHash, tBase);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _rleLength, ctx->rankBins);
+  train->TrainForest(pmTrain, rowRank, true);
+
+  delete rowRank;
+  delete train;
+  delete pmTrain;
+
+  return tBase;
+}
+
 
-  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _rleLength);
+/**
+   @brief Static entry for growing additional classification trees into
+   a previously-trained forest, as with regression.
+
+   @return void, with extended output reference parameters.
+*/
+void Train::ClassificationAppend(TrainCtx *ctx, const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _numOff[], const double _numVal[], const unsigned int _feRLE[], unsigned int _rleLength, const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<double> &_predInfo, const std::vector<unsigned int> &_feCard, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagLeaf> &_bagRow, std::vector<unsigned int> &_bagBits, std::vector<double> &_weight) {
+  unsigned int tBase = Extend(ctx, _yCtg.size(), _origin, _facOrigin, _leafOrigin, _bagBits);
+  PMTrain *pmTrain = new PMTrain(_feCard, _predInfo.size(), _yCtg.size());
+  uint64_t dataHash = Checkpoint::Fingerprint(ctx, pmTrain, _feRow, _feRank, _feRLE, _rleLength, _numOff, _numVal, &_yProxy[0], _yProxy.size(), &_yCtg[0]);
+  Train *train = new Train(ctx, _yCtg, _ctgWidth, _yProxy, pmTrain, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _bagBits, _weight, dataHash, tBase);
+
+  RowRank *rowRank = new RowRank(pmTrain, _feRow, _feRank, _numOff, _numVal, _feRLE, _rleLength, ctx->rankBins);
   train->TrainForest(pmTrain, rowRank);
 
   delete rowRank;
   delete train;
   delete pmTrain;
-  DeImmutables();
+}
+
+
+/**
+   @brief Makes room for the context's trees beyond those already
+   trained.  Origin vectors gain a slot per new tree and the bag matrix
+   is widened in place.
+
+   @param nRow is the number of training rows.
+
+   @return count of trees previously trained.
+ */
+unsigned int Train::Extend(const TrainCtx *ctx, unsigned int nRow, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_leafOrigin, std::vector<unsigned int> &_bagBits) {
+  unsigned int tBase = _origin.size();
+  unsigned int tTot = tBase + ctx->nTree;
+  _origin.resize(tTot);
+  _facOrigin.resize(tTot);
+  _leafOrigin.resize(tTot);
+  BitMatrix::Widen(_bagBits, nRow, tBase, tTot);
+
+  return tBase;
 }
 
 
 Train::~Train() {
+  delete checkpoint;
   delete response;
   delete forest;
 }
@@ -149,12 +396,28 @@ Train::~Train() {
 
   @param trainBlock is the maximum Count of trees to train en block.
 
+  @param infoSum is true iff 'predInfo' already holds the running sum of
+  prior trees, as recovered from a checkpoint, rather than their means.
+
   @return void.
 */
-void Train::TrainForest(const PMTrain *pmTrain, const RowRank *rowRank) {
-  for (unsigned treeStart = 0; treeStart < nTree; treeStart += trainBlock) {
+void Train::TrainForest(const PMTrain *pmTrain, const RowRank *rowRank, bool infoSum) {
+  // Restores prior per-tree means to sums, if warm starting.
+  if (!infoSum) {
+    for (unsigned int i = 0; i < predInfo.size(); i++) {
+      predInfo[i] *= tBase;
+    }
+  }
+
+  // Records any prior trees not yet checkpointed.
+  if (checkpoint != 0)
+    checkpoint->Record(tBase, predInfo);
+
+  for (unsigned treeStart = tBase; treeStart < nTree; treeStart += trainBlock) {
     unsigned int treeEnd = std::min(treeStart + trainBlock, nTree); // one beyond.
-    Block(rowRank, treeStart, treeEnd - treeStart);
+    Block(pmTrain, rowRank, treeStart, treeEnd - treeStart);
+    if (checkpoint != 0)
+      checkpoint->Record(treeEnd, predInfo);
   }
     
   // Normalizes 'predInfo' to per-tree means.
@@ -163,21 +426,31 @@ void Train::TrainForest(const PMTrain *pmTrain, const RowRank *rowRank) {
     predInfo[i] *= recipNTree;
   }
 
-  forest->SplitUpdate(pmTrain, rowRank);
+  // Segmented stores are copied out contiguously only now, once final.
+  forest->Export();
+  response->LeafExport();
 }
 
 
 /**
+   @brief Trains a block of trees.  Numerical splits are converted from
+   ranks as each block completes, so that the block is final once
+   trained.
 
-   @param tEnd is one 
+   @param tStart is the absolute index of the first tree in the block.
+
+   @param tCount is the number of trees in the block.
+
+   @return void.
  */
-void Train::Block(const RowRank *rowRank, unsigned int tStart, unsigned int tCount) {
-  PreTree **ptBlock = response->BlockTree(rowRank, tCount);
-  if (tStart == 0)
+void Train::Block(const PMTrain *pmTrain, const RowRank *rowRank, unsigned int tStart, unsigned int tCount) {
+  PreTree **ptBlock = response->BlockTree(rowRank, tStart, tCount);
+  if (tStart == tBase)
     Reserve(ptBlock, tCount);
 
   BlockTree(ptBlock, tStart, tCount);
   response->DeBlock(tCount);
+  forest->SplitUpdate(pmTrain, rowRank, &ctx->splitQuant[0], tStart);
 
   delete [] ptBlock;
 }
@@ -195,9 +468,9 @@ void Train::Reserve(PreTree **ptBlock, unsigned int tCount) {
   unsigned int blockFac, blockBag, blockLeaf;
   unsigned int maxHeight = 0;
   unsigned int blockHeight = BlockPeek(ptBlock, tCount, blockFac, blockBag, blockLeaf, maxHeight);
-  PreTree::Reserve(maxHeight);
+  PreTree::Reserve(maxHeight, ctx->heightEst);
 
-  double slop = (slopFactor * nTree) / trainBlock;
+  double slop = (slopFactor * (nTree - tBase)) / trainBlock;
   forest->Reserve(blockHeight, blockFac, slop);
   response->LeafReserve(slop * blockLeaf, slop * blockBag);
 }
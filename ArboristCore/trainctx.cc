@@ -0,0 +1,173 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainctx.cc
+
+   @brief Methods for building the per-training context.
+
+   @author Mark Seligman
+ */
+
+#include "trainctx.h"
+#include "samplepred.h"
+#include "pretree.h"
+#include "callback.h"
+#include "rowsampler.h"
+#include "taskpool.h"
+
+#include <algorithm>
+
+const unsigned int TrainCtx::rankBinMax;
+
+/**
+   @brief Sets every option lacking a natural value to its default.
+
+   @param _nTree is the number of trees to train.
+
+   @param _nSamp is the number of samples drawn per tree.
+
+   @param _seed keys the core generator.
+ */
+TrainOpt::TrainOpt(unsigned int _nTree, unsigned int _nSamp, uint64_t _seed) :
+  nTree(_nTree),
+  nSamp(_nSamp),
+  seed(_seed),
+  withRepl(true),
+  trainBlock(1),
+  minNode(2),
+  minRatio(0.0),
+  totLevels(0),
+  ctgWidth(0),
+  predFixed(0),
+  splitQuant(0),
+  predProb(0),
+  regMono(0),
+  thinLeaves(false),
+  treeParallel(false),
+  feRNG(false),
+  rankBins(0),
+  lazyStage(false),
+  columnLayout(false),
+  subtreeMax(0),
+  levelSync(false),
+  extraTrees(false),
+  approxMin(0),
+  segWidth(0),
+  checkpointPath(0) {
+}
+
+
+/**
+   @brief Copies front-end parameters, so that the front end need not
+   preserve them beyond the call.  Options are validated by Train::Init.
+
+   @param _nPred is the number of predictors, sizing the per-predictor
+   options.
+
+   @param _sampleWeight is the per-row sampling weight, sizing the rows.
+
+   @param _opt holds the remaining options, by name.
+ */
+TrainCtx::TrainCtx(unsigned int _nPred, const std::vector<double> &_sampleWeight, const TrainOpt &_opt) :
+  nPred(_nPred),
+  nTree(_opt.nTree),
+  nRow(_sampleWeight.size()),
+  nSamp(_opt.nSamp),
+  sampleWeight(_sampleWeight),
+  withRepl(_opt.withRepl),
+  trainBlock(_opt.trainBlock),
+  minNode(_opt.minNode),
+  minRatio(_opt.minRatio),
+  totLevels(_opt.totLevels),
+  ctgWidth(_opt.ctgWidth),
+  ctgShift(SPNode::CtgShift(_opt.ctgWidth)),
+  predFixed(_opt.predFixed),
+  predProb(_opt.predProb == 0 ? std::vector<double>(_nPred, 1.0) : std::vector<double>(_opt.predProb, _opt.predProb + _nPred)),
+  splitQuant(_opt.splitQuant == 0 ? std::vector<double>(_nPred, 0.5) : std::vector<double>(_opt.splitQuant, _opt.splitQuant + _nPred)),
+  regMono(_opt.regMono == 0 ? std::vector<double>(0) : std::vector<double>(_opt.regMono, _opt.regMono + _nPred)),
+  predMono(std::count_if(regMono.begin(), regMono.end(), [](double prob) { return prob != 0.0; })),
+  thinLeaves(_opt.thinLeaves),
+  treeParallel(_opt.treeParallel),
+  feRNG(_opt.feRNG),
+  rankBins(_opt.rankBins < 2 ? 0 : std::min(_opt.rankBins, rankBinMax)),
+  lazyStage(_opt.lazyStage),
+  columnLayout(_opt.columnLayout),
+  subtreeMax(_opt.subtreeMax),
+  levelSync(_opt.levelSync),
+  extraTrees(_opt.extraTrees),
+  approxMin(_opt.approxMin),
+  segWidth(_opt.segWidth == 0 ? segWidthDefault : _opt.segWidth),
+  seed(_opt.seed),
+  prng(PRNG(_opt.seed)),
+  checkpointPath(_opt.checkpointPath == 0 ? "" : _opt.checkpointPath),
+  heightEst(PreTree::HeightEst(_opt.nSamp, _opt.minNode)),
+  growTime(0.0),
+  rowSampler(new RowSampler(nRow, &sampleWeight[0], _opt.withRepl)),
+  taskPool(new TaskPool()) {
+}
+
+
+TrainCtx::~TrainCtx() {
+  delete rowSampler;
+  delete taskPool;
+}
+
+
+/**
+   @brief Draws uniform variates from either the core generator or the
+   front end.
+
+   @param tIdx is the absolute tree index.
+
+   @param level is the level, or other round number, of the draw.
+
+   @param stream is the client's tag.
+
+   @param len is the number of variates to draw.
+
+   @param out outputs the variates.
+
+   @return void, with output parameter vector.
+ */
+void TrainCtx::RUnif(unsigned int tIdx, unsigned int level, unsigned int stream, unsigned int len, double out[]) const {
+  if (feRNG) {
+    // Front-end generator not reentrant:  trainings may overlap.
+#pragma omp critical(callBack)
+    CallBack::RUnif(len, out);
+  }
+  else {
+    prng.Uniform(tIdx, level, stream, len, out);
+  }
+}
+
+
+/**
+   @brief Draws the bagged rows of a tree.
+
+   @param tIdx is the absolute tree index.
+
+   @param out outputs 'nSamp'-many sampled rows.
+
+   @return count of rows sampled.
+ */
+unsigned int TrainCtx::SampleRows(unsigned int tIdx, int out[]) const {
+  if (feRNG) {
+    unsigned int sampCount;
+#pragma omp critical(callBack)
+    sampCount = CallBack::SampleRows(rowSampler, nSamp, out);
+    return sampCount;
+  }
+
+  unsigned int varCount = rowSampler->VarCount(nSamp);
+  double *ruRow = new double[varCount];
+  prng.Uniform(tIdx, 0, PRNG::streamRow, varCount, ruRow);
+  unsigned int sampCount = rowSampler->Sample(nSamp, ruRow, out);
+  delete [] ruRow;
+
+  return sampCount;
+}
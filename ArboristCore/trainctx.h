@@ -0,0 +1,133 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainctx.h
+
+   @brief Class definition for the per-training context.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_TRAINCTX_H
+#define ARBORIST_TRAINCTX_H
+
+#include "prng.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/**
+   @brief Training options, set by name.  Only the tree count, the sample
+   count and the seed lack defaults, so callers assign just the options
+   they vary.  Per-predictor vectors and the checkpoint path are copied
+   when the context is built, so need persist only until then.
+
+   Options are documented in full at Train::Init().
+ */
+struct TrainOpt {
+  unsigned int nTree; // # trees to train.
+  unsigned int nSamp; // # samples drawn per tree.
+  uint64_t seed; // Keys the core generator:  no default.
+  bool withRepl; // Whether rows are sampled with replacement.
+  unsigned int trainBlock; // # trees trained en bloc.
+  unsigned int minNode; // Minimal splitable index-node width.
+  double minRatio; // Information threshold ratio for splitting.
+  unsigned int totLevels; // Level limit, if positive.
+  unsigned int ctgWidth; // Response cardinality:  zero iff regression.
+  unsigned int predFixed; // # predictors tried per node, if positive.
+  const double *splitQuant; // Per-predictor split quantile:  null iff midpoint.
+  const double *predProb; // Per-predictor selection probability:  null iff unity.
+  const double *regMono; // Per-predictor monotonicity:  null iff none.
+  bool thinLeaves; // Whether to omit bag/leaf records.
+  bool treeParallel; // Whether trees of a block grow concurrently.
+  bool feRNG; // Whether variates are drawn from the front end.
+  unsigned int rankBins; // Maximal # numerical rank bins:  zero iff exact.
+  bool lazyStage; // Whether predictors are staged only once scheduled.
+  bool columnLayout; // Whether SamplePred buffers are laid out by field.
+  unsigned int subtreeMax; // Extent completed as local subtree:  zero iff none.
+  bool levelSync; // Whether trees of a block split levels in lockstep.
+  bool extraTrees; // Whether splitting draws a single random cut.
+  unsigned int approxMin; // Extent scanned approximately:  zero iff none.
+  unsigned int segWidth; // Indices per scan segment:  zero iff default.
+  const char *checkpointPath; // Block-wise checkpoint file:  null iff none.
+
+  TrainOpt(unsigned int _nTree, unsigned int _nSamp, uint64_t _seed);
+};
+
+
+/**
+   @brief Parameters invariant over a single training invocation, together
+   with the small amount of state refined from block to block.
+
+   These were formerly maintained as class statics, set by Train::Init()
+   and reset on exit.  Each invocation now owns its own context, which is
+   passed down to the objects needing it, so that independent forests may
+   be trained concurrently within a single process.  In particular, the
+   row sampler is owned by the context, the front end supplying at most
+   the variates it maps.
+ */
+class TrainCtx {
+ public:
+  static const unsigned int rankBinMax = 1 << 16; // Bin codes fit in 16 bits.
+  static const unsigned int segWidthDefault = 1 << 16; // Indices per scan segment.
+
+  const unsigned int nPred;
+  const unsigned int nTree;
+  const unsigned int nRow;
+  const unsigned int nSamp; // # samples drawn per tree.
+  const std::vector<double> sampleWeight; // Per-row sampling weight.
+  const bool withRepl;
+  const unsigned int trainBlock; // # trees trained en bloc.
+  const unsigned int minNode; // Minimal splitable index-node width.
+  const double minRatio; // Information threshold ratio for splitting.
+  const unsigned int totLevels; // Level limit, if positive.
+  const unsigned int ctgWidth; // Response cardinality:  zero iff regression.
+  const unsigned int ctgShift; // Packing width for category values.
+  const unsigned int predFixed; // # predictors tried per node, if positive.
+  const std::vector<double> predProb; // Per-predictor selection probability.
+  const std::vector<double> splitQuant; // Per-predictor split quantile.
+  const std::vector<double> regMono; // Regression monotonicity:  possibly empty.
+  const unsigned int predMono; // # monotonically-constrained predictors.
+  const bool thinLeaves; // Whether to omit bag/leaf records.
+  const bool treeParallel; // Whether trees of a block grow concurrently.
+  const bool feRNG; // Whether variates are drawn from the front end.
+  const unsigned int rankBins; // Maximal # numerical rank bins:  zero iff exact.
+  const bool lazyStage; // Whether predictors are staged only once scheduled.
+  const bool columnLayout; // Whether SamplePred buffers are laid out by field.
+  const unsigned int subtreeMax; // Extent completed as local subtree:  zero iff none.
+  const bool levelSync; // Whether trees of a block split levels in lockstep.
+  const bool extraTrees; // Whether splitting draws a single random cut.
+  const unsigned int approxMin; // Extent scanned approximately:  zero iff none.
+  const unsigned int segWidth; // Indices per scan segment.
+  const uint64_t seed; // Keys the core generator:  recorded by checkpoints.
+  const PRNG prng; // Core generator, keyed by seed.
+  const std::string checkpointPath; // Block-wise checkpoint file:  empty iff none.
+
+  unsigned int heightEst; // PreTree height estimate:  refined after first block.
+  double growTime; // Wall-clock seconds spent growing trees.
+  class RowSampler *rowSampler; // Maps variates from either generator to rows.
+  class TaskPool *taskPool; // Persistent workers for level-wise loops.
+
+  TrainCtx(unsigned int _nPred, const std::vector<double> &_sampleWeight, const TrainOpt &_opt);
+  ~TrainCtx();
+  void RUnif(unsigned int tIdx, unsigned int level, unsigned int stream, unsigned int len, double out[]) const;
+  unsigned int SampleRows(unsigned int tIdx, int out[]) const;
+
+
+  /**
+     @brief Looks up monotonicity constraint of a predictor.
+
+     @return signed probability of constraint, else zero.
+   */
+  inline double Mono(unsigned int predIdx) const {
+    return regMono.empty() ? 0.0 : regMono[predIdx];
+  }
+};
+
+#endif